@@ -34,6 +34,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <sys/param.h>
+#include <sys/uio.h>
 #include <endian.h>
 #include <byteswap.h>
 #include <unistd.h>
@@ -104,6 +105,39 @@ pwrite_retry (int fd, const void *buf, size_t len, off_t off)
   return recvd;
 }
 
+/* Like pwrite_retry, but for the IOVCNT buffers of IOV, which it
+   changes to skip what was written.  */
+static inline ssize_t __attribute__ ((unused))
+pwritev_retry (int fd, struct iovec *iov, int iovcnt, off_t off)
+{
+  ssize_t recvd = 0;
+
+  while (iovcnt > 0)
+    {
+      ssize_t ret = TEMP_FAILURE_RETRY (pwritev (fd, iov, iovcnt,
+						 off + recvd));
+      if (ret <= 0)
+	return ret < 0 ? ret : recvd;
+
+      recvd += ret;
+
+      /* A write can end in the middle of a buffer.  */
+      while (iovcnt > 0 && (size_t) ret >= iov->iov_len)
+	{
+	  ret -= iov->iov_len;
+	  ++iov;
+	  --iovcnt;
+	}
+      if (iovcnt > 0)
+	{
+	  iov->iov_base = (char *) iov->iov_base + ret;
+	  iov->iov_len -= ret;
+	}
+    }
+
+  return recvd;
+}
+
 static inline ssize_t __attribute__ ((unused))
 write_retry (int fd, const void *buf, size_t len)
 {
@@ -70,6 +70,19 @@ struct dwarf_fde
   const uint8_t *instructions_end;
 };
 
+/* Sorted index of the FDEs in a Dwarf_CFI.  */
+struct dwarf_fde_index
+{
+  size_t n;
+  struct dwarf_fde_index_entry
+  {
+    Dwarf_Addr start;		/* Range [start, end) of the FDE.  */
+    Dwarf_Addr end;
+    Dwarf_Off offset;		/* Offset of the FDE in the section.  */
+    struct dwarf_fde *fde;	/* Interned on first lookup, or NULL.  */
+  } entries[];
+};
+
 /* This holds everything we cache about the CFI from each ELF file's
    .debug_frame or .eh_frame section.  */
 struct Dwarf_CFI_s
@@ -92,8 +105,12 @@ struct Dwarf_CFI_s
   /* Search tree for the CIEs, indexed by CIE_pointer (section offset).  */
   void *cie_tree;
 
-  /* Search tree for the FDEs, indexed by PC address.  */
-  void *fde_tree;
+  /* All FDEs sorted by PC address, built on the first lookup when
+     there is no .eh_frame_hdr search table.  */
+  struct dwarf_fde_index *fde_index;
+
+  /* FDEs read through the .eh_frame_hdr search table, by table index.  */
+  struct dwarf_fde **search_table_fdes;
 
   /* Search tree for parsed DWARF expressions, indexed by raw pointer.  */
   void *expr_tree;
@@ -207,7 +224,8 @@ extern struct dwarf_fde *__libdw_find_fde (Dwarf_CFI *cache,
 					   Dwarf_Addr address)
   __nonnull_attribute__ (1) internal_function;
 
-/* Look for an FDE by its offset in the section.  */
+/* Read the FDE at OFFSET in the section.  The result is not cached,
+   the caller must free it.  */
 extern struct dwarf_fde *__libdw_fde_by_offset (Dwarf_CFI *cache,
 						Dwarf_Off offset)
   __nonnull_attribute__ (1) internal_function;
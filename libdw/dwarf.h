@@ -925,6 +925,19 @@ enum
   };
 
 
+/* DWARF5 name index attribute encodings.  */
+enum
+  {
+    DW_IDX_compile_unit = 1,
+    DW_IDX_type_unit = 2,
+    DW_IDX_die_offset = 3,
+    DW_IDX_parent = 4,
+    DW_IDX_type_hash = 5,
+    DW_IDX_lo_user = 0x2000,
+    DW_IDX_hi_user = 0x3fff
+  };
+
+
 /* DWARF call frame instruction encodings.  */
 enum
   {
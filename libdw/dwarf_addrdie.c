@@ -37,14 +37,9 @@
 Dwarf_Die *
 dwarf_addrdie (Dwarf *dbg, Dwarf_Addr addr, Dwarf_Die *result)
 {
-  Dwarf_Aranges *aranges;
-  size_t naranges;
   Dwarf_Off off;
 
-  if (INTUSE(dwarf_getaranges) (dbg, &aranges, &naranges) != 0
-      || INTUSE(dwarf_getarangeinfo) (INTUSE(dwarf_getarange_addr) (aranges,
-								    addr),
-				      NULL, NULL, &off) != 0)
+  if (dbg == NULL || __libdw_findarange (dbg, addr, &off) != 0)
     return NULL;
 
   return INTUSE(dwarf_offdie) (dbg, off, result);
@@ -60,13 +60,15 @@ static const char dwarf_scnnames[IDX_last][19] =
   [IDX_debug_loc] = ".debug_loc",
   [IDX_debug_loclists] = ".debug_loclists",
   [IDX_debug_pubnames] = ".debug_pubnames",
+  [IDX_debug_names] = ".debug_names",
   [IDX_debug_str] = ".debug_str",
   [IDX_debug_str_offsets] = ".debug_str_offsets",
   [IDX_debug_macinfo] = ".debug_macinfo",
   [IDX_debug_macro] = ".debug_macro",
   [IDX_debug_ranges] = ".debug_ranges",
   [IDX_debug_rnglists] = ".debug_rnglists",
-  [IDX_gnu_debugaltlink] = ".gnu_debugaltlink"
+  [IDX_gnu_debugaltlink] = ".gnu_debugaltlink",
+  [IDX_gdb_index] = ".gdb_index"
 };
 #define ndwarf_scnnames (sizeof (dwarf_scnnames) / sizeof (dwarf_scnnames[0]))
 
@@ -235,6 +237,8 @@ valid_p (Dwarf *result)
 	{
 	  result->fake_loc_cu->sec_idx = IDX_debug_loc;
 	  result->fake_loc_cu->dbg = result;
+	  rwlock_init (result->fake_loc_cu->lock);
+	  rwlock_init (result->fake_loc_cu->abbrev_lock);
 	  result->fake_loc_cu->startp
 	    = result->sectiondata[IDX_debug_loc]->d_buf;
 	  result->fake_loc_cu->endp
@@ -258,6 +262,8 @@ valid_p (Dwarf *result)
 	{
 	  result->fake_loclists_cu->sec_idx = IDX_debug_loclists;
 	  result->fake_loclists_cu->dbg = result;
+	  rwlock_init (result->fake_loclists_cu->lock);
+	  rwlock_init (result->fake_loclists_cu->abbrev_lock);
 	  result->fake_loclists_cu->startp
 	    = result->sectiondata[IDX_debug_loclists]->d_buf;
 	  result->fake_loclists_cu->endp
@@ -286,6 +292,8 @@ valid_p (Dwarf *result)
 	{
 	  result->fake_addr_cu->sec_idx = IDX_debug_addr;
 	  result->fake_addr_cu->dbg = result;
+	  rwlock_init (result->fake_addr_cu->lock);
+	  rwlock_init (result->fake_addr_cu->abbrev_lock);
 	  result->fake_addr_cu->startp
 	    = result->sectiondata[IDX_debug_addr]->d_buf;
 	  result->fake_addr_cu->endp
@@ -394,10 +402,9 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
 
   /* Default memory allocation size.  */
   size_t mem_default_size = sysconf (_SC_PAGESIZE) - 4 * sizeof (void *);
-  assert (sizeof (struct Dwarf) < mem_default_size);
 
   /* Allocate the data structure.  */
-  Dwarf *result = (Dwarf *) calloc (1, sizeof (Dwarf) + mem_default_size);
+  Dwarf *result = (Dwarf *) calloc (1, sizeof (Dwarf));
   if (unlikely (result == NULL)
       || unlikely (Dwarf_Sig8_Hash_init (&result->sig8_hash, 11) < 0))
     {
@@ -414,14 +421,19 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
   result->elf = elf;
   result->alt_fd = -1;
 
-  /* Initialize the memory handling.  */
+  /* Initialize the memory handling.  The blocks are allocated on
+     first use by each thread.  */
   result->mem_default_size = mem_default_size;
+  result->mem_hugepages = false;
   result->oom_handler = __libdw_oom;
-  result->mem_tail = (struct libdw_memblock *) (result + 1);
-  result->mem_tail->size = (result->mem_default_size
-			    - offsetof (struct libdw_memblock, mem));
-  result->mem_tail->remaining = result->mem_tail->size;
-  result->mem_tail->prev = NULL;
+  __libdw_mem_init (result);
+
+  rwlock_init (result->units_lock);
+  rwlock_init (result->split_lock);
+  rwlock_init (result->macro_lock);
+  rwlock_init (result->lines_lock);
+  rwlock_init (result->cache_lock);
+  rwlock_init (result->aranges_lock);
 
   if (cmd == DWARF_C_READ || cmd == DWARF_C_RDWR)
     {
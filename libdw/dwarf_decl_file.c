@@ -56,7 +56,8 @@ dwarf_decl_file (Dwarf_Die *die)
 
   /* Get the array of source files for the CU.  */
   struct Dwarf_CU *cu = die->cu;
-  if (cu->lines == NULL)
+  Dwarf_Lines *culines = __atomic_load_n (&cu->lines, __ATOMIC_ACQUIRE);
+  if (culines == NULL)
     {
       Dwarf_Lines *lines;
       size_t nlines;
@@ -64,10 +65,11 @@ dwarf_decl_file (Dwarf_Die *die)
       /* Let the more generic function do the work.  It'll create more
 	 data but that will be needed in an real program anyway.  */
       (void) INTUSE(dwarf_getsrclines) (&CUDIE (cu), &lines, &nlines);
-      assert (cu->lines != NULL);
+      culines = __atomic_load_n (&cu->lines, __ATOMIC_ACQUIRE);
+      assert (culines != NULL);
     }
 
-  if (cu->lines == (void *) -1l)
+  if (culines == (void *) -1l)
     {
       /* If the file index is not zero, there must be file information
 	 available.  */
@@ -75,15 +77,16 @@ dwarf_decl_file (Dwarf_Die *die)
       return NULL;
     }
 
-  assert (cu->files != NULL && cu->files != (void *) -1l);
+  Dwarf_Files *files = __atomic_load_n (&cu->files, __ATOMIC_ACQUIRE);
+  assert (files != NULL && files != (void *) -1l);
 
-  if (idx >= cu->files->nfiles)
+  if (idx >= files->nfiles)
     {
       __libdw_seterrno (DWARF_E_INVALID_DWARF);
       return NULL;
     }
 
-  return cu->files->info[idx].name;
+  return files->info[idx].name;
 }
 OLD_VERSION (dwarf_decl_file, ELFUTILS_0.122)
 NEW_VERSION (dwarf_decl_file, ELFUTILS_0.143)
@@ -47,6 +47,14 @@ noop_free (void *arg __attribute__ ((unused)))
 }
 
 
+static void
+files_lines_free (void *arg)
+{
+  struct files_lines_s *node = arg;
+  __libdw_linetable_free (node->table);
+}
+
+
 static void
 cu_free (void *arg)
 {
@@ -56,6 +64,11 @@ cu_free (void *arg)
 
   tdestroy (p->locs, noop_free);
 
+  __libdw_inlines_free (p->inlines);
+
+  rwlock_fini (p->lock);
+  rwlock_fini (p->abbrev_lock);
+
   /* Free split dwarf one way (from skeleton to split).  */
   if (p->unit_type == DW_UT_skeleton
       && p->split != NULL && p->split != (void *)-1)
@@ -68,6 +81,15 @@ cu_free (void *arg)
 }
 
 
+static void
+unit_table_free (struct libdw_unit_table *table)
+{
+  for (size_t i = 0; i < table->nentries; i++)
+    cu_free (table->entries[i].cu);
+  free (table->entries);
+}
+
+
 int
 dwarf_end (Dwarf *dwarf)
 {
@@ -79,33 +101,40 @@ dwarf_end (Dwarf *dwarf)
 
       Dwarf_Sig8_Hash_free (&dwarf->sig8_hash);
 
-      /* The search tree for the CUs.  NB: the CU data itself is
-	 allocated separately, but the abbreviation hash tables need
-	 to be handled.  */
-      tdestroy (dwarf->cu_tree, cu_free);
-      tdestroy (dwarf->tu_tree, cu_free);
+      /* The tables of the CUs.  NB: the CU data itself is allocated
+	 separately, but the abbreviation hash tables need to be
+	 handled.  */
+      unit_table_free (&dwarf->cu_table);
+      unit_table_free (&dwarf->tu_table);
 
       /* Search tree for macro opcode tables.  */
       tdestroy (dwarf->macro_ops, noop_free);
 
       /* Search tree for decoded .debug_lines units.  */
-      tdestroy (dwarf->files_lines, noop_free);
+      tdestroy (dwarf->files_lines, files_lines_free);
 
       /* And the split Dwarf.  */
       tdestroy (dwarf->split_tree, noop_free);
 
-      struct libdw_memblock *memp = dwarf->mem_tail;
-      /* The first block is allocated together with the Dwarf object.  */
-      while (memp->prev != NULL)
-	{
-	  struct libdw_memblock *prevp = memp->prev;
-	  free (memp);
-	  memp = prevp;
-	}
+      /* Free the memory blocks of all threads.  */
+      __libdw_mem_free (dwarf);
+
+      rwlock_fini (dwarf->units_lock);
+      rwlock_fini (dwarf->split_lock);
+      rwlock_fini (dwarf->macro_lock);
+      rwlock_fini (dwarf->lines_lock);
+      rwlock_fini (dwarf->cache_lock);
+      rwlock_fini (dwarf->aranges_lock);
+
+      /* The address ranges read before the table was complete.  */
+      free (dwarf->synth_aranges);
 
       /* Free the pubnames helper structure.  */
       free (dwarf->pubnames_sets);
 
+      /* And the .debug_names indexes.  */
+      __libdw_names_free (dwarf->names);
+
       /* Free the ELF descriptor if necessary.  */
       if (dwarf->free_elf)
 	elf_end (dwarf->elf);
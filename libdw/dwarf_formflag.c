@@ -57,3 +57,4 @@ dwarf_formflag (Dwarf_Attribute *attr, bool *return_bool)
 
   return 0;
 }
+INTDEF(dwarf_formflag)
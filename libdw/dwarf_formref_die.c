@@ -83,29 +83,36 @@ dwarf_formref_die (Dwarf_Attribute *attr, Dwarf_Die *result)
 	 have to match in the type unit headers.  */
 
       uint64_t sig = read_8ubyte_unaligned (cu->dbg, attr->valp);
-      cu = Dwarf_Sig8_Hash_find (&cu->dbg->sig8_hash, sig, NULL);
+      Dwarf *dbg = cu->dbg;
+      rwlock_rdlock (dbg->units_lock);
+      cu = Dwarf_Sig8_Hash_find (&dbg->sig8_hash, sig, NULL);
+      rwlock_unlock (dbg->units_lock);
       if (cu == NULL)
 	{
 	  /* Not seen before.  We have to scan through the type units.
 	     Since DWARFv5 these can (also) be found in .debug_info,
-	     so scan that first.  */
+	     so scan that first.  Check again under the write lock,
+	     another thread might have found it in the meantime.  */
+	  rwlock_wrlock (dbg->units_lock);
+	  cu = Dwarf_Sig8_Hash_find (&dbg->sig8_hash, sig, NULL);
 	  bool scan_debug_types = false;
-	  do
+	  while (cu == NULL || cu->unit_id8 != sig)
 	    {
-	      cu = __libdw_intern_next_unit (attr->cu->dbg, scan_debug_types);
+	      cu = __libdw_intern_next_unit (dbg, scan_debug_types);
 	      if (cu == NULL)
 		{
 		  if (scan_debug_types == false)
 		    scan_debug_types = true;
 		  else
 		    {
+		      rwlock_unlock (dbg->units_lock);
 		      __libdw_seterrno (INTUSE(dwarf_errno) ()
 					?: DWARF_E_INVALID_REFERENCE);
 		      return NULL;
 		    }
 		}
 	    }
-	  while (cu == NULL || cu->unit_id8 != sig);
+	  rwlock_unlock (dbg->units_lock);
 	}
 
       int secid = cu_sec_idx (cu);
@@ -174,5 +174,9 @@ dwarf_getabbrev (Dwarf_Die *die, Dwarf_Off offset, size_t *lengthp)
       return NULL;
     }
 
-  return __libdw_getabbrev (dbg, cu, abbrev_offset + offset, lengthp, NULL);
+  rwlock_wrlock (cu->abbrev_lock);
+  Dwarf_Abbrev *abb = __libdw_getabbrev (dbg, cu, abbrev_offset + offset,
+					 lengthp, NULL);
+  rwlock_unlock (cu->abbrev_lock);
+  return abb;
 }
@@ -95,6 +95,7 @@ __libdw_filepath (const char *debugdir, const char *dir, const char *file)
   return NULL;
 }
 
+/* Called with cache_lock held for writing.  */
 static void
 find_debug_altlink (Dwarf *dbg)
 {
@@ -152,8 +153,8 @@ find_debug_altlink (Dwarf *dbg)
       Dwarf *alt = dwarf_begin (fd, O_RDONLY);
       if (alt != NULL)
 	{
-	  dbg->alt_dwarf = alt;
 	  dbg->alt_fd = fd;
+	  __atomic_store_n (&dbg->alt_dwarf, alt, __ATOMIC_RELEASE);
 	}
       else
 	close (fd);
@@ -163,22 +164,29 @@ find_debug_altlink (Dwarf *dbg)
 Dwarf *
 dwarf_getalt (Dwarf *main)
 {
-  /* Only try once.  */
-  if (main == NULL || main->alt_dwarf == (void *) -1)
+  if (main == NULL)
     return NULL;
 
-  if (main->alt_dwarf != NULL)
-    return main->alt_dwarf;
-
-  find_debug_altlink (main);
-
-  /* If we found nothing, make sure we don't try again.  */
-  if (main->alt_dwarf == NULL)
+  Dwarf *alt = __atomic_load_n (&main->alt_dwarf, __ATOMIC_ACQUIRE);
+  if (alt == NULL)
     {
-      main->alt_dwarf = (void *) -1;
-      return NULL;
+      rwlock_wrlock (main->cache_lock);
+      if (main->alt_dwarf == NULL)
+	{
+	  find_debug_altlink (main);
+
+	  /* If we found nothing, make sure we don't try again.  */
+	  if (main->alt_dwarf == NULL)
+	    __atomic_store_n (&main->alt_dwarf, (void *) -1, __ATOMIC_RELEASE);
+	}
+      alt = main->alt_dwarf;
+      rwlock_unlock (main->cache_lock);
     }
 
-  return main->alt_dwarf;
+  /* Only try once.  */
+  if (alt == (void *) -1)
+    return NULL;
+
+  return alt;
 }
 INTDEF (dwarf_getalt)
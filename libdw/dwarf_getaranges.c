@@ -32,6 +32,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "libdwP.h"
 #include <dwarf.h>
@@ -53,26 +54,331 @@ compare_aranges (const void *a, const void *b)
   return 0;
 }
 
+static int
+compare_arange_addr (const void *a, const void *b)
+{
+  const Dwarf_Arange *a1 = a, *a2 = b;
+  if (a1->addr != a2->addr)
+    return (a1->addr < a2->addr) ? -1 : 1;
+  return 0;
+}
+
+static int
+compare_offsets (const void *a, const void *b)
+{
+  const Dwarf_Off *o1 = a, *o2 = b;
+  return (*o1 < *o2) ? -1 : ((*o1 > *o2) ? 1 : 0);
+}
+
+/* Append the address ranges of the unit DIE of CU (from DW_AT_low_pc
+   and DW_AT_high_pc or DW_AT_ranges) to *ARANGESP, which is malloced
+   with room for *ALLOCP entries.  */
+static int
+add_unit_ranges (Dwarf_CU *cu, Dwarf_Aranges **arangesp, size_t *allocp)
+{
+  /* Type units have no code and the split units are covered by their
+     skeletons.  Partial units are only there to be imported.  */
+  if (cu->unit_type != DW_UT_compile && cu->unit_type != DW_UT_skeleton)
+    return 0;
+
+  Dwarf_Die cudie = CUDIE (cu);
+  Dwarf_Off die_off = __libdw_first_die_off_from_cu (cu);
+  Dwarf_Addr base, start, end;
+  ptrdiff_t offset = 0;
+  while ((offset = INTUSE(dwarf_ranges) (&cudie, offset, &base,
+					 &start, &end)) > 0)
+    {
+      if (start >= end)
+	continue;
+
+      size_t n = *arangesp == NULL ? 0 : (*arangesp)->naranges;
+      if (n == *allocp)
+	{
+	  size_t alloc = n == 0 ? 16 : 2 * n;
+	  Dwarf_Aranges *newp = realloc (*arangesp, (sizeof (Dwarf_Aranges)
+						    + (alloc
+						       * sizeof (Dwarf_Arange))));
+	  if (unlikely (newp == NULL))
+	    {
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return -1;
+	    }
+	  newp->dbg = cu->dbg;
+	  newp->naranges = n;
+	  *arangesp = newp;
+	  *allocp = alloc;
+	}
+
+      (*arangesp)->info[n].addr = start;
+      (*arangesp)->info[n].length = end - start;
+      (*arangesp)->info[n].offset = die_off;
+      (*arangesp)->naranges = n + 1;
+    }
+
+  return offset < 0 ? -1 : 0;
+}
+
+/* Compilers don't always emit .debug_aranges for all units.  Return
+   in *MISSING the ranges of the units that have none in ARANGES, or
+   NULL if there are no such ranges.  Only the unit headers are read
+   for the other units.  */
+static int
+find_missing_units (Dwarf *dbg, const Dwarf_Aranges *aranges,
+		    Dwarf_Aranges **missing)
+{
+  /* The unit DIE offsets that do have some, sorted.  */
+  size_t n = aranges == NULL ? 0 : aranges->naranges;
+  Dwarf_Off *covered = malloc ((n + 1) * sizeof (Dwarf_Off));
+  if (unlikely (covered == NULL))
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+  for (size_t i = 0; i < n; i++)
+    covered[i] = aranges->info[i].offset;
+  qsort (covered, n, sizeof covered[0], compare_offsets);
+
+  *missing = NULL;
+  size_t alloc = 0;
+  Dwarf_Off off = 0;
+  Dwarf_Off next;
+  size_t hsize;
+  int res;
+  while ((res = INTUSE(dwarf_next_unit) (dbg, off, &next, &hsize, NULL,
+					 NULL, NULL, NULL, NULL, NULL)) == 0)
+    {
+      Dwarf_Off die_off = off + hsize;
+      if (bsearch (&die_off, covered, n, sizeof covered[0],
+		   compare_offsets) == NULL)
+	{
+	  Dwarf_CU *cu = __libdw_findcu (dbg, off, false);
+	  if (cu == NULL || add_unit_ranges (cu, missing, &alloc) != 0)
+	    {
+	      res = -1;
+	      break;
+	    }
+	}
+      off = next;
+    }
+  free (covered);
+
+  if (res < 0)
+    {
+      free (*missing);
+      *missing = NULL;
+      return -1;
+    }
+  return 0;
+}
+
+/* Another thread might have read the aranges at the same time.  Only
+   publish ours if nobody beat us, otherwise use theirs (ours will just
+   be released with the rest of the memory in dwarf_end).  */
+static void
+publish_aranges (Dwarf *dbg, Dwarf_Aranges **aranges)
+{
+  rwlock_wrlock (dbg->cache_lock);
+  if (dbg->aranges == NULL)
+    __atomic_store_n (&dbg->aranges, *aranges, __ATOMIC_RELEASE);
+  else
+    *aranges = dbg->aranges;
+  rwlock_unlock (dbg->cache_lock);
+}
+
+/* Sort the ranges of ARANGES after the first SORTED, which already
+   are, and merge them into those.  Units usually follow each other in
+   address order, then there is nothing to merge.  */
+static void
+sort_new_aranges (Dwarf_Aranges *aranges, size_t sorted)
+{
+  Dwarf_Arange *info = aranges->info;
+  size_t n = aranges->naranges;
+  size_t nnew = n - sorted;
+  qsort (&info[sorted], nnew, sizeof info[0], compare_arange_addr);
+  if (sorted == 0 || info[sorted - 1].addr <= info[sorted].addr)
+    return;
+
+  Dwarf_Arange *new = malloc (nnew * sizeof new[0]);
+  if (unlikely (new == NULL))
+    {
+      qsort (info, n, sizeof info[0], compare_arange_addr);
+      return;
+    }
+  memcpy (new, &info[sorted], nnew * sizeof new[0]);
+
+  /* Merge from the end, into the room the new ones were in.  */
+  size_t i = sorted;
+  while (nnew > 0)
+    if (i > 0 && info[i - 1].addr > new[nnew - 1].addr)
+      info[--n] = info[--i];
+    else
+      info[--n] = new[--nnew];
+  free (new);
+}
+
+/* Read the ranges of the units from DBG->synth_next on, until one
+   covering *ADDR is found (or all if ADDR is NULL).  Returns 0 if it
+   was found, 1 if not and -1 on error.  Called with aranges_lock held
+   for writing.  */
+static int
+synth_scan (Dwarf *dbg, const Dwarf_Addr *addr, Dwarf_Off *offp)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_info];
+  size_t sorted = dbg->synth_aranges == NULL ? 0 : dbg->synth_aranges->naranges;
+  int result = 1;
+  while (result == 1 && data != NULL && dbg->synth_next < data->d_size)
+    {
+      size_t first = (dbg->synth_aranges == NULL
+		      ? 0 : dbg->synth_aranges->naranges);
+      Dwarf_CU *cu = __libdw_findcu (dbg, dbg->synth_next, false);
+      if (cu == NULL
+	  || add_unit_ranges (cu, &dbg->synth_aranges, &dbg->synth_alloc) != 0)
+	{
+	  result = -1;
+	  break;
+	}
+      dbg->synth_next = cu->end;
+
+      for (size_t i = first; (addr != NULL && dbg->synth_aranges != NULL
+			      && i < dbg->synth_aranges->naranges); i++)
+	{
+	  Dwarf_Arange *arange = &dbg->synth_aranges->info[i];
+	  if (*addr >= arange->addr && *addr - arange->addr < arange->length)
+	    {
+	      *offp = arange->offset;
+	      result = 0;
+	      break;
+	    }
+	}
+    }
+
+  /* Keep them sorted for the next binary search.  */
+  if (dbg->synth_aranges != NULL && dbg->synth_aranges->naranges > sorted)
+    sort_new_aranges (dbg->synth_aranges, sorted);
+
+  if (result == 1)
+    __libdw_seterrno (DWARF_E_NO_MATCH);
+
+  return result;
+}
+
+/* Once all units are read the synthesized ranges become the real
+   aranges table.  Called with aranges_lock held for writing.  */
+static void
+synth_publish (Dwarf *dbg)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_info];
+  if ((data != NULL && dbg->synth_next < data->d_size)
+      || dbg->synth_aranges == NULL)
+    return;
+
+  size_t n = dbg->synth_aranges->naranges;
+  Dwarf_Aranges *aranges = libdw_alloc (dbg, Dwarf_Aranges,
+					sizeof (Dwarf_Aranges)
+					+ n * sizeof (Dwarf_Arange), 1);
+  memcpy (aranges, dbg->synth_aranges,
+	  sizeof (Dwarf_Aranges) + n * sizeof (Dwarf_Arange));
+  publish_aranges (dbg, &aranges);
+
+  free (dbg->synth_aranges);
+  dbg->synth_aranges = NULL;
+  dbg->synth_alloc = 0;
+}
+
+int
+internal_function
+__libdw_findarange (Dwarf *dbg, Dwarf_Addr addr, Dwarf_Off *offp)
+{
+  Dwarf_Aranges *aranges = __atomic_load_n (&dbg->aranges, __ATOMIC_ACQUIRE);
+
+  /* Without .debug_aranges (or a .gdb_index) read the units only up to
+     the one covering ADDR.  */
+  if (aranges == NULL && dbg->sectiondata[IDX_debug_aranges] == NULL
+      && dbg->sectiondata[IDX_gdb_index] == NULL)
+    {
+      /* Usually ADDR is in a unit already read.  */
+      rwlock_rdlock (dbg->aranges_lock);
+      Dwarf_Arange *arange = INTUSE(dwarf_getarange_addr) (dbg->synth_aranges,
+							   addr);
+      if (arange != NULL)
+	*offp = arange->offset;
+      rwlock_unlock (dbg->aranges_lock);
+      if (arange != NULL)
+	return 0;
+
+      rwlock_wrlock (dbg->aranges_lock);
+      aranges = __atomic_load_n (&dbg->aranges, __ATOMIC_ACQUIRE);
+      int res = 1;
+      if (aranges == NULL)
+	{
+	  /* Another thread might have read more units meanwhile.  */
+	  arange = INTUSE(dwarf_getarange_addr) (dbg->synth_aranges, addr);
+	  if (arange != NULL)
+	    {
+	      *offp = arange->offset;
+	      res = 0;
+	    }
+	  else
+	    {
+	      res = synth_scan (dbg, &addr, offp);
+	      synth_publish (dbg);
+	    }
+	}
+      rwlock_unlock (dbg->aranges_lock);
+      if (aranges == NULL)
+	return res;
+    }
+
+  if (__libdw_getaranges_complete (dbg, &aranges) != 0)
+    return -1;
+
+  Dwarf_Arange *arange = INTUSE(dwarf_getarange_addr) (aranges, addr);
+  if (arange == NULL)
+    return 1;
+
+  *offp = arange->offset;
+  return 0;
+}
+
 int
 dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
 {
   if (dbg == NULL)
     return -1;
 
-  if (dbg->aranges != NULL)
+  Dwarf_Aranges *cached = __atomic_load_n (&dbg->aranges, __ATOMIC_ACQUIRE);
+  if (cached != NULL)
     {
-      *aranges = dbg->aranges;
+      *aranges = cached;
       if (naranges != NULL)
-	*naranges = dbg->aranges->naranges;
+	*naranges = cached->naranges;
       return 0;
     }
 
   if (dbg->sectiondata[IDX_debug_aranges] == NULL)
     {
-      /* No such section.  */
-      *aranges = NULL;
+      /* No such section.  A .gdb_index has an address table too.  */
+      size_t n;
+      if (__libdw_gdb_index_aranges (dbg, aranges, &n) != 0)
+	return -1;
+      if (*aranges != NULL)
+	publish_aranges (dbg, aranges);
+      else
+	{
+	  /* Otherwise use the ranges of all the unit DIEs.  */
+	  rwlock_wrlock (dbg->aranges_lock);
+	  int res = synth_scan (dbg, NULL, NULL);
+	  if (res >= 0)
+	    synth_publish (dbg);
+	  rwlock_unlock (dbg->aranges_lock);
+	  if (res < 0)
+	    return -1;
+
+	  *aranges = __atomic_load_n (&dbg->aranges, __ATOMIC_ACQUIRE);
+	  n = *aranges == NULL ? 0 : (*aranges)->naranges;
+	}
       if (naranges != NULL)
-	*naranges = 0;
+	*naranges = n;
       return 0;
     }
 
@@ -262,7 +568,6 @@ dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
   *aranges = buf;
   (*aranges)->dbg = dbg;
   (*aranges)->naranges = narangelist;
-  dbg->aranges = *aranges;
   if (naranges != NULL)
     *naranges = narangelist;
   for (i = 0; i < narangelist; ++i)
@@ -272,6 +577,66 @@ dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
       free (elt);
     }
 
+  publish_aranges (dbg, aranges);
+
   return 0;
 }
 INTDEF(dwarf_getaranges)
+
+int
+internal_function
+__libdw_getaranges_complete (Dwarf *dbg, Dwarf_Aranges **aranges)
+{
+  Dwarf_Aranges *complete = __atomic_load_n (&dbg->complete_aranges,
+					     __ATOMIC_ACQUIRE);
+  if (complete != NULL)
+    {
+      *aranges = complete;
+      return 0;
+    }
+
+  if (INTUSE(dwarf_getaranges) (dbg, aranges, NULL) != 0)
+    return -1;
+
+  /* Without .debug_aranges the table already covers all units.  */
+  if (dbg->sectiondata[IDX_debug_aranges] == NULL)
+    return 0;
+
+  rwlock_wrlock (dbg->aranges_lock);
+  complete = dbg->complete_aranges;
+  if (complete == NULL)
+    {
+      Dwarf_Aranges *missing;
+      if (find_missing_units (dbg, *aranges, &missing) != 0)
+	{
+	  rwlock_unlock (dbg->aranges_lock);
+	  return -1;
+	}
+
+      complete = *aranges;
+      if (missing != NULL)
+	{
+	  size_t n = *aranges == NULL ? 0 : (*aranges)->naranges;
+	  size_t m = missing->naranges;
+	  complete = libdw_alloc (dbg, Dwarf_Aranges,
+				  sizeof (Dwarf_Aranges)
+				  + (n + m) * sizeof (Dwarf_Arange), 1);
+	  complete->dbg = dbg;
+	  complete->naranges = n + m;
+	  if (n != 0)
+	    memcpy (complete->info, (*aranges)->info,
+		    n * sizeof (Dwarf_Arange));
+	  memcpy (&complete->info[n], missing->info,
+		  m * sizeof (Dwarf_Arange));
+	  free (missing);
+	  qsort (complete->info, n + m, sizeof (Dwarf_Arange),
+		 compare_arange_addr);
+	}
+      if (complete != NULL)
+	__atomic_store_n (&dbg->complete_aranges, complete, __ATOMIC_RELEASE);
+    }
+  rwlock_unlock (dbg->aranges_lock);
+
+  *aranges = complete;
+  return 0;
+}
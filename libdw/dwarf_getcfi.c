@@ -40,7 +40,12 @@ dwarf_getcfi (Dwarf *dbg)
   if (dbg == NULL)
     return NULL;
 
-  if (dbg->cfi == NULL && dbg->sectiondata[IDX_debug_frame] != NULL)
+  Dwarf_CFI *cached = __atomic_load_n (&dbg->cfi, __ATOMIC_ACQUIRE);
+  if (cached != NULL || dbg->sectiondata[IDX_debug_frame] == NULL)
+    return cached;
+
+  rwlock_wrlock (dbg->cache_lock);
+  if (dbg->cfi == NULL)
     {
       Dwarf_CFI *cfi = libdw_typed_alloc (dbg, Dwarf_CFI);
 
@@ -51,6 +56,7 @@ dwarf_getcfi (Dwarf *dbg)
       cfi->search_table_vaddr = 0;
       cfi->search_table_entries = 0;
       cfi->search_table_encoding = DW_EH_PE_omit;
+      cfi->search_table_fdes = NULL;
 
       cfi->frame_vaddr = 0;
       cfi->textrel = 0;
@@ -60,13 +66,16 @@ dwarf_getcfi (Dwarf *dbg)
       cfi->other_byte_order = dbg->other_byte_order;
 
       cfi->next_offset = 0;
-      cfi->cie_tree = cfi->fde_tree = cfi->expr_tree = NULL;
+      cfi->cie_tree = cfi->expr_tree = NULL;
+      cfi->fde_index = NULL;
 
       cfi->ebl = NULL;
 
-      dbg->cfi = cfi;
+      __atomic_store_n (&dbg->cfi, cfi, __ATOMIC_RELEASE);
     }
+  cached = dbg->cfi;
+  rwlock_unlock (dbg->cache_lock);
 
-  return dbg->cfi;
+  return cached;
 }
 INTDEF (dwarf_getcfi)
@@ -0,0 +1,315 @@
+/* Return the functions containing an address, from an index of their ranges.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <dwarf.h>
+#include "libdwP.h"
+
+#define NO_INDEX ((unsigned int) -1)
+
+/* A function DIE, DW_TAG_subprogram, DW_TAG_inlined_subroutine or
+   DW_TAG_entry_point.  */
+struct inline_func
+{
+  Dwarf_Die die;
+  unsigned int parent;		/* The function this one is inlined into.  */
+  unsigned int depth;		/* Length of the chain of parents.  */
+};
+
+/* One address range of a function.  The ranges are sorted by address,
+   outer ranges before the ranges they contain.  */
+struct inline_range
+{
+  Dwarf_Addr low;
+  Dwarf_Addr high;
+  unsigned int func;
+  unsigned int enclosing;	/* The closest range containing this one.  */
+};
+
+struct Dwarf_Inlines_s
+{
+  struct inline_func *funcs;
+  size_t nfuncs;
+  struct inline_range *ranges;
+  size_t nranges;
+};
+
+struct build_state
+{
+  Dwarf_Inlines *inlines;
+  size_t funcs_alloc;
+  size_t ranges_alloc;
+  /* The innermost function at or above each depth of the walk.  */
+  unsigned int *stack;
+  size_t stack_alloc;
+};
+
+static bool
+is_function (Dwarf_Die *die)
+{
+  switch (INTUSE(dwarf_tag) (die))
+    {
+    case DW_TAG_subprogram:
+    case DW_TAG_inlined_subroutine:
+    case DW_TAG_entry_point:
+      return true;
+    default:
+      return false;
+    }
+}
+
+static int
+add_range (struct build_state *state, Dwarf_Addr low, Dwarf_Addr high,
+	   unsigned int func)
+{
+  Dwarf_Inlines *inlines = state->inlines;
+  if (inlines->nranges == state->ranges_alloc)
+    {
+      size_t alloc = state->ranges_alloc * 2 ?: 64;
+      struct inline_range *ranges = realloc (inlines->ranges,
+					     alloc * sizeof ranges[0]);
+      if (ranges == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      inlines->ranges = ranges;
+      state->ranges_alloc = alloc;
+    }
+  inlines->ranges[inlines->nranges++] = (struct inline_range)
+    { .low = low, .high = high, .func = func, .enclosing = NO_INDEX };
+  return 0;
+}
+
+/* Preorder visitor: record every function DIE and its ranges.  */
+static int
+record_func (unsigned int depth, struct Dwarf_Die_Chain *die, void *arg)
+{
+  struct build_state *state = arg;
+  Dwarf_Inlines *inlines = state->inlines;
+
+  if (depth >= state->stack_alloc)
+    {
+      size_t alloc = state->stack_alloc * 2 ?: 16;
+      while (depth >= alloc)
+	alloc *= 2;
+      unsigned int *stack = realloc (state->stack, alloc * sizeof stack[0]);
+      if (stack == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      state->stack = stack;
+      state->stack_alloc = alloc;
+    }
+
+  unsigned int parent = state->stack[depth - 1];
+  state->stack[depth] = parent;
+  if (! is_function (&die->die))
+    return 0;
+
+  if (inlines->nfuncs == state->funcs_alloc)
+    {
+      size_t alloc = state->funcs_alloc * 2 ?: 32;
+      struct inline_func *funcs = realloc (inlines->funcs,
+					   alloc * sizeof funcs[0]);
+      if (funcs == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      inlines->funcs = funcs;
+      state->funcs_alloc = alloc;
+    }
+  /* The chain ends at the subprogram everything is inlined into, a
+     nested function is not part of the chain of its parent.  */
+  if (INTUSE(dwarf_tag) (&die->die) == DW_TAG_subprogram)
+    parent = NO_INDEX;
+  unsigned int func = inlines->nfuncs++;
+  inlines->funcs[func] = (struct inline_func)
+    {
+      .die = die->die,
+      .parent = parent,
+      .depth = parent == NO_INDEX ? 0 : inlines->funcs[parent].depth + 1
+    };
+  state->stack[depth] = func;
+
+  /* Declarations and abstract instances have no ranges.  A DIE whose
+     ranges cannot be read, like in an unrelocated object file, just
+     does not match, it does not make the whole CU fail.  */
+  Dwarf_Addr base, low, high;
+  ptrdiff_t offset = 0;
+  while ((offset = INTUSE(dwarf_ranges) (&die->die, offset,
+					 &base, &low, &high)) > 0)
+    if (low < high && add_range (state, low, high, func) != 0)
+      return -1;
+  return 0;
+}
+
+static int
+compare_ranges (const void *a, const void *b)
+{
+  const struct inline_range *r1 = a;
+  const struct inline_range *r2 = b;
+  if (r1->low != r2->low)
+    return r1->low < r2->low ? -1 : 1;
+  /* Outer ranges first.  */
+  if (r1->high != r2->high)
+    return r1->high > r2->high ? -1 : 1;
+  return r1->func < r2->func ? -1 : r1->func > r2->func;
+}
+
+void
+internal_function
+__libdw_inlines_free (Dwarf_Inlines *inlines)
+{
+  if (inlines == NULL || inlines == (void *) -1l)
+    return;
+  free (inlines->funcs);
+  free (inlines->ranges);
+  free (inlines);
+}
+
+/* Index the function DIEs of the CU of CUDIE.  Returns (void *) -1 on
+   failure.  Called with the CU lock held for writing.  */
+static Dwarf_Inlines *
+read_cu_inlines (Dwarf_Die *cudie)
+{
+  Dwarf_Inlines *inlines = calloc (1, sizeof *inlines);
+  if (inlines == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return (void *) -1l;
+    }
+
+  struct build_state state = { .inlines = inlines };
+  state.stack = malloc (16 * sizeof state.stack[0]);
+  if (state.stack == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      free (inlines);
+      return (void *) -1l;
+    }
+  state.stack_alloc = 16;
+  state.stack[0] = NO_INDEX;
+
+  struct Dwarf_Die_Chain cu = { .parent = NULL, .die = *cudie };
+  int result = __libdw_visit_scopes (0, &cu, NULL, &record_func, NULL,
+				     &state);
+  free (state.stack);
+  if (result != 0)
+    {
+      __libdw_inlines_free (inlines);
+      return (void *) -1l;
+    }
+
+  /* Link every range to the closest one containing it.  The stack
+     holds the ranges containing the previous one.  */
+  struct inline_range *ranges = inlines->ranges;
+  qsort (ranges, inlines->nranges, sizeof ranges[0], compare_ranges);
+  unsigned int top = NO_INDEX;
+  for (size_t i = 0; i < inlines->nranges; i++)
+    {
+      while (top != NO_INDEX && ranges[top].high < ranges[i].high)
+	top = ranges[top].enclosing;
+      ranges[i].enclosing = top;
+      top = i;
+    }
+
+  return inlines;
+}
+
+int
+dwarf_getinlinechain (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
+{
+  if (cudie == NULL)
+    return -1;
+  if (! is_cudie (cudie))
+    {
+      __libdw_seterrno (DWARF_E_NOT_CUDIE);
+      return -1;
+    }
+
+  /* Build the index if it is not already known.  Once set it never
+     changes, so it can be read without locking.  */
+  struct Dwarf_CU *const cu = cudie->cu;
+  Dwarf_Inlines *inlines = __atomic_load_n (&cu->inlines, __ATOMIC_ACQUIRE);
+  if (inlines == NULL)
+    {
+      rwlock_wrlock (cu->lock);
+      inlines = cu->inlines;
+      if (inlines == NULL)
+	{
+	  inlines = read_cu_inlines (cudie);
+	  __atomic_store_n (&cu->inlines, inlines, __ATOMIC_RELEASE);
+	}
+      rwlock_unlock (cu->lock);
+    }
+  if (inlines == (void *) -1l)
+    return -1;
+
+  /* The last range starting at or before PC.  If it does not contain
+     PC, one of the ranges containing it does.  */
+  const struct inline_range *ranges = inlines->ranges;
+  size_t l = 0, u = inlines->nranges;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (ranges[idx].low <= pc)
+	l = idx + 1;
+      else
+	u = idx;
+    }
+  unsigned int r = l > 0 ? l - 1 : NO_INDEX;
+  while (r != NO_INDEX && ranges[r].high <= pc)
+    r = ranges[r].enclosing;
+  if (r == NO_INDEX)
+    return 0;
+
+  const struct inline_func *funcs = inlines->funcs;
+  unsigned int func = ranges[r].func;
+  unsigned int nscopes = funcs[func].depth + 1;
+  Dwarf_Die *result = malloc (nscopes * sizeof result[0]);
+  if (result == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+  for (unsigned int i = 0; i < nscopes; i++)
+    {
+      result[i] = funcs[func].die;
+      func = funcs[func].parent;
+    }
+  *scopes = result;
+  return nscopes;
+}
@@ -0,0 +1,119 @@
+/* Return the source lines of a CU in the compact layout.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwP.h"
+
+
+/* Read the line table for the CU of CUDIE.  Returns (void *) -1 on
+   failure.  Called with the CU lock held for writing.  */
+static Dwarf_Line_Table *
+read_cu_linetable (Dwarf_Die *cudie)
+{
+  struct Dwarf_CU *const cu = cudie->cu;
+
+  /* For split units always pick the lines from the skeleton.  */
+  if (cu->unit_type == DW_UT_split_compile
+      || cu->unit_type == DW_UT_split_type)
+    {
+      Dwarf_CU *skel = __libdw_find_split_unit (cu);
+      if (skel != NULL)
+	{
+	  Dwarf_Die skeldie = CUDIE (skel);
+	  Dwarf_Line_Table *table;
+	  size_t nrows;
+	  if (INTUSE(dwarf_getlinetable) (&skeldie, &table, &nrows) == 0)
+	    return table;
+	  return (void *) -1l;
+	}
+
+      __libdw_seterrno (DWARF_E_NO_DEBUG_LINE);
+      return (void *) -1l;
+    }
+
+  /* The die must have a statement list associated.  */
+  Dwarf_Attribute stmt_list_mem;
+  Dwarf_Attribute *stmt_list = INTUSE(dwarf_attr) (cudie, DW_AT_stmt_list,
+						   &stmt_list_mem);
+
+  /* Get the offset into the .debug_line section.  NB: this call
+     also checks whether the previous dwarf_attr call failed.  */
+  Dwarf_Off debug_line_offset;
+  Dwarf_Line_Table *table;
+  if (__libdw_formptr (stmt_list, IDX_debug_line, DWARF_E_NO_DEBUG_LINE,
+		       NULL, &debug_line_offset) == NULL
+      || __libdw_getlinetable (cu->dbg, debug_line_offset,
+			       __libdw_getcompdir (cudie),
+			       cu->address_size, &table) < 0)
+    return (void *) -1l;
+
+  return table;
+}
+
+int
+dwarf_getlinetable (Dwarf_Die *cudie, Dwarf_Line_Table **table,
+		    size_t *nrows)
+{
+  if (cudie == NULL)
+    return -1;
+  if (! is_cudie (cudie))
+    {
+      __libdw_seterrno (DWARF_E_NOT_CUDIE);
+      return -1;
+    }
+
+  /* Get the information if it is not already known.  Once set the
+     table never changes, so it can be read without locking.  */
+  struct Dwarf_CU *const cu = cudie->cu;
+  Dwarf_Line_Table *cutable = __atomic_load_n (&cu->linetable,
+					       __ATOMIC_ACQUIRE);
+  if (cutable == NULL)
+    {
+      rwlock_wrlock (cu->lock);
+      cutable = cu->linetable;
+      if (cutable == NULL)
+	{
+	  cutable = read_cu_linetable (cudie);
+	  __atomic_store_n (&cu->linetable, cutable, __ATOMIC_RELEASE);
+	}
+      rwlock_unlock (cu->lock);
+    }
+
+  if (cutable == (void *) -1l)
+    return -1;
+
+  *table = cutable;
+  *nrows = cutable->nrows;
+
+  return 0;
+}
+INTDEF(dwarf_getlinetable)
@@ -147,15 +147,21 @@ dwarf_getlocation_implicit_value (Dwarf_Attribute *attr, const Dwarf_Op *op,
     return -1;
 
   struct loc_block_s fake = { .addr = (void *) op };
+  rwlock_rdlock (attr->cu->lock);
   struct loc_block_s **found = tfind (&fake, &attr->cu->locs, loc_compare);
+  if (found != NULL)
+    {
+      return_block->length = (*found)->length;
+      return_block->data = (*found)->data;
+    }
+  rwlock_unlock (attr->cu->lock);
+
   if (unlikely (found == NULL))
     {
       __libdw_seterrno (DWARF_E_NO_BLOCK);
       return -1;
     }
 
-  return_block->length = (*found)->length;
-  return_block->data = (*found)->data;
   return 0;
 }
 
@@ -187,7 +193,9 @@ check_constant_offset (Dwarf_Attribute *attr,
 
   /* Check whether we already cached this location.  */
   struct loc_s fake = { .addr = attr->valp };
+  rwlock_rdlock (attr->cu->lock);
   struct loc_s **found = tfind (&fake, &attr->cu->locs, loc_compare);
+  rwlock_unlock (attr->cu->lock);
 
   if (found == NULL)
     {
@@ -211,7 +219,15 @@ check_constant_offset (Dwarf_Attribute *attr,
       newp->loc = result;
       newp->nloc = 1;
 
+      /* If another thread got here first we just use its record.  */
+      rwlock_wrlock (attr->cu->lock);
       found = tsearch (newp, &attr->cu->locs, loc_compare);
+      rwlock_unlock (attr->cu->lock);
+      if (unlikely (found == NULL))
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
     }
 
   assert ((*found)->nloc == 1);
@@ -648,13 +664,31 @@ getlocation (struct Dwarf_CU *cu, const Dwarf_Block *block,
       return 0;
     }
 
-  return __libdw_intern_expression (cu->dbg, cu->dbg->other_byte_order,
-				    cu->address_size, (cu->version == 2
-						       ? cu->address_size
-						       : cu->offset_size),
-				    &cu->locs, block,
-				    false, false,
-				    llbuf, listlen, sec_index);
+  /* Check whether we already looked at this expression, without
+     blocking other readers.  */
+  struct loc_s fake = { .addr = block->data };
+  rwlock_rdlock (cu->lock);
+  struct loc_s **found = tfind (&fake, &cu->locs, loc_compare);
+  if (found != NULL)
+    {
+      *llbuf = (*found)->loc;
+      *listlen = (*found)->nloc;
+    }
+  rwlock_unlock (cu->lock);
+  if (found != NULL)
+    return 0;
+
+  rwlock_wrlock (cu->lock);
+  int result = __libdw_intern_expression (cu->dbg, cu->dbg->other_byte_order,
+					  cu->address_size,
+					  (cu->version == 2
+					   ? cu->address_size
+					   : cu->offset_size),
+					  &cu->locs, block,
+					  false, false,
+					  llbuf, listlen, sec_index);
+  rwlock_unlock (cu->lock);
+  return result;
 }
 
 int
@@ -275,20 +275,34 @@ cache_op_table (Dwarf *dbg, int sec_index, Dwarf_Off macoff,
 		Dwarf_Die *cudie)
 {
   Dwarf_Macro_Op_Table fake = { .offset = macoff, .sec_index = sec_index };
+  rwlock_rdlock (dbg->macro_lock);
   Dwarf_Macro_Op_Table **found = tfind (&fake, &dbg->macro_ops,
 					macro_op_compare);
+  rwlock_unlock (dbg->macro_lock);
   if (found != NULL)
     return *found;
 
+  rwlock_wrlock (dbg->macro_lock);
+  found = tfind (&fake, &dbg->macro_ops, macro_op_compare);
+  if (found != NULL)
+    {
+      rwlock_unlock (dbg->macro_lock);
+      return *found;
+    }
+
   Dwarf_Macro_Op_Table *table = sec_index == IDX_debug_macro
     ? get_table_for_offset (dbg, macoff, startp, endp, cudie)
     : get_macinfo_table (dbg, macoff, cudie);
 
   if (table == NULL)
-    return NULL;
+    {
+      rwlock_unlock (dbg->macro_lock);
+      return NULL;
+    }
 
   Dwarf_Macro_Op_Table **ret = tsearch (table, &dbg->macro_ops,
 					macro_op_compare);
+  rwlock_unlock (dbg->macro_lock);
   if (unlikely (ret == NULL))
     {
       __libdw_seterrno (DWARF_E_NOMEM);
@@ -0,0 +1,640 @@
+/* Read the DWARF5 .debug_names accelerated name index.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libdwP.h"
+
+
+/* One abbreviation of a name index.  SPECS points to the (index
+   attribute, form) pairs in the abbreviation table.  */
+struct names_abbrev
+{
+  Dwarf_Word code;
+  unsigned int tag;
+  const unsigned char *specs;
+};
+
+/* One name index, the .debug_names section can contain several of
+   them (for example one per object file after linking).  */
+struct names_index
+{
+  unsigned int offset_size;
+  uint32_t cu_count;
+  uint32_t local_tu_count;
+  uint32_t foreign_tu_count;
+  uint32_t bucket_count;
+  uint32_t name_count;
+
+  const unsigned char *cu_list;
+  const unsigned char *local_tu_list;
+  const unsigned char *buckets;
+  const unsigned char *hashes;
+  const unsigned char *str_offsets;
+  const unsigned char *entry_offsets;
+  const unsigned char *abbrevs_end;
+  const unsigned char *entry_pool;
+  const unsigned char *end;
+
+  /* Sorted by code.  */
+  struct names_abbrev *abbrevs;
+  size_t nabbrevs;
+};
+
+struct libdw_names
+{
+  size_t nindexes;
+  struct names_index indexes[0];
+};
+
+
+/* The hash function for names.  This is the DJB hash from the DWARF5
+   standard on the case folded name.  Like other producers we only
+   fold ASCII characters.  */
+static uint32_t
+names_hash (const char *name)
+{
+  uint32_t hash = 5381;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0'; p++)
+    {
+      unsigned char c = *p;
+      if (c >= 'A' && c <= 'Z')
+	c += 'a' - 'A';
+      hash = hash * 33 + c;
+    }
+  return hash;
+}
+
+static int
+compare_abbrevs (const void *a, const void *b)
+{
+  const struct names_abbrev *a1 = a, *a2 = b;
+  if (a1->code != a2->code)
+    return a1->code < a2->code ? -1 : 1;
+  return 0;
+}
+
+static const struct names_abbrev *
+find_abbrev (const struct names_index *idx, Dwarf_Word code)
+{
+  size_t l = 0, u = idx->nabbrevs;
+  while (l < u)
+    {
+      size_t i = (l + u) / 2;
+      if (code < idx->abbrevs[i].code)
+	u = i;
+      else if (code > idx->abbrevs[i].code)
+	l = i + 1;
+      else
+	return &idx->abbrevs[i];
+    }
+  return NULL;
+}
+
+/* Skip over a value of FORM, returning its (unsigned) value in *VAL.
+   Only the forms the standard allows for index attributes are
+   accepted.  */
+static int
+read_form (Dwarf *dbg, unsigned int form, const unsigned char **readp,
+	   const unsigned char *end, Dwarf_Word *val)
+{
+  const unsigned char *p = *readp;
+  size_t len;
+  switch (form)
+    {
+    case DW_FORM_flag_present:
+      *val = 1;
+      return 0;
+    case DW_FORM_data1:
+    case DW_FORM_ref1:
+    case DW_FORM_flag:
+      len = 1;
+      break;
+    case DW_FORM_data2:
+    case DW_FORM_ref2:
+      len = 2;
+      break;
+    case DW_FORM_data4:
+    case DW_FORM_ref4:
+      len = 4;
+      break;
+    case DW_FORM_data8:
+    case DW_FORM_ref8:
+    case DW_FORM_ref_sig8:
+      len = 8;
+      break;
+    case DW_FORM_udata:
+    case DW_FORM_ref_udata:
+      if (unlikely (p >= end))
+	return -1;
+      get_uleb128 (*val, p, end);
+      *readp = p;
+      return 0;
+    default:
+      return -1;
+    }
+
+  if (unlikely ((size_t) (end - p) < len))
+    return -1;
+  switch (len)
+    {
+    case 1:
+      *val = *p;
+      break;
+    case 2:
+      *val = read_2ubyte_unaligned (dbg, p);
+      break;
+    case 4:
+      *val = read_4ubyte_unaligned (dbg, p);
+      break;
+    default:
+      *val = read_8ubyte_unaligned (dbg, p);
+      break;
+    }
+  *readp = p + len;
+  return 0;
+}
+
+static Dwarf_Off
+read_offset (Dwarf *dbg, const struct names_index *idx,
+	     const unsigned char *table, size_t n)
+{
+  if (idx->offset_size == 4)
+    return read_4ubyte_unaligned (dbg, table + n * 4);
+  return read_8ubyte_unaligned (dbg, table + n * 8);
+}
+
+/* Parse the header and abbreviation table of the name index at
+   READP.  Returns the end of the index, or NULL on error.  */
+static const unsigned char *
+parse_index (Dwarf *dbg, const unsigned char *readp,
+	     const unsigned char *readendp, struct names_index *idx)
+{
+  idx->abbrevs = NULL;
+  idx->nabbrevs = 0;
+
+  if (unlikely (readendp - readp < 4))
+    goto invalid;
+
+  Dwarf_Word unit_length = read_4ubyte_unaligned_inc (dbg, readp);
+  idx->offset_size = 4;
+  if (unit_length == DWARF3_LENGTH_64_BIT)
+    {
+      if (unlikely (readendp - readp < 8))
+	goto invalid;
+      unit_length = read_8ubyte_unaligned_inc (dbg, readp);
+      idx->offset_size = 8;
+    }
+  else if (unlikely (unit_length >= DWARF3_LENGTH_MIN_ESCAPE_CODE
+		     && unit_length <= DWARF3_LENGTH_MAX_ESCAPE_CODE))
+    goto invalid;
+
+  if (unlikely (unit_length > (size_t) (readendp - readp)
+		|| unit_length < 2 + 2 + 7 * 4))
+    goto invalid;
+  const unsigned char *endp = readp + unit_length;
+  idx->end = endp;
+
+  uint16_t version = read_2ubyte_unaligned_inc (dbg, readp);
+  if (unlikely (version != 5))
+    goto invalid;
+  readp += 2; /* Padding.  */
+
+  idx->cu_count = read_4ubyte_unaligned_inc (dbg, readp);
+  idx->local_tu_count = read_4ubyte_unaligned_inc (dbg, readp);
+  idx->foreign_tu_count = read_4ubyte_unaligned_inc (dbg, readp);
+  idx->bucket_count = read_4ubyte_unaligned_inc (dbg, readp);
+  idx->name_count = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t abbrev_table_size = read_4ubyte_unaligned_inc (dbg, readp);
+  uint32_t augmentation_size = read_4ubyte_unaligned_inc (dbg, readp);
+
+  /* The augmentation string is padded to a multiple of four.  */
+  augmentation_size = (augmentation_size + 3) & ~3U;
+
+  /* Check all tables fit before computing their addresses.  */
+  uint64_t need = ((uint64_t) augmentation_size
+		   + ((uint64_t) idx->cu_count + idx->local_tu_count)
+		     * idx->offset_size
+		   + (uint64_t) idx->foreign_tu_count * 8
+		   + (uint64_t) idx->bucket_count * 4
+		   + (idx->bucket_count > 0 ? (uint64_t) idx->name_count * 4 : 0)
+		   + (uint64_t) idx->name_count * 2 * idx->offset_size
+		   + abbrev_table_size);
+  if (unlikely (need > (uint64_t) (endp - readp)))
+    goto invalid;
+
+  readp += augmentation_size;
+  idx->cu_list = readp;
+  readp += idx->cu_count * idx->offset_size;
+  idx->local_tu_list = readp;
+  readp += idx->local_tu_count * idx->offset_size;
+  readp += idx->foreign_tu_count * 8;
+  idx->buckets = readp;
+  readp += idx->bucket_count * 4;
+  idx->hashes = readp;
+  if (idx->bucket_count > 0)
+    readp += idx->name_count * 4;
+  idx->str_offsets = readp;
+  readp += idx->name_count * idx->offset_size;
+  idx->entry_offsets = readp;
+  readp += idx->name_count * idx->offset_size;
+  const unsigned char *abbrevp = readp;
+  idx->abbrevs_end = readp + abbrev_table_size;
+  idx->entry_pool = idx->abbrevs_end;
+
+  /* Collect the abbreviations.  */
+  size_t nalloc = 0;
+  while (abbrevp < idx->abbrevs_end)
+    {
+      Dwarf_Word code;
+      get_uleb128 (code, abbrevp, idx->abbrevs_end);
+      if (code == 0)
+	break;
+
+      if (idx->nabbrevs == nalloc)
+	{
+	  nalloc = nalloc == 0 ? 16 : 2 * nalloc;
+	  struct names_abbrev *newp = realloc (idx->abbrevs,
+					       nalloc * sizeof *newp);
+	  if (unlikely (newp == NULL))
+	    {
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      goto fail;
+	    }
+	  idx->abbrevs = newp;
+	}
+
+      struct names_abbrev *abbrev = &idx->abbrevs[idx->nabbrevs++];
+      abbrev->code = code;
+      if (unlikely (abbrevp >= idx->abbrevs_end))
+	goto invalid;
+      Dwarf_Word tag;
+      get_uleb128 (tag, abbrevp, idx->abbrevs_end);
+      abbrev->tag = tag;
+      abbrev->specs = abbrevp;
+
+      /* Skip the attribute specifications.  */
+      Dwarf_Word attr, form;
+      do
+	{
+	  if (unlikely (abbrevp >= idx->abbrevs_end))
+	    goto invalid;
+	  get_uleb128 (attr, abbrevp, idx->abbrevs_end);
+	  if (unlikely (abbrevp >= idx->abbrevs_end))
+	    goto invalid;
+	  get_uleb128 (form, abbrevp, idx->abbrevs_end);
+	}
+      while (attr != 0 || form != 0);
+    }
+
+  qsort (idx->abbrevs, idx->nabbrevs, sizeof (struct names_abbrev),
+	 compare_abbrevs);
+  return endp;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+ fail:
+  free (idx->abbrevs);
+  idx->abbrevs = NULL;
+  return NULL;
+}
+
+static struct libdw_names *
+read_names (Dwarf *dbg)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_names];
+  const unsigned char *readp = data->d_buf;
+  const unsigned char *readendp = readp + data->d_size;
+
+  size_t nalloc = 1;
+  struct libdw_names *names = malloc (sizeof (struct libdw_names)
+				      + sizeof (struct names_index));
+  if (unlikely (names == NULL))
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+  names->nindexes = 0;
+
+  while (readp < readendp)
+    {
+      if (names->nindexes == nalloc)
+	{
+	  nalloc *= 2;
+	  struct libdw_names *newp
+	    = realloc (names, (sizeof (struct libdw_names)
+			       + nalloc * sizeof (struct names_index)));
+	  if (unlikely (newp == NULL))
+	    {
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      __libdw_names_free (names);
+	      return NULL;
+	    }
+	  names = newp;
+	}
+
+      struct names_index *idx = &names->indexes[names->nindexes];
+      readp = parse_index (dbg, readp, readendp, idx);
+      if (readp == NULL)
+	{
+	  __libdw_names_free (names);
+	  return NULL;
+	}
+      names->nindexes++;
+    }
+
+  return names;
+}
+
+/* Get the parsed name indexes, reading them on first use.  */
+static struct libdw_names *
+get_names (Dwarf *dbg)
+{
+  struct libdw_names *names = __atomic_load_n (&dbg->names,
+					       __ATOMIC_ACQUIRE);
+  if (names != NULL)
+    return names;
+
+  if (dbg->sectiondata[IDX_debug_names] == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NO_DEBUG_NAMES);
+      return NULL;
+    }
+
+  rwlock_wrlock (dbg->cache_lock);
+  names = dbg->names;
+  if (names == NULL)
+    {
+      names = read_names (dbg);
+      if (names != NULL)
+	__atomic_store_n (&dbg->names, names, __ATOMIC_RELEASE);
+    }
+  rwlock_unlock (dbg->cache_lock);
+  return names;
+}
+
+void
+internal_function
+__libdw_names_free (struct libdw_names *names)
+{
+  if (names == NULL)
+    return;
+
+  for (size_t i = 0; i < names->nindexes; i++)
+    free (names->indexes[i].abbrevs);
+  free (names);
+}
+
+/* Report all entries of name number I (zero based) of IDX to the
+   CALLBACK.  Returns 0 when all entries were reported, 1 if the
+   callback aborted and -1 on error.  */
+static int
+report_entries (Dwarf *dbg, const struct names_index *idx, uint32_t i,
+		int (*callback) (Dwarf *, Dwarf_Name *, void *), void *arg)
+{
+  Elf_Data *strdata = dbg->sectiondata[IDX_debug_str];
+  Dwarf_Off str_off = read_offset (dbg, idx, idx->str_offsets, i);
+  if (unlikely (strdata == NULL || str_off >= strdata->d_size
+		|| memchr ((char *) strdata->d_buf + str_off, '\0',
+			   strdata->d_size - str_off) == NULL))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return -1;
+    }
+
+  Dwarf_Name entry;
+  entry.name = (const char *) strdata->d_buf + str_off;
+
+  Dwarf_Off pool_off = read_offset (dbg, idx, idx->entry_offsets, i);
+  if (unlikely (pool_off >= (size_t) (idx->end - idx->entry_pool)))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return -1;
+    }
+
+  const unsigned char *readp = idx->entry_pool + pool_off;
+  while (readp < idx->end)
+    {
+      Dwarf_Word code;
+      get_uleb128 (code, readp, idx->end);
+      if (code == 0)
+	return 0;
+
+      const struct names_abbrev *abbrev = find_abbrev (idx, code);
+      if (unlikely (abbrev == NULL))
+	goto invalid;
+
+      /* Without an explicit unit index the only unit is meant.  */
+      Dwarf_Word cu_index = 0;
+      Dwarf_Word tu_index = (Dwarf_Word) -1;
+      Dwarf_Word die_offset = (Dwarf_Word) -1;
+      const unsigned char *specp = abbrev->specs;
+      while (1)
+	{
+	  Dwarf_Word attr, form, val;
+	  get_uleb128 (attr, specp, idx->abbrevs_end);
+	  get_uleb128 (form, specp, idx->abbrevs_end);
+	  if (attr == 0 && form == 0)
+	    break;
+	  if (unlikely (read_form (dbg, form, &readp, idx->end, &val) != 0))
+	    goto invalid;
+
+	  switch (attr)
+	    {
+	    case DW_IDX_compile_unit:
+	      cu_index = val;
+	      break;
+	    case DW_IDX_type_unit:
+	      tu_index = val;
+	      break;
+	    case DW_IDX_die_offset:
+	      die_offset = val;
+	      break;
+	    default:
+	      /* DW_IDX_parent, DW_IDX_type_hash and vendor extensions
+		 aren't needed to find the DIE.  */
+	      break;
+	    }
+	}
+
+      if (unlikely (die_offset == (Dwarf_Word) -1))
+	goto invalid;
+
+      /* Type units in other (split) files cannot be resolved here.  */
+      Dwarf_Off unit_off;
+      if (tu_index != (Dwarf_Word) -1)
+	{
+	  if (tu_index >= idx->local_tu_count)
+	    continue;
+	  unit_off = read_offset (dbg, idx, idx->local_tu_list, tu_index);
+	}
+      else if (cu_index < idx->cu_count)
+	unit_off = read_offset (dbg, idx, idx->cu_list, cu_index);
+      else if (idx->cu_count == 0 && idx->local_tu_count == 1)
+	unit_off = read_offset (dbg, idx, idx->local_tu_list, 0);
+      else
+	goto invalid;
+
+      Dwarf_CU *cu = __libdw_findcu (dbg, unit_off, false);
+      if (unlikely (cu == NULL))
+	return -1;
+      if (unlikely (die_offset >= cu->end - cu->start))
+	goto invalid;
+
+      entry.cu_offset = __libdw_first_die_off_from_cu (cu);
+      entry.die_offset = unit_off + die_offset;
+      entry.tag = abbrev->tag;
+      if (callback (dbg, &entry, arg) != DWARF_CB_OK)
+	return 1;
+    }
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+ptrdiff_t
+dwarf_getnames (Dwarf *dbg, int (*callback) (Dwarf *, Dwarf_Name *, void *),
+		void *arg, ptrdiff_t offset)
+{
+  if (dbg == NULL)
+    return -1;
+
+  if (unlikely (offset < 0))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_OFFSET);
+      return -1;
+    }
+
+  struct libdw_names *names = get_names (dbg);
+  if (names == NULL)
+    return -1;
+
+  /* OFFSET counts the names over all indexes.  */
+  size_t n = 0;
+  for (size_t i = 0; i < names->nindexes; i++)
+    {
+      const struct names_index *idx = &names->indexes[i];
+      if ((size_t) offset >= n + idx->name_count)
+	{
+	  n += idx->name_count;
+	  continue;
+	}
+
+      for (uint32_t j = offset - n; j < idx->name_count; j++)
+	{
+	  int res = report_entries (dbg, idx, j, callback, arg);
+	  if (res < 0)
+	    return -1;
+	  if (res > 0)
+	    return n + j + 1;
+	}
+      n += idx->name_count;
+      offset = n;
+    }
+
+  return 0;
+}
+
+int
+dwarf_names_lookup (Dwarf *dbg, const char *name,
+		    int (*callback) (Dwarf *, Dwarf_Name *, void *),
+		    void *arg)
+{
+  if (dbg == NULL)
+    return -1;
+
+  /* Without .debug_names the .gdb_index can at least tell which
+     units to look in.  */
+  if (dbg->sectiondata[IDX_debug_names] == NULL
+      && dbg->sectiondata[IDX_gdb_index] != NULL)
+    return __libdw_gdb_index_lookup (dbg, name, callback, arg);
+
+  struct libdw_names *names = get_names (dbg);
+  if (names == NULL)
+    return -1;
+
+  Elf_Data *strdata = dbg->sectiondata[IDX_debug_str];
+  if (unlikely (strdata == NULL))
+    {
+      __libdw_seterrno (DWARF_E_NO_DEBUG_STR);
+      return -1;
+    }
+
+  uint32_t hash = names_hash (name);
+  int found = 0;
+  for (size_t i = 0; i < names->nindexes; i++)
+    {
+      const struct names_index *idx = &names->indexes[i];
+
+      /* Without a hash table all names have to be compared.  */
+      uint32_t j = 0;
+      uint32_t bucket = 0;
+      if (idx->bucket_count > 0)
+	{
+	  bucket = hash % idx->bucket_count;
+	  j = read_4ubyte_unaligned (dbg, idx->buckets + bucket * 4);
+	  if (j == 0)
+	    continue;
+	  j--;
+	}
+
+      for (; j < idx->name_count; j++)
+	{
+	  if (idx->bucket_count > 0)
+	    {
+	      /* The names of a bucket are consecutive.  */
+	      uint32_t h = read_4ubyte_unaligned (dbg, idx->hashes + j * 4);
+	      if (h % idx->bucket_count != bucket)
+		break;
+	      if (h != hash)
+		continue;
+	    }
+
+	  Dwarf_Off str_off = read_offset (dbg, idx, idx->str_offsets, j);
+	  if (str_off >= strdata->d_size
+	      || strncmp ((const char *) strdata->d_buf + str_off, name,
+			  strdata->d_size - str_off) != 0)
+	    continue;
+
+	  found = 1;
+	  int res = report_entries (dbg, idx, j, callback, arg);
+	  if (res < 0)
+	    return -1;
+	  if (res > 0)
+	    return found;
+	}
+    }
+
+  return found;
+}
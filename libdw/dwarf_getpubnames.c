@@ -40,6 +40,7 @@
 #include <system.h>
 
 
+/* Called with cache_lock held for writing.  */
 static int
 get_offsets (Dwarf *dbg)
 {
@@ -133,7 +134,8 @@ get_offsets (Dwarf *dbg)
     }
 
   dbg->pubnames_sets = (struct pubnames_s *) realloc (mem, cnt * entsize);
-  dbg->pubnames_nsets = cnt;
+  /* Readers check pubnames_nsets before looking at the sets.  */
+  __atomic_store_n (&dbg->pubnames_nsets, cnt, __ATOMIC_RELEASE);
 
   return 0;
 }
@@ -161,8 +163,14 @@ dwarf_getpubnames (Dwarf *dbg,
     return 0;
 
   /* If necessary read the set information.  */
-  if (dbg->pubnames_nsets == 0 && unlikely (get_offsets (dbg) != 0))
-    return -1l;
+  if (__atomic_load_n (&dbg->pubnames_nsets, __ATOMIC_ACQUIRE) == 0)
+    {
+      rwlock_wrlock (dbg->cache_lock);
+      int res = dbg->pubnames_nsets == 0 ? get_offsets (dbg) : 0;
+      rwlock_unlock (dbg->cache_lock);
+      if (unlikely (res != 0))
+	return -1l;
+    }
 
   /* Find the place where to start.  */
   size_t cnt;
@@ -48,39 +48,50 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 
   int res = -1;
 
-  /* Get the information if it is not already known.  */
+  /* Get the information if it is not already known.  Once set the
+     files never change, so they can be read without locking.  */
   struct Dwarf_CU *const cu = cudie->cu;
-  if (cu->files == NULL)
+  Dwarf_Files *cufiles = __atomic_load_n (&cu->files, __ATOMIC_ACQUIRE);
+  if (cufiles == NULL)
     {
       /* For split units there might be a simple file table (without lines).
 	 If not, use the one from the skeleton.  */
       if (cu->unit_type == DW_UT_split_compile
 	  || cu->unit_type == DW_UT_split_type)
 	{
-	  /* We tried, assume we fail...  */
-	  cu->files = (void *) -1;
-
-	  /* See if there is a .debug_line section, for split CUs
-	     the table is at offset zero.  */
-	  if (cu->dbg->sectiondata[IDX_debug_line] != NULL)
-	    {
-	      /* We are only interested in the files, the lines will
-		 always come from the skeleton.  */
-	      res = __libdw_getsrclines (cu->dbg, 0,
-					 __libdw_getcompdir (cudie),
-					 cu->address_size, NULL,
-					 &cu->files);
-	    }
-	  else
+	  rwlock_wrlock (cu->lock);
+	  cufiles = cu->files;
+	  if (cufiles == NULL)
 	    {
-	      Dwarf_CU *skel = __libdw_find_split_unit (cu);
-	      if (skel != NULL)
+	      /* We tried, assume we fail...  */
+	      cufiles = (void *) -1;
+
+	      /* See if there is a .debug_line section, for split CUs
+		 the table is at offset zero.  */
+	      if (cu->dbg->sectiondata[IDX_debug_line] != NULL)
 		{
-		  Dwarf_Die skeldie = CUDIE (skel);
-		  res = INTUSE(dwarf_getsrcfiles) (&skeldie, files, nfiles);
-		  cu->files = skel->files;
+		  /* We are only interested in the files, the lines will
+		     always come from the skeleton.  */
+		  if (__libdw_getsrclines (cu->dbg, 0,
+					   __libdw_getcompdir (cudie),
+					   cu->address_size, NULL,
+					   &cufiles) != 0)
+		    cufiles = (void *) -1;
 		}
+	      else
+		{
+		  Dwarf_CU *skel = __libdw_find_split_unit (cu);
+		  if (skel != NULL)
+		    {
+		      Dwarf_Die skeldie = CUDIE (skel);
+		      if (INTUSE(dwarf_getsrcfiles) (&skeldie, files,
+						     nfiles) == 0)
+			cufiles = skel->files;
+		    }
+		}
+	      __atomic_store_n (&cu->files, cufiles, __ATOMIC_RELEASE);
 	    }
+	  rwlock_unlock (cu->lock);
 	}
       else
 	{
@@ -89,23 +100,19 @@ dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 
 	  /* Let the more generic function do the work.  It'll create more
 	     data but that will be needed in an real program anyway.  */
-	  res = INTUSE(dwarf_getsrclines) (cudie, &lines, &nlines);
+	  if (INTUSE(dwarf_getsrclines) (cudie, &lines, &nlines) == 0)
+	    cufiles = __atomic_load_n (&cu->files, __ATOMIC_ACQUIRE);
 	}
     }
-  else if (cu->files != (void *) -1l)
-    /* We already have the information.  */
-    res = 0;
 
-  if (likely (res == 0))
+  if (cufiles != NULL && cufiles != (void *) -1l)
     {
-      assert (cu->files != NULL && cu->files != (void *) -1l);
-      *files = cu->files;
+      *files = cufiles;
       if (nfiles != NULL)
-	*nfiles = cu->files->nfiles;
+	*nfiles = cufiles->nfiles;
+      res = 0;
     }
 
-  // XXX Eventually: unlocking here.
-
   return res;
 }
 INTDEF (dwarf_getsrcfiles)
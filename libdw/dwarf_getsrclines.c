@@ -45,35 +45,27 @@ struct filelist
   struct filelist *next;
 };
 
-struct linelist
+/* Compare by address, given pointers into an array of sort keys.  */
+struct line_key
 {
-  Dwarf_Line line;
-  struct linelist *next;
-  size_t sequence;
+  Dwarf_Addr addr;
+  /* The row index, with the top bit set unless it is an end_sequence.  */
+  size_t order;
 };
 
-
-/* Compare by Dwarf_Line.addr, given pointers into an array of pointers.  */
 static int
 compare_lines (const void *a, const void *b)
 {
-  struct linelist *const *p1 = a;
-  struct linelist *const *p2 = b;
-  struct linelist *list1 = *p1;
-  struct linelist *list2 = *p2;
-  Dwarf_Line *line1 = &list1->line;
-  Dwarf_Line *line2 = &list2->line;
-
-  if (line1->addr != line2->addr)
-    return (line1->addr < line2->addr) ? -1 : 1;
-
-  /* An end_sequence marker precedes a normal record at the same address.  */
-  if (line1->end_sequence != line2->end_sequence)
-    return line2->end_sequence - line1->end_sequence;
-
-  /* Otherwise, the linelist sequence maintains a stable sort.  */
-  return (list1->sequence < list2->sequence) ? -1
-    : (list1->sequence > list2->sequence) ? 1
+  const struct line_key *key1 = a;
+  const struct line_key *key2 = b;
+
+  if (key1->addr != key2->addr)
+    return (key1->addr < key2->addr) ? -1 : 1;
+
+  /* An end_sequence marker precedes a normal record at the same address.
+     Otherwise, the row order maintains a stable sort.  */
+  return (key1->order < key2->order) ? -1
+    : (key1->order > key2->order) ? 1
     : 0;
 }
 
@@ -90,8 +82,8 @@ struct line_state
   bool epilogue_begin;
   unsigned int isa;
   unsigned int discriminator;
-  struct linelist *linelist;
-  size_t nlinelist;
+  Dwarf_Line_Table *rows;
+  size_t nalloc;
   unsigned int end_sequence;
 };
 
@@ -104,17 +96,37 @@ run_advance_pc (struct line_state *state, unsigned int op_advance,
   state->op_index = (state->op_index + op_advance) % max_ops_per_instr;
 }
 
+/* Make room for more rows, doubling the arrays.  */
+static int
+grow_rows (struct line_state *state)
+{
+  Dwarf_Line_Table *rows = state->rows;
+  size_t nalloc = state->nalloc == 0 ? 256 : 2 * state->nalloc;
+  if (nalloc > SIZE_MAX / sizeof (struct Dwarf_Line_Attr_s))
+    return -1;
+
+  Dwarf_Addr *addrs = realloc (rows->addrs, nalloc * sizeof (Dwarf_Addr));
+  if (unlikely (addrs == NULL))
+    return -1;
+  rows->addrs = addrs;
+
+  struct Dwarf_Line_Attr_s *attrs
+    = realloc (rows->attrs, nalloc * sizeof (struct Dwarf_Line_Attr_s));
+  if (unlikely (attrs == NULL))
+    return -1;
+  rows->attrs = attrs;
+
+  state->nalloc = nalloc;
+  return 0;
+}
+
 static inline bool
-add_new_line (struct line_state *state, struct linelist *new_line)
+add_new_line (struct line_state *state)
 {
-  /* Set the line information.  For some fields we use bitfields,
-     so we would lose information if the encoded values are too large.
-     Check just for paranoia, and call the data "invalid" if it
-     violates our assumptions on reasonable limits for the values.  */
-  new_line->next = state->linelist;
-  new_line->sequence = state->nlinelist;
-  state->linelist = new_line;
-  ++(state->nlinelist);
+  Dwarf_Line_Table *rows = state->rows;
+  struct Dwarf_Line_Attr_s *new_line = &rows->attrs[rows->nrows];
+  rows->addrs[rows->nrows] = state->addr;
+  ++rows->nrows;
 
   /* Set the line information.  For some fields we use bitfields,
      so we would lose information if the encoded values are too large.
@@ -122,12 +134,11 @@ add_new_line (struct line_state *state, struct linelist *new_line)
      violates our assumptions on reasonable limits for the values.  */
 #define SET(field)						      \
   do {								      \
-     new_line->line.field = state->field;			      \
-     if (unlikely (new_line->line.field != state->field))	      \
+     new_line->field = state->field;				      \
+     if (unlikely (new_line->field != state->field))		      \
        return true;						      \
    } while (0)
 
-  SET (addr);
   SET (op_index);
   SET (file);
   SET (line);
@@ -145,11 +156,80 @@ add_new_line (struct line_state *state, struct linelist *new_line)
   return false;
 }
 
+/* Sort the rows by address, in place.  Each sequence is already in
+   order, so often there is nothing to do.  */
+static int
+sort_rows (Dwarf_Line_Table *rows)
+{
+  size_t n = rows->nrows;
+  size_t i;
+  for (i = 1; i < n; i++)
+    if (rows->addrs[i - 1] > rows->addrs[i]
+	|| (rows->addrs[i - 1] == rows->addrs[i]
+	    && rows->attrs[i].end_sequence
+	    && ! rows->attrs[i - 1].end_sequence))
+      break;
+  if (i >= n)
+    return 0;
+
+  struct line_key *keys = malloc (n * sizeof (struct line_key));
+  if (unlikely (keys == NULL))
+    return -1;
+
+  const size_t normal = (size_t) 1 << (sizeof (size_t) * 8 - 1);
+  for (i = 0; i < n; i++)
+    {
+      keys[i].addr = rows->addrs[i];
+      keys[i].order = rows->attrs[i].end_sequence ? i : (i | normal);
+    }
+  qsort (keys, n, sizeof keys[0], &compare_lines);
+
+  /* Row I should get the row at KEYS[I].order.  Follow the cycles of
+     that permutation, marking the finished rows by setting their order
+     to their own index.  */
+  for (i = 0; i < n; i++)
+    {
+      size_t from = keys[i].order & ~normal;
+      if (from == i)
+	continue;
+
+      Dwarf_Addr addr = rows->addrs[i];
+      struct Dwarf_Line_Attr_s attr = rows->attrs[i];
+      size_t to = i;
+      while (from != i)
+	{
+	  rows->addrs[to] = rows->addrs[from];
+	  rows->attrs[to] = rows->attrs[from];
+	  keys[to].order = to;
+	  to = from;
+	  from = keys[to].order & ~normal;
+	}
+      rows->addrs[to] = addr;
+      rows->attrs[to] = attr;
+      keys[to].order = to;
+    }
+
+  free (keys);
+  return 0;
+}
+
+void
+internal_function
+__libdw_linetable_free (Dwarf_Line_Table *table)
+{
+  if (table != NULL)
+    {
+      free (table->addrs);
+      free (table->attrs);
+      free (table);
+    }
+}
+
 static int
 read_srclines (Dwarf *dbg,
 	       const unsigned char *linep, const unsigned char *lineendp,
 	       const char *comp_dir, unsigned address_size,
-	       Dwarf_Lines **linesp, Dwarf_Files **filesp)
+	       Dwarf_Line_Table **tablep, Dwarf_Files **filesp)
 {
   int res = -1;
 
@@ -161,15 +241,21 @@ read_srclines (Dwarf *dbg,
      the stack.  Stack allocate some entries, only dynamically malloc
      when more than MAX.  */
 #define MAX_STACK_ALLOC 4096
-#define MAX_STACK_LINES MAX_STACK_ALLOC
 #define MAX_STACK_FILES (MAX_STACK_ALLOC / 4)
 #define MAX_STACK_DIRS  (MAX_STACK_ALLOC / 16)
 
   /* Initial statement program state (except for stmt_list, see below).  */
+  Dwarf_Line_Table *rows = calloc (1, sizeof (Dwarf_Line_Table));
+  if (unlikely (rows == NULL))
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+
   struct line_state state =
     {
-      .linelist = NULL,
-      .nlinelist = 0,
+      .rows = rows,
+      .nalloc = 0,
       .addr = 0,
       .op_index = 0,
       .file = 1,
@@ -662,18 +748,14 @@ read_srclines (Dwarf *dbg,
 
   /* Process the instructions.  */
 
-  /* Adds a new line to the matrix.  For the first MAX_STACK_LINES
-     entries just return a slot in the preallocated stack array.  */
-  struct linelist llstack[MAX_STACK_LINES];
+  /* Adds a new line to the matrix.  */
 #define NEW_LINE(end_seq)						\
   do {								\
-    struct linelist *ll = (state.nlinelist < MAX_STACK_LINES	\
-			   ? &llstack[state.nlinelist]		\
-			   : malloc (sizeof (struct linelist)));	\
-    if (unlikely (ll == NULL))					\
+    if (unlikely (rows->nrows == state.nalloc)			\
+	&& unlikely (grow_rows (&state) != 0))			\
       goto no_mem;						\
     state.end_sequence = end_seq;				\
-    if (unlikely (add_new_line (&state, ll)))			\
+    if (unlikely (add_new_line (&state)))			\
       goto invalid_data;						\
   } while (0)
 
@@ -1009,63 +1091,26 @@ read_srclines (Dwarf *dbg,
   if (filesp != NULL)
     *filesp = files;
 
-  size_t buf_size = (sizeof (Dwarf_Lines)
-		     + (sizeof (Dwarf_Line) * state.nlinelist));
-  void *buf = libdw_alloc (dbg, Dwarf_Lines, buf_size, 1);
-
-  /* First use the buffer for the pointers, and sort the entries.
-     We'll write the pointers in the end of the buffer, and then
-     copy into the buffer from the beginning so the overlap works.  */
-  assert (sizeof (Dwarf_Line) >= sizeof (struct linelist *));
-  struct linelist **sortlines = (buf + buf_size
-				 - sizeof (struct linelist **) * state.nlinelist);
-
-  /* The list is in LIFO order and usually they come in clumps with
-     ascending addresses.  So fill from the back to probably start with
-     runs already in order before we sort.  */
-  struct linelist *lineslist = state.linelist;
-  for (size_t i = state.nlinelist; i-- > 0; )
-    {
-      sortlines[i] = lineslist;
-      lineslist = lineslist->next;
-    }
-  assert (lineslist == NULL);
-
-  /* Sort by ascending address.  */
-  qsort (sortlines, state.nlinelist, sizeof sortlines[0], &compare_lines);
-
-  /* Now that they are sorted, put them in the final array.
-     The buffers overlap, so we've clobbered the early elements
-     of SORTLINES by the time we're reading the later ones.  */
-  Dwarf_Lines *lines = buf;
-  lines->nlines = state.nlinelist;
-  for (size_t i = 0; i < state.nlinelist; ++i)
-    {
-      lines->info[i] = sortlines[i]->line;
-      lines->info[i].files = files;
-    }
+  rows->files = files;
+  if (unlikely (sort_rows (rows) != 0))
+    goto no_mem;
 
   /* Make sure the highest address for the CU is marked as end_sequence.
      This is required by the DWARF spec, but some compilers forget and
      dwfl_module_getsrc depends on it.  */
-  if (state.nlinelist > 0)
-    lines->info[state.nlinelist - 1].end_sequence = 1;
+  if (rows->nrows > 0)
+    rows->attrs[rows->nrows - 1].end_sequence = 1;
 
-  /* Pass the line structure back to the caller.  */
-  if (linesp != NULL)
-    *linesp = lines;
+  /* Pass the rows back to the caller.  */
+  *tablep = rows;
+  rows = NULL;
 
   /* Success.  */
   res = 0;
 
  out:
-  /* Free malloced line records, if any.  */
-  for (size_t i = MAX_STACK_LINES; i < state.nlinelist; i++)
-    {
-      struct linelist *ll = state.linelist->next;
-      free (state.linelist);
-      state.linelist = ll;
-    }
+  /* Free the rows, unless passed to the caller.  */
+  __libdw_linetable_free (rows);
   if (dirarray != dirstack)
     free (dirarray);
   for (size_t i = MAX_STACK_FILES; i < nfilelist; i++)
@@ -1092,41 +1137,158 @@ files_lines_compare (const void *p1, const void *p2)
   return 0;
 }
 
-int
-internal_function
-__libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
-		     const char *comp_dir, unsigned address_size,
-		     Dwarf_Lines **linesp, Dwarf_Files **filesp)
+/* Expand the compact rows into the Dwarf_Line array.  */
+static Dwarf_Lines *
+lines_from_table (Dwarf *dbg, Dwarf_Line_Table *table)
+{
+  Dwarf_Lines *lines = libdw_alloc (dbg, Dwarf_Lines,
+				    (sizeof (Dwarf_Lines)
+				     + sizeof (Dwarf_Line) * table->nrows), 1);
+  lines->nlines = table->nrows;
+  for (size_t i = 0; i < table->nrows; ++i)
+    {
+      Dwarf_Line *line = &lines->info[i];
+      const struct Dwarf_Line_Attr_s *attr = &table->attrs[i];
+      line->files = table->files;
+      line->addr = table->addrs[i];
+      line->file = attr->file;
+      line->line = attr->line;
+      line->column = attr->column;
+      line->is_stmt = attr->is_stmt;
+      line->basic_block = attr->basic_block;
+      line->end_sequence = attr->end_sequence;
+      line->prologue_end = attr->prologue_end;
+      line->epilogue_begin = attr->epilogue_begin;
+      line->op_index = attr->op_index;
+      line->isa = attr->isa;
+      line->discriminator = attr->discriminator;
+    }
+  return lines;
+}
+
+/* And the other way around, when the Dwarf_Lines were read first.  */
+static Dwarf_Line_Table *
+table_from_lines (Dwarf_Lines *lines, Dwarf_Files *files)
+{
+  Dwarf_Line_Table *table = malloc (sizeof (Dwarf_Line_Table));
+  if (unlikely (table == NULL))
+    return NULL;
+  table->files = files;
+  table->nrows = lines->nlines;
+  table->addrs = malloc (lines->nlines * sizeof (Dwarf_Addr) + 1);
+  table->attrs = malloc (lines->nlines * sizeof (struct Dwarf_Line_Attr_s)
+			 + 1);
+  if (unlikely (table->addrs == NULL || table->attrs == NULL))
+    {
+      __libdw_linetable_free (table);
+      return NULL;
+    }
+
+  for (size_t i = 0; i < lines->nlines; ++i)
+    {
+      const Dwarf_Line *line = &lines->info[i];
+      struct Dwarf_Line_Attr_s *attr = &table->attrs[i];
+      table->addrs[i] = line->addr;
+      attr->file = line->file;
+      attr->line = line->line;
+      attr->column = line->column;
+      attr->is_stmt = line->is_stmt;
+      attr->basic_block = line->basic_block;
+      attr->end_sequence = line->end_sequence;
+      attr->prologue_end = line->prologue_end;
+      attr->epilogue_begin = line->epilogue_begin;
+      attr->op_index = line->op_index;
+      attr->isa = line->isa;
+      attr->discriminator = line->discriminator;
+    }
+  return table;
+}
+
+/* Find the cached line table at DEBUG_LINE_OFFSET, decoding it if
+   necessary, and make sure it has the Dwarf_Lines (TABLEP is NULL) or
+   the Dwarf_Line_Table (TABLEP is not NULL).  The line program is only
+   decoded once, the other layout is made from the one already there.  */
+static int
+get_files_lines (Dwarf *dbg, Dwarf_Off debug_line_offset,
+		 const char *comp_dir, unsigned address_size,
+		 Dwarf_Lines **linesp, Dwarf_Files **filesp,
+		 Dwarf_Line_Table **tablep)
 {
   struct files_lines_s fake = { .debug_line_offset = debug_line_offset };
+  rwlock_rdlock (dbg->lines_lock);
   struct files_lines_s **found = tfind (&fake, &dbg->files_lines,
 					files_lines_compare);
+  if (found != NULL
+      && (tablep != NULL ? (*found)->table == NULL : (*found)->lines == NULL))
+    found = NULL;
+  rwlock_unlock (dbg->lines_lock);
   if (found == NULL)
     {
-      Elf_Data *data = __libdw_checked_get_data (dbg, IDX_debug_line);
-      if (data == NULL
-	  || __libdw_offset_in_section (dbg, IDX_debug_line,
-					debug_line_offset, 1) != 0)
-	return -1;
+      /* Hold the write lock while decoding, so concurrent callers
+	 don't all decode the same (possibly huge) line table.  */
+      rwlock_wrlock (dbg->lines_lock);
+      found = tfind (&fake, &dbg->files_lines, files_lines_compare);
+      struct files_lines_s *node = found != NULL ? *found : NULL;
+      bool keep_table = tablep != NULL;
+      if (node == NULL)
+	{
+	  Elf_Data *data = __libdw_checked_get_data (dbg, IDX_debug_line);
+	  if (data == NULL
+	      || __libdw_offset_in_section (dbg, IDX_debug_line,
+					    debug_line_offset, 1) != 0)
+	    {
+	      rwlock_unlock (dbg->lines_lock);
+	      return -1;
+	    }
 
-      const unsigned char *linep = data->d_buf + debug_line_offset;
-      const unsigned char *lineendp = data->d_buf + data->d_size;
+	  const unsigned char *linep = data->d_buf + debug_line_offset;
+	  const unsigned char *lineendp = data->d_buf + data->d_size;
 
-      struct files_lines_s *node = libdw_alloc (dbg, struct files_lines_s,
-						sizeof *node, 1);
+	  node = libdw_alloc (dbg, struct files_lines_s, sizeof *node, 1);
+	  node->lines = NULL;
+	  if (read_srclines (dbg, linep, lineendp, comp_dir, address_size,
+			     &node->table, &node->files) != 0)
+	    {
+	      rwlock_unlock (dbg->lines_lock);
+	      return -1;
+	    }
 
-      if (read_srclines (dbg, linep, lineendp, comp_dir, address_size,
-			 &node->lines, &node->files) != 0)
-	return -1;
+	  node->debug_line_offset = debug_line_offset;
 
-      node->debug_line_offset = debug_line_offset;
+	  found = tsearch (node, &dbg->files_lines, files_lines_compare);
+	  if (found == NULL)
+	    {
+	      __libdw_linetable_free (node->table);
+	      rwlock_unlock (dbg->lines_lock);
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return -1;
+	    }
+	}
+      else
+	keep_table |= node->table != NULL;
 
-      found = tsearch (node, &dbg->files_lines, files_lines_compare);
-      if (found == NULL)
+      if (node->lines == NULL && tablep == NULL)
 	{
-	  __libdw_seterrno (DWARF_E_NOMEM);
-	  return -1;
+	  node->lines = lines_from_table (dbg, node->table);
+
+	  /* Nobody asked for the compact rows, don't keep them around.  */
+	  if (! keep_table)
+	    {
+	      __libdw_linetable_free (node->table);
+	      node->table = NULL;
+	    }
 	}
+      else if (node->table == NULL && tablep != NULL)
+	{
+	  node->table = table_from_lines (node->lines, node->files);
+	  if (node->table == NULL)
+	    {
+	      rwlock_unlock (dbg->lines_lock);
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return -1;
+	    }
+	}
+      rwlock_unlock (dbg->lines_lock);
     }
 
   if (linesp != NULL)
@@ -1135,9 +1297,32 @@ __libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
   if (filesp != NULL)
     *filesp = (*found)->files;
 
+  if (tablep != NULL)
+    *tablep = (*found)->table;
+
   return 0;
 }
 
+int
+internal_function
+__libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
+		     const char *comp_dir, unsigned address_size,
+		     Dwarf_Lines **linesp, Dwarf_Files **filesp)
+{
+  return get_files_lines (dbg, debug_line_offset, comp_dir, address_size,
+			  linesp, filesp, NULL);
+}
+
+int
+internal_function
+__libdw_getlinetable (Dwarf *dbg, Dwarf_Off debug_line_offset,
+		      const char *comp_dir, unsigned address_size,
+		      Dwarf_Line_Table **tablep)
+{
+  return get_files_lines (dbg, debug_line_offset, comp_dir, address_size,
+			  NULL, NULL, tablep);
+}
+
 /* Get the compilation directory, if any is set.  */
 const char *
 __libdw_getcompdir (Dwarf_Die *cudie)
@@ -1149,6 +1334,60 @@ __libdw_getcompdir (Dwarf_Die *cudie)
   return INTUSE(dwarf_formstring) (compdir_attr);
 }
 
+/* Read the line table for the CU of CUDIE.  Sets the CU files and
+   returns the lines, or (void *) -1 on failure.  Called with the CU
+   lock held for writing.  */
+static Dwarf_Lines *
+read_cu_srclines (Dwarf_Die *cudie)
+{
+  struct Dwarf_CU *const cu = cudie->cu;
+
+  /* For split units always pick the lines from the skeleton.  */
+  if (cu->unit_type == DW_UT_split_compile
+      || cu->unit_type == DW_UT_split_type)
+    {
+      Dwarf_CU *skel = __libdw_find_split_unit (cu);
+      if (skel != NULL)
+	{
+	  Dwarf_Die skeldie = CUDIE (skel);
+	  Dwarf_Lines *lines;
+	  size_t nlines;
+	  if (INTUSE(dwarf_getsrclines) (&skeldie, &lines, &nlines) == 0)
+	    return lines;
+	  return (void *) -1l;
+	}
+
+      __libdw_seterrno (DWARF_E_NO_DEBUG_LINE);
+      return (void *) -1l;
+    }
+
+  /* Failsafe mode: no data found.  */
+  Dwarf_Lines *lines = (void *) -1l;
+  Dwarf_Files *files = (void *) -1l;
+
+  /* The die must have a statement list associated.  */
+  Dwarf_Attribute stmt_list_mem;
+  Dwarf_Attribute *stmt_list = INTUSE(dwarf_attr) (cudie, DW_AT_stmt_list,
+						   &stmt_list_mem);
+
+  /* Get the offset into the .debug_line section.  NB: this call
+     also checks whether the previous dwarf_attr call failed.  */
+  Dwarf_Off debug_line_offset;
+  if (__libdw_formptr (stmt_list, IDX_debug_line, DWARF_E_NO_DEBUG_LINE,
+		       NULL, &debug_line_offset) == NULL
+      || __libdw_getsrclines (cu->dbg, debug_line_offset,
+			      __libdw_getcompdir (cudie),
+			      cu->address_size, &lines, &files) < 0)
+    {
+      lines = (void *) -1l;
+      files = (void *) -1l;
+    }
+
+  /* The files must be visible before the lines are.  */
+  __atomic_store_n (&cu->files, files, __ATOMIC_RELEASE);
+  return lines;
+}
+
 int
 dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
 {
@@ -1160,63 +1399,27 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
       return -1;
     }
 
-  /* Get the information if it is not already known.  */
+  /* Get the information if it is not already known.  Once set the
+     lines never change, so they can be read without locking.  */
   struct Dwarf_CU *const cu = cudie->cu;
-  if (cu->lines == NULL)
+  Dwarf_Lines *culines = __atomic_load_n (&cu->lines, __ATOMIC_ACQUIRE);
+  if (culines == NULL)
     {
-      /* For split units always pick the lines from the skeleton.  */
-      if (cu->unit_type == DW_UT_split_compile
-	  || cu->unit_type == DW_UT_split_type)
+      rwlock_wrlock (cu->lock);
+      culines = cu->lines;
+      if (culines == NULL)
 	{
-	  /* We tries, assume we fail...  */
-	  cu->lines = (void *) -1l;
-
-	  Dwarf_CU *skel = __libdw_find_split_unit (cu);
-	  if (skel != NULL)
-	    {
-	      Dwarf_Die skeldie = CUDIE (skel);
-	      int res = INTUSE(dwarf_getsrclines) (&skeldie, lines, nlines);
-	      if (res == 0)
-		{
-		  cu->lines = skel->lines;
-		  *lines = cu->lines;
-		  *nlines = cu->lines->nlines;
-		}
-	      return res;
-	    }
-
-	  __libdw_seterrno (DWARF_E_NO_DEBUG_LINE);
-	  return -1;
+	  culines = read_cu_srclines (cudie);
+	  __atomic_store_n (&cu->lines, culines, __ATOMIC_RELEASE);
 	}
-
-      /* Failsafe mode: no data found.  */
-      cu->lines = (void *) -1l;
-      cu->files = (void *) -1l;
-
-      /* The die must have a statement list associated.  */
-      Dwarf_Attribute stmt_list_mem;
-      Dwarf_Attribute *stmt_list = INTUSE(dwarf_attr) (cudie, DW_AT_stmt_list,
-						       &stmt_list_mem);
-
-      /* Get the offset into the .debug_line section.  NB: this call
-	 also checks whether the previous dwarf_attr call failed.  */
-      Dwarf_Off debug_line_offset;
-      if (__libdw_formptr (stmt_list, IDX_debug_line, DWARF_E_NO_DEBUG_LINE,
-			   NULL, &debug_line_offset) == NULL)
-	return -1;
-
-      if (__libdw_getsrclines (cu->dbg, debug_line_offset,
-			       __libdw_getcompdir (cudie),
-			       cu->address_size, &cu->lines, &cu->files) < 0)
-	return -1;
+      rwlock_unlock (cu->lock);
     }
-  else if (cu->lines == (void *) -1l)
-    return -1;
 
-  *lines = cu->lines;
-  *nlines = cu->lines->nlines;
+  if (culines == (void *) -1l)
+    return -1;
 
-  // XXX Eventually: unlocking here.
+  *lines = culines;
+  *nlines = culines->nlines;
 
   return 0;
 }
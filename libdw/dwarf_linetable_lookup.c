@@ -0,0 +1,70 @@
+/* Find the row of a compact line table for an address.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwP.h"
+
+
+ptrdiff_t
+dwarf_linetable_lookup (Dwarf_Line_Table *table, Dwarf_Addr addr)
+{
+  if (table == NULL)
+    return -1;
+
+  const Dwarf_Addr *base = table->addrs;
+  size_t n = table->nrows;
+  if (n == 0 || addr < base[0])
+    {
+      __libdw_seterrno (DWARF_E_ADDR_OUTOFRANGE);
+      return -1;
+    }
+
+  /* Find the last row at or before ADDR.  Halve the range without
+     branching on the comparison, so the compiler can use conditional
+     moves and the loop runs the same number of times for any ADDR.  */
+  while (n > 1)
+    {
+      size_t half = n / 2;
+      base = base[half] <= addr ? base + half : base;
+      n -= half;
+    }
+
+  /* An end_sequence row is the first address after its sequence.  */
+  ptrdiff_t idx = base - table->addrs;
+  if (table->attrs[idx].end_sequence)
+    {
+      __libdw_seterrno (DWARF_E_ADDR_OUTOFRANGE);
+      return -1;
+    }
+
+  return idx;
+}
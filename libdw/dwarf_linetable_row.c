@@ -0,0 +1,66 @@
+/* Return one row of a compact line table.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwP.h"
+
+
+int
+dwarf_linetable_row (Dwarf_Line_Table *table, size_t idx,
+		     Dwarf_Line_Row *row)
+{
+  if (table == NULL)
+    return -1;
+
+  if (idx >= table->nrows)
+    {
+      __libdw_seterrno (DWARF_E_INVALID_LINE_IDX);
+      return -1;
+    }
+
+  const struct Dwarf_Line_Attr_s *attr = &table->attrs[idx];
+  row->addr = table->addrs[idx];
+  row->files = table->files;
+  row->file = attr->file;
+  row->line = attr->line;
+  row->column = attr->column;
+  row->op_index = attr->op_index;
+  row->isa = attr->isa;
+  row->discriminator = attr->discriminator;
+  row->flags = ((attr->is_stmt ? DWARF_LINE_IS_STMT : 0)
+		| (attr->basic_block ? DWARF_LINE_BASIC_BLOCK : 0)
+		| (attr->end_sequence ? DWARF_LINE_END_SEQUENCE : 0)
+		| (attr->prologue_end ? DWARF_LINE_PROLOGUE_END : 0)
+		| (attr->epilogue_begin ? DWARF_LINE_EPILOGUE_BEGIN : 0));
+
+  return 0;
+}
@@ -38,7 +38,8 @@ dwarf_macro_getsrcfiles (Dwarf *dbg, Dwarf_Macro *macro,
 {
   /* macro is declared NN */
   Dwarf_Macro_Op_Table *const table = macro->table;
-  if (table->files == NULL)
+  Dwarf_Files *tfiles = __atomic_load_n (&table->files, __ATOMIC_ACQUIRE);
+  if (tfiles == NULL)
     {
       Dwarf_Off line_offset = table->line_offset;
       if (line_offset == (Dwarf_Off) -1)
@@ -71,16 +72,19 @@ dwarf_macro_getsrcfiles (Dwarf *dbg, Dwarf_Macro *macro,
 	 the same unit through dwarf_getsrcfiles, and the file names
 	 will be broken.  */
 
+      /* Concurrent callers all get the same files from the
+	 (locked) cache, so it doesn't matter who stores it first.  */
       if (__libdw_getsrclines (dbg, line_offset, table->comp_dir,
 			       table->is_64bit ? 8 : 4,
-			       NULL, &table->files) < 0)
-	table->files = (void *) -1;
+			       NULL, &tfiles) < 0)
+	tfiles = (void *) -1;
+      __atomic_store_n (&table->files, tfiles, __ATOMIC_RELEASE);
     }
 
-  if (table->files == (void *) -1)
+  if (tfiles == (void *) -1)
     return -1;
 
-  *files = table->files;
-  *nfiles = table->files->nfiles;
+  *files = tfiles;
+  *nfiles = tfiles->nfiles;
   return 0;
 }
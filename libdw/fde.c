@@ -31,35 +31,30 @@
 #endif
 
 #include "cfi.h"
-#include <search.h>
 #include <stdlib.h>
 
 #include "encoded-value.h"
 
+/* Read the address range of the FDE ENTRY with CIE into [*START, *END).
+   Leaves *P after the range.  Returns -1 for bad data, 1 if the FDE
+   does not cover a real code range.  */
 static int
-compare_fde (const void *a, const void *b)
+read_fde_range (Dwarf_CFI *cache, const struct dwarf_cie *cie,
+		const Dwarf_FDE *entry, const uint8_t **p,
+		Dwarf_Addr *start, Dwarf_Addr *end)
 {
-  const struct dwarf_fde *fde1 = a;
-  const struct dwarf_fde *fde2 = b;
-
-  /* Find out which of the two arguments is the search value.
-     It has end offset 0.  */
-  if (fde1->end == 0)
-    {
-      if (fde1->start < fde2->start)
-	return -1;
-      if (fde1->start >= fde2->end)
-	return 1;
-    }
-  else
+  *p = entry->start;
+  if (unlikely (read_encoded_value (cache, cie->fde_encoding, p, start))
+      || unlikely (read_encoded_value (cache, cie->fde_encoding & 0x0f,
+				       p, end)))
     {
-      if (fde2->start < fde1->start)
-	return 1;
-      if (fde2->start >= fde1->end)
-	return -1;
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return -1;
     }
+  *end += *start;
 
-  return 0;
+  /* Make sure the fde actually covers a real code range.  */
+  return *start >= *end;
 }
 
 static struct dwarf_fde *
@@ -77,24 +72,13 @@ intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
       return NULL;
     }
 
-  fde->instructions = entry->start;
   fde->instructions_end = entry->end;
-  if (unlikely (read_encoded_value (cache, cie->fde_encoding,
-				    &fde->instructions, &fde->start))
-      || unlikely (read_encoded_value (cache, cie->fde_encoding & 0x0f,
-				       &fde->instructions, &fde->end)))
-    {
-      free (fde);
-      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-      return NULL;
-    }
-  fde->end += fde->start;
-
-  /* Make sure the fde actually covers a real code range.  */
-  if (fde->start >= fde->end)
+  int result = read_fde_range (cache, cie, entry, &fde->instructions,
+			       &fde->start, &fde->end);
+  if (result != 0)
     {
       free (fde);
-      return (void *) -1;
+      return result < 0 ? NULL : (void *) -1l;
     }
 
   fde->cie = cie;
@@ -118,26 +102,10 @@ intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
        We've recorded the number of data bytes in FDEs.  */
     fde->instructions += cie->fde_augmentation_data_size;
 
-  /* Add the new entry to the search tree.  */
-  struct dwarf_fde **tres = tsearch (fde, &cache->fde_tree, &compare_fde);
-  if (tres == NULL)
-    {
-      free (fde);
-      __libdw_seterrno (DWARF_E_NOMEM);
-      return NULL;
-    }
-  else if (*tres != fde)
-    {
-      /* There is already an FDE in the cache that covers the same
-	 address range.  That is odd.  Ignore this FDE.  And just use
-	 the one in the cache for consistency.  */
-      free (fde);
-      return *tres;
-    }
-
   return fde;
 }
 
+/* Read and intern the FDE at OFFSET.  The caller owns the result.  */
 struct dwarf_fde *
 internal_function
 __libdw_fde_by_offset (Dwarf_CFI *cache, Dwarf_Off offset)
@@ -170,9 +138,151 @@ __libdw_fde_by_offset (Dwarf_CFI *cache, Dwarf_Off offset)
   return fde;
 }
 
-/* Use a binary search table in .eh_frame_hdr format, yield an FDE offset.  */
+static int
+compare_fde_index (const void *a, const void *b)
+{
+  const struct dwarf_fde_index_entry *e1 = a;
+  const struct dwarf_fde_index_entry *e2 = b;
+
+  if (e1->start != e2->start)
+    return e1->start < e2->start ? -1 : 1;
+
+  /* Keep the FDE that comes first in the section.  */
+  return (e1->offset > e2->offset) - (e1->offset < e2->offset);
+}
+
+/* Read through all of the CFI once, collecting the address range and
+   offset of each FDE, and sort them by address.  The FDEs themselves
+   are only interned when looked up.  */
+static struct dwarf_fde_index *
+build_fde_index (Dwarf_CFI *cache)
+{
+  size_t alloc = 64;
+  struct dwarf_fde_index *index = malloc (sizeof *index
+					  + alloc * sizeof index->entries[0]);
+  if (unlikely (index == NULL))
+    goto nomem;
+  index->n = 0;
+
+  Dwarf_Off offset = 0;
+  while (1)
+    {
+      Dwarf_Off last_offset = offset;
+      Dwarf_CFI_Entry entry;
+      int result = INTUSE(dwarf_next_cfi) (cache->e_ident,
+					   &cache->data->d, CFI_IS_EH (cache),
+					   last_offset, &offset, &entry);
+      if (result > 0)
+	break;
+      if (result < 0)
+	{
+	  if (offset == last_offset)
+	    /* We couldn't progress past the bogus FDE.  */
+	    break;
+	  /* Skip the loser and look at the next entry.  */
+	  continue;
+	}
+
+      if (dwarf_cfi_cie_p (&entry))
+	{
+	  /* This is a CIE, not an FDE.  We eagerly intern these
+	     because the next FDE will usually refer to this CIE.  */
+	  __libdw_intern_cie (cache, last_offset, &entry.cie);
+	  continue;
+	}
+
+      /* Bad FDEs are skipped, like a linear search would.  */
+      struct dwarf_cie *cie = __libdw_find_cie (cache, entry.fde.CIE_pointer);
+      const uint8_t *p;
+      Dwarf_Addr start, end;
+      if (cie == NULL
+	  || read_fde_range (cache, cie, &entry.fde, &p, &start, &end) != 0)
+	continue;
+
+      if (index->n == alloc)
+	{
+	  alloc *= 2;
+	  struct dwarf_fde_index *new_index
+	    = realloc (index, sizeof *index + alloc * sizeof index->entries[0]);
+	  if (unlikely (new_index == NULL))
+	    goto nomem;
+	  index = new_index;
+	}
+      index->entries[index->n++] = (struct dwarf_fde_index_entry)
+	{
+	  .start = start,
+	  .end = end,
+	  .offset = last_offset,
+	  .fde = NULL
+	};
+    }
+  cache->next_offset = offset;
+
+  qsort (index->entries, index->n, sizeof index->entries[0],
+	 compare_fde_index);
+
+  /* FDEs overlapping each other are odd.  The one starting first keeps
+     its whole range, a later one only the part past it.  One entirely
+     covered by earlier ones is dropped.  */
+  size_t n = 0;
+  for (size_t i = 0; i < index->n; i++)
+    {
+      struct dwarf_fde_index_entry *entry = &index->entries[i];
+      if (n > 0 && entry->start < index->entries[n - 1].end)
+	{
+	  if (entry->end <= index->entries[n - 1].end)
+	    continue;
+	  entry->start = index->entries[n - 1].end;
+	}
+      index->entries[n++] = *entry;
+    }
+  index->n = n;
+
+  return index;
+
+ nomem:
+  free (index);
+  __libdw_seterrno (DWARF_E_NOMEM);
+  return NULL;
+}
+
+/* Look up ADDRESS in the sorted index of all FDEs.  */
+static struct dwarf_fde *
+index_find_fde (Dwarf_CFI *cache, Dwarf_Addr address)
+{
+  if (cache->fde_index == NULL)
+    {
+      cache->fde_index = build_fde_index (cache);
+      if (cache->fde_index == NULL)
+	return NULL;
+    }
+
+  struct dwarf_fde_index *index = cache->fde_index;
+  size_t l = 0, u = index->n;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      struct dwarf_fde_index_entry *entry = &index->entries[idx];
+      if (address < entry->start)
+	u = idx;
+      else if (address >= entry->end)
+	l = idx + 1;
+      else
+	{
+	  if (entry->fde == NULL)
+	    entry->fde = __libdw_fde_by_offset (cache, entry->offset);
+	  return entry->fde;
+	}
+    }
+
+  __libdw_seterrno (DWARF_E_NO_MATCH);
+  return NULL;
+}
+
+/* Use a binary search table in .eh_frame_hdr format, yield an FDE offset
+   and its index in the table.  */
 static Dwarf_Off
-binary_search_fde (Dwarf_CFI *cache, Dwarf_Addr address)
+binary_search_fde (Dwarf_CFI *cache, Dwarf_Addr address, size_t *idxp)
 {
   const size_t size = 2 * encoded_value_size (&cache->data->d, cache->e_ident,
 					      cache->search_table_encoding,
@@ -235,6 +345,7 @@ binary_search_fde (Dwarf_CFI *cache, Dwarf_Addr address)
 		continue;
 	    }
 
+	  *idxp = idx;
 	  return fde - cache->frame_vaddr;
 	}
     }
@@ -246,76 +357,45 @@ struct dwarf_fde *
 internal_function
 __libdw_find_fde (Dwarf_CFI *cache, Dwarf_Addr address)
 {
-  /* Look for a cached FDE covering this address.  */
+  /* Without .eh_frame_hdr binary search table use our own index.  */
+  if (cache->search_table == NULL)
+    return index_find_fde (cache, address);
 
-  const struct dwarf_fde fde_key = { .start = address, .end = 0 };
-  struct dwarf_fde **found = tfind (&fde_key, &cache->fde_tree, &compare_fde);
-  if (found != NULL)
-    return *found;
+  size_t idx;
+  Dwarf_Off offset = binary_search_fde (cache, address, &idx);
+  if (offset == (Dwarf_Off) -1l)
+    goto no_match;
 
-  /* Use .eh_frame_hdr binary search table if possible.  */
-  if (cache->search_table != NULL)
+  /* Look for the FDE already read for this table entry.  */
+  if (cache->search_table_fdes == NULL)
     {
-      Dwarf_Off offset = binary_search_fde (cache, address);
-      if (offset == (Dwarf_Off) -1l)
-	goto no_match;
-      struct dwarf_fde *fde = __libdw_fde_by_offset (cache, offset);
-      if (likely (fde != NULL))
+      cache->search_table_fdes = calloc (cache->search_table_entries,
+					 sizeof cache->search_table_fdes[0]);
+      if (unlikely (cache->search_table_fdes == NULL))
 	{
-	  /* Sanity check the address range.  */
-	  if (unlikely (address < fde->start))
-	    {
-	      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-	      return NULL;
-	    }
-	  /* .eh_frame_hdr does not indicate length covered by FDE.  */
-	  if (unlikely (address >= fde->end))
-	    goto no_match;
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return NULL;
 	}
-      return fde;
     }
-
-  /* It's not there.  Read more CFI entries until we find it.  */
-  while (1)
+  struct dwarf_fde *fde = cache->search_table_fdes[idx];
+  if (fde == NULL)
     {
-      Dwarf_Off last_offset = cache->next_offset;
-      Dwarf_CFI_Entry entry;
-      int result = INTUSE(dwarf_next_cfi) (cache->e_ident,
-					   &cache->data->d, CFI_IS_EH (cache),
-					   last_offset, &cache->next_offset,
-					   &entry);
-      if (result > 0)
-	break;
-      if (result < 0)
-	{
-	  if (cache->next_offset == last_offset)
-	    /* We couldn't progress past the bogus FDE.  */
-	    break;
-	  /* Skip the loser and look at the next entry.  */
-	  continue;
-	}
-
-      if (dwarf_cfi_cie_p (&entry))
-	{
-	  /* This is a CIE, not an FDE.  We eagerly intern these
-	     because the next FDE will usually refer to this CIE.  */
-	  __libdw_intern_cie (cache, last_offset, &entry.cie);
-	  continue;
-	}
-
-      /* We have a new FDE to consider.  */
-      struct dwarf_fde *fde = intern_fde (cache, &entry.fde);
-
-      if (fde == (void *) -1l)	/* Bad FDE, but we can keep looking.  */
-	continue;
-
-      if (fde == NULL)		/* Bad data.  */
+      fde = __libdw_fde_by_offset (cache, offset);
+      if (unlikely (fde == NULL))
 	return NULL;
+      cache->search_table_fdes[idx] = fde;
+    }
 
-      /* Is this the one we're looking for?  */
-      if (fde->start <= address && fde->end > address)
-	return fde;
+  /* Sanity check the address range.  */
+  if (unlikely (address < fde->start))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return NULL;
     }
+  /* .eh_frame_hdr does not indicate length covered by FDE.  */
+  if (unlikely (address >= fde->end))
+    goto no_match;
+  return fde;
 
  no_match:
   /* We found no FDE covering this address.  */
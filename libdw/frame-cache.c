@@ -45,8 +45,6 @@ free_cie (void *arg)
   free (cie);
 }
 
-#define free_fde	free
-
 static void
 free_expr (void *arg)
 {
@@ -60,8 +58,20 @@ void
 internal_function
 __libdw_destroy_frame_cache (Dwarf_CFI *cache)
 {
-  /* Most of the data is in our two search trees.  */
-  tdestroy (cache->fde_tree, free_fde);
+  if (cache->fde_index != NULL)
+    {
+      for (size_t i = 0; i < cache->fde_index->n; i++)
+	free (cache->fde_index->entries[i].fde);
+      free (cache->fde_index);
+    }
+  if (cache->search_table_fdes != NULL)
+    {
+      for (size_t i = 0; i < cache->search_table_entries; i++)
+	free (cache->search_table_fdes[i]);
+      free (cache->search_table_fdes);
+    }
+
+  /* Most of the data is in our search trees.  */
   tdestroy (cache->cie_tree, free_cie);
   tdestroy (cache->expr_tree, free_expr);
 
@@ -52,6 +52,13 @@ enum
 };
 
 
+/* Flags for dwarf_set_memory_hint.  */
+enum
+  {
+    DWARF_MEM_HUGEPAGES = 1	/* Back large blocks with huge pages.  */
+  };
+
+
 /* Error values.  */
 enum
   {
@@ -85,6 +92,9 @@ typedef struct Dwarf_Lines_s Dwarf_Lines;
 /* One source code line information.  */
 typedef struct Dwarf_Line_s Dwarf_Line;
 
+/* Source code line information for CU in a compact layout.  */
+typedef struct Dwarf_Line_Table_s Dwarf_Line_Table;
+
 /* Source file information.  */
 typedef struct Dwarf_Files_s Dwarf_Files;
 
@@ -143,6 +153,16 @@ typedef struct
 } Dwarf_Global;
 
 
+/* Entry of the .debug_names accelerated name index.  */
+typedef struct
+{
+  Dwarf_Off cu_offset;		/* Offset of the unit DIE.  */
+  Dwarf_Off die_offset;		/* Offset of the DIE.  */
+  const char *name;
+  unsigned int tag;		/* DW_TAG of the DIE.  */
+} Dwarf_Name;
+
+
 /* One operation in a DWARF location expression.
    A location expression is an array of these.  */
 typedef struct
@@ -623,6 +643,31 @@ extern ptrdiff_t dwarf_getpubnames (Dwarf *dbg,
      __nonnull_attribute__ (2);
 
 
+/* Call CALLBACK for all entries of the .debug_names name indexes.  The
+   DIE and unit offsets of the entries can be given to dwarf_offdie.
+   Entries for type units in a different (split) file are skipped.
+   Returns zero when all names have been visited, -1 on error (for
+   example when there is no .debug_names section) or, if the callback
+   returned DWARF_CB_ABORT, the OFFSET to continue with the next name.  */
+extern ptrdiff_t dwarf_getnames (Dwarf *dbg,
+				 int (*callback) (Dwarf *, Dwarf_Name *,
+						  void *),
+				 void *arg, ptrdiff_t offset)
+     __nonnull_attribute__ (2);
+
+/* Call CALLBACK for all entries of the .debug_names name indexes with
+   exactly NAME, using the hash tables.  Without .debug_names but with
+   a .gdb_index the DIEs named NAME are searched in the units the
+   .gdb_index lists for it (types only in type units are not found).
+   Returns 1 if NAME was found (even if the callback returned
+   DWARF_CB_ABORT), 0 if it wasn't and -1 on error.  */
+extern int dwarf_names_lookup (Dwarf *dbg, const char *name,
+			       int (*callback) (Dwarf *, Dwarf_Name *,
+						void *),
+			       void *arg)
+     __nonnull_attribute__ (2, 3);
+
+
 /* Get source file information for CU.  */
 extern int dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines,
 			      size_t *nlines) __nonnull_attribute__ (2, 3);
@@ -639,6 +684,55 @@ extern int dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files,
 /* Get source for address in CU.  */
 extern Dwarf_Line *dwarf_getsrc_die (Dwarf_Die *cudie, Dwarf_Addr addr);
 
+
+/* Flags of a Dwarf_Line_Row.  */
+enum
+  {
+    DWARF_LINE_IS_STMT = 1,
+    DWARF_LINE_BASIC_BLOCK = 2,
+    DWARF_LINE_END_SEQUENCE = 4,
+    DWARF_LINE_PROLOGUE_END = 8,
+    DWARF_LINE_EPILOGUE_BEGIN = 16
+  };
+
+/* One row of a Dwarf_Line_Table.  FILES and FILE can be passed to
+   dwarf_filesrc.  */
+typedef struct
+{
+  Dwarf_Addr addr;
+  Dwarf_Files *files;
+  unsigned int file;
+  int line;
+  unsigned int column;
+  unsigned int op_index;
+  unsigned int isa;
+  unsigned int discriminator;
+  unsigned int flags;
+} Dwarf_Line_Row;
+
+/* Get the source lines of the CU like dwarf_getsrclines, but in a
+   layout with all addresses in one dense array and the other row
+   attributes packed next to it.  The line program is decoded straight
+   into it, for very large line tables this takes much less memory than
+   dwarf_getsrclines and makes address lookups faster.  The rows are
+   sorted like the Dwarf_Lines.  */
+extern int dwarf_getlinetable (Dwarf_Die *cudie, Dwarf_Line_Table **table,
+			       size_t *nrows) __nonnull_attribute__ (2, 3);
+
+/* Return the sorted array of the addresses of all rows of TABLE.  */
+extern const Dwarf_Addr *dwarf_linetable_addrs (Dwarf_Line_Table *table);
+
+/* Fill in ROW with row IDX of TABLE.  */
+extern int dwarf_linetable_row (Dwarf_Line_Table *table, size_t idx,
+				Dwarf_Line_Row *row)
+     __nonnull_attribute__ (3);
+
+/* Return the index of the row describing ADDR, the last row at or
+   before ADDR unless that ends a sequence.  Returns -1 if there is no
+   such row.  */
+extern ptrdiff_t dwarf_linetable_lookup (Dwarf_Line_Table *table,
+					 Dwarf_Addr addr);
+
 /* Get source for file and line number.  */
 extern int dwarf_getsrc_file (Dwarf *dbg, const char *fname, int line, int col,
 			      Dwarf_Line ***srcsp, size_t *nsrcs)
@@ -835,6 +929,20 @@ extern int dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc,
    Returns -1 for errors or 0 if DIE is not found in any scope entry.  */
 extern int dwarf_getscopes_die (Dwarf_Die *die, Dwarf_Die **scopes);
 
+/* Return the function DIEs containing PC address, the chain of
+   DW_TAG_inlined_subroutine DIEs up to the DW_TAG_subprogram they are
+   inlined into.  Sets *SCOPES to a malloc'd array of Dwarf_Die
+   structures, and returns the number of elements in the array.
+   (*SCOPES)[0] is the innermost DW_TAG_subprogram, DW_TAG_inlined_subroutine
+   or DW_TAG_entry_point DIE containing PC, (*SCOPES)[1] the function DIE
+   containing that one, and so on up to the first DW_TAG_subprogram, as
+   dwarf_getscopes_die would return them without the other scopes.
+   The first call for a CU indexes the address ranges of all its function
+   DIEs, so later calls for any PC in it do not walk the DIE tree again.
+   Returns -1 for errors or 0 if no function contains PC.  */
+extern int dwarf_getinlinechain (Dwarf_Die *cudie, Dwarf_Addr pc,
+				 Dwarf_Die **scopes);
+
 
 /* Search SCOPES[0..NSCOPES-1] for a variable called NAME.
    Ignore the first SKIP_SHADOWS scopes that match the name.
@@ -1077,6 +1185,23 @@ extern const char *dwarf_errmsg (int err);
 /* Register new Out-Of-Memory handler.  The old handler is returned.  */
 extern Dwarf_OOM dwarf_new_oom_handler (Dwarf *dbg, Dwarf_OOM handler);
 
+/* Tell libdw how much memory DBG is expected to need for the data it
+   caches (abbrevs, line tables, location expressions, etc.).  Memory
+   blocks start small and double in size as more memory is needed.
+   SIZE sets the minimum size of the blocks allocated from now on (per
+   thread).  FLAGS is zero or DWARF_MEM_HUGEPAGES to advise the kernel
+   to use transparent huge pages for blocks that are big enough, if
+   supported.  Returns zero on success, -1 on error.  */
+extern int dwarf_set_memory_hint (Dwarf *dbg, size_t size,
+				  unsigned int flags);
+
+/* Get the memory statistics of DBG.  *RESERVED is set to the total size
+   of the memory blocks allocated (by all threads), *USED to the part of
+   it handed out.  While other threads use DBG the result is only an
+   approximation.  Either pointer can be NULL.  Returns zero on success,
+   -1 on error.  */
+extern int dwarf_memory_stats (Dwarf *dbg, size_t *reserved, size_t *used);
+
 
 /* Inline optimizations.  */
 #ifdef __OPTIMIZE__
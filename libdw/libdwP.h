@@ -64,6 +64,7 @@ struct files_lines_s
   Dwarf_Off debug_line_offset;
   Dwarf_Files *files;
   Dwarf_Lines *lines;
+  Dwarf_Line_Table *table;
 };
 
 /* Valid indeces for the section data.  */
@@ -80,6 +81,7 @@ enum
     IDX_debug_loc,
     IDX_debug_loclists,
     IDX_debug_pubnames,
+    IDX_debug_names,
     IDX_debug_str,
     IDX_debug_str_offsets,
     IDX_debug_macinfo,
@@ -87,6 +89,7 @@ enum
     IDX_debug_ranges,
     IDX_debug_rnglists,
     IDX_gnu_debugaltlink,
+    IDX_gdb_index,
     IDX_last
   };
 
@@ -142,11 +145,29 @@ enum
   DWARF_E_NOT_CUDIE,
   DWARF_E_UNKNOWN_LANGUAGE,
   DWARF_E_NO_DEBUG_ADDR,
+  DWARF_E_NO_DEBUG_NAMES,
 };
 
 
 #include "dwarf_sig8_hash.h"
 
+/* Units are always read in section order, so a table of known units
+   is kept sorted simply by appending to it.  Lookups use a binary
+   search over the contiguous START/END pairs, with a fast path for
+   the unit found last and the one directly following it.  */
+struct libdw_unit_table
+{
+  struct libdw_unit_entry
+  {
+    Dwarf_Off start;
+    Dwarf_Off end;
+    struct Dwarf_CU *cu;
+  } *entries;
+  size_t nentries;
+  size_t nalloc;
+  size_t last;
+};
+
 /* This is the structure representing the debugging state.  */
 struct Dwarf
 {
@@ -184,27 +205,58 @@ struct Dwarf
   } *pubnames_sets;
   size_t pubnames_nsets;
 
-  /* Search tree for the CUs.  */
-  void *cu_tree;
+  /* The parsed .debug_names name indexes, see dwarf_getnames.c.
+     Separately allocated with malloc.  */
+  struct libdw_names *names;
+
+  /* Table of the CUs read so far, sorted by offset.  */
+  struct libdw_unit_table cu_table;
   Dwarf_Off next_cu_offset;
 
-  /* Search tree and sig8 hash table for .debug_types type units.  */
-  void *tu_tree;
+  /* Table and sig8 hash table for .debug_types type units.  */
+  struct libdw_unit_table tu_table;
   Dwarf_Off next_tu_offset;
   Dwarf_Sig8_Hash sig8_hash;
 
-  /* Search tree for split Dwarf associated with CUs in this debug.  */
+  /* Protects the unit tables, their next offsets and sig8_hash.  */
+  rwlock_define (, units_lock);
+
+  /* Search tree for split Dwarf associated with CUs in this debug.
+     Protected by split_lock, which also guards the split field of the
+     CUs while searching for the split unit.  */
   void *split_tree;
+  rwlock_define (, split_lock);
 
   /* Search tree for .debug_macro operator tables.  */
   void *macro_ops;
+  rwlock_define (, macro_lock);
 
   /* Search tree for decoded .debug_line units.  */
   void *files_lines;
+  rwlock_define (, lines_lock);
+
+  /* Protects publishing the lazily created aranges, pubnames_sets,
+     names, cfi and alt_dwarf.  Readers check the pointers with an
+     acquire load first and only take the lock if they are not set.  */
+  rwlock_define (, cache_lock);
 
   /* Address ranges.  */
   Dwarf_Aranges *aranges;
 
+  /* Address ranges synthesized from the unit DIEs when there is no
+     .debug_aranges, see dwarf_getaranges.c.  SYNTH_ARANGES is malloced
+     with room for SYNTH_ALLOC entries and holds the sorted ranges of
+     the units before SYNTH_NEXT.  Protected by aranges_lock.  */
+  Dwarf_Aranges *synth_aranges;
+  size_t synth_alloc;
+  Dwarf_Off synth_next;
+  rwlock_define (, aranges_lock);
+
+  /* The aranges plus the ranges of the units .debug_aranges leaves out,
+     for looking up addresses.  Same as ARANGES if there are none.
+     Published with a release store under aranges_lock.  */
+  Dwarf_Aranges *complete_aranges;
+
   /* Cached info from the CFI section.  */
   struct Dwarf_CFI_s *cfi;
 
@@ -220,18 +272,40 @@ struct Dwarf
 
   /* Internal memory handling.  This is basically a simplified
      reimplementation of obstacks.  Unfortunately the standard obstack
-     implementation is not usable in libraries.  */
-  struct libdw_memblock
+     implementation is not usable in libraries.  Each thread allocates
+     from its own chain of blocks, so concurrent readers don't contend
+     on a single tail.  The chain of a thread that exited is taken over
+     by the next thread that needs one.  mem_rwl protects the mem_tails
+     list and the owners, not the blocks.  */
+  struct libdw_memtail
   {
-    size_t size;
-    size_t remaining;
-    struct libdw_memblock *prev;
-    char mem[0];
-  } *mem_tail;
-
-  /* Default size of allocated memory blocks.  */
+    /* Only changed by the owner, published with a release store.
+       remaining changes afterwards, the owner stores it atomically so
+       dwarf_memory_stats can read it from another thread.  */
+    struct libdw_memblock
+    {
+      size_t size;
+      size_t remaining;
+      struct libdw_memblock *prev;
+      char mem[0];
+    } *tail;
+    struct libdw_thread *owner;
+    struct libdw_memtail *next;
+  } *mem_tails;
+  rwlock_define (, mem_rwl);
+
+  /* Unique for each Dwarf, tells the per thread caches of chains apart
+     from those of an earlier Dwarf at the same address.  */
+  uint64_t mem_serial;
+
+  /* Minimum size of allocated memory blocks.  Each new block of a
+     thread is twice as big as the previous one, up to the larger of
+     mem_default_size and MEM_MAX_GROWTH_SIZE.  */
   size_t mem_default_size;
 
+  /* Whether large blocks should use transparent huge pages.  */
+  bool mem_hugepages;
+
   /* Registered OOM handler.  */
   Dwarf_OOM oom_handler;
 };
@@ -265,6 +339,9 @@ struct Dwarf_Files_s
   };
 typedef struct Dwarf_Fileinfo_s Dwarf_Fileinfo;
 
+/* Function DIEs indexed by address, see dwarf_getinlinechain.c.  */
+typedef struct Dwarf_Inlines_s Dwarf_Inlines;
+
 
 /* Representation of a row in the line table.  */
 
@@ -295,6 +372,34 @@ struct Dwarf_Lines_s
   struct Dwarf_Line_s info[0];
 };
 
+/* The attributes of a row of a Dwarf_Line_Table.  Like Dwarf_Line,
+   but without the address and files, packed into 16 bytes.  */
+struct Dwarf_Line_Attr_s
+{
+  unsigned int file;
+  int line;
+  unsigned short int column;
+  unsigned int is_stmt:1;
+  unsigned int basic_block:1;
+  unsigned int end_sequence:1;
+  unsigned int prologue_end:1;
+  unsigned int epilogue_begin:1;
+  unsigned int op_index:8;
+  unsigned int isa:8;
+  unsigned int discriminator:24;
+};
+
+/* The rows of a line table sorted like Dwarf_Lines, but with the
+   addresses in their own dense array to keep searches compact.  Both
+   arrays are malloced.  */
+struct Dwarf_Line_Table_s
+{
+  Dwarf_Files *files;
+  size_t nrows;
+  Dwarf_Addr *addrs;
+  struct Dwarf_Line_Attr_s *attrs;
+};
+
 /* Representation of address ranges.  */
 struct Dwarf_Aranges_s
 {
@@ -344,16 +449,28 @@ struct Dwarf_CU
   size_t orig_abbrev_offset;
   /* Offset past last read abbreviation.  */
   size_t last_abbrev_offset;
+  /* Protects abbrev_hash and last_abbrev_offset.  */
+  rwlock_define (, abbrev_lock);
 
   /* The srcline information.  */
   Dwarf_Lines *lines;
 
+  /* The same in the compact layout, see dwarf_getlinetable.  */
+  Dwarf_Line_Table *linetable;
+
   /* The source file information.  */
   Dwarf_Files *files;
 
+  /* Index of the function DIEs, see dwarf_getinlinechain.  */
+  Dwarf_Inlines *inlines;
+
   /* Known location lists.  */
   void *locs;
 
+  /* Protects locs and setting lines and files.  Once set lines and
+     files don't change and can be read without taking the lock.  */
+  rwlock_define (, lock);
+
   /* Base address for use with ranges and locs.
      Don't access directly, call __libdw_cu_base_address.  */
   Dwarf_Addr base_address;
@@ -570,9 +687,10 @@ libdw_valid_user_form (int form)
 extern void __libdw_seterrno (int value) internal_function;
 
 
-/* Memory handling, the easy parts.  This macro does not do any locking.  */
+/* Memory handling, the easy parts.  This macro does not do any locking,
+   the tail returned by __libdw_alloc_tail belongs to the calling thread.  */
 #define libdw_alloc(dbg, type, tsize, cnt) \
-  ({ struct libdw_memblock *_tail = (dbg)->mem_tail;			      \
+  ({ struct libdw_memblock *_tail = __libdw_alloc_tail (dbg);		      \
      size_t _required = (tsize) * (cnt);				      \
      type *_result = (type *) (_tail->mem + (_tail->size - _tail->remaining));\
      size_t _padding = ((__alignof (type)				      \
@@ -584,13 +702,57 @@ extern void __libdw_seterrno (int value) internal_function;
        {								      \
 	 _required += _padding;						      \
 	 _result = (type *) ((char *) _result + _padding);		      \
-	 _tail->remaining -= _required;					      \
+	 __atomic_store_n (&_tail->remaining, _tail->remaining - _required,   \
+			   __ATOMIC_RELAXED);				      \
        }								      \
      _result; })
 
 #define libdw_typed_alloc(dbg, type) \
   libdw_alloc (dbg, type, sizeof (type), 1)
 
+/* Free the parsed .debug_names indexes.  */
+extern void __libdw_names_free (struct libdw_names *names)
+     internal_function;
+
+/* Find the unit DIE offset for ADDR.  Without .debug_aranges only
+   reads as many units as needed.  Returns 0 if found, 1 if not and -1
+   on error.  */
+extern int __libdw_findarange (Dwarf *dbg, Dwarf_Addr addr, Dwarf_Off *offp)
+     internal_function;
+
+/* Like dwarf_getaranges, but with the ranges of the units that have
+   no .debug_aranges entries added from their unit DIEs.  */
+extern int __libdw_getaranges_complete (Dwarf *dbg, Dwarf_Aranges **aranges)
+     internal_function;
+
+/* Build the address ranges from the address area of the .gdb_index.
+   Sets *ARANGES to NULL if there is no (usable) .gdb_index.  Returns
+   -1 if it is corrupt, zero otherwise.  */
+extern int __libdw_gdb_index_aranges (Dwarf *dbg, Dwarf_Aranges **aranges,
+				      size_t *naranges)
+     internal_function;
+
+/* Look up NAME in the .gdb_index symbol table and call CALLBACK for
+   each matching DIE in the units it lists.  Returns like
+   dwarf_names_lookup.  */
+extern int __libdw_gdb_index_lookup (Dwarf *dbg, const char *name,
+				     int (*callback) (Dwarf *, Dwarf_Name *,
+						      void *),
+				     void *arg)
+     internal_function;
+
+/* Get the memory block the calling thread allocates from.  */
+extern struct libdw_memblock *__libdw_alloc_tail (Dwarf *dbg)
+     __nonnull_attribute__ (1) attribute_hidden;
+
+/* Set up the memory handling of a new Dwarf.  */
+extern void __libdw_mem_init (Dwarf *dbg)
+     __nonnull_attribute__ (1) attribute_hidden;
+
+/* Free all memory blocks of DBG.  */
+extern void __libdw_mem_free (Dwarf *dbg)
+     __nonnull_attribute__ (1) attribute_hidden;
+
 /* Callback to allocate more.  */
 extern void *__libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
      __attribute__ ((__malloc__)) __nonnull_attribute__ (1);
@@ -610,7 +772,8 @@ __libdw_next_unit (Dwarf *dbg, bool v4_debug_types, Dwarf_Off off,
 		   Dwarf_Off *subdie_offsetp)
      __nonnull_attribute__ (4) internal_function;
 
-/* Allocate the internal data for a unit not seen before.  */
+/* Allocate the internal data for a unit not seen before.  The caller
+   must hold the units_lock for writing.  */
 extern struct Dwarf_CU *__libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
      __nonnull_attribute__ (1) internal_function;
 
@@ -635,7 +798,8 @@ extern Dwarf_Abbrev *__libdw_findabbrev (struct Dwarf_CU *cu,
 					 unsigned int code)
      __nonnull_attribute__ (1) internal_function;
 
-/* Get abbreviation at given offset.  */
+/* Get abbreviation at given offset.  If CU is not NULL the caller must
+   hold its abbrev_lock for writing.  */
 extern Dwarf_Abbrev *__libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu,
 					Dwarf_Off offset, size_t *lengthp,
 					Dwarf_Abbrev *result)
@@ -962,6 +1126,22 @@ int __libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
   internal_function
   __nonnull_attribute__ (1);
 
+/* Like __libdw_getsrclines, but gets the line table in the compact
+   layout.  */
+int __libdw_getlinetable (Dwarf *dbg, Dwarf_Off debug_line_offset,
+			  const char *comp_dir, unsigned address_size,
+			  Dwarf_Line_Table **tablep)
+  internal_function
+  __nonnull_attribute__ (1, 5);
+
+/* Free a Dwarf_Line_Table and its arrays.  */
+void __libdw_linetable_free (Dwarf_Line_Table *table)
+  internal_function;
+
+/* Free the function index built by dwarf_getinlinechain.  */
+void __libdw_inlines_free (Dwarf_Inlines *inlines)
+  internal_function;
+
 /* Load and return value of DW_AT_comp_dir from CUDIE.  */
 const char *__libdw_getcompdir (Dwarf_Die *cudie);
 
@@ -1276,7 +1456,6 @@ int __libdw_finddbg_cb (const void *arg1, const void *arg2);
 static inline void
 __libdw_link_skel_split (Dwarf_CU *skel, Dwarf_CU *split)
 {
-  skel->split = split;
   split->split = skel;
 
   /* Get .debug_addr and addr_base greedy.
@@ -1292,6 +1471,9 @@ __libdw_link_skel_split (Dwarf_CU *skel, Dwarf_CU *split)
       split->addr_base = __libdw_cu_addr_base (skel);
       sdbg->fake_addr_cu = dbg->fake_addr_cu;
     }
+
+  /* Publish last, __libdw_find_split_unit reads this without locking.  */
+  __atomic_store_n (&skel->split, split, __ATOMIC_RELEASE);
 }
 
 
@@ -1338,6 +1520,7 @@ INTDECL (dwarf_entrypc)
 INTDECL (dwarf_errmsg)
 INTDECL (dwarf_formaddr)
 INTDECL (dwarf_formblock)
+INTDECL (dwarf_formflag)
 INTDECL (dwarf_formref_die)
 INTDECL (dwarf_formsdata)
 INTDECL (dwarf_formstring)
@@ -1350,6 +1533,7 @@ INTDECL (dwarf_getaranges)
 INTDECL (dwarf_getlocation_die)
 INTDECL (dwarf_getsrcfiles)
 INTDECL (dwarf_getsrclines)
+INTDECL (dwarf_getlinetable)
 INTDECL (dwarf_hasattr)
 INTDECL (dwarf_haschildren)
 INTDECL (dwarf_haspc)
@@ -32,32 +32,314 @@
 #endif
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "libdwP.h"
 #include "system.h"
 
 
+/* Blocks stop growing geometrically at this size, unless a larger
+   size was requested with dwarf_set_memory_hint.  */
+#define MEM_MAX_GROWTH_SIZE (4 * 1024 * 1024)
+
+/* Blocks at least this big are backed by (and aligned to) transparent
+   huge pages when requested.  */
+#define MEM_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/* A thread that allocated from some Dwarf.  The chains of blocks it
+   owns refer to it, so they can be taken over once it exited.  */
+struct libdw_thread
+{
+  /* Set when the thread exits.  */
+  bool exited;
+  /* One for the running thread and one for each chain it owns.  */
+  unsigned int refs;
+};
+
+static __thread struct libdw_thread *self;
+
+/* The chains this thread used recently, by Dwarf, so finding the own
+   chain takes no lock.  */
+#define TAIL_CACHE_SIZE 8
+static __thread struct
+{
+  Dwarf *dbg;
+  uint64_t serial;
+  struct libdw_memtail *mt;
+} tail_cache[TAIL_CACHE_SIZE];
+
+static uint64_t next_serial = 1;
+
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_key;
+static bool thread_key_valid;
+
+static void
+thread_unref (struct libdw_thread *t)
+{
+  if (__atomic_sub_fetch (&t->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    free (t);
+}
+
+/* Called when a thread exits.  From now on other threads can take
+   over its chains.  */
+static void
+thread_exit (void *arg)
+{
+  struct libdw_thread *t = arg;
+  memset (tail_cache, '\0', sizeof tail_cache);
+  self = NULL;
+  __atomic_store_n (&t->exited, true, __ATOMIC_RELEASE);
+  thread_unref (t);
+}
+
+static void
+thread_key_init (void)
+{
+  thread_key_valid = pthread_key_create (&thread_key, thread_exit) == 0;
+}
+
+/* Without the key the chains of the thread are just never taken
+   over.  */
+static struct libdw_thread *
+thread_self (void)
+{
+  if (self == NULL)
+    {
+      struct libdw_thread *t = malloc (sizeof *t);
+      if (t == NULL)
+	return NULL;
+      t->exited = false;
+      t->refs = 1;
+      pthread_once (&thread_key_once, thread_key_init);
+      if (thread_key_valid && pthread_setspecific (thread_key, t) != 0)
+	{
+	  free (t);
+	  return NULL;
+	}
+      self = t;
+    }
+  return self;
+}
+
+/* Allocate a new memory block of SIZE bytes (including the header).
+   Calls the OOM handler on failure.  */
+static struct libdw_memblock *
+new_block (Dwarf *dbg, size_t size)
+{
+  struct libdw_memblock *newp = NULL;
+
+#ifdef MADV_HUGEPAGE
+  if (__atomic_load_n (&dbg->mem_hugepages, __ATOMIC_RELAXED)
+      && size >= MEM_HUGEPAGE_SIZE)
+    {
+      size = (size + MEM_HUGEPAGE_SIZE - 1) & ~(MEM_HUGEPAGE_SIZE - 1);
+      void *mem;
+      if (posix_memalign (&mem, MEM_HUGEPAGE_SIZE, size) == 0)
+	{
+	  /* Just advice, if the kernel cannot do it we still have
+	     the memory.  */
+	  (void) madvise (mem, size, MADV_HUGEPAGE);
+	  newp = mem;
+	}
+    }
+  else
+#endif
+    newp = malloc (size);
+
+  if (unlikely (newp == NULL))
+    dbg->oom_handler ();
+
+  newp->size = size - offsetof (struct libdw_memblock, mem);
+  newp->remaining = newp->size;
+  newp->prev = NULL;
+  return newp;
+}
+
+/* Find the chain of the calling thread in DBG, or give it one, either
+   of a thread that exited or a new one.  */
+static struct libdw_memtail *
+find_tail (Dwarf *dbg)
+{
+  struct libdw_thread *me = thread_self ();
+  if (unlikely (me == NULL))
+    dbg->oom_handler ();
+
+  struct libdw_memtail *mt;
+  rwlock_rdlock (dbg->mem_rwl);
+  for (mt = dbg->mem_tails; mt != NULL; mt = mt->next)
+    if (mt->owner == me)
+      break;
+  rwlock_unlock (dbg->mem_rwl);
+
+  if (mt == NULL)
+    {
+      rwlock_wrlock (dbg->mem_rwl);
+      for (mt = dbg->mem_tails; mt != NULL; mt = mt->next)
+	if (__atomic_load_n (&mt->owner->exited, __ATOMIC_ACQUIRE))
+	  break;
+      if (mt != NULL)
+	thread_unref (mt->owner);
+      else
+	{
+	  mt = malloc (sizeof *mt);
+	  if (unlikely (mt == NULL))
+	    {
+	      rwlock_unlock (dbg->mem_rwl);
+	      dbg->oom_handler ();
+	    }
+	  mt->tail = NULL;
+	  mt->next = dbg->mem_tails;
+	  dbg->mem_tails = mt;
+	}
+      __atomic_add_fetch (&me->refs, 1, __ATOMIC_RELAXED);
+      mt->owner = me;
+      rwlock_unlock (dbg->mem_rwl);
+    }
+
+  size_t h = ((uintptr_t) dbg / sizeof (void *)) % TAIL_CACHE_SIZE;
+  tail_cache[h].dbg = dbg;
+  tail_cache[h].serial = dbg->mem_serial;
+  tail_cache[h].mt = mt;
+  return mt;
+}
+
+static inline struct libdw_memtail *
+get_tail (Dwarf *dbg)
+{
+  size_t h = ((uintptr_t) dbg / sizeof (void *)) % TAIL_CACHE_SIZE;
+  if (likely (tail_cache[h].dbg == dbg
+	      && tail_cache[h].serial == dbg->mem_serial))
+    return tail_cache[h].mt;
+  return find_tail (dbg);
+}
+
+struct libdw_memblock *
+__libdw_alloc_tail (Dwarf *dbg)
+{
+  struct libdw_memtail *mt = get_tail (dbg);
+  if (unlikely (mt->tail == NULL))
+    __atomic_store_n (&mt->tail,
+		      new_block (dbg, __atomic_load_n (&dbg->mem_default_size,
+						       __ATOMIC_RELAXED)),
+		      __ATOMIC_RELEASE);
+  return mt->tail;
+}
+
 void *
 __libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
 {
-  size_t size = MAX (dbg->mem_default_size,
-		     (align - 1 +
-		      2 * minsize + offsetof (struct libdw_memblock, mem)));
-  struct libdw_memblock *newp = malloc (size);
-  if (newp == NULL)
-    dbg->oom_handler ();
+  struct libdw_memtail *mt = get_tail (dbg);
+  struct libdw_memblock *tail = mt->tail;
 
-  uintptr_t result = ((uintptr_t) newp->mem + align - 1) & ~(align - 1);
+  /* Double the block size each time, so a big DWARF file needs only
+     a few mallocs.  Large requests get a block of their own size.  */
+  size_t default_size = __atomic_load_n (&dbg->mem_default_size,
+					 __ATOMIC_RELAXED);
+  size_t size = MAX (default_size,
+		     MIN (2 * (tail->size + offsetof (struct libdw_memblock,
+						      mem)),
+			  MAX (default_size, MEM_MAX_GROWTH_SIZE)));
+  size = MAX (size, (align - 1 + minsize
+		     + offsetof (struct libdw_memblock, mem)));
+  struct libdw_memblock *newp = new_block (dbg, size);
 
-  newp->size = size - offsetof (struct libdw_memblock, mem);
-  newp->remaining = (uintptr_t) newp + size - (result + minsize);
+  uintptr_t result = ((uintptr_t) newp->mem + align - 1) & ~(align - 1);
+  newp->remaining = (uintptr_t) newp->mem + newp->size - (result + minsize);
 
-  newp->prev = dbg->mem_tail;
-  dbg->mem_tail = newp;
+  newp->prev = tail;
+  __atomic_store_n (&mt->tail, newp, __ATOMIC_RELEASE);
 
   return (void *) result;
 }
 
+void
+__libdw_mem_init (Dwarf *dbg)
+{
+  dbg->mem_tails = NULL;
+  dbg->mem_serial = __atomic_fetch_add (&next_serial, 1, __ATOMIC_RELAXED);
+  rwlock_init (dbg->mem_rwl);
+}
+
+void
+__libdw_mem_free (Dwarf *dbg)
+{
+  struct libdw_memtail *mt = dbg->mem_tails;
+  while (mt != NULL)
+    {
+      struct libdw_memblock *memp = mt->tail;
+      while (memp != NULL)
+	{
+	  struct libdw_memblock *prevp = memp->prev;
+	  free (memp);
+	  memp = prevp;
+	}
+      thread_unref (mt->owner);
+
+      struct libdw_memtail *next = mt->next;
+      free (mt);
+      mt = next;
+    }
+  rwlock_fini (dbg->mem_rwl);
+}
+
+
+int
+dwarf_set_memory_hint (Dwarf *dbg, size_t size, unsigned int flags)
+{
+  if (dbg == NULL)
+    return -1;
+
+  if (unlikely ((flags & ~DWARF_MEM_HUGEPAGES) != 0))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_CMD);
+      return -1;
+    }
+
+  /* Never go below the default from dwarf_begin.  */
+  size_t min_size = sysconf (_SC_PAGESIZE) - 4 * sizeof (void *);
+
+  /* Threads allocating meanwhile use either the old or new values.  */
+  __atomic_store_n (&dbg->mem_default_size, MAX (size, min_size),
+		    __ATOMIC_RELAXED);
+  __atomic_store_n (&dbg->mem_hugepages,
+		    (flags & DWARF_MEM_HUGEPAGES) != 0, __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+
+int
+dwarf_memory_stats (Dwarf *dbg, size_t *reserved, size_t *used)
+{
+  if (dbg == NULL)
+    return -1;
+
+  size_t total = 0;
+  size_t remaining = 0;
+  rwlock_rdlock (dbg->mem_rwl);
+  for (struct libdw_memtail *mt = dbg->mem_tails; mt != NULL; mt = mt->next)
+    for (struct libdw_memblock *memp = __atomic_load_n (&mt->tail,
+							__ATOMIC_ACQUIRE);
+	 memp != NULL; memp = memp->prev)
+      {
+	/* The owners keep allocating meanwhile.  */
+	total += (__atomic_load_n (&memp->size, __ATOMIC_RELAXED)
+		  + offsetof (struct libdw_memblock, mem));
+	remaining += __atomic_load_n (&memp->remaining, __ATOMIC_RELAXED);
+      }
+  rwlock_unlock (dbg->mem_rwl);
+
+  if (reserved != NULL)
+    *reserved = total;
+  if (used != NULL)
+    *used = total - remaining;
+  return 0;
+}
+
 
 Dwarf_OOM
 dwarf_new_oom_handler (Dwarf *dbg, Dwarf_OOM handler)
@@ -42,6 +42,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+/* Called with the split_lock of the skeleton's Dwarf held for writing.  */
 void
 try_split_file (Dwarf_CU *cu, const char *dwo_path)
 {
@@ -91,8 +92,19 @@ internal_function
 __libdw_find_split_unit (Dwarf_CU *cu)
 {
   /* Only try once.  */
+  Dwarf_CU *split = __atomic_load_n (&cu->split, __ATOMIC_ACQUIRE);
+  if (split != (Dwarf_CU *) -1)
+    return split;
+
+  /* The split_lock protects the split_tree and makes sure only one
+     thread opens the dwo file for this skeleton.  */
+  rwlock_wrlock (cu->dbg->split_lock);
   if (cu->split != (Dwarf_CU *) -1)
-    return cu->split;
+    {
+      split = cu->split;
+      rwlock_unlock (cu->dbg->split_lock);
+      return split;
+    }
 
   /* We need a skeleton unit with a comp_dir and [GNU_]dwo_name attributes.
      The split unit will be the first in the dwo file and should have the
@@ -141,7 +153,9 @@ __libdw_find_split_unit (Dwarf_CU *cu)
 
   /* If we found nothing, make sure we don't try again.  */
   if (cu->split == (Dwarf_CU *) -1)
-    cu->split = NULL;
+    __atomic_store_n (&cu->split, NULL, __ATOMIC_RELEASE);
 
-  return cu->split;
+  split = cu->split;
+  rwlock_unlock (cu->dbg->split_lock);
+  return split;
 }
@@ -33,32 +33,68 @@
 
 #include <assert.h>
 #include <search.h>
+#include <stdlib.h>
 #include "libdwP.h"
 
-static int
-findcu_cb (const void *arg1, const void *arg2)
+/* Make sure there is room for one more entry in TABLE.  */
+static bool
+unit_table_reserve (struct libdw_unit_table *table)
 {
-  struct Dwarf_CU *cu1 = (struct Dwarf_CU *) arg1;
-  struct Dwarf_CU *cu2 = (struct Dwarf_CU *) arg2;
+  if (table->nentries < table->nalloc)
+    return true;
+
+  size_t nalloc = table->nalloc == 0 ? 16 : 2 * table->nalloc;
+  struct libdw_unit_entry *entries
+    = realloc (table->entries, nalloc * sizeof (struct libdw_unit_entry));
+  if (entries == NULL)
+    return false;
+
+  table->entries = entries;
+  table->nalloc = nalloc;
+  return true;
+}
 
-  /* Find out which of the two arguments is the search value.  It has
-     end offset 0.  */
-  if (cu1->end == 0)
+/* Find the unit in TABLE containing OFFSET.  The caller must hold the
+   units_lock, at least for reading.  The last hint is only updated
+   atomically since concurrent readers might race to set it.  */
+static struct Dwarf_CU *
+unit_table_find (struct libdw_unit_table *table, Dwarf_Off offset)
+{
+  const struct libdw_unit_entry *entries = table->entries;
+  size_t n = table->nentries;
+
+  /* Most lookups are for the unit found last, or for the next one
+     when iterating over all units.  */
+  size_t idx = __atomic_load_n (&table->last, __ATOMIC_RELAXED);
+  if (likely (idx < n))
     {
-      if (cu1->start < cu2->start)
-	return -1;
-      if (cu1->start >= cu2->end)
-	return 1;
+      if (offset >= entries[idx].start && offset < entries[idx].end)
+	return entries[idx].cu;
+      if (idx + 1 < n
+	  && offset >= entries[idx + 1].start && offset < entries[idx + 1].end)
+	{
+	  __atomic_store_n (&table->last, idx + 1, __ATOMIC_RELAXED);
+	  return entries[idx + 1].cu;
+	}
     }
-  else
+
+  size_t l = 0;
+  size_t u = n;
+  while (l < u)
     {
-      if (cu2->start < cu1->start)
-	return 1;
-      if (cu2->start >= cu1->end)
-	return -1;
+      idx = (l + u) / 2;
+      if (offset < entries[idx].start)
+	u = idx;
+      else if (offset >= entries[idx].end)
+	l = idx + 1;
+      else
+	{
+	  __atomic_store_n (&table->last, idx, __ATOMIC_RELAXED);
+	  return entries[idx].cu;
+	}
     }
 
-  return 0;
+  return NULL;
 }
 
 int
@@ -101,7 +137,8 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
 {
   Dwarf_Off *const offsetp
     = debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
-  void **tree = debug_types ? &dbg->tu_tree : &dbg->cu_tree;
+  struct libdw_unit_table *table
+    = debug_types ? &dbg->tu_table : &dbg->cu_table;
 
   Dwarf_Off oldoff = *offsetp;
   uint16_t version;
@@ -137,6 +174,14 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   if (unlikely (offset_size != 4 && offset_size != 8))
     offset_size = 8;
 
+  /* Make sure we can record the new unit before creating it.  */
+  if (unlikely (! unit_table_reserve (table)))
+    {
+      *offsetp = oldoff;
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
   /* Invalid or truncated debug section data?  */
   size_t sec_idx = debug_types ? IDX_debug_types : IDX_debug_info;
   Elf_Data *data = dbg->sectiondata[sec_idx];
@@ -156,9 +201,13 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   newp->unit_id8 = unit_id8;
   newp->subdie_offset = subdie_offset;
   Dwarf_Abbrev_Hash_init (&newp->abbrev_hash, 41);
+  rwlock_init (newp->abbrev_lock);
+  rwlock_init (newp->lock);
   newp->orig_abbrev_offset = newp->last_abbrev_offset = abbrev_offset;
   newp->files = NULL;
   newp->lines = NULL;
+  newp->linetable = NULL;
+  newp->inlines = NULL;
   newp->locs = NULL;
   newp->split = (Dwarf_CU *) -1;
   newp->base_address = (Dwarf_Addr) -1;
@@ -212,14 +261,16 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   if (unit_type == DW_UT_type || unit_type == DW_UT_split_type)
     Dwarf_Sig8_Hash_insert (&dbg->sig8_hash, unit_id8, newp);
 
-  /* Add the new entry to the search tree.  */
-  if (tsearch (newp, tree, findcu_cb) == NULL)
+  /* Add the new entry to the table.  Units are read in order, so
+     this keeps the table sorted.  */
+  assert (table->nentries == 0
+	  || table->entries[table->nentries - 1].end <= newp->start);
+  table->entries[table->nentries++] = (struct libdw_unit_entry)
     {
-      /* Something went wrong.  Undo the operation.  */
-      *offsetp = oldoff;
-      __libdw_seterrno (DWARF_E_NOMEM);
-      return NULL;
-    }
+      .start = newp->start,
+      .end = newp->end,
+      .cu = newp
+    };
 
   return newp;
 }
@@ -228,47 +279,58 @@ struct Dwarf_CU *
 internal_function
 __libdw_findcu (Dwarf *dbg, Dwarf_Off start, bool v4_debug_types)
 {
-  void **tree = v4_debug_types ? &dbg->tu_tree : &dbg->cu_tree;
+  struct libdw_unit_table *table
+    = v4_debug_types ? &dbg->tu_table : &dbg->cu_table;
   Dwarf_Off *next_offset
     = v4_debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
 
   /* Maybe we already know that CU.  */
-  struct Dwarf_CU fake = { .start = start, .end = 0 };
-  struct Dwarf_CU **found = tfind (&fake, tree, findcu_cb);
+  rwlock_rdlock (dbg->units_lock);
+  struct Dwarf_CU *found = unit_table_find (table, start);
+  rwlock_unlock (dbg->units_lock);
   if (found != NULL)
-    return *found;
+    return found;
 
-  if (start < *next_offset)
+  /* No.  Then read more CUs.  Another thread might have done so
+     while we didn't hold the lock, so check again.  */
+  rwlock_wrlock (dbg->units_lock);
+  found = unit_table_find (table, start);
+  if (found == NULL)
     {
-      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-      return NULL;
+      if (start < *next_offset)
+	__libdw_seterrno (DWARF_E_INVALID_DWARF);
+      else
+	while (1)
+	  {
+	    struct Dwarf_CU *newp = __libdw_intern_next_unit (dbg,
+							      v4_debug_types);
+	    if (newp == NULL)
+	      break;
+
+	    /* Is this the one we are looking for?  */
+	    if (start < *next_offset || start == newp->start)
+	      {
+		found = newp;
+		break;
+	      }
+	  }
     }
+  rwlock_unlock (dbg->units_lock);
 
-  /* No.  Then read more CUs.  */
-  while (1)
-    {
-      struct Dwarf_CU *newp = __libdw_intern_next_unit (dbg, v4_debug_types);
-      if (newp == NULL)
-	return NULL;
-
-      /* Is this the one we are looking for?  */
-      if (start < *next_offset || start == newp->start)
-	return newp;
-    }
-  /* NOTREACHED */
+  return found;
 }
 
 struct Dwarf_CU *
 internal_function
 __libdw_findcu_addr (Dwarf *dbg, void *addr)
 {
-  void **tree;
+  struct libdw_unit_table *table;
   Dwarf_Off start;
   if (addr >= dbg->sectiondata[IDX_debug_info]->d_buf
       && addr < (dbg->sectiondata[IDX_debug_info]->d_buf
 		 + dbg->sectiondata[IDX_debug_info]->d_size))
     {
-      tree = &dbg->cu_tree;
+      table = &dbg->cu_table;
       start = addr - dbg->sectiondata[IDX_debug_info]->d_buf;
     }
   else if (dbg->sectiondata[IDX_debug_types] != NULL
@@ -276,19 +338,17 @@ __libdw_findcu_addr (Dwarf *dbg, void *addr)
 	   && addr < (dbg->sectiondata[IDX_debug_types]->d_buf
 		      + dbg->sectiondata[IDX_debug_types]->d_size))
     {
-      tree = &dbg->tu_tree;
+      table = &dbg->tu_table;
       start = addr - dbg->sectiondata[IDX_debug_types]->d_buf;
     }
   else
     return NULL;
 
-  struct Dwarf_CU fake = { .start = start, .end = 0 };
-  struct Dwarf_CU **found = tfind (&fake, tree, findcu_cb);
+  rwlock_rdlock (dbg->units_lock);
+  struct Dwarf_CU *found = unit_table_find (table, start);
+  rwlock_unlock (dbg->units_lock);
 
-  if (found != NULL)
-    return *found;
-
-  return NULL;
+  return found;
 }
 
 Dwarf *
@@ -298,7 +358,9 @@ __libdw_find_split_dbg_addr (Dwarf *dbg, void *addr)
   /* XXX Assumes split DWARF only has CUs in main IDX_debug_info.  */
   Elf_Data fake_data = { .d_buf = addr, .d_size = 0 };
   Dwarf fake = { .sectiondata[IDX_debug_info] = &fake_data };
+  rwlock_rdlock (dbg->split_lock);
   Dwarf **found = tfind (&fake, &dbg->split_tree, __libdw_finddbg_cb);
+  rwlock_unlock (dbg->split_lock);
 
   if (found != NULL)
     return *found;
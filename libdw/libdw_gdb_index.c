@@ -0,0 +1,422 @@
+/* Use the .gdb_index section to find units by address or name.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libdwP.h"
+
+
+/* The parts of the .gdb_index we use.  See the "Index Section Format"
+   appendix of the GDB manual.  All values are little endian.  */
+struct gdb_index
+{
+  uint32_t version;
+
+  /* Pairs of 8 byte .debug_info offset and length.  */
+  const unsigned char *cu_list;
+  uint32_t cu_count;
+
+  /* 8 byte low address, 8 byte high address, 4 byte CU index.  */
+  const unsigned char *addr_area;
+  size_t naddrs;
+
+  /* Pairs of 4 byte constant pool offsets (name, CU vector).  */
+  const unsigned char *symtab;
+  uint32_t nslots;
+
+  const unsigned char *pool;
+  const unsigned char *end;
+};
+
+static inline uint32_t
+read_le4 (const unsigned char *p)
+{
+  return ((uint32_t) p[0] | (uint32_t) p[1] << 8
+	  | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24);
+}
+
+static inline uint64_t
+read_le8 (const unsigned char *p)
+{
+  return (uint64_t) read_le4 (p) | (uint64_t) read_le4 (p + 4) << 32;
+}
+
+static int
+compare_aranges (const void *a, const void *b)
+{
+  const Dwarf_Arange *a1 = a, *a2 = b;
+  if (a1->addr != a2->addr)
+    return a1->addr < a2->addr ? -1 : 1;
+  return 0;
+}
+
+/* Returns 0 if IDX was filled in, 1 if there is no (usable) .gdb_index
+   and -1 if it is corrupt.  */
+static int
+read_gdb_index (Dwarf *dbg, struct gdb_index *idx)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_gdb_index];
+  if (data == NULL || data->d_buf == NULL)
+    return 1;
+
+  const unsigned char *start = data->d_buf;
+  idx->end = start + data->d_size;
+  if (data->d_size < 6 * 4)
+    goto invalid;
+
+  /* Version 4 and older used a different hash function.  */
+  idx->version = read_le4 (start);
+  if (idx->version < 5 || idx->version > 8)
+    return 1;
+
+  uint32_t cu_off = read_le4 (start + 4);
+  uint32_t types_off = read_le4 (start + 8);
+  uint32_t addr_off = read_le4 (start + 12);
+  uint32_t sym_off = read_le4 (start + 16);
+  uint32_t pool_off = read_le4 (start + 20);
+  if (cu_off > types_off || types_off > addr_off || addr_off > sym_off
+      || sym_off > pool_off || pool_off > data->d_size)
+    goto invalid;
+
+  idx->cu_list = start + cu_off;
+  idx->cu_count = (types_off - cu_off) / 16;
+  idx->addr_area = start + addr_off;
+  idx->naddrs = (sym_off - addr_off) / 20;
+  idx->symtab = start + sym_off;
+  idx->nslots = (pool_off - sym_off) / 8;
+  idx->pool = start + pool_off;
+
+  /* The symbol table is a power of two sized hash table.  */
+  if ((idx->nslots & (idx->nslots - 1)) != 0)
+    goto invalid;
+
+  return 0;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+/* Return the offset of the unit DIE of the unit at UNIT_OFF in
+   .debug_info, reading just its header.  Returns (Dwarf_Off) -1 if the
+   header is bad.  */
+static Dwarf_Off
+unit_die_offset (Dwarf *dbg, Dwarf_Off unit_off)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_debug_info];
+  if (data == NULL || unit_off >= data->d_size
+      || data->d_size - unit_off < 4 + 2 + 1)
+    return (Dwarf_Off) -1;
+
+  const unsigned char *p = (const unsigned char *) data->d_buf + unit_off;
+  const unsigned char *end = (const unsigned char *) data->d_buf
+			     + data->d_size;
+  uint8_t offset_size = 4;
+  if (read_4ubyte_unaligned_inc (dbg, p) == DWARF3_LENGTH_64_BIT)
+    {
+      if (end - p < 8 + 2 + 1)
+	return (Dwarf_Off) -1;
+      p += 8;
+      offset_size = 8;
+    }
+
+  uint16_t version = read_2ubyte_unaligned_inc (dbg, p);
+  if (version < 2 || version > 5)
+    return (Dwarf_Off) -1;
+
+  uint8_t unit_type = DW_UT_compile;
+  if (version >= 5)
+    unit_type = *p;
+
+  return __libdw_first_die_from_cu_start (unit_off, offset_size, version,
+					  unit_type);
+}
+
+int
+internal_function
+__libdw_gdb_index_aranges (Dwarf *dbg, Dwarf_Aranges **aranges,
+			   size_t *naranges)
+{
+  *aranges = NULL;
+  *naranges = 0;
+
+  struct gdb_index idx;
+  int res = read_gdb_index (dbg, &idx);
+  if (res != 0)
+    return res < 0 ? -1 : 0;
+
+  if (idx.naddrs == 0)
+    return 0;
+
+  Dwarf_Aranges *result = libdw_alloc (dbg, Dwarf_Aranges,
+				       sizeof (Dwarf_Aranges)
+				       + idx.naddrs * sizeof (Dwarf_Arange),
+				       1);
+  result->dbg = dbg;
+
+  size_t n = 0;
+  Dwarf_Off last_unit = (Dwarf_Off) -1;
+  Dwarf_Off last_die = 0;
+  for (size_t i = 0; i < idx.naddrs; i++)
+    {
+      const unsigned char *entry = idx.addr_area + i * 20;
+      uint64_t low = read_le8 (entry);
+      uint64_t high = read_le8 (entry + 8);
+      uint32_t cu_index = read_le4 (entry + 16);
+      if (cu_index >= idx.cu_count || high < low)
+	goto invalid;
+
+      /* Ranges for one unit are usually next to each other.  */
+      Dwarf_Off unit_off = read_le8 (idx.cu_list + cu_index * 16);
+      if (unit_off != last_unit)
+	{
+	  last_die = unit_die_offset (dbg, unit_off);
+	  if (last_die == (Dwarf_Off) -1)
+	    goto invalid;
+	  last_unit = unit_off;
+	}
+
+      /* Empty ranges are useless.  */
+      if (high == low)
+	continue;
+
+      result->info[n].addr = low;
+      result->info[n].length = high - low;
+      result->info[n].offset = last_die;
+      n++;
+    }
+
+  /* GDB writes them sorted, but don't depend on that.  */
+  qsort (result->info, n, sizeof (Dwarf_Arange), compare_aranges);
+
+  result->naranges = n;
+  *aranges = n > 0 ? result : NULL;
+  *naranges = n;
+  return 0;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+
+/* The hash function GDB uses for the symbol table (since version 5).  */
+static uint32_t
+gdb_index_hash (const char *name)
+{
+  uint32_t r = 0;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0'; p++)
+    {
+      unsigned char c = *p;
+      if (c >= 'A' && c <= 'Z')
+	c += 'a' - 'A';
+      r = r * 67 + c - 113;
+    }
+  return r;
+}
+
+struct find_arg
+{
+  Dwarf *dbg;
+  Dwarf_Off cu_offset;
+  int (*callback) (Dwarf *, Dwarf_Name *, void *);
+  void *arg;
+  int found;
+  bool aborted;
+};
+
+/* Look for DIEs called REST in the scope of DIE.  REST is the part of
+   the qualified name not yet matched by the enclosing scopes, the index
+   uses names like "ns::klass::method".  */
+static int
+find_in_scope (struct find_arg *find, Dwarf_Die *die, const char *rest)
+{
+  Dwarf_Die child;
+  int res = INTUSE(dwarf_child) (die, &child);
+  if (res != 0)
+    return res < 0 ? -1 : 0;
+
+  do
+    {
+      int tag = INTUSE(dwarf_tag) (&child);
+      const char *diename = INTUSE(dwarf_diename) (&child);
+
+      /* Unscoped enumerators are named in the enclosing scope.  */
+      if (tag == DW_TAG_enumeration_type)
+	{
+	  if (find_in_scope (find, &child, rest) != 0)
+	    return -1;
+	  if (find->aborted)
+	    return 0;
+	}
+
+      if (diename == NULL)
+	continue;
+
+      size_t len = strlen (diename);
+      if (strncmp (rest, diename, len) != 0)
+	continue;
+
+      const char *after = rest + len;
+      if (*after == '\0')
+	{
+	  /* The index only points at definitions.  */
+	  Dwarf_Attribute attr_mem;
+	  bool decl;
+	  Dwarf_Attribute *attr;
+	  attr = INTUSE(dwarf_attr) (&child, DW_AT_declaration, &attr_mem);
+	  if (INTUSE(dwarf_formflag) (attr, &decl) == 0 && decl)
+	    continue;
+
+	  Dwarf_Name entry =
+	    {
+	      .cu_offset = find->cu_offset,
+	      .die_offset = INTUSE(dwarf_dieoffset) (&child),
+	      .name = diename,
+	      .tag = tag
+	    };
+	  find->found = 1;
+	  if (find->callback (find->dbg, &entry, find->arg) != DWARF_CB_OK)
+	    {
+	      find->aborted = true;
+	      return 0;
+	    }
+	}
+      else if (after[0] == ':' && after[1] == ':'
+	       && (tag == DW_TAG_namespace || tag == DW_TAG_structure_type
+		   || tag == DW_TAG_class_type || tag == DW_TAG_union_type
+		   || tag == DW_TAG_enumeration_type))
+	{
+	  if (find_in_scope (find, &child, after + 2) != 0)
+	    return -1;
+	  if (find->aborted)
+	    return 0;
+	}
+    }
+  while ((res = INTUSE(dwarf_siblingof) (&child, &child)) == 0);
+
+  return res < 0 ? -1 : 0;
+}
+
+int
+internal_function
+__libdw_gdb_index_lookup (Dwarf *dbg, const char *name,
+			  int (*callback) (Dwarf *, Dwarf_Name *, void *),
+			  void *arg)
+{
+  struct gdb_index idx;
+  int res = read_gdb_index (dbg, &idx);
+  if (res != 0)
+    {
+      if (res > 0)
+	__libdw_seterrno (DWARF_E_NO_DEBUG_NAMES);
+      return -1;
+    }
+
+  if (idx.nslots == 0)
+    return 0;
+
+  size_t pool_size = idx.end - idx.pool;
+  uint32_t mask = idx.nslots - 1;
+  uint32_t hash = gdb_index_hash (name);
+  uint32_t slot = hash & mask;
+  uint32_t step = ((hash * 17) & mask) | 1;
+  const unsigned char *vec = NULL;
+  for (uint32_t probes = 0; probes < idx.nslots; probes++)
+    {
+      uint32_t name_off = read_le4 (idx.symtab + slot * 8);
+      uint32_t vec_off = read_le4 (idx.symtab + slot * 8 + 4);
+      if (name_off == 0 && vec_off == 0)
+	return 0;
+
+      if (name_off >= pool_size || vec_off >= pool_size
+	  || memchr (idx.pool + name_off, '\0', pool_size - name_off) == NULL)
+	goto invalid;
+      if (strcmp ((const char *) idx.pool + name_off, name) == 0)
+	{
+	  vec = idx.pool + vec_off;
+	  break;
+	}
+
+      slot = (slot + step) & mask;
+    }
+
+  if (vec == NULL)
+    return 0;
+
+  if ((size_t) (idx.end - vec) < 4)
+    goto invalid;
+  uint32_t count = read_le4 (vec);
+  if ((size_t) (idx.end - vec - 4) / 4 < count)
+    goto invalid;
+
+  struct find_arg find =
+    {
+      .dbg = dbg, .callback = callback, .arg = arg,
+      .found = 0, .aborted = false
+    };
+  for (uint32_t i = 0; i < count && ! find.aborted; i++)
+    {
+      /* The upper byte has the symbol kind and whether it is static.  */
+      uint32_t cu_index = read_le4 (vec + 4 + i * 4) & 0xffffff;
+
+      /* The same unit can be listed for different kinds of symbols.  */
+      bool seen = false;
+      for (uint32_t j = 0; j < i && ! seen; j++)
+	seen = (read_le4 (vec + 4 + j * 4) & 0xffffff) == cu_index;
+      if (seen)
+	continue;
+
+      /* Indexes past the CU list are type units in .debug_types, whose
+	 DIEs cannot be described by a .debug_info offset.  */
+      if (cu_index >= idx.cu_count)
+	continue;
+
+      Dwarf_Off unit_off = read_le8 (idx.cu_list + cu_index * 16);
+      Dwarf_Off die_off = unit_die_offset (dbg, unit_off);
+      Dwarf_Die cudie;
+      if (die_off == (Dwarf_Off) -1
+	  || INTUSE(dwarf_offdie) (dbg, die_off, &cudie) == NULL)
+	goto invalid;
+
+      find.cu_offset = die_off;
+      if (find_in_scope (&find, &cudie, name) != 0)
+	return -1;
+    }
+
+  return find.found;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
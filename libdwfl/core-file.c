@@ -82,10 +82,10 @@ elf_begin_rand (Elf *parent, off_t offset, off_t size, off_t *next)
       if (parent->map_address != NULL)
 	memcpy (h.ar_size, parent->map_address + parent->start_offset + offset,
 		sizeof h.ar_size);
-      else if (unlikely (pread_retry (parent->fildes,
-				      h.ar_size, sizeof (h.ar_size),
-				      parent->start_offset + offset
-				      + offsetof (struct ar_hdr, ar_size))
+      else if (unlikely (__libelf_pread (parent,
+					 h.ar_size, sizeof (h.ar_size),
+					 parent->start_offset + offset
+					 + offsetof (struct ar_hdr, ar_size))
 			 != sizeof (h.ar_size)))
 	return fail (ELF_E_READ_ERROR);
 
@@ -230,14 +230,10 @@ core_file_read_eagerly (Dwfl_Module *mod,
     return false;
 
   /* The file is either small (most likely the vdso) or big and incomplete,
-     but we don't have a build-id.  */
-
-  if (core->map_address != NULL)
-    /* It's cheap to get, so get it.  */
-    return true;
-
-  /* Only use it if there isn't too much to be read.  */
-  return cost <= MAX_EAGER_COST;
+     but we don't have a build-id.  The partial file would be copied out
+     of the core file into memory of its own, even when the core file
+     is mmap'd, so only use it if there isn't too much of it.  */
+  return cost <= MAX_EAGER_COST && whole <= MAX_EAGER_COST;
 }
 
 static inline void
@@ -372,7 +368,7 @@ dwfl_elf_phdr_memory_callback (Dwfl *dwfl, int ndx,
 	    }
 	}
 
-      ssize_t nread = pread_retry (elf->fildes, into, *buffer_available, start);
+      ssize_t nread = __libelf_pread (elf, into, *buffer_available, start);
       if (nread < (ssize_t) minread)
 	{
 	  if (into != *buffer)
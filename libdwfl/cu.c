@@ -39,7 +39,7 @@
 static inline Dwarf_Arange *
 dwar (Dwfl_Module *mod, unsigned int idx)
 {
-  return &mod->dw->aranges->info[mod->aranges[idx].arange];
+  return &mod->dwaranges->info[mod->aranges[idx].arange];
 }
 
 
@@ -51,8 +51,9 @@ addrarange (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_arange **arange)
       struct dwfl_arange *aranges = NULL;
       Dwarf_Aranges *dwaranges = NULL;
       size_t naranges;
-      if (INTUSE(dwarf_getaranges) (mod->dw, &dwaranges, &naranges) != 0)
+      if (__libdw_getaranges_complete (mod->dw, &dwaranges) != 0)
 	return DWFL_E_LIBDW;
+      naranges = dwaranges == NULL ? 0 : dwaranges->naranges;
 
       /* If the module has no aranges (when no code is included) we
 	 allocate nothing.  */
@@ -83,6 +84,7 @@ addrarange (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_arange **arange)
 
       /* Store the final array, which is probably much smaller than before.  */
       mod->naranges = naranges;
+      mod->dwaranges = dwaranges;
       mod->aranges = (realloc (aranges, naranges * sizeof aranges[0])
 		      ?: aranges);
       mod->lazycu += naranges;
@@ -116,7 +118,7 @@ addrarange (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_arange **arange)
 	    {
 	      /* It might be in the last range.  */
 	      const Dwarf_Arange *last
-		= &mod->dw->aranges->info[mod->dw->aranges->naranges - 1];
+		= &mod->dwaranges->info[mod->dwaranges->naranges - 1];
 	      if (addr > last->addr + last->length)
 		break;
 	    }
@@ -293,7 +295,7 @@ arangecu (Dwfl_Module *mod, struct dwfl_arange *arange, struct dwfl_cu **cu)
 {
   if (arange->cu == NULL)
     {
-      const Dwarf_Arange *dwarange = &mod->dw->aranges->info[arange->arange];
+      const Dwarf_Arange *dwarange = &mod->dwaranges->info[arange->arange];
       Dwfl_Error result = intern_cu (mod, dwarange->offset, &arange->cu);
       if (result != DWFL_E_NOERROR)
 	return result;
@@ -307,8 +309,56 @@ arangecu (Dwfl_Module *mod, struct dwfl_arange *arange, struct dwfl_cu **cu)
 
 Dwfl_Error
 internal_function
-__libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_cu **cu)
+__libdwfl_addrcu_range (Dwfl_Module *mod, Dwarf_Addr addr,
+			struct dwfl_cu **cu, Dwarf_Addr *start,
+			Dwarf_Addr *end)
 {
+  /* Without .debug_aranges libdw only reads the units up to the one
+     covering ADDR.  Not finding it means all units have been read and
+     we can use the complete table as usual.  */
+  if (mod->aranges == NULL
+      && __atomic_load_n (&mod->dw->aranges, __ATOMIC_ACQUIRE) == NULL
+      && mod->dw->sectiondata[IDX_debug_aranges] == NULL
+      && mod->dw->sectiondata[IDX_gdb_index] == NULL)
+    {
+      Dwarf_Addr dwaddr = dwfl_deadjust_dwarf_addr (mod, addr);
+      Dwarf_Off cuoff;
+      int res = __libdw_findarange (mod->dw, dwaddr, &cuoff);
+      if (res < 0)
+	return DWFL_E_LIBDW;
+      if (res == 0)
+	{
+	  *start = dwaddr;
+	  *end = dwaddr + 1;
+	  return intern_cu (mod, cuoff, cu);
+	}
+    }
+
   struct dwfl_arange *arange;
-  return addrarange (mod, addr, &arange) ?: arangecu (mod, arange, cu);
+  Dwfl_Error error = addrarange (mod, addr, &arange);
+  if (error == DWFL_E_NOERROR)
+    {
+      /* Everything up to the next run belongs to the same CU, see
+	 addrarange.  */
+      size_t idx = arange - mod->aranges;
+      *start = dwar (mod, idx)->addr;
+      if (idx + 1 < mod->naranges)
+	*end = dwar (mod, idx + 1)->addr;
+      else
+	{
+	  const Dwarf_Arange *last
+	    = &mod->dwaranges->info[mod->dwaranges->naranges - 1];
+	  *end = last->addr + last->length + 1;
+	}
+      error = arangecu (mod, arange, cu);
+    }
+  return error;
+}
+
+Dwfl_Error
+internal_function
+__libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_cu **cu)
+{
+  Dwarf_Addr start, end;
+  return __libdwfl_addrcu_range (mod, addr, cu, &start, &end);
 }
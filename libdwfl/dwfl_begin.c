@@ -48,6 +48,7 @@ dwfl_begin (const Dwfl_Callbacks *callbacks)
     {
       dwfl->callbacks = callbacks;
       dwfl->offline_next_address = OFFLINE_REDZONE;
+      rwlock_init (dwfl->unwind_lock);
     }
 
   return dwfl;
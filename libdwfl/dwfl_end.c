@@ -62,5 +62,6 @@ dwfl_end (Dwfl *dwfl)
 	close (dwfl->user_core->fd);
       free (dwfl->user_core);
     }
+  rwlock_fini (dwfl->unwind_lock);
   free (dwfl);
 }
@@ -31,6 +31,7 @@
 #endif
 
 #include "libdwflP.h"
+#include <sys/param.h>
 #include <unistd.h>
 
 /* Set STATE->pc_set from STATE->regs according to the backend.  Return true on
@@ -76,7 +77,7 @@ state_free (Dwfl_Frame *state)
   Dwfl_Thread *thread = state->thread;
   assert (thread->unwound == state);
   thread->unwound = state->unwound;
-  free (state);
+  __libdwfl_frame_release (state);
 }
 
 static void
@@ -95,19 +96,110 @@ state_alloc (Dwfl_Thread *thread)
   if (nregs == 0)
     return NULL;
   assert (nregs < sizeof (((Dwfl_Frame *) NULL)->regs_set) * 8);
-  Dwfl_Frame *state = malloc (sizeof (*state) + sizeof (*state->regs) * nregs);
+  Dwfl_Frame *state = __libdwfl_frame_alloc (thread);
   if (state == NULL)
     return NULL;
+  state->initial_frame = true;
+  thread->unwound = state;
+  return state;
+}
+
+/* Done with THREAD for now, unless dwfl_getthreads_parallel keeps it
+   stopped.  */
+static void
+thread_detach (Dwfl_Thread *thread)
+{
+  if (thread->prepared != NULL)
+    return;
+  Dwfl_Process *process = thread->process;
+  __libdwfl_memory_cache_clear (process);
+  if (process->callbacks->thread_detach)
+    process->callbacks->thread_detach (thread, thread->callbacks_arg);
+}
+
+static bool
+in_frame_arena (Dwfl_Process *process, Dwfl_Frame *state)
+{
+  char *p = (char *) state;
+  return (process->frame_arena != NULL
+	  && p >= process->frame_arena
+	  && p < (process->frame_arena
+		  + __LIBDWFL_FRAME_ARENA_FRAMES * process->frame_size));
+}
+
+Dwfl_Frame *
+internal_function
+__libdwfl_frame_alloc (Dwfl_Thread *thread)
+{
+  Dwfl_Process *process = thread->process;
+  rwlock_wrlock (process->dwfl->unwind_lock);
+  Dwfl_Frame *state = process->frame_pool;
+  if (state != NULL)
+    process->frame_pool = state->unwound;
+  rwlock_unlock (process->dwfl->unwind_lock);
+  if (state == NULL)
+    {
+      size_t nregs = ebl_frame_nregs (process->ebl);
+      state = malloc (sizeof (*state) + sizeof (*state->regs) * nregs);
+      if (state == NULL)
+	return NULL;
+    }
   state->thread = thread;
+  state->unwound = NULL;
   state->signal_frame = false;
-  state->initial_frame = true;
+  state->initial_frame = false;
+  state->unwind_method = DWFL_UNWIND_INITIAL;
   state->pc_state = DWFL_FRAME_STATE_ERROR;
   memset (state->regs_set, 0, sizeof (state->regs_set));
-  thread->unwound = state;
-  state->unwound = NULL;
   return state;
 }
 
+void
+internal_function
+__libdwfl_frame_release (Dwfl_Frame *state)
+{
+  Dwfl_Process *process = state->thread->process;
+  if (process->reuse_frames || in_frame_arena (process, state))
+    {
+      rwlock_wrlock (process->dwfl->unwind_lock);
+      state->unwound = process->frame_pool;
+      process->frame_pool = state;
+      rwlock_unlock (process->dwfl->unwind_lock);
+    }
+  else
+    free (state);
+}
+
+/* Free the frames in the frame pool of PROCESS, and its frame arena
+   unless some of its frames are still in use.  When PROCESS itself is
+   freed no thread has frames left, so the arena is always freed.  */
+static void
+frame_pool_free (Dwfl_Process *process, bool final)
+{
+  size_t arena_frames = 0;
+  Dwfl_Frame **prevp = &process->frame_pool;
+  while (*prevp != NULL)
+    {
+      Dwfl_Frame *state = *prevp;
+      if (in_frame_arena (process, state))
+	{
+	  arena_frames++;
+	  prevp = &state->unwound;
+	}
+      else
+	{
+	  *prevp = state->unwound;
+	  free (state);
+	}
+    }
+  if (final || arena_frames == __LIBDWFL_FRAME_ARENA_FRAMES)
+    {
+      free (process->frame_arena);
+      process->frame_arena = NULL;
+      process->frame_pool = NULL;
+    }
+}
+
 void
 internal_function
 __libdwfl_process_free (Dwfl_Process *process)
@@ -119,6 +211,8 @@ __libdwfl_process_free (Dwfl_Process *process)
   dwfl->process = NULL;
   if (process->ebl_close)
     ebl_closebackend (process->ebl);
+  free (process->mem_cache);
+  frame_pool_free (process, true);
   free (process);
   dwfl->attacherr = DWFL_E_NOERROR;
 }
@@ -134,9 +228,9 @@ process_alloc (Dwfl *dwfl)
   dwfl->process = process;
 }
 
-bool
-dwfl_attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
-		   const Dwfl_Thread_Callbacks *thread_callbacks, void *arg)
+static bool
+attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
+	      const Dwfl_Thread_Callbacks *thread_callbacks, void *arg)
 {
   if (dwfl->process != NULL)
     {
@@ -209,9 +303,93 @@ dwfl_attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
   process->pid = pid;
   process->callbacks = thread_callbacks;
   process->callbacks_arg = arg;
+  process->memory_read_bulk = NULL;
+  process->mem_cache = NULL;
+  process->frame_pool = NULL;
+  process->frame_arena = NULL;
+  process->frame_size = 0;
+  process->reuse_frames = false;
+  return true;
+}
+
+bool
+dwfl_attach_state (Dwfl *dwfl, Elf *elf, pid_t pid,
+		   const Dwfl_Thread_Callbacks *thread_callbacks, void *arg)
+{
+  if (! attach_state (dwfl, elf, pid, thread_callbacks, arg))
+    return false;
+  dwfl->process->memory_read_bulk = thread_callbacks->memory_read_bulk;
   return true;
 }
 INTDEF(dwfl_attach_state)
+NEW_VERSION (dwfl_attach_state, ELFUTILS_0.175)
+
+#ifdef SYMBOL_VERSIONING
+/* Older callers' Dwfl_Thread_Callbacks end before memory_read_bulk.  */
+bool _compat_without_memory_read_bulk_dwfl_attach_state
+  (Dwfl *dwfl, Elf *elf, pid_t pid,
+   const Dwfl_Thread_Callbacks *thread_callbacks, void *arg);
+COMPAT_VERSION_NEWPROTO (dwfl_attach_state, ELFUTILS_0.158,
+			 without_memory_read_bulk)
+
+bool
+_compat_without_memory_read_bulk_dwfl_attach_state
+  (Dwfl *dwfl, Elf *elf, pid_t pid,
+   const Dwfl_Thread_Callbacks *thread_callbacks, void *arg)
+{
+  return attach_state (dwfl, elf, pid, thread_callbacks, arg);
+}
+#endif
+
+int
+dwfl_frame_reuse (Dwfl *dwfl, bool reuse)
+{
+  if (dwfl->attacherr != DWFL_E_NOERROR)
+    {
+      __libdwfl_seterrno (dwfl->attacherr);
+      return -1;
+    }
+
+  Dwfl_Process *process = dwfl->process;
+  if (process == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NO_ATTACH_STATE);
+      return -1;
+    }
+
+  if (reuse && process->frame_arena == NULL)
+    {
+      size_t nregs = ebl_frame_nregs (process->ebl);
+      if (nregs == 0)
+	{
+	  __libdwfl_seterrno (DWFL_E_NO_UNWIND);
+	  return -1;
+	}
+      size_t align = __alignof__ (Dwfl_Frame);
+      size_t size = sizeof (Dwfl_Frame) + sizeof (Dwarf_Addr) * nregs;
+      size = (size + align - 1) & ~(align - 1);
+      char *arena = malloc (__LIBDWFL_FRAME_ARENA_FRAMES * size);
+      if (arena == NULL)
+	{
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return -1;
+	}
+      process->frame_arena = arena;
+      process->frame_size = size;
+      for (size_t i = 0; i < __LIBDWFL_FRAME_ARENA_FRAMES; i++)
+	{
+	  Dwfl_Frame *state = (Dwfl_Frame *) (arena + i * size);
+	  state->unwound = process->frame_pool;
+	  process->frame_pool = state;
+	}
+    }
+
+  process->reuse_frames = reuse;
+  if (! reuse)
+    frame_pool_free (process, false);
+  return 0;
+}
+INTDEF(dwfl_frame_reuse)
 
 pid_t
 dwfl_pid (Dwfl *dwfl)
@@ -273,6 +451,9 @@ dwfl_getthreads (Dwfl *dwfl, int (*callback) (Dwfl_Thread *thread, void *arg),
   thread.process = process;
   thread.unwound = NULL;
   thread.callbacks_arg = NULL;
+  thread.prepared = NULL;
+  thread.prepare_error = DWFL_E_NOERROR;
+  thread.mem_cache = NULL;
   for (;;)
     {
       thread.tid = process->callbacks->next_thread (dwfl,
@@ -303,6 +484,260 @@ dwfl_getthreads (Dwfl *dwfl, int (*callback) (Dwfl_Thread *thread, void *arg),
 }
 INTDEF(dwfl_getthreads)
 
+/* Remember why the initial frame of THREAD could not be set up.  */
+static void
+prepare_failed (Dwfl_Thread *thread, Dwfl_Error error)
+{
+  thread->prepare_errno = errno;
+  thread->prepare_error = (error != DWFL_E_NOERROR
+			   ? error : DWFL_E_UNKNOWN_ERROR);
+}
+
+/* Set up the initial frame of THREAD for dwfl_thread_getframes, while
+   the thread is stopped.  */
+static void
+thread_prepare (Dwfl_Thread *thread)
+{
+  Dwfl_Process *process = thread->process;
+  if (ebl_frame_nregs (process->ebl) == 0)
+    {
+      prepare_failed (thread, DWFL_E_NO_UNWIND);
+      return;
+    }
+  if (state_alloc (thread) == NULL)
+    {
+      prepare_failed (thread, DWFL_E_NOMEM);
+      return;
+    }
+  if (! process->callbacks->set_initial_registers (thread,
+						   thread->callbacks_arg))
+    {
+      thread_free_all_states (thread);
+      prepare_failed (thread, dwfl_errno ());
+      return;
+    }
+  bool ok = state_fetch_pc (thread->unwound);
+  Dwfl_Error err = dwfl_errno ();
+  if (process->callbacks->thread_detach)
+    process->callbacks->thread_detach (thread, thread->callbacks_arg);
+  if (! ok)
+    {
+      thread_free_all_states (thread);
+      prepare_failed (thread, err);
+      return;
+    }
+  thread->prepared = thread->unwound;
+  thread->unwound = NULL;
+}
+
+struct parallel_arg
+{
+  Dwfl_Thread *threads;
+  size_t nthreads;
+  /* The next thread for a worker to take.  */
+  size_t next;
+  int (*callback) (Dwfl_Thread *thread, void *arg);
+  void *arg;
+  /* The first result of CALLBACK other than DWARF_CB_OK.  */
+  int ret;
+};
+
+/* Call the callback for the threads not taken by another worker yet.
+   CACHE is the remote memory cache of this worker, NULL for the one
+   of the process.  */
+static void
+parallel_work (struct parallel_arg *pa,
+	       struct __libdwfl_remote_mem_cache *cache)
+{
+  size_t i;
+  while ((i = __atomic_fetch_add (&pa->next, 1, __ATOMIC_RELAXED))
+	 < pa->nthreads)
+    {
+      Dwfl_Thread *thread = &pa->threads[i];
+      thread->mem_cache = cache;
+      int err = pa->callback (thread, pa->arg);
+      thread->mem_cache = NULL;
+      if (err != DWARF_CB_OK)
+	{
+	  int ok = DWARF_CB_OK;
+	  __atomic_compare_exchange_n (&pa->ret, &ok, err, false,
+				       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	  __atomic_store_n (&pa->next, pa->nthreads, __ATOMIC_RELAXED);
+	}
+    }
+}
+
+#ifdef USE_LOCKS
+static void *
+parallel_worker (void *arg)
+{
+  struct parallel_arg *pa = arg;
+  Dwfl_Process *process = pa->threads[0].process;
+  struct __libdwfl_remote_mem_cache *cache = NULL;
+  if (process->memory_read_bulk != NULL)
+    {
+      /* Without a cache of its own this worker cannot help.  */
+      cache = calloc (1, sizeof *cache);
+      if (cache == NULL)
+	return NULL;
+    }
+  parallel_work (pa, cache);
+  free (cache);
+  return NULL;
+}
+#endif
+
+/* Call the callback for all threads of PA from up to NWORKERS
+   threads.  */
+static void
+parallel_run (struct parallel_arg *pa, unsigned nworkers)
+{
+#ifdef USE_LOCKS
+  size_t max = MIN (nworkers, pa->nthreads);
+  /* Without memory for the workers this thread does all the work.  */
+  pthread_t *workers = NULL;
+  if (max > 1)
+    workers = malloc ((max - 1) * sizeof *workers);
+  size_t nstarted = 0;
+  while (workers != NULL && nstarted + 1 < max
+	 && pthread_create (&workers[nstarted], NULL,
+			    parallel_worker, pa) == 0)
+    nstarted++;
+  parallel_work (pa, NULL);
+  for (size_t i = 0; i < nstarted; i++)
+    pthread_join (workers[i], NULL);
+  free (workers);
+#else
+  /* Without thread safety the threads are unwound one by one, they are
+     still stopped all at once.  */
+  (void) nworkers;
+  parallel_work (pa, NULL);
+#endif
+}
+
+int
+dwfl_getthreads_parallel (Dwfl *dwfl, unsigned nworkers,
+			  int (*callback) (Dwfl_Thread *thread, void *arg),
+			  void *arg)
+{
+  if (dwfl->attacherr != DWFL_E_NOERROR)
+    {
+      __libdwfl_seterrno (dwfl->attacherr);
+      return -1;
+    }
+
+  Dwfl_Process *process = dwfl->process;
+  if (process == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NO_ATTACH_STATE);
+      return -1;
+    }
+
+  /* A live process is stopped as a whole once all its threads are
+     known.  Other threads are set up as they are found, like
+     dwfl_getthreads does.  */
+  struct __libdwfl_pid_arg *pid_arg = __libdwfl_get_pid_arg (dwfl);
+  Dwfl_Thread *threads = NULL;
+  pid_t *tids = NULL;
+  size_t nthreads = 0;
+  size_t alloc = 0;
+  void *thread_arg = NULL;
+  int ret = -1;
+  for (;;)
+    {
+      pid_t tid = process->callbacks->next_thread (dwfl,
+						   process->callbacks_arg,
+						   &thread_arg);
+      if (tid < 0)
+	goto out;
+      if (tid == 0)
+	break;
+      if (nthreads == alloc)
+	{
+	  alloc = alloc * 2 + 16;
+	  Dwfl_Thread *new_threads = realloc (threads,
+					      alloc * sizeof threads[0]);
+	  if (new_threads == NULL)
+	    goto nomem;
+	  threads = new_threads;
+	  pid_t *new_tids = realloc (tids, alloc * sizeof tids[0]);
+	  if (new_tids == NULL)
+	    goto nomem;
+	  tids = new_tids;
+	}
+      Dwfl_Thread *thread = &threads[nthreads];
+      thread->process = process;
+      thread->tid = tid;
+      thread->unwound = NULL;
+      thread->callbacks_arg = thread_arg;
+      thread->prepared = NULL;
+      thread->prepare_error = DWFL_E_NOERROR;
+      thread->mem_cache = NULL;
+      tids[nthreads++] = tid;
+      if (pid_arg == NULL)
+	{
+	  thread_prepare (thread);
+	  /* THREADS may still move, its frame is pointed to it below.  */
+	  if (thread->prepared != NULL)
+	    thread->prepared->thread = NULL;
+	}
+    }
+
+  int *sigs = NULL;
+  if (pid_arg != NULL && nthreads > 0)
+    {
+      sigs = malloc (nthreads * sizeof sigs[0]);
+      if (sigs == NULL)
+	goto nomem;
+      if (! __libdwfl_ptrace_stop_all (pid_arg, tids, sigs, nthreads))
+	{
+	  free (sigs);
+	  goto out;
+	}
+      for (size_t i = 0; i < nthreads; i++)
+	if (sigs[i] >= 0)
+	  thread_prepare (&threads[i]);
+	else
+	  {
+	    errno = ESRCH;
+	    prepare_failed (&threads[i], DWFL_E_ERRNO);
+	  }
+    }
+  for (size_t i = 0; i < nthreads; i++)
+    if (threads[i].prepared != NULL)
+      threads[i].prepared->thread = &threads[i];
+
+  struct parallel_arg pa =
+    {
+      .threads = threads, .nthreads = nthreads, .next = 0,
+      .callback = callback, .arg = arg, .ret = DWARF_CB_OK
+    };
+  parallel_run (&pa, nworkers);
+  ret = pa.ret;
+
+  if (sigs != NULL)
+    {
+      __libdwfl_ptrace_resume_all (pid_arg, tids, sigs, nthreads);
+      free (sigs);
+    }
+  __libdwfl_memory_cache_clear (process);
+  __libdwfl_seterrno (DWFL_E_NOERROR);
+  goto out;
+
+ nomem:
+  __libdwfl_seterrno (DWFL_E_NOMEM);
+ out:
+  for (size_t i = 0; i < nthreads; i++)
+    if (threads[i].prepared != NULL)
+      {
+	threads[i].prepared->thread = &threads[i];
+	__libdwfl_frame_release (threads[i].prepared);
+      }
+  free (threads);
+  free (tids);
+  return ret;
+}
+
 struct one_arg
 {
   pid_t tid;
@@ -352,6 +787,9 @@ getthread (Dwfl *dwfl, pid_t tid,
       thread.process = process;
       thread.unwound = NULL;
       thread.callbacks_arg = NULL;
+      thread.prepared = NULL;
+      thread.prepare_error = DWFL_E_NOERROR;
+      thread.mem_cache = NULL;
 
       if (process->callbacks->get_thread (dwfl, tid, process->callbacks_arg,
 					  &thread.callbacks_arg))
@@ -417,6 +855,12 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
       __libdwfl_seterrno (DWFL_E_ATTACH_STATE_CONFLICT);
       return -1;
     }
+  if (thread->prepare_error != DWFL_E_NOERROR)
+    {
+      errno = thread->prepare_errno;
+      __libdwfl_seterrno (thread->prepare_error);
+      return -1;
+    }
   Ebl *ebl = thread->process->ebl;
   if (ebl_frame_nregs (ebl) == 0)
     {
@@ -429,16 +873,25 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
       return -1;
     }
   Dwfl_Process *process = thread->process;
-  if (! process->callbacks->set_initial_registers (thread,
-						   thread->callbacks_arg))
+  if (thread->prepared != NULL)
+    {
+      Dwfl_Frame *state = thread->unwound;
+      state->pc = thread->prepared->pc;
+      state->pc_state = thread->prepared->pc_state;
+      memcpy (state->regs_set, thread->prepared->regs_set,
+	      sizeof state->regs_set);
+      memcpy (state->regs, thread->prepared->regs,
+	      sizeof state->regs[0] * ebl_frame_nregs (ebl));
+    }
+  else if (! process->callbacks->set_initial_registers (thread,
+							thread->callbacks_arg))
     {
       thread_free_all_states (thread);
       return -1;
     }
   if (! state_fetch_pc (thread->unwound))
     {
-      if (process->callbacks->thread_detach)
-	process->callbacks->thread_detach (thread, thread->callbacks_arg);
+      thread_detach (thread);
       thread_free_all_states (thread);
       return -1;
     }
@@ -450,8 +903,7 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
       int err = callback (state, arg);
       if (err != DWARF_CB_OK)
 	{
-	  if (process->callbacks->thread_detach)
-	    process->callbacks->thread_detach (thread, thread->callbacks_arg);
+	  thread_detach (thread);
 	  thread_free_all_states (thread);
 	  return err;
 	}
@@ -463,8 +915,7 @@ dwfl_thread_getframes (Dwfl_Thread *thread,
   while (state && state->pc_state == DWFL_FRAME_STATE_PC_SET);
 
   Dwfl_Error err = dwfl_errno ();
-  if (process->callbacks->thread_detach)
-    process->callbacks->thread_detach (thread, thread->callbacks_arg);
+  thread_detach (thread);
   if (state == NULL || state->pc_state == DWFL_FRAME_STATE_ERROR)
     {
       thread_free_all_states (thread);
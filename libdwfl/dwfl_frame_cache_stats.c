@@ -0,0 +1,46 @@
+/* Report the hit and miss counts of the unwind rules caches.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+
+int
+dwfl_frame_cache_stats (Dwfl *dwfl, size_t *hits, size_t *misses)
+{
+  if (dwfl == NULL)
+    return -1;
+
+  if (hits != NULL)
+    *hits = dwfl->frame_cache_hits;
+  if (misses != NULL)
+    *misses = dwfl->frame_cache_misses;
+  return 0;
+}
@@ -75,6 +75,9 @@ __libdwfl_module_free (Dwfl_Module *mod)
       free (mod->cu);
     }
 
+  __libdwfl_frame_rules_free (&mod->eh_rules);
+  __libdwfl_frame_rules_free (&mod->dwarf_rules);
+
   /* We might have primed the Dwarf_CFI ebl cache with our own ebl
      in __libdwfl_set_cfi. Make sure we don't free it twice.  */
   if (mod->eh_cfi != NULL)
@@ -119,6 +122,10 @@ __libdwfl_module_free (Dwfl_Module *mod)
   if (mod->reloc_info != NULL)
     free (mod->reloc_info);
 
+  free (mod->symindex[0]);
+  free (mod->symindex[1]);
+  free (mod->symnames);
+
   free (mod->name);
   free (mod->elfdir);
   free (mod);
@@ -31,6 +31,8 @@
 #endif
 
 #include "libdwflP.h"
+#include <stdlib.h>
+#include <sys/param.h>
 
 struct search_state
 {
@@ -234,16 +236,325 @@ search_table (struct search_state *state, int start, int end)
 	}
 }
 
+/* One symbol value in the index built by get_symindex.  A symbol can
+   have two values, its st_value and its resolved function entry.  */
+struct dwfl_symentry
+{
+  GElf_Addr value;
+  GElf_Addr end;		/* value + st_size.  */
+  GElf_Addr max_global;		/* Highest end of the globals up to here.  */
+  GElf_Addr max_local;		/* Highest end of the locals up to here.  */
+  int ndx;			/* Index in the symbol table.  */
+  bool adjusted;		/* value is the adjusted st_value.  */
+};
+
+/* All symbols search_table would try, sorted by value.  When LINEAR
+   is set no index could be built and search_table is used instead.  */
+struct dwfl_symindex
+{
+  bool linear;
+  size_t n;
+  struct dwfl_symentry entries[];
+};
+
+static int
+compare_symentry (const void *a, const void *b)
+{
+  const struct dwfl_symentry *p1 = a;
+  const struct dwfl_symentry *p2 = b;
+
+  if (p1->value != p2->value)
+    return p1->value < p2->value ? -1 : 1;
+  if (p1->ndx != p2->ndx)
+    return p1->ndx < p2->ndx ? -1 : 1;
+  return p1->adjusted - p2->adjusted;
+}
+
+static bool
+add_symentry (struct dwfl_symindex **idxp, size_t *alloc,
+	      GElf_Addr value, const GElf_Sym *sym, int ndx, bool adjusted)
+{
+  struct dwfl_symindex *idx = *idxp;
+
+  /* The index relies on st_size not wrapping around.  */
+  if (value + sym->st_size < value)
+    return false;
+
+  if (idx->n == *alloc)
+    {
+      size_t new_alloc = *alloc * 2;
+      idx = realloc (idx, sizeof *idx + new_alloc * sizeof idx->entries[0]);
+      if (idx == NULL)
+	return false;
+      *idxp = idx;
+      *alloc = new_alloc;
+    }
+
+  idx->entries[idx->n++] = (struct dwfl_symentry)
+    {
+      .value = value,
+      .end = value + sym->st_size,
+      .ndx = ndx,
+      .adjusted = adjusted
+    };
+  return true;
+}
+
+/* Build the index with all values search_table could try, applying
+   all its checks except the one against the address.  */
+static struct dwfl_symindex *
+build_symindex (Dwfl_Module *mod, int syments, int first_global,
+		bool adjust_st_value)
+{
+  size_t alloc = 64;
+  struct dwfl_symindex *idx = malloc (sizeof *idx
+				      + alloc * sizeof idx->entries[0]);
+  if (idx == NULL)
+    return NULL;
+  idx->linear = false;
+  idx->n = 0;
+
+  for (int i = 1; i < syments; ++i)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      GElf_Word shndx;
+      Elf *elf;
+      bool resolved;
+      const char *name = __libdwfl_getsym (mod, i, &sym, &value,
+					   &shndx, &elf, NULL,
+					   &resolved, adjust_st_value);
+      if (name != NULL && name[0] != '\0'
+	  && sym.st_shndx != SHN_UNDEF
+	  && GELF_ST_TYPE (sym.st_info) != STT_SECTION
+	  && GELF_ST_TYPE (sym.st_info) != STT_FILE
+	  && GELF_ST_TYPE (sym.st_info) != STT_TLS)
+	{
+	  if (! add_symentry (&idx, &alloc, value, &sym, i, false))
+	    goto linear;
+
+	  if (resolved && mod->e_type != ET_REL)
+	    {
+	      GElf_Addr adjusted_st_value;
+	      adjusted_st_value = dwfl_adjusted_st_value (mod, elf,
+							  sym.st_value);
+	      if (value != adjusted_st_value
+		  && ! add_symentry (&idx, &alloc, adjusted_st_value, &sym,
+				     i, true))
+		goto linear;
+	    }
+	}
+    }
+
+  qsort (idx->entries, idx->n, sizeof idx->entries[0], compare_symentry);
+
+  /* The highest end up to each entry is what search_table leaves in
+     min_label after trying all values up to that entry.  The locals
+     are only tried after all globals, so keep them apart.  */
+  GElf_Addr max_global = 0;
+  GElf_Addr max_local = 0;
+  for (size_t i = 0; i < idx->n; ++i)
+    {
+      struct dwfl_symentry *entry = &idx->entries[i];
+      if (entry->ndx < first_global)
+	max_local = MAX (max_local, entry->end);
+      else
+	max_global = MAX (max_global, entry->end);
+      entry->max_global = max_global;
+      entry->max_local = max_local;
+    }
+
+  return idx;
+
+ linear:
+  idx->linear = true;
+  idx->n = 0;
+  return idx;
+}
+
+static struct dwfl_symindex *
+get_symindex (Dwfl_Module *mod, int syments, int first_global,
+	      bool adjust_st_value)
+{
+  struct dwfl_symindex **idxp = &mod->symindex[adjust_st_value];
+  if (*idxp == NULL)
+    *idxp = build_symindex (mod, syments, first_global, adjust_st_value);
+  if (*idxp == NULL || (*idxp)->linear)
+    return NULL;
+  return *idxp;
+}
+
+/* Return the number of entries with a value at or below ADDR.  When
+   the lookups come in ascending order, FROM is the result of the
+   previous lookup and we gallop forward from there.  */
+static size_t
+find_symentry (const struct dwfl_symindex *idx, GElf_Addr addr, size_t from)
+{
+  size_t l = 0;
+  size_t u = idx->n;
+  if (from > 0 && from <= idx->n && idx->entries[from - 1].value <= addr)
+    {
+      l = from;
+      size_t step = 1;
+      while (step <= idx->n - l && idx->entries[l + step - 1].value <= addr)
+	{
+	  l += step;
+	  step *= 2;
+	}
+      u = MIN (l + step - 1, idx->n);
+    }
+
+  while (l < u)
+    {
+      size_t i = (l + u) / 2;
+      if (idx->entries[i].value <= addr)
+	l = i + 1;
+      else
+	u = i;
+    }
+  return l;
+}
+
+/* The values that can make a difference for one address.  */
+#define MAX_CANDIDATES 64
+struct candidates
+{
+  size_t n;
+  GElf_Addr max_global;
+  GElf_Addr max_local;
+  const struct dwfl_symentry *entries[MAX_CANDIDATES];
+};
+
+static bool
+add_candidate (struct candidates *cands, const struct dwfl_symentry *entry)
+{
+  if (cands->n == MAX_CANDIDATES)
+    return false;
+
+  /* Keep them in the order search_table tries them, so ties resolve
+     the same way: of equally good sized symbols the first one wins,
+     of the sizeless ones at the same address the last one does.  */
+  size_t i = cands->n++;
+  while (i > 0 && (cands->entries[i - 1]->ndx > entry->ndx
+		   || (cands->entries[i - 1]->ndx == entry->ndx
+		       && cands->entries[i - 1]->adjusted > entry->adjusted)))
+    {
+      cands->entries[i] = cands->entries[i - 1];
+      i--;
+    }
+  cands->entries[i] = entry;
+  return true;
+}
+
+/* Add the sizeless symbols with value LABEL among the first N entries.  */
+static bool
+add_labels (struct candidates *cands, const struct dwfl_symindex *idx,
+	    size_t n, GElf_Addr label)
+{
+  size_t l = 0;
+  size_t u = n;
+  while (l < u)
+    {
+      size_t i = (l + u) / 2;
+      if (idx->entries[i].value < label)
+	l = i + 1;
+      else
+	u = i;
+    }
+
+  for (; l < n && idx->entries[l].value == label; ++l)
+    if (idx->entries[l].end == label
+	&& ! add_candidate (cands, &idx->entries[l]))
+      return false;
+  return true;
+}
+
+/* Collect the values search_table would try for STATE->addr that can
+   change the outcome.  Those are the sized symbols that contain the
+   address and the sizeless symbols at the final min_label of either
+   pass, others will always lose against these or against min_label.
+   Return false if there are too many.  */
+static bool
+find_candidates (struct search_state *state, const struct dwfl_symindex *idx,
+		 size_t *hint, struct candidates *cands)
+{
+  GElf_Addr addr = state->addr;
+  size_t n = find_symentry (idx, addr, *hint);
+  *hint = n;
+
+  cands->n = 0;
+  cands->max_global = 0;
+  cands->max_local = 0;
+  if (n == 0)
+    return true;
+
+  cands->max_global = idx->entries[n - 1].max_global;
+  cands->max_local = idx->entries[n - 1].max_local;
+
+  for (size_t i = n; i > 0; --i)
+    {
+      const struct dwfl_symentry *entry = &idx->entries[i - 1];
+      if (entry->max_global <= addr && entry->max_local <= addr)
+	break;
+      if (entry->end > addr && ! add_candidate (cands, entry))
+	return false;
+    }
+
+  GElf_Addr label = cands->max_global;
+  if (label <= addr && ! add_labels (cands, idx, n, label))
+    return false;
+  if (cands->max_local > label)
+    {
+      label = cands->max_local;
+      if (label <= addr && ! add_labels (cands, idx, n, label))
+	return false;
+    }
+  return true;
+}
+
+/* Like search_table, but only try the candidates.  */
+static inline void
+search_candidates (struct search_state *state,
+		   const struct candidates *cands, int start, int end)
+{
+  for (size_t i = 0; i < cands->n; ++i)
+    {
+      const struct dwfl_symentry *entry = cands->entries[i];
+      if (entry->ndx < start || entry->ndx >= end)
+	continue;
+
+      GElf_Sym sym;
+      GElf_Addr value;
+      GElf_Word shndx;
+      Elf *elf;
+      bool resolved;
+      const char *name = __libdwfl_getsym (state->mod, entry->ndx, &sym,
+					   &value, &shndx, &elf, NULL,
+					   &resolved,
+					   state->adjust_st_value);
+      if (name == NULL)
+	continue;
+      if (entry->adjusted)
+	try_sym_value (state, entry->value, &sym, name, shndx, elf, false);
+      else
+	try_sym_value (state, entry->value, &sym, name, shndx, elf,
+		       resolved);
+    }
+}
+
 /* Returns the name of the symbol "closest" to ADDR.
    Never returns symbols at addresses above ADDR.
 
    Wrapper for old dwfl_module_addrsym and new dwfl_module_addrinfo.
    adjust_st_value set to true returns adjusted SYM st_value, set to false
-   it will not adjust SYM at all, but does match against resolved values.   */
+   it will not adjust SYM at all, but does match against resolved values.
+   HINT is used by find_symentry, for a first or unordered lookup it
+   should be zero.  */
 static const char *
 __libdwfl_addrsym (Dwfl_Module *_mod, GElf_Addr _addr, GElf_Off *off,
 		   GElf_Sym *_closest_sym, GElf_Word *shndxp,
-		   Elf **elfp, Dwarf_Addr *biasp, bool _adjust_st_value)
+		   Elf **elfp, Dwarf_Addr *biasp, bool _adjust_st_value,
+		   size_t *hint)
 {
   int syments = INTUSE(dwfl_module_getsymtab) (_mod);
   if (syments < 0)
@@ -281,13 +592,38 @@ __libdwfl_addrsym (Dwfl_Module *_mod, GElf_Addr _addr, GElf_Off *off,
   int first_global = INTUSE (dwfl_module_getsymtab_first_global) (state.mod);
   if (first_global < 0)
     return NULL;
-  search_table (&state, first_global == 0 ? 1 : first_global, syments);
+
+  /* Instead of going through all symbols, only try those the index
+     says can matter, with min_label set up front to what going
+     through all of them would end with.  */
+  struct candidates cands;
+  struct dwfl_symindex *idx = get_symindex (state.mod, syments, first_global,
+					    state.adjust_st_value);
+  bool use_index = (idx != NULL
+		    && find_candidates (&state, idx, hint, &cands));
+
+  if (use_index)
+    {
+      state.min_label = cands.max_global;
+      search_candidates (&state, &cands,
+			 first_global == 0 ? 1 : first_global, syments);
+    }
+  else
+    search_table (&state, first_global == 0 ? 1 : first_global, syments);
 
   /* If we found nothing searching the global symbols, then try the locals.
      Unless we have a global sizeless symbol that matches exactly.  */
   if (state.closest_name == NULL && first_global > 1
       && (state.sizeless_name == NULL || state.sizeless_value != state.addr))
-    search_table (&state, 1, first_global);
+    {
+      if (use_index)
+	{
+	  state.min_label = MAX (cands.max_global, cands.max_local);
+	  search_candidates (&state, &cands, 1, first_global);
+	}
+      else
+	search_table (&state, 1, first_global);
+    }
 
   /* If we found no proper sized symbol to use, fall back to the best
      candidate sizeless symbol we found, if any.  */
@@ -319,8 +655,9 @@ dwfl_module_addrsym (Dwfl_Module *mod, GElf_Addr addr,
 		     GElf_Sym *closest_sym, GElf_Word *shndxp)
 {
   GElf_Off off;
+  size_t hint = 0;
   return __libdwfl_addrsym (mod, addr, &off, closest_sym, shndxp,
-			    NULL, NULL, true);
+			    NULL, NULL, true, &hint);
 }
 INTDEF (dwfl_module_addrsym)
 
@@ -329,7 +666,34 @@ const char
 		       GElf_Off *offset, GElf_Sym *sym,
 		       GElf_Word *shndxp, Elf **elfp, Dwarf_Addr *bias)
 {
+  size_t hint = 0;
   return __libdwfl_addrsym (mod, address, offset, sym, shndxp, elfp, bias,
-			    false);
+			    false, &hint);
 }
 INTDEF (dwfl_module_addrinfo)
+
+ptrdiff_t
+dwfl_module_addrinfo_batch (Dwfl_Module *mod, const GElf_Addr *addrs,
+			    size_t n, const char **names, GElf_Off *offsets,
+			    GElf_Sym *syms)
+{
+  if (INTUSE(dwfl_module_getsymtab) (mod) < 0)
+    return -1;
+
+  ptrdiff_t found = 0;
+  size_t hint = 0;
+  for (size_t i = 0; i < n; i++)
+    {
+      GElf_Off off;
+      GElf_Sym sym;
+      names[i] = __libdwfl_addrsym (mod, addrs[i], &off, &sym, NULL, NULL,
+				    NULL, false, &hint);
+      if (names[i] != NULL)
+	found++;
+      if (offsets != NULL)
+	offsets[i] = off;
+      if (syms != NULL)
+	syms[i] = sym;
+    }
+  return found;
+}
@@ -695,6 +695,74 @@ enum
   i_max
 };
 
+/* Load the hash table of a dynamic symbol table found through the
+   phdrs, preferring .gnu.hash, see dwfl_module_symbol_by_name.  */
+static void
+load_symhash (Dwfl_Module *mod, GElf_Off hash_off, GElf_Off gnu_hash_off,
+	      GElf_Ehdr *ehdr)
+{
+  Elf *elf = mod->main.elf;
+  if (gnu_hash_off != 0)
+    {
+      Elf_Data *data = elf_getdata_rawchunk (elf, gnu_hash_off,
+					     4 * sizeof (Elf32_Word),
+					     ELF_T_WORD);
+      if (data != NULL)
+	{
+	  const Elf32_Word *header = data->d_buf;
+	  Elf32_Word nbuckets = header[0];
+	  Elf32_Word symndx = header[1];
+	  Elf32_Word maskwords = header[2];
+	  /* The chain has an entry for each symbol from symndx on.  */
+	  GElf_Off size = ((4 + (GElf_Off) nbuckets + mod->syments - symndx)
+			   * sizeof (Elf32_Word)
+			   + (GElf_Off) maskwords * gelf_fsize (elf, ELF_T_ADDR,
+								1, EV_CURRENT));
+	  // elf_getdata_rawchunk takes a size_t, make sure it
+	  // doesn't overflow.
+	  data = NULL;
+	  if (symndx <= mod->syments
+#if SIZE_MAX <= UINT32_MAX
+	      && size <= SIZE_MAX
+#endif
+	      )
+	    data = elf_getdata_rawchunk (elf, gnu_hash_off, size,
+					 ELF_T_GNUHASH);
+	  if (data != NULL)
+	    {
+	      mod->symhashdata = data;
+	      mod->symhash_gnu = true;
+	      return;
+	    }
+	}
+    }
+
+  if (hash_off != 0 && SH_ENTSIZE_HASH (ehdr) == sizeof (Elf32_Word))
+    {
+      Elf_Data *data = elf_getdata_rawchunk (elf, hash_off,
+					     2 * sizeof (Elf32_Word),
+					     ELF_T_WORD);
+      if (data != NULL)
+	{
+	  const Elf32_Word *header = data->d_buf;
+	  Elf32_Word nbucket = header[0];
+	  Elf32_Word nchain = header[1];
+	  GElf_Off size = ((2 + (GElf_Off) nbucket + nchain)
+			   * sizeof (Elf32_Word));
+	  data = NULL;
+#if SIZE_MAX <= UINT32_MAX
+	  if (size <= SIZE_MAX)
+#endif
+	    data = elf_getdata_rawchunk (elf, hash_off, size, ELF_T_WORD);
+	  if (data != NULL)
+	    {
+	      mod->symhashdata = data;
+	      mod->symhash_gnu = false;
+	    }
+	}
+    }
+}
+
 /* Translate pointers into file offsets.  ADJUST is either zero
    in case the dynamic segment wasn't adjusted or mod->main_bias.
    Will set mod->symfile if the translated offsets can be used as
@@ -816,6 +884,7 @@ translate_offs (GElf_Addr adjust,
 	{
 	  mod->symfile = &mod->main;
 	  mod->symerr = DWFL_E_NOERROR;
+	  load_symhash (mod, offs[i_hash], offs[i_gnu_hash], ehdr);
 	}
     }
 }
@@ -1048,6 +1117,35 @@ find_aux_sym (Dwfl_Module *mod __attribute__ ((unused)),
 #endif
 }
 
+/* Find the hash table of the dynamic symbol table SYMSCN, preferring
+   .gnu.hash, see dwfl_module_symbol_by_name.  */
+static void
+find_symhash (Dwfl_Module *mod, Elf_Scn *symscn)
+{
+  size_t symndx = elf_ndxscn (symscn);
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (mod->symfile->elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL || shdr->sh_link != symndx
+	  || (shdr->sh_flags & SHF_COMPRESSED) != 0
+	  || (shdr->sh_type != SHT_GNU_HASH && shdr->sh_type != SHT_HASH))
+	continue;
+
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data == NULL || data->d_buf == NULL
+	  || data->d_type != (shdr->sh_type == SHT_GNU_HASH
+			      ? ELF_T_GNUHASH : ELF_T_WORD))
+	continue;
+
+      mod->symhashdata = data;
+      mod->symhash_gnu = shdr->sh_type == SHT_GNU_HASH;
+      if (mod->symhash_gnu)
+	break;
+    }
+}
+
 /* Try to find a symbol table in either MOD->main.elf or MOD->debug.elf.  */
 static void
 find_symtab (Dwfl_Module *mod)
@@ -1133,6 +1231,7 @@ find_symtab (Dwfl_Module *mod)
     {
     elferr:
       mod->symdata = NULL;
+      mod->symhashdata = NULL;
       mod->syments = 0;
       mod->first_global = 0;
       mod->symerr = DWFL_E (LIBELF, elf_errno ());
@@ -1211,6 +1310,9 @@ find_symtab (Dwfl_Module *mod)
       || (size_t) mod->first_global > mod->syments)
     goto elferr;
 
+  if (shdr->sh_type == SHT_DYNSYM)
+    find_symhash (mod, symscn);
+
   /* Cache any auxiliary symbol info, when it fails, just ignore aux_sym.  */
   if (aux_symscn != NULL)
     {
@@ -0,0 +1,133 @@
+/* Find source locations for many PC addresses in a module at once.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "../libdw/libdwP.h"
+
+/* Return the last line at or before ADDR, or 0 if there is none,
+   looking from line FROM on.  Gallop forward first, so lines near the
+   previous lookup are found in a few steps.  */
+static size_t
+find_line (Dwarf_Lines *lines, size_t from, Dwarf_Addr addr)
+{
+  size_t nlines = lines->nlines;
+  size_t l = from;
+  size_t step = 1;
+  while (step < nlines - l && lines->info[l + step].addr <= addr)
+    {
+      l += step;
+      step *= 2;
+    }
+
+  /* The lines are sorted by address, so we can use binary search.  */
+  size_t u = (step < nlines - l ? l + step : nlines) - 1;
+  while (l < u)
+    {
+      size_t idx = u - (u - l) / 2;
+      if (addr < lines->info[idx].addr)
+	u = idx - 1;
+      else
+	l = idx;
+    }
+  return l;
+}
+
+ptrdiff_t
+dwfl_module_getsrc_batch (Dwfl_Module *mod, const Dwarf_Addr *addrs,
+			  size_t n, Dwfl_Line **lines, int *errors)
+{
+  Dwarf_Addr bias;
+  if (INTUSE(dwfl_module_getdwarf) (mod, &bias) == NULL)
+    return -1;
+
+  /* The CU of the previous address and the DWARF addresses that
+     belong to it too.  */
+  struct dwfl_cu *cu = NULL;
+  Dwarf_Addr cu_start = 0;
+  Dwarf_Addr cu_end = 0;
+
+  /* The line found for the previous address in CU, if HAVE_LINE.  */
+  bool have_line = false;
+  size_t line_idx = 0;
+  Dwarf_Addr line_addr = 0;
+
+  ptrdiff_t found = 0;
+  for (size_t i = 0; i < n; i++)
+    {
+      Dwfl_Error error = DWFL_E_NOERROR;
+      Dwarf_Addr dwaddr = dwfl_deadjust_dwarf_addr (mod, addrs[i]);
+      if (cu == NULL || dwaddr < cu_start || dwaddr >= cu_end)
+	{
+	  error = __libdwfl_addrcu_range (mod, addrs[i], &cu,
+					  &cu_start, &cu_end);
+	  if (likely (error == DWFL_E_NOERROR))
+	    error = __libdwfl_cu_getsrclines (cu);
+	  if (unlikely (error != DWFL_E_NOERROR))
+	    cu = NULL;
+	  have_line = false;
+	}
+
+      lines[i] = NULL;
+      if (likely (error == DWFL_E_NOERROR))
+	{
+	  Dwarf_Lines *dwlines = cu->die.cu->lines;
+	  Dwarf_Addr addr = addrs[i] - bias;
+	  if (dwlines->nlines > 0)
+	    {
+	      /* Only a sorted ADDRS lets us continue from the last one.  */
+	      if (! have_line || addr < line_addr)
+		line_idx = 0;
+	      line_idx = find_line (dwlines, line_idx, addr);
+	      line_addr = addr;
+	      have_line = true;
+
+	      /* The last line which is less than or equal to addr is
+		 what we want, unless it is the end_sequence which is
+		 after the current line sequence.  */
+	      Dwarf_Line *line = &dwlines->info[line_idx];
+	      if (! line->end_sequence && line->addr <= addr)
+		{
+		  lines[i] = &cu->lines->idx[line_idx];
+		  found++;
+		}
+	    }
+	  if (lines[i] == NULL)
+	    error = DWFL_E_ADDR_OUTOFRANGE;
+	}
+
+      if (errors != NULL)
+	errors[i] = __libdwfl_canon_error (error);
+    }
+
+  return found;
+}
@@ -0,0 +1,289 @@
+/* Find a symbol in a module by its name.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* One slot of the hash table built over all symbols when the module
+   has no usable ELF hash table.  NDX is zero for an empty slot.  */
+struct dwfl_symname
+{
+  const char *name;
+  Elf32_Word hash;
+  int ndx;
+  int rank;
+};
+
+struct dwfl_symnames
+{
+  size_t mask;
+  struct dwfl_symname slots[];
+};
+
+/* Return GELF_ST_BIND as higher-is-better integer, like
+   dwfl_module_addrsym does.  */
+static inline int
+binding_rank (const GElf_Sym *sym)
+{
+  switch (GELF_ST_BIND (sym->st_info))
+    {
+    case STB_GLOBAL:
+      return 3;
+    case STB_WEAK:
+      return 2;
+    case STB_LOCAL:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+/* Return the name of symbol NDX, or NULL if it is not a defined
+   symbol that can be looked up by name.  */
+static const char *
+symbol_name (Dwfl_Module *mod, int ndx, int *rank)
+{
+  GElf_Sym sym;
+  bool resolved;
+  const char *name = __libdwfl_getsym (mod, ndx, &sym, NULL, NULL, NULL,
+				       NULL, &resolved, true);
+  if (name == NULL || name[0] == '\0'
+      || sym.st_shndx == SHN_UNDEF
+      || GELF_ST_TYPE (sym.st_info) == STT_SECTION
+      || GELF_ST_TYPE (sym.st_info) == STT_FILE)
+    return NULL;
+
+  *rank = binding_rank (&sym);
+  return name;
+}
+
+/* Consider symbol NDX for NAME.  Prefer global over weak over local
+   symbols, and the first symbol of those.  */
+static void
+try_symbol (Dwfl_Module *mod, int ndx, const char *name,
+	    int *best, int *best_rank)
+{
+  int rank;
+  const char *symname = symbol_name (mod, ndx, &rank);
+  if (symname != NULL && strcmp (symname, name) == 0
+      && (*best < 0 || rank > *best_rank
+	  || (rank == *best_rank && ndx < *best)))
+    {
+      *best = ndx;
+      *best_rank = rank;
+    }
+}
+
+/* Look up NAME in the .gnu.hash table of the dynamic symbol table.  */
+static int
+lookup_gnu_hash (Dwfl_Module *mod, int syments, const char *name)
+{
+  Elf_Data *data = mod->symhashdata;
+  const Elf32_Word *words = data->d_buf;
+  size_t nwords = data->d_size / sizeof (Elf32_Word);
+  if (nwords < 4)
+    return -1;
+
+  Elf32_Word nbuckets = words[0];
+  Elf32_Word symndx = words[1];
+  Elf32_Word maskwords = words[2];
+  Elf32_Word shift2 = words[3];
+  size_t bloom_bits = (gelf_getclass (mod->symfile->elf) == ELFCLASS64
+		       ? 64 : 32);
+  size_t bloom_words = (size_t) maskwords * (bloom_bits / 32);
+  if (nbuckets == 0 || maskwords == 0
+      || bloom_words > nwords - 4 || nbuckets > nwords - 4 - bloom_words)
+    return -1;
+
+  Elf32_Word hash = elf_gnu_hash (name);
+
+  /* The bloom filter rejects most names that aren't there.  */
+  if (bloom_bits == 64)
+    {
+      const Elf64_Xword *bloom = (const Elf64_Xword *) &words[4];
+      Elf64_Xword word = bloom[(hash / 64) % maskwords];
+      Elf64_Xword mask = (((Elf64_Xword) 1 << (hash % 64))
+			  | ((Elf64_Xword) 1 << ((hash >> shift2) % 64)));
+      if ((word & mask) != mask)
+	return -1;
+    }
+  else
+    {
+      const Elf32_Word *bloom = &words[4];
+      Elf32_Word word = bloom[(hash / 32) % maskwords];
+      Elf32_Word mask = ((1u << (hash % 32))
+			 | (1u << ((hash >> shift2) % 32)));
+      if ((word & mask) != mask)
+	return -1;
+    }
+
+  const Elf32_Word *buckets = &words[4 + bloom_words];
+  const Elf32_Word *chain = &buckets[nbuckets];
+  size_t nchain = nwords - 4 - bloom_words - nbuckets;
+
+  int best = -1;
+  int best_rank = 0;
+  for (Elf32_Word i = buckets[hash % nbuckets];
+       i >= symndx && i - symndx < nchain && i < (Elf32_Word) syments;
+       ++i)
+    {
+      Elf32_Word h = chain[i - symndx];
+      if ((h | 1) == (hash | 1))
+	try_symbol (mod, i, name, &best, &best_rank);
+      if ((h & 1) != 0)
+	break;
+    }
+  return best;
+}
+
+/* Look up NAME in the .hash table of the dynamic symbol table.  */
+static int
+lookup_hash (Dwfl_Module *mod, int syments, const char *name)
+{
+  Elf_Data *data = mod->symhashdata;
+  const Elf32_Word *words = data->d_buf;
+  size_t nwords = data->d_size / sizeof (Elf32_Word);
+  if (nwords < 2)
+    return -1;
+
+  Elf32_Word nbucket = words[0];
+  Elf32_Word nchain = words[1];
+  if (nbucket == 0 || nbucket > nwords - 2 || nchain > nwords - 2 - nbucket)
+    return -1;
+
+  const Elf32_Word *bucket = &words[2];
+  const Elf32_Word *chain = &bucket[nbucket];
+  Elf32_Word hash = elf_hash (name);
+
+  int best = -1;
+  int best_rank = 0;
+  Elf32_Word n = 0;
+  for (Elf32_Word i = bucket[hash % nbucket];
+       i != 0 && i < nchain && i < (Elf32_Word) syments && n++ < nchain;
+       i = chain[i])
+    try_symbol (mod, i, name, &best, &best_rank);
+  return best;
+}
+
+/* Build a hash table over all symbols, keeping only the preferred
+   symbol for each name.  */
+static struct dwfl_symnames *
+build_symnames (Dwfl_Module *mod, int syments)
+{
+  size_t size = 16;
+  while (size < 2 * (size_t) syments)
+    size *= 2;
+
+  struct dwfl_symnames *names = calloc (1, (sizeof *names
+					    + size * sizeof names->slots[0]));
+  if (names == NULL)
+    return NULL;
+  names->mask = size - 1;
+
+  for (int ndx = 1; ndx < syments; ++ndx)
+    {
+      int rank;
+      const char *name = symbol_name (mod, ndx, &rank);
+      if (name == NULL)
+	continue;
+
+      Elf32_Word hash = elf_gnu_hash (name);
+      size_t i = hash & names->mask;
+      while (names->slots[i].ndx != 0
+	     && (names->slots[i].hash != hash
+		 || strcmp (names->slots[i].name, name) != 0))
+	i = (i + 1) & names->mask;
+
+      struct dwfl_symname *slot = &names->slots[i];
+      if (slot->ndx == 0 || rank > slot->rank)
+	{
+	  slot->name = name;
+	  slot->hash = hash;
+	  slot->ndx = ndx;
+	  slot->rank = rank;
+	}
+    }
+
+  return names;
+}
+
+static int
+lookup_symnames (struct dwfl_symnames *names, const char *name)
+{
+  Elf32_Word hash = elf_gnu_hash (name);
+  for (size_t i = hash & names->mask;
+       names->slots[i].ndx != 0;
+       i = (i + 1) & names->mask)
+    if (names->slots[i].hash == hash
+	&& strcmp (names->slots[i].name, name) == 0)
+      return names->slots[i].ndx;
+  return -1;
+}
+
+int
+dwfl_module_symbol_by_name (Dwfl_Module *mod, const char *name,
+			    GElf_Sym *sym, GElf_Addr *addr,
+			    GElf_Word *shndxp, Elf **elfp, Dwarf_Addr *bias)
+{
+  int syments = INTUSE(dwfl_module_getsymtab) (mod);
+  if (syments < 0)
+    return -1;
+
+  /* A dynamic symbol table comes with a hash table, use it unless
+     there is also an auxiliary table.  Otherwise build our own.  */
+  int ndx;
+  if (mod->symhashdata != NULL && mod->aux_symdata == NULL)
+    ndx = (mod->symhash_gnu
+	   ? lookup_gnu_hash (mod, syments, name)
+	   : lookup_hash (mod, syments, name));
+  else
+    {
+      if (mod->symnames == NULL)
+	{
+	  mod->symnames = build_symnames (mod, syments);
+	  if (mod->symnames == NULL)
+	    {
+	      __libdwfl_seterrno (DWFL_E_NOMEM);
+	      return -1;
+	    }
+	}
+      ndx = lookup_symnames (mod->symnames, name);
+    }
+
+  if (ndx < 0
+      || INTUSE(dwfl_module_getsym_info) (mod, ndx, sym, addr, shndxp,
+					  elfp, bias) == NULL)
+    return -1;
+  return ndx;
+}
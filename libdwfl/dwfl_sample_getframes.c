@@ -0,0 +1,245 @@
+/* Unwind a stack sample copied from a thread.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include <byteswap.h>
+#include <endian.h>
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+# define MY_ELFDATA	ELFDATA2LSB
+#else
+# define MY_ELFDATA	ELFDATA2MSB
+#endif
+
+/* The callbacks_arg of a Dwfl attached by dwfl_sample_getframes.  It
+   holds the sample being unwound, and the one thread all the samples
+   are unwound with.  */
+struct __libdwfl_sample_arg
+{
+  Dwfl_Thread thread;
+  const Dwarf_Word *regs;
+  size_t nregs;
+  Dwarf_Addr pc;
+  Dwarf_Addr stack_addr;
+  const unsigned char *stack;
+  size_t stack_size;
+};
+
+/* Return where the SIZE bytes at ADDR are in the file of the module
+   containing them, or NULL.  */
+static const unsigned char *
+module_memory (Dwfl *dwfl, Dwarf_Addr addr, size_t size)
+{
+  Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (dwfl, addr);
+  if (mod == NULL)
+    return NULL;
+  Dwarf_Addr bias;
+  Elf *elf = INTUSE(dwfl_module_getelf) (mod, &bias);
+  if (elf == NULL)
+    return NULL;
+  size_t fsize;
+  const unsigned char *file = (const unsigned char *) elf_rawfile (elf,
+								    &fsize);
+  size_t phnum;
+  if (file == NULL || elf_getphdrnum (elf, &phnum) != 0)
+    return NULL;
+
+  addr -= bias;
+  for (size_t i = 0; i < phnum; i++)
+    {
+      GElf_Phdr phdr_mem, *phdr = gelf_getphdr (elf, i, &phdr_mem);
+      if (phdr == NULL || phdr->p_type != PT_LOAD
+	  || addr < phdr->p_vaddr || phdr->p_filesz < size
+	  || addr - phdr->p_vaddr > phdr->p_filesz - size)
+	continue;
+      GElf_Off offset = phdr->p_offset + (addr - phdr->p_vaddr);
+      if (offset > fsize || fsize - offset < size)
+	return NULL;
+      return file + offset;
+    }
+  return NULL;
+}
+
+static bool
+sample_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
+		    void *dwfl_arg)
+{
+  struct __libdwfl_sample_arg *sample = dwfl_arg;
+  Ebl *ebl = dwfl->process->ebl;
+  size_t size = ebl_get_elfclass (ebl) == ELFCLASS64 ? 8 : 4;
+
+  const unsigned char *src;
+  if (addr >= sample->stack_addr && sample->stack_size >= size
+      && addr - sample->stack_addr <= sample->stack_size - size)
+    src = sample->stack + (addr - sample->stack_addr);
+  else
+    src = module_memory (dwfl, addr, size);
+  if (src == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_ADDR_OUTOFRANGE);
+      return false;
+    }
+
+  bool swap = ebl_get_elfdata (ebl) != MY_ELFDATA;
+  if (size == 8)
+    {
+      uint64_t val;
+      memcpy (&val, src, sizeof val);
+      *result = swap ? bswap_64 (val) : val;
+    }
+  else
+    {
+      uint32_t val;
+      memcpy (&val, src, sizeof val);
+      *result = swap ? bswap_32 (val) : val;
+    }
+  return true;
+}
+
+static pid_t
+sample_next_thread (Dwfl *dwfl __attribute__ ((unused)),
+		    void *dwfl_arg __attribute__ ((unused)),
+		    void **thread_argp __attribute__ ((unused)))
+{
+  /* A sample is not a thread that can be found by dwfl_getthreads.  */
+  return 0;
+}
+
+static bool
+sample_set_initial_registers (Dwfl_Thread *thread, void *thread_arg)
+{
+  struct __libdwfl_sample_arg *sample = thread_arg;
+  if (! INTUSE(dwfl_thread_state_registers) (thread, 0, sample->nregs,
+					      sample->regs))
+    return false;
+  INTUSE(dwfl_thread_state_register_pc) (thread, sample->pc);
+  return true;
+}
+
+static void
+sample_detach (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg)
+{
+  free (dwfl_arg);
+}
+
+static const Dwfl_Thread_Callbacks sample_thread_callbacks =
+{
+  sample_next_thread,
+  NULL, /* get_thread */
+  sample_memory_read,
+  sample_set_initial_registers,
+  sample_detach,
+  NULL, /* thread_detach */
+  NULL, /* memory_read_bulk */
+};
+
+struct sample_pcs
+{
+  Dwarf_Addr *pcs;
+  size_t maxpcs;
+  size_t npcs;
+};
+
+static int
+sample_frame_cb (Dwfl_Frame *state, void *arg)
+{
+  struct sample_pcs *pcs = arg;
+  if (! INTUSE(dwfl_frame_pc) (state, &pcs->pcs[pcs->npcs], NULL))
+    return -1;
+  return ++pcs->npcs < pcs->maxpcs ? DWARF_CB_OK : DWARF_CB_ABORT;
+}
+
+int
+dwfl_sample_getframes (Dwfl *dwfl, pid_t pid,
+		       const Dwarf_Word *regs, size_t nregs, Dwarf_Addr pc,
+		       Dwarf_Addr stack_addr, const void *stack,
+		       size_t stack_size, Dwarf_Addr *pcs, size_t maxpcs)
+{
+  if (dwfl == NULL)
+    return -1;
+
+  Dwfl_Process *process = dwfl->process;
+  if (process == NULL)
+    {
+      struct __libdwfl_sample_arg *sample = malloc (sizeof *sample);
+      if (sample == NULL)
+	{
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return -1;
+	}
+      if (! INTUSE(dwfl_attach_state) (dwfl, NULL, pid,
+				       &sample_thread_callbacks, sample))
+	{
+	  free (sample);
+	  return -1;
+	}
+      process = dwfl->process;
+      sample->thread.process = process;
+      sample->thread.tid = pid;
+      sample->thread.unwound = NULL;
+      sample->thread.callbacks_arg = sample;
+      sample->thread.prepared = NULL;
+      sample->thread.prepare_error = DWFL_E_NOERROR;
+      sample->thread.mem_cache = NULL;
+      if (INTUSE(dwfl_frame_reuse) (dwfl, true) != 0)
+	return -1;
+    }
+  else if (process->callbacks != &sample_thread_callbacks)
+    {
+      __libdwfl_seterrno (DWFL_E_ATTACH_STATE_CONFLICT);
+      return -1;
+    }
+
+  if (maxpcs == 0)
+    return 0;
+
+  struct __libdwfl_sample_arg *sample = process->callbacks_arg;
+  sample->regs = regs;
+  sample->nregs = nregs;
+  sample->pc = pc;
+  sample->stack_addr = stack_addr;
+  sample->stack = stack;
+  sample->stack_size = stack_size;
+
+  struct sample_pcs sample_pcs = { pcs, maxpcs, 0 };
+  int err = INTUSE(dwfl_thread_getframes) (&sample->thread, sample_frame_cb,
+					   &sample_pcs);
+  sample->regs = NULL;
+  sample->stack = NULL;
+
+  /* Running out of stack or unwind information ends most samples, the
+     frames up to there are what the caller wants.  */
+  if (err == -1 && sample_pcs.npcs == 0)
+    return -1;
+  return sample_pcs.npcs;
+}
@@ -0,0 +1,92 @@
+/* Choose between CFI and frame pointer unwinding, and count their frames.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+
+static bool
+valid_policy (Dwfl_Unwind_Policy policy)
+{
+  switch (policy)
+    {
+    case DWFL_UNWIND_POLICY_DEFAULT:
+    case DWFL_UNWIND_POLICY_CFI:
+    case DWFL_UNWIND_POLICY_CFI_ONLY:
+    case DWFL_UNWIND_POLICY_FRAME_POINTER:
+    case DWFL_UNWIND_POLICY_FRAME_POINTER_ONLY:
+      return true;
+    }
+  __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
+  return false;
+}
+
+int
+dwfl_set_unwind_policy (Dwfl *dwfl, Dwfl_Unwind_Policy policy)
+{
+  if (! valid_policy (policy))
+    return -1;
+  dwfl->unwind_policy = policy;
+  return 0;
+}
+
+int
+dwfl_module_set_unwind_policy (Dwfl_Module *mod, Dwfl_Unwind_Policy policy)
+{
+  if (! valid_policy (policy))
+    return -1;
+  mod->unwind_policy = policy;
+  return 0;
+}
+
+Dwfl_Unwind_Method
+dwfl_frame_unwind_method (Dwfl_Frame *state)
+{
+  return state->unwind_method;
+}
+
+int
+dwfl_unwind_stats (Dwfl *dwfl, size_t *cfi, size_t *frame_pointer,
+		   size_t *rejected)
+{
+  if (dwfl == NULL)
+    return -1;
+
+  if (cfi != NULL)
+    *cfi = __atomic_load_n (&dwfl->unwind_cfi_frames, __ATOMIC_RELAXED);
+  if (frame_pointer != NULL)
+    *frame_pointer = __atomic_load_n (&dwfl->unwind_fp_frames,
+				      __ATOMIC_RELAXED);
+  if (rejected != NULL)
+    *rejected = __atomic_load_n (&dwfl->unwind_fp_rejected,
+				 __ATOMIC_RELAXED);
+  return 0;
+}
@@ -32,6 +32,7 @@
 
 #include "cfi.h"
 #include <stdlib.h>
+#include <sys/param.h>
 #include "libdwflP.h"
 #include "../libdw/dwarf.h"
 #include <system.h>
@@ -97,12 +98,24 @@ bra_compar (const void *key_voidp, const void *elem_voidp)
   return (offset > op->offset) - (offset < op->offset);
 }
 
+/* Most expressions need only a few stack slots, those come from MEM so
+   that evaluating them doesn't need any allocation.  */
+#define EVAL_STACK_MEM 16
+
 struct eval_stack {
   Dwarf_Addr *addrs;
   size_t used;
   size_t allocated;
+  Dwarf_Addr mem[EVAL_STACK_MEM];
 };
 
+static void
+stack_free (struct eval_stack *stack)
+{
+  if (stack->addrs != stack->mem)
+    free (stack->addrs);
+}
+
 static bool
 do_push (struct eval_stack *stack, Dwarf_Addr val)
 {
@@ -115,8 +128,15 @@ do_push (struct eval_stack *stack, Dwarf_Addr val)
     {
       stack->allocated = MAX (stack->allocated * 2, 32);
       Dwarf_Addr *new_addrs;
-      new_addrs = realloc (stack->addrs,
-			   stack->allocated * sizeof (*stack->addrs));
+      if (stack->addrs == stack->mem)
+	{
+	  new_addrs = malloc (stack->allocated * sizeof (*stack->addrs));
+	  if (new_addrs != NULL)
+	    memcpy (new_addrs, stack->mem, sizeof stack->mem);
+	}
+      else
+	new_addrs = realloc (stack->addrs,
+			     stack->allocated * sizeof (*stack->addrs));
       if (new_addrs == NULL)
         {
           __libdwfl_seterrno (DWFL_E_NOMEM);
@@ -140,14 +160,66 @@ do_pop (struct eval_stack *stack, Dwarf_Addr *val)
   return true;
 }
 
-/* If FRAME is NULL is are computing CFI frame base.  In such case another
+/* How to recover one register, compiled from a Dwarf_Frame row.  */
+struct frame_rule
+{
+  enum
+    {
+      rule_error,		/* dwarf_frame_register failed.  */
+      rule_undefined,
+      rule_same_value,
+      rule_offset,		/* Saved at CFA + OFFSET.  */
+      rule_val_offset,		/* The value is CFA + OFFSET.  */
+      rule_register,		/* The value is in register REGNO.  */
+      rule_expr			/* Evaluate OPS.  */
+    } kind;
+  uint32_t nops;
+  union
+  {
+    Dwarf_Sword offset;
+    Dwarf_Word regno;
+    const Dwarf_Op *ops;
+  };
+};
+
+/* All rules of one Dwarf_Frame row, which covers [START, END) of the
+   CFI it came from.  Expression rules point to the expressions libdw
+   keeps in the Dwarf_CFI, so these are only valid as long as it.  */
+struct dwfl_frame_rules
+{
+  Dwarf_Addr start;
+  Dwarf_Addr end;
+  unsigned int ra;		/* CIE return_address_register.  */
+  bool signal_frame;
+  unsigned char elfclass;
+  enum { cfa_rule_undefined, cfa_rule_register, cfa_rule_expr,
+	 cfa_rule_invalid } cfa_kind;
+  Dwarf_Word cfa_regno;
+  Dwarf_Sword cfa_offset;
+  const Dwarf_Op *cfa_ops;
+  size_t cfa_nops;
+  size_t nregs;
+  struct frame_rule regs[];
+};
+
+/* The CFA of the frame being unwound, computed on first use.  While the
+   CFA itself is being computed STATE is cfa_failed, as another
    DW_OP_call_frame_cfa is no longer permitted.  */
+struct frame_cfa
+{
+  const struct dwfl_frame_rules *rules;
+  enum { cfa_unknown, cfa_known, cfa_failed } state;
+  Dwarf_Addr value;
+};
+
+static bool get_cfa (Dwfl_Frame *state, struct frame_cfa *cfa,
+		     Dwarf_Addr bias, Dwarf_Addr *value);
 
 static bool
-expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
+expr_eval (Dwfl_Frame *state, struct frame_cfa *cfa, const Dwarf_Op *ops,
 	   size_t nops, Dwarf_Addr *result, Dwarf_Addr bias)
 {
-  Dwfl_Process *process = state->thread->process;
+  Dwfl_Thread *thread = state->thread;
   if (nops == 0)
     {
       __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
@@ -155,10 +227,10 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
     }
   struct eval_stack stack =
     {
-      .addrs = NULL,
       .used = 0,
-      .allocated = 0
+      .allocated = EVAL_STACK_MEM
     };
+  stack.addrs = stack.mem;
 
 #define pop(x) do_pop(&stack, x)
 #define push(x) do_push(&stack, x)
@@ -179,14 +251,14 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_lit0 ... DW_OP_lit31:
 	  if (! push (op->atom - DW_OP_lit0))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_addr:
 	  if (! push (op->number + bias))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -206,7 +278,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_consts:
 	  if (! push (op->number))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -214,67 +286,67 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	  if (! state_get_reg (state, op->atom - DW_OP_reg0, &val1)
 	      || ! push (val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_regx:
 	  if (! state_get_reg (state, op->number, &val1) || ! push (val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_breg0 ... DW_OP_breg31:
 	  if (! state_get_reg (state, op->atom - DW_OP_breg0, &val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  val1 += op->number;
 	  if (! push (val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_bregx:
 	  if (! state_get_reg (state, op->number, &val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  val1 += op->number2;
 	  if (! push (val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_dup:
 	  if (! pop (&val1) || ! push (val1) || ! push (val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_drop:
 	  if (! pop (&val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_pick:
 	  if (stack.used <= op->number)
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
 	      return false;
 	    }
 	  if (! push (stack.addrs[stack.used - 1 - op->number]))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -282,14 +354,14 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	  if (! pop (&val1) || ! pop (&val2)
 	      || ! push (val2) || ! push (val1) || ! push (val2))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
 	case DW_OP_swap:
 	  if (! pop (&val1) || ! pop (&val2) || ! push (val1) || ! push (val2))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -299,33 +371,26 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	    if (! pop (&val1) || ! pop (&val2) || ! pop (&val3)
 		|| ! push (val1) || ! push (val3) || ! push (val2))
 	      {
-		free (stack.addrs);
+		stack_free (&stack);
 		return false;
 	      }
 	  }
 	  break;
 	case DW_OP_deref:
 	case DW_OP_deref_size:
-	  if (process->callbacks->memory_read == NULL)
-	    {
-	      free (stack.addrs);
-	      __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
-	      return false;
-	    }
 	  if (! pop (&val1)
-	      || ! process->callbacks->memory_read (process->dwfl, val1, &val1,
-						    process->callbacks_arg))
+	      || ! __libdwfl_memory_read (thread, val1, &val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  if (op->atom == DW_OP_deref_size)
 	    {
-	      const int elfclass = frame->cache->e_ident[EI_CLASS];
+	      const int elfclass = cfa->rules->elfclass;
 	      const unsigned addr_bytes = elfclass == ELFCLASS32 ? 4 : 8;
 	      if (op->number > addr_bytes)
 		{
-		  free (stack.addrs);
+		  stack_free (&stack);
 		  __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
 		  return false;
 		}
@@ -341,7 +406,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	    }
 	  if (! push (val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -349,7 +414,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case atom:							\
 	  if (! pop (&val1) || ! push (expr))				\
 	    {								\
-	      free (stack.addrs);					\
+	      stack_free (&stack);					\
 	      return false;						\
 	    }								\
 	  break;
@@ -360,7 +425,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_plus_uconst:
 	  if (! pop (&val1) || ! push (val1 + op->number))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -368,7 +433,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case atom:							\
 	  if (! pop (&val2) || ! pop (&val1) || ! push (val1 op val2))	\
 	    {								\
-	      free (stack.addrs);					\
+	      stack_free (&stack);					\
 	      return false;						\
 	    }								\
 	  break;
@@ -377,7 +442,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	  if (! pop (&val2) || ! pop (&val1)				\
 	      || ! push ((int64_t) val1 op (int64_t) val2))		\
 	    {								\
-	      free (stack.addrs);					\
+	      stack_free (&stack);					\
 	      return false;						\
 	    }								\
 	  break;
@@ -385,18 +450,18 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_div:
 	  if (! pop (&val2) || ! pop (&val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  if (val2 == 0)
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
 	      return false;
 	    }
 	  if (! push ((int64_t) val1 / (int64_t) val2))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -404,18 +469,18 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_mod:
 	  if (! pop (&val2) || ! pop (&val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  if (val2 == 0)
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
 	      return false;
 	    }
 	  if (! push (val1 % val2))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  break;
@@ -437,7 +502,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_bra:
 	  if (! pop (&val1))
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  if (val1 == 0)
@@ -449,7 +514,7 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 					   sizeof (*ops), bra_compar);
 	  if (found == NULL)
 	    {
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      /* PPC32 vDSO has such invalid operations.  */
 	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
 	      return false;
@@ -460,18 +525,11 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
 	case DW_OP_nop:
 	  break;
 	/* DW_OP_* not listed in libgcc/unwind-dw2.c execute_stack_op:  */
-	case DW_OP_call_frame_cfa:;
+	case DW_OP_call_frame_cfa:
 	  // Not used by CFI itself but it is synthetized by elfutils internation.
-	  Dwarf_Op *cfa_ops;
-	  size_t cfa_nops;
-	  Dwarf_Addr cfa;
-	  if (frame == NULL
-	      || dwarf_frame_cfa (frame, &cfa_ops, &cfa_nops) != 0
-	      || ! expr_eval (state, NULL, cfa_ops, cfa_nops, &cfa, bias)
-	      || ! push (cfa))
+	  if (! get_cfa (state, cfa, bias, &val1) || ! push (val1))
 	    {
-	      __libdwfl_seterrno (DWFL_E_LIBDW);
-	      free (stack.addrs);
+	      stack_free (&stack);
 	      return false;
 	    }
 	  is_location = true;
@@ -487,19 +545,13 @@ expr_eval (Dwfl_Frame *state, Dwarf_Frame *frame, const Dwarf_Op *ops,
     }
   if (! pop (result))
     {
-      free (stack.addrs);
+      stack_free (&stack);
       return false;
     }
-  free (stack.addrs);
+  stack_free (&stack);
   if (is_location)
     {
-      if (process->callbacks->memory_read == NULL)
-	{
-	  __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
-	  return false;
-	}
-      if (! process->callbacks->memory_read (process->dwfl, *result, result,
-					     process->callbacks_arg))
+      if (! __libdwfl_memory_read (thread, *result, result))
 	return false;
     }
   return true;
@@ -512,21 +564,11 @@ new_unwound (Dwfl_Frame *state)
 {
   assert (state->unwound == NULL);
   Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
-  Ebl *ebl = process->ebl;
-  size_t nregs = ebl_frame_nregs (ebl);
-  assert (nregs > 0);
-  Dwfl_Frame *unwound;
-  unwound = malloc (sizeof (*unwound) + sizeof (*unwound->regs) * nregs);
+  assert (ebl_frame_nregs (thread->process->ebl) > 0);
+  Dwfl_Frame *unwound = __libdwfl_frame_alloc (thread);
   if (unlikely (unwound == NULL))
     return NULL;
   state->unwound = unwound;
-  unwound->thread = thread;
-  unwound->unwound = NULL;
-  unwound->signal_frame = false;
-  unwound->initial_frame = false;
-  unwound->pc_state = DWFL_FRAME_STATE_ERROR;
-  memset (unwound->regs_set, 0, sizeof (unwound->regs_set));
   return unwound;
 }
 
@@ -535,77 +577,331 @@ new_unwound (Dwfl_Frame *state)
    archs with invalid CFI for some registers where the registers are never used
    later.  Therefore we continue unwinding leaving the registers undefined.  */
 
-static void
-handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
+static bool
+get_cfa (Dwfl_Frame *state, struct frame_cfa *cfa, Dwarf_Addr bias,
+	 Dwarf_Addr *value)
+{
+  if (cfa->state == cfa_unknown)
+    {
+      const struct dwfl_frame_rules *rules = cfa->rules;
+      bool ok;
+      switch (rules->cfa_kind)
+	{
+	case cfa_rule_register:
+	  ok = state_get_reg (state, rules->cfa_regno, &cfa->value);
+	  cfa->value += rules->cfa_offset;
+	  break;
+
+	case cfa_rule_expr:
+	  {
+	    /* The CFA expression itself cannot refer to the CFA.  */
+	    struct frame_cfa nested = { .rules = rules, .state = cfa_failed };
+	    ok = expr_eval (state, &nested, rules->cfa_ops, rules->cfa_nops,
+			    &cfa->value, bias);
+	  }
+	  break;
+
+	default:
+	  ok = false;
+	  break;
+	}
+      cfa->state = ok ? cfa_known : cfa_failed;
+    }
+
+  if (cfa->state == cfa_failed)
+    {
+      __libdwfl_seterrno (DWFL_E_LIBDW);
+      return false;
+    }
+  *value = cfa->value;
+  return true;
+}
+
+/* Compile the register rules of FRAME for the first NREGS registers.  */
+static struct dwfl_frame_rules *
+compile_rules (Dwarf_Frame *frame, size_t nregs)
+{
+  struct dwfl_frame_rules *rules = malloc (sizeof *rules
+					   + nregs * sizeof rules->regs[0]);
+  if (unlikely (rules == NULL))
+    return NULL;
+
+  rules->start = frame->start;
+  rules->end = frame->end;
+  rules->ra = frame->fde->cie->return_address_register;
+  rules->signal_frame = frame->fde->cie->signal_frame;
+  rules->elfclass = frame->cache->e_ident[EI_CLASS];
+  rules->nregs = nregs;
+
+  switch (frame->cfa_rule)
+    {
+    case cfa_offset:
+      rules->cfa_kind = cfa_rule_register;
+      rules->cfa_regno = frame->cfa_val_reg;
+      rules->cfa_offset = frame->cfa_val_offset;
+      break;
+
+    case cfa_expr:
+      {
+	Dwarf_Op *ops;
+	if (dwarf_frame_cfa (frame, &ops, &rules->cfa_nops) == 0)
+	  {
+	    rules->cfa_kind = cfa_rule_expr;
+	    rules->cfa_ops = ops;
+	  }
+	else
+	  rules->cfa_kind = cfa_rule_invalid;
+      }
+      break;
+
+    case cfa_undefined:
+      rules->cfa_kind = cfa_rule_undefined;
+      break;
+
+    default:
+      rules->cfa_kind = cfa_rule_invalid;
+      break;
+    }
+
+  for (unsigned regno = 0; regno < nregs; regno++)
+    {
+      struct frame_rule *rule = &rules->regs[regno];
+      int reg_rule = (regno < frame->nregs
+		      ? frame->regs[regno].rule : reg_unspecified);
+      Dwarf_Sword value = regno < frame->nregs ? frame->regs[regno].value : 0;
+      switch (reg_rule)
+	{
+	case reg_unspecified:
+	  rule->kind = (frame->cache->default_same_value
+			? rule_same_value : rule_undefined);
+	  break;
+
+	case reg_undefined:
+	  rule->kind = rule_undefined;
+	  break;
+
+	case reg_same_value:
+	  rule->kind = rule_same_value;
+	  break;
+
+	case reg_offset:
+	  rule->kind = rule_offset;
+	  rule->offset = value;
+	  break;
+
+	case reg_val_offset:
+	  rule->kind = rule_val_offset;
+	  rule->offset = value;
+	  break;
+
+	case reg_register:
+	  rule->kind = rule_register;
+	  rule->regno = value;
+	  break;
+
+	default:
+	  {
+	    /* The expressions are parsed once and kept in the CFI.  */
+	    Dwarf_Op reg_ops_mem[3], *reg_ops;
+	    size_t reg_nops;
+	    if (dwarf_frame_register (frame, regno, reg_ops_mem,
+				      &reg_ops, &reg_nops) != 0
+		|| reg_nops == 0 || reg_ops == reg_ops_mem)
+	      rule->kind = rule_error;
+	    else
+	      {
+		rule->kind = rule_expr;
+		rule->ops = reg_ops;
+		rule->nops = reg_nops;
+	      }
+	  }
+	  break;
+	}
+    }
+
+  return rules;
+}
+
+/* Return the index of the first rules in CACHE that start after PC.  */
+static size_t
+find_rules (const struct dwfl_frame_rules_cache *cache, Dwarf_Addr pc)
 {
+  size_t l = 0;
+  size_t u = cache->nrules;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (cache->rules[idx]->start <= pc)
+	l = idx + 1;
+      else
+	u = idx;
+    }
+  return l;
+}
+
+/* Return the rules for PC from CACHE, or compile and add them.
+   Call with DWFL->unwind_lock held.  */
+static const struct dwfl_frame_rules *
+lookup_rules (Dwfl *dwfl, struct dwfl_frame_rules_cache *cache,
+	      Dwarf_CFI *cfi, Dwarf_Addr pc, size_t nregs)
+{
+  size_t idx = find_rules (cache, pc);
+  if (idx > 0)
+    {
+      struct dwfl_frame_rules *rules = cache->rules[idx - 1];
+      if (pc < rules->end && rules->nregs == nregs)
+	{
+	  dwfl->frame_cache_hits++;
+	  return rules;
+	}
+    }
+
   Dwarf_Frame *frame;
   if (INTUSE(dwarf_cfi_addrframe) (cfi, pc, &frame) != 0)
     {
       __libdwfl_seterrno (DWFL_E_LIBDW);
-      return;
+      return NULL;
     }
-
-  Dwfl_Frame *unwound = new_unwound (state);
-  if (unwound == NULL)
+  struct dwfl_frame_rules *rules = compile_rules (frame, nregs);
+  free (frame);
+  if (unlikely (rules == NULL))
     {
       __libdwfl_seterrno (DWFL_E_NOMEM);
-      return;
+      return NULL;
+    }
+  dwfl->frame_cache_misses++;
+
+  /* Rules for another number of registers are replaced.  */
+  if (idx > 0 && cache->rules[idx - 1]->start == rules->start)
+    {
+      free (cache->rules[idx - 1]);
+      cache->rules[idx - 1] = rules;
+      return rules;
     }
 
-  unwound->signal_frame = frame->fde->cie->signal_frame;
+  if (cache->nrules == cache->alloc)
+    {
+      size_t alloc = MAX (cache->alloc * 2, 16);
+      struct dwfl_frame_rules **new_rules
+	= realloc (cache->rules, alloc * sizeof cache->rules[0]);
+      if (unlikely (new_rules == NULL))
+	{
+	  /* They cannot be kept until done with them, other workers of
+	     dwfl_getthreads_parallel may be using rules too.  */
+	  free (rules);
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return NULL;
+	}
+      cache->rules = new_rules;
+      cache->alloc = alloc;
+    }
+  memmove (&cache->rules[idx + 1], &cache->rules[idx],
+	   (cache->nrules - idx) * sizeof cache->rules[0]);
+  cache->rules[idx] = rules;
+  cache->nrules++;
+  return rules;
+}
+
+void
+internal_function
+__libdwfl_frame_rules_free (struct dwfl_frame_rules_cache *cache)
+{
+  for (size_t i = 0; i < cache->nrules; i++)
+    free (cache->rules[i]);
+  free (cache->rules);
+  cache->rules = NULL;
+  cache->nrules = 0;
+  cache->alloc = 0;
+}
+
+static void
+handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias,
+	    struct dwfl_frame_rules_cache *cache)
+{
   Dwfl_Thread *thread = state->thread;
   Dwfl_Process *process = thread->process;
   Ebl *ebl = process->ebl;
   size_t nregs = ebl_frame_nregs (ebl);
   assert (nregs > 0);
 
+  /* Rules once cached stay until the module is freed, they can be
+     used without holding the lock.  */
+  Dwfl *dwfl = process->dwfl;
+  rwlock_wrlock (dwfl->unwind_lock);
+  const struct dwfl_frame_rules *rules = lookup_rules (dwfl, cache,
+						       cfi, pc, nregs);
+  rwlock_unlock (dwfl->unwind_lock);
+  if (rules == NULL)
+    return;
+
+  Dwfl_Frame *unwound = new_unwound (state);
+  if (unwound == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return;
+    }
+
+  unwound->signal_frame = rules->signal_frame;
+  unwound->unwind_method = DWFL_UNWIND_CFI;
+
   /* The return register is special for setting the unwound->pc_state.  */
-  unsigned ra = frame->fde->cie->return_address_register;
+  unsigned ra = rules->ra;
   bool ra_set = false;
   ebl_dwarf_to_regno (ebl, &ra);
 
+  struct frame_cfa cfa = { .rules = rules, .state = cfa_unknown };
   for (unsigned regno = 0; regno < nregs; regno++)
     {
-      Dwarf_Op reg_ops_mem[3], *reg_ops;
-      size_t reg_nops;
-      if (dwarf_frame_register (frame, regno, reg_ops_mem, &reg_ops,
-				&reg_nops) != 0)
+      const struct frame_rule *rule = &rules->regs[regno];
+      Dwarf_Addr regval;
+      switch (rule->kind)
 	{
+	case rule_error:
 	  __libdwfl_seterrno (DWFL_E_LIBDW);
 	  continue;
-	}
-      Dwarf_Addr regval;
-      if (reg_nops == 0)
-	{
-	  if (reg_ops == reg_ops_mem)
-	    {
-	      /* REGNO is undefined.  */
-	      if (regno == ra)
-		unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
-	      continue;
-	    }
-	  else if (reg_ops == NULL)
-	    {
-	      /* REGNO is same-value.  */
-	      if (! state_get_reg (state, regno, &regval))
-		continue;
-	    }
-	  else
+
+	case rule_undefined:
+	  if (regno == ra)
+	    unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
+	  continue;
+
+	case rule_same_value:
+	  if (! state_get_reg (state, regno, &regval))
+	    continue;
+	  break;
+
+	case rule_offset:
+	  if (! get_cfa (state, &cfa, bias, &regval))
+	    continue;
+	  if (! __libdwfl_memory_read (thread, regval + rule->offset,
+				       &regval))
+	    continue;
+	  break;
+
+	case rule_val_offset:
+	  if (! get_cfa (state, &cfa, bias, &regval))
+	    continue;
+	  regval += rule->offset;
+	  break;
+
+	case rule_register:
+	  if (! state_get_reg (state, rule->regno, &regval))
+	    continue;
+	  break;
+
+	default:
+	  if (! expr_eval (state, &cfa, rule->ops, rule->nops, &regval, bias))
 	    {
-	      __libdwfl_seterrno (DWFL_E_INVALID_DWARF);
+	      /* PPC32 vDSO has various invalid operations, ignore them.  The
+		 register will look as unset causing an error later, if used.
+		 But PPC32 does not use such registers.  */
 	      continue;
 	    }
-	}
-      else if (! expr_eval (state, frame, reg_ops, reg_nops, &regval, bias))
-	{
-	  /* PPC32 vDSO has various invalid operations, ignore them.  The
-	     register will look as unset causing an error later, if used.
-	     But PPC32 does not use such registers.  */
-	  continue;
+	  break;
 	}
 
       /* Some architectures encode some extra info in the return address.  */
-      if (regno == frame->fde->cie->return_address_register)
+      if (regno == rules->ra)
 	regval &= ebl_func_addr_mask (ebl);
 
       /* This is another strange PPC[64] case.  There are two
@@ -613,7 +909,7 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 	 register number.  We only want one to actually set the return
 	 register value.  But we always want to override the value if
 	 the register is the actual CIE return address register.  */
-      if (ra_set && regno != frame->fde->cie->return_address_register)
+      if (ra_set && regno != rules->ra)
 	{
 	  unsigned r = regno;
 	  if (ebl_dwarf_to_regno (ebl, &r) && r == ra)
@@ -634,9 +930,7 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
     }
   if (unwound->pc_state == DWFL_FRAME_STATE_ERROR)
     {
-      if (__libdwfl_frame_reg_get (unwound,
-				   frame->fde->cie->return_address_register,
-				   &unwound->pc))
+      if (__libdwfl_frame_reg_get (unwound, rules->ra, &unwound->pc))
 	{
 	  /* PPC32 __libc_start_main properly CFI-unwinds PC as zero.
 	     Currently none of the archs supported for unwinding have
@@ -657,7 +951,7 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 	{
 	  /* We couldn't set the return register, either it was bogus,
 	     or the return pc is undefined, maybe end of call stack.  */
-	  unsigned pcreg = frame->fde->cie->return_address_register;
+	  unsigned pcreg = rules->ra;
 	  if (! ebl_dwarf_to_regno (ebl, &pcreg)
 	      || pcreg >= ebl_frame_nregs (ebl))
 	    __libdwfl_seterrno (DWFL_E_INVALID_REGISTER);
@@ -665,7 +959,6 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
 	    unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
 	}
     }
-  free (frame);
 }
 
 static bool
@@ -703,48 +996,54 @@ static bool
 readfunc (Dwarf_Addr addr, Dwarf_Word *datap, void *arg)
 {
   Dwfl_Frame *state = arg;
-  Dwfl_Thread *thread = state->thread;
-  Dwfl_Process *process = thread->process;
-  return process->callbacks->memory_read (process->dwfl, addr, datap,
-					  process->callbacks_arg);
+  return __libdwfl_memory_read (state->thread, addr, datap);
 }
 
-void
-internal_function
-__libdwfl_frame_unwind (Dwfl_Frame *state)
+/* The CFI of MOD is read when it is first asked for.  */
+static Dwarf_CFI *
+module_cfi (Dwfl_Module *mod, bool eh, Dwarf_Addr *bias)
+{
+  Dwfl *dwfl = mod->dwfl;
+  rwlock_wrlock (dwfl->unwind_lock);
+  Dwarf_CFI *cfi = (eh ? INTUSE(dwfl_module_eh_cfi) (mod, bias)
+		    : INTUSE(dwfl_module_dwarf_cfi) (mod, bias));
+  rwlock_unlock (dwfl->unwind_lock);
+  return cfi;
+}
+
+/* Unwind STATE with the CFI of MOD, if there is any.  */
+static bool
+unwind_cfi (Dwfl_Frame *state, Dwfl_Module *mod, Dwarf_Addr pc)
 {
-  if (state->unwound)
-    return;
-  /* Do not ask dwfl_frame_pc for ISACTIVATION, it would try to unwind STATE
-     which would deadlock us.  */
-  Dwarf_Addr pc;
-  bool ok = INTUSE(dwfl_frame_pc) (state, &pc, NULL);
-  assert (ok);
-  /* Check whether this is the initial frame or a signal frame.
-     Then we need to unwind from the original, unadjusted PC.  */
-  if (! state->initial_frame && ! state->signal_frame)
-    pc--;
-  Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (state->thread->process->dwfl, pc);
   if (mod == NULL)
-    __libdwfl_seterrno (DWFL_E_NO_DWARF);
-  else
     {
-      Dwarf_Addr bias;
-      Dwarf_CFI *cfi_eh = INTUSE(dwfl_module_eh_cfi) (mod, &bias);
-      if (cfi_eh)
-	{
-	  handle_cfi (state, pc - bias, cfi_eh, bias);
-	  if (state->unwound)
-	    return;
-	}
-      Dwarf_CFI *cfi_dwarf = INTUSE(dwfl_module_dwarf_cfi) (mod, &bias);
-      if (cfi_dwarf)
-	{
-	  handle_cfi (state, pc - bias, cfi_dwarf, bias);
-	  if (state->unwound)
-	    return;
-	}
+      __libdwfl_seterrno (DWFL_E_NO_DWARF);
+      return false;
+    }
+  Dwarf_Addr bias;
+  Dwarf_CFI *cfi_eh = module_cfi (mod, true, &bias);
+  if (cfi_eh)
+    {
+      handle_cfi (state, pc - bias, cfi_eh, bias, &mod->eh_rules);
+      if (state->unwound)
+	return true;
+    }
+  Dwarf_CFI *cfi_dwarf = module_cfi (mod, false, &bias);
+  if (cfi_dwarf)
+    {
+      handle_cfi (state, pc - bias, cfi_dwarf, bias, &mod->dwarf_rules);
+      if (state->unwound)
+	return true;
     }
+  return false;
+}
+
+/* Unwind STATE with the backend, usually by following the frame pointer.
+   With CHECK the result is only kept if its return address is within a
+   reported module.  */
+static bool
+unwind_frame_pointer (Dwfl_Frame *state, Dwarf_Addr pc, bool check)
+{
   assert (state->unwound == NULL);
   Dwfl_Thread *thread = state->thread;
   Dwfl_Process *process = thread->process;
@@ -752,21 +1051,99 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
   if (new_unwound (state) == NULL)
     {
       __libdwfl_seterrno (DWFL_E_NOMEM);
-      return;
+      return false;
     }
   state->unwound->pc_state = DWFL_FRAME_STATE_PC_UNDEFINED;
   // &Dwfl_Frame.signal_frame cannot be passed as it is a bitfield.
   bool signal_frame = false;
-  if (! ebl_unwind (ebl, pc, setfunc, getfunc, readfunc, state, &signal_frame))
+  bool ok = ebl_unwind (ebl, pc, setfunc, getfunc, readfunc, state,
+			&signal_frame);
+  if (ok && check)
+    {
+      assert (state->unwound->pc_state == DWFL_FRAME_STATE_PC_SET);
+      Dwfl *dwfl = process->dwfl;
+      rwlock_wrlock (dwfl->unwind_lock);
+      ok = INTUSE(dwfl_addrmodule) (dwfl, state->unwound->pc - 1) != NULL;
+      rwlock_unlock (dwfl->unwind_lock);
+      if (! ok)
+	{
+	  __atomic_fetch_add (&dwfl->unwind_fp_rejected, 1, __ATOMIC_RELAXED);
+	  __libdwfl_seterrno (DWFL_E_NO_MATCH);
+	}
+    }
+  if (! ok)
     {
       // Discard the unwind attempt.  During next __libdwfl_frame_unwind call
       // we may have for example the appropriate Dwfl_Module already mapped.
       assert (state->unwound->unwound == NULL);
-      free (state->unwound);
+      __libdwfl_frame_release (state->unwound);
       state->unwound = NULL;
       // __libdwfl_seterrno has been called above.
-      return;
+      return false;
     }
   assert (state->unwound->pc_state == DWFL_FRAME_STATE_PC_SET);
   state->unwound->signal_frame = signal_frame;
+  state->unwound->unwind_method = DWFL_UNWIND_FRAME_POINTER;
+  return true;
+}
+
+void
+internal_function
+__libdwfl_frame_unwind (Dwfl_Frame *state)
+{
+  if (state->unwound)
+    return;
+  /* Do not ask dwfl_frame_pc for ISACTIVATION, it would try to unwind STATE
+     which would deadlock us.  */
+  Dwarf_Addr pc;
+  bool ok = INTUSE(dwfl_frame_pc) (state, &pc, NULL);
+  assert (ok);
+  /* Check whether this is the initial frame or a signal frame.
+     Then we need to unwind from the original, unadjusted PC.  */
+  if (! state->initial_frame && ! state->signal_frame)
+    pc--;
+  Dwfl *dwfl = state->thread->process->dwfl;
+  rwlock_wrlock (dwfl->unwind_lock);
+  Dwfl_Module *mod = INTUSE(dwfl_addrmodule) (dwfl, pc);
+  rwlock_unlock (dwfl->unwind_lock);
+
+  Dwfl_Unwind_Policy policy = DWFL_UNWIND_POLICY_DEFAULT;
+  if (mod != NULL)
+    policy = mod->unwind_policy;
+  if (policy == DWFL_UNWIND_POLICY_DEFAULT)
+    policy = dwfl->unwind_policy;
+  /* The initial frame or a signal frame may have been stopped anywhere,
+     also before the frame pointer was set up.  */
+  if (policy == DWFL_UNWIND_POLICY_FRAME_POINTER
+      && (state->initial_frame || state->signal_frame))
+    policy = DWFL_UNWIND_POLICY_CFI;
+
+  switch (policy)
+    {
+    case DWFL_UNWIND_POLICY_FRAME_POINTER:
+    case DWFL_UNWIND_POLICY_FRAME_POINTER_ONLY:
+      /* Without a module there is no CFI to check against.  */
+      if (unwind_frame_pointer (state, pc,
+				(policy == DWFL_UNWIND_POLICY_FRAME_POINTER
+				 && mod != NULL)))
+	break;
+      if (policy == DWFL_UNWIND_POLICY_FRAME_POINTER_ONLY
+	  || ! unwind_cfi (state, mod, pc))
+	return;
+      break;
+
+    default:
+      if (unwind_cfi (state, mod, pc))
+	break;
+      assert (state->unwound == NULL);
+      if (policy == DWFL_UNWIND_POLICY_CFI_ONLY
+	  || ! unwind_frame_pointer (state, pc, false))
+	return;
+      break;
+    }
+
+  if (state->unwound->unwind_method == DWFL_UNWIND_CFI)
+    __atomic_fetch_add (&dwfl->unwind_cfi_frames, 1, __ATOMIC_RELAXED);
+  else
+    __atomic_fetch_add (&dwfl->unwind_fp_frames, 1, __ATOMIC_RELAXED);
 }
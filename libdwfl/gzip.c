@@ -1,4 +1,5 @@
-/* Decompression support for libdwfl: zlib (gzip) and/or bzlib (bzip2).
+/* Decompression support for libdwfl: zlib (gzip), bzlib (bzip2), lzma (xz)
+   or zstd.
    Copyright (C) 2009 Red Hat, Inc.
    This file is part of elfutils.
 
@@ -60,6 +61,83 @@
 # define inflateInit(z)	BZ2_bzDecompressInit (z, 0, 0)
 # define do_inflate(z)	BZ2_bzDecompress (z)
 # define inflateEnd(z)	BZ2_bzDecompressEnd (z)
+#elif defined ZSTD
+# define USE_INFLATE	1
+# include <zstd.h>
+# define unzip		__libdw_unzstd
+# define DWFL_E_ZLIB	DWFL_E_ZSTD
+# define MAGIC		"\x28\xb5\x2f\xfd"
+# define Z(what)	UNZSTD_##what
+# define z_stream	struct unzstd_stream
+# define inflateInit(z)	unzstd_init (z)
+# define do_inflate(z)	unzstd_decompress (z)
+# define inflateEnd(z)	unzstd_end (z)
+
+/* The zstd streaming interface dressed up like z_stream.  */
+enum
+  {
+    UNZSTD_OK,
+    UNZSTD_STREAM_END,
+    UNZSTD_MEM_ERROR,
+    UNZSTD_ERRNO,
+    UNZSTD_DATA_ERROR,
+  };
+
+struct unzstd_stream
+{
+  void *next_in;
+  size_t avail_in;
+  void *next_out;
+  size_t avail_out;
+  size_t total_out;
+  ZSTD_DCtx *dctx;
+  /* Set when a frame ended with all the input used.  */
+  bool frame_done;
+};
+
+static int
+unzstd_init (struct unzstd_stream *z)
+{
+  z->dctx = ZSTD_createDCtx ();
+  return z->dctx == NULL ? UNZSTD_MEM_ERROR : UNZSTD_OK;
+}
+
+static int
+unzstd_decompress (struct unzstd_stream *z)
+{
+  /* A file can have several frames, it ends when a frame ends with no
+     more input coming.  */
+  if (z->frame_done)
+    {
+      if (z->avail_in == 0)
+	return UNZSTD_STREAM_END;
+      z->frame_done = false;
+    }
+
+  ZSTD_inBuffer in = { .src = z->next_in, .size = z->avail_in };
+  ZSTD_outBuffer out = { .dst = z->next_out, .size = z->avail_out };
+  size_t result = ZSTD_decompressStream (z->dctx, &out, &in);
+  z->next_in += in.pos;
+  z->avail_in -= in.pos;
+  z->next_out += out.pos;
+  z->avail_out -= out.pos;
+  z->total_out += out.pos;
+  if (ZSTD_isError (result))
+    return UNZSTD_DATA_ERROR;
+  /* There is always room for output, so no progress means the input
+     ended in the middle of a frame, like LZMA_BUF_ERROR.  */
+  if (in.pos == 0 && out.pos == 0)
+    return UNZSTD_DATA_ERROR;
+  if (result == 0 && z->avail_in == 0)
+    z->frame_done = true;
+  return UNZSTD_OK;
+}
+
+static void
+unzstd_end (struct unzstd_stream *z)
+{
+  ZSTD_freeDCtx (z->dctx);
+}
 #else
 # define USE_INFLATE	0
 # define crc32		loser_crc32
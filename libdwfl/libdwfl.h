@@ -481,6 +481,22 @@ extern const char *dwfl_module_getsym_info (Dwfl_Module *mod, int ndx,
 /* Find the symbol that ADDRESS lies inside, and return its name.  */
 extern const char *dwfl_module_addrname (Dwfl_Module *mod, GElf_Addr address);
 
+/* Find the symbol called NAME, the reverse of dwfl_module_addrname.
+   Returns its index, which can be passed to dwfl_module_getsym_info,
+   or -1 when nothing was found.  SYM, ADDR, SHNDXP, ELFP and BIAS are
+   filled in as by dwfl_module_getsym_info.  Only defined symbols are
+   found.  If several have the same name a global symbol is preferred
+   over a weak symbol and a weak symbol over a local one, otherwise the
+   first is used.  When the module only has a dynamic symbol table its
+   .gnu.hash or .hash table is used, so only the symbols the dynamic
+   linker can find are found.  Otherwise a hash table of all symbol
+   names is built on first use.  */
+extern int dwfl_module_symbol_by_name (Dwfl_Module *mod, const char *name,
+				       GElf_Sym *sym, GElf_Addr *addr,
+				       GElf_Word *shndxp, Elf **elfp,
+				       Dwarf_Addr *bias)
+  __nonnull_attribute__ (2, 3, 4);
+
 /* Find the symbol associated with ADDRESS.  Return its name or NULL
    when nothing was found.  If the architecture uses function
    descriptors, and symbol st_value points to one, ADDRESS wil be
@@ -506,6 +522,20 @@ extern const char *dwfl_module_addrinfo (Dwfl_Module *mod, GElf_Addr address,
 					 Dwarf_Addr *bias)
   __nonnull_attribute__ (3);
 
+/* Find the symbols associated with the N addresses ADDRS at once, as
+   if by calling dwfl_module_addrinfo for each.  NAMES[I] is set to the
+   name of the symbol for ADDRS[I], or to NULL when nothing was found.
+   If OFFSETS or SYMS is not NULL, OFFSETS[I] and SYMS[I] are filled in
+   as the OFFSET and SYM arguments of dwfl_module_addrinfo.  When ADDRS
+   is sorted each lookup continues from where the previous one ended.
+   Returns the number of addresses for which a symbol was found, or -1
+   if the symbol table cannot be loaded.  */
+extern ptrdiff_t dwfl_module_addrinfo_batch (Dwfl_Module *mod,
+					     const GElf_Addr *addrs, size_t n,
+					     const char **names,
+					     GElf_Off *offsets, GElf_Sym *syms)
+  __nonnull_attribute__ (2, 4);
+
 /* Find the symbol that ADDRESS lies inside, and return detailed
    information as for dwfl_module_getsym (above).  Note that like
    dwfl_module_getsym this function also adjusts SYM->ST_VALUE to an
@@ -579,6 +609,19 @@ extern Dwfl_Line *dwfl_onesrcline (Dwarf_Die *cudie, size_t idx);
 extern Dwfl_Line *dwfl_module_getsrc (Dwfl_Module *mod, Dwarf_Addr addr);
 extern Dwfl_Line *dwfl_getsrc (Dwfl *dwfl, Dwarf_Addr addr);
 
+/* Get source for the N addresses ADDRS of MOD at once, as if by calling
+   dwfl_module_getsrc for each.  LINES[I] is set to the line for
+   ADDRS[I], or to NULL if there is none.  If ERRORS is not NULL,
+   ERRORS[I] is set to zero or to the error for ADDRS[I], which can be
+   passed to dwfl_errmsg.  When ADDRS is sorted each lookup continues
+   from the CU and line of the previous one, so N lookups cost about as
+   much as walking over the lines they touch.  Returns the number of
+   addresses that were found, or -1 if MOD has no DWARF.  */
+extern ptrdiff_t dwfl_module_getsrc_batch (Dwfl_Module *mod,
+					   const Dwarf_Addr *addrs, size_t n,
+					   Dwfl_Line **lines, int *errors)
+  __nonnull_attribute__ (2, 4);
+
 /* Get address for source.  */
 extern int dwfl_module_getsrc_file (Dwfl_Module *mod,
 				    const char *fname, int lineno, int column,
@@ -702,6 +745,16 @@ typedef struct
      detach method above.  This method may be NULL.  */
   void (*thread_detach) (Dwfl_Thread *thread, void *thread_arg)
     __nonnull_attribute__ (1);
+
+  /* Called during unwinding to read LEN bytes of memory at ADDR into BUF,
+     typically several pages of the stack at once.  Returns the number of
+     bytes read from the start of the range, which may be less than LEN,
+     or zero on failure.  The memory read is cached until thread_detach is
+     called, memory_read is still used for what could not be read.  This
+     method may be NULL.  */
+  size_t (*memory_read_bulk) (Dwfl *dwfl, Dwarf_Addr addr, void *buf,
+			      size_t len, void *dwfl_arg)
+    __nonnull_attribute__ (1, 3);
 } Dwfl_Thread_Callbacks;
 
 /* PID is the process id associated with the DWFL state.  Architecture of DWFL
@@ -775,6 +828,25 @@ int dwfl_getthreads (Dwfl *dwfl,
 		     void *arg)
   __nonnull_attribute__ (1, 2);
 
+/* Like dwfl_getthreads, but first sets up the initial frames of all
+   threads at once, then calls CALLBACK for them from up to NWORKERS
+   threads concurrently.  The threads of a process attached by
+   dwfl_linux_proc_attach are all stopped together, with PTRACE_SEIZE
+   and PTRACE_INTERRUPT, and only resumed once CALLBACK is done with all
+   of them.  CALLBACK may only use dwfl_thread_tid, dwfl_thread_dwfl,
+   dwfl_thread_getframes and the functions for its frames; other
+   functions on DWFL have to wait until dwfl_getthreads_parallel
+   returns.  Without thread safety (--enable-thread-safety) CALLBACK
+   is called for one thread after the other.  Returns zero if CALLBACK
+   returned DWARF_CB_OK for all threads, -1 (and sets dwfl_errno ())
+   on error, or the value CALLBACK returned when not DWARF_CB_OK,
+   after which it is not called for any more threads.  */
+int dwfl_getthreads_parallel (Dwfl *dwfl, unsigned nworkers,
+			      int (*callback) (Dwfl_Thread *thread,
+					       void *arg),
+			      void *arg)
+  __nonnull_attribute__ (1, 3);
+
 /* Iterate through the frames for a thread.  Returns zero if all frames
    have been processed by the callback, returns -1 on error, or the value of
    the callback when not DWARF_CB_OK.  -1 returned on error will
@@ -789,6 +861,16 @@ int dwfl_thread_getframes (Dwfl_Thread *thread,
 			   void *arg)
   __nonnull_attribute__ (1, 2);
 
+/* By default every frame dwfl_thread_getframes passes to its callback
+   is allocated, and freed when it is done.  If REUSE is true, keep the
+   frames instead and use them again for later frames and backtraces of
+   DWFL, so unwinding does not allocate memory once the modules and
+   their unwind information have been read.  If REUSE is false, free
+   the frames kept.  DWFL must have been attached by dwfl_attach_state.
+   Returns zero on success, -1 (and sets dwfl_errno ()) on failure.  */
+int dwfl_frame_reuse (Dwfl *dwfl, bool reuse)
+  __nonnull_attribute__ (1);
+
 /* Like dwfl_thread_getframes, but specifying the thread by its unique
    identifier number.  Returns zero if all frames have been processed
    by the callback, returns -1 on error (and when no thread with
@@ -807,6 +889,100 @@ int dwfl_getthread_frames (Dwfl *dwfl, pid_t tid,
 bool dwfl_frame_pc (Dwfl_Frame *state, Dwarf_Addr *pc, bool *isactivation)
   __nonnull_attribute__ (1, 2);
 
+/* Unwind a sample of a thread taken without stopping it, like the
+   PERF_SAMPLE_REGS_USER and PERF_SAMPLE_STACK_USER of a perf_event
+   sample.  REGS are the NREGS first DWARF registers of the thread, as
+   for dwfl_thread_state_registers, and PC its program counter.  STACK
+   is a copy of the STACK_SIZE bytes of its memory at STACK_ADDR,
+   usually starting at the stack pointer.  Any other memory is read from
+   the files of the modules reported in DWFL.
+
+   Stores the program counters of up to MAXPCS frames in PCS, as
+   dwfl_frame_pc would return them.  PCS[0] is PC, the others are return
+   addresses (unless the frame was interrupted by a signal), so subtract
+   1 from them to find the function of the caller.
+   Returns the number of frames stored, which ends where the unwinding
+   stopped, or -1 (and sets dwfl_errno ()) if not even the first frame
+   could be stored.
+
+   The first call attaches the state of DWFL for process PID (see
+   dwfl_attach_state), so DWFL must not have been attached otherwise.
+   Later calls reuse it, and the frames of the previous samples (see
+   dwfl_frame_reuse), so unwinding a sample does not allocate memory
+   once the modules and their unwind information have been read.  */
+int dwfl_sample_getframes (Dwfl *dwfl, pid_t pid,
+			   const Dwarf_Word *regs, size_t nregs,
+			   Dwarf_Addr pc, Dwarf_Addr stack_addr,
+			   const void *stack, size_t stack_size,
+			   Dwarf_Addr *pcs, size_t maxpcs);
+
+/* Unwinding keeps the register rules compiled from the CFI of each
+   module, so later frames at the same PC ranges do not interpret the
+   CFI again.  Store in *HITS and *MISSES how many times the rules were
+   found in that cache, and how many times they had to be compiled,
+   since DWFL was created.  HITS or MISSES may be NULL.  Returns zero
+   on success, -1 if DWFL is NULL.  */
+int dwfl_frame_cache_stats (Dwfl *dwfl, size_t *hits, size_t *misses);
+
+/* How the registers of a frame were found, see dwfl_frame_unwind_method.  */
+typedef enum
+  {
+    /* The initial frame of a thread, not unwound.  */
+    DWFL_UNWIND_INITIAL,
+    /* From the CFI (.eh_frame or .debug_frame) of the inner frame's module.  */
+    DWFL_UNWIND_CFI,
+    /* By the backend without CFI, usually following the frame pointer.  */
+    DWFL_UNWIND_FRAME_POINTER
+  } Dwfl_Unwind_Method;
+
+/* Which unwind methods to use for a frame, see dwfl_set_unwind_policy.  */
+typedef enum
+  {
+    /* For a module, the policy of its Dwfl.  For a Dwfl, the same as
+       DWFL_UNWIND_POLICY_CFI.  */
+    DWFL_UNWIND_POLICY_DEFAULT,
+    /* CFI, and the frame pointer where there is no CFI for the PC.  */
+    DWFL_UNWIND_POLICY_CFI,
+    /* CFI only.  */
+    DWFL_UNWIND_POLICY_CFI_ONLY,
+    /* The frame pointer, and CFI where the frame pointer gives no return
+       address within a reported module.  Initial and signal frames, which
+       may have stopped before the frame pointer was set up, use CFI
+       first.  */
+    DWFL_UNWIND_POLICY_FRAME_POINTER,
+    /* The frame pointer only, the result is not checked.  */
+    DWFL_UNWIND_POLICY_FRAME_POINTER_ONLY
+  } Dwfl_Unwind_Policy;
+
+/* Set the unwind policy for frames with a PC in no module with its own
+   policy, or outside of all modules (like JIT code).  Following the
+   frame pointer is cheaper than interpreting CFI, but only gives the
+   right frames for code that keeps a frame pointer.  Returns zero on
+   success, -1 if POLICY is not valid.  */
+int dwfl_set_unwind_policy (Dwfl *dwfl, Dwfl_Unwind_Policy policy)
+  __nonnull_attribute__ (1);
+
+/* Set the unwind policy for frames with a PC in MOD, for instance
+   DWFL_UNWIND_POLICY_FRAME_POINTER for a module known to be built with
+   -fno-omit-frame-pointer.  DWFL_UNWIND_POLICY_DEFAULT uses the policy
+   of its Dwfl again.  Returns zero on success, -1 if POLICY is not
+   valid.  */
+int dwfl_module_set_unwind_policy (Dwfl_Module *mod,
+				   Dwfl_Unwind_Policy policy)
+  __nonnull_attribute__ (1);
+
+/* Return how the registers of frame STATE were found.  */
+Dwfl_Unwind_Method dwfl_frame_unwind_method (Dwfl_Frame *state)
+  __nonnull_attribute__ (1);
+
+/* Store in *CFI and *FRAME_POINTER how many frames were unwound with
+   each method since DWFL was created, and in *REJECTED how many frame
+   pointer results DWFL_UNWIND_POLICY_FRAME_POINTER did not use because
+   their return address was outside of all modules.  Any of the pointers
+   may be NULL.  Returns zero on success, -1 if DWFL is NULL.  */
+int dwfl_unwind_stats (Dwfl *dwfl, size_t *cfi, size_t *frame_pointer,
+		       size_t *rejected);
+
 #ifdef __cplusplus
 }
 #endif
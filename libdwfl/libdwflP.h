@@ -57,6 +57,7 @@ typedef struct Dwfl_Process Dwfl_Process;
   DWFL_ERROR (ZLIB, N_("gzip decompression failed"))			      \
   DWFL_ERROR (BZLIB, N_("bzip2 decompression failed"))			      \
   DWFL_ERROR (LZMA, N_("LZMA decompression failed"))			      \
+  DWFL_ERROR (ZSTD, N_("zstd decompression failed"))			      \
   DWFL_ERROR (UNKNOWN_MACHINE, N_("no support library found for machine"))    \
   DWFL_ERROR (NOREL, N_("Callbacks missing for ET_REL file"))		      \
   DWFL_ERROR (BADRELTYPE, N_("Unsupported relocation type"))		      \
@@ -138,6 +139,21 @@ struct Dwfl
   int lookup_tail_ndx;
 
   struct Dwfl_User_Core *user_core;
+
+  /* Lookups in the unwind rules caches of all modules.  */
+  size_t frame_cache_hits;
+  size_t frame_cache_misses;
+
+  /* See dwfl_set_unwind_policy and dwfl_unwind_stats.  */
+  Dwfl_Unwind_Policy unwind_policy;
+  size_t unwind_cfi_frames;
+  size_t unwind_fp_frames;
+  size_t unwind_fp_rejected;
+
+  /* Serializes what unwinding changes in DWFL, its modules and their
+     CFI, and the frame pool of PROCESS, for the workers of
+     dwfl_getthreads_parallel.  */
+  rwlock_define (, unwind_lock);
 };
 
 #define OFFLINE_REDZONE		0x10000
@@ -160,6 +176,15 @@ struct dwfl_file
   GElf_Addr address_sync;
 };
 
+/* Register rules compiled from CFI, sorted by start address,
+   see frame_unwind.c.  */
+struct dwfl_frame_rules_cache
+{
+  struct dwfl_frame_rules **rules;
+  size_t nrules;
+  size_t alloc;
+};
+
 struct Dwfl_Module
 {
   Dwfl *dwfl;
@@ -174,6 +199,7 @@ struct Dwfl_Module
   GElf_Addr main_bias;
   Ebl *ebl;
   GElf_Half e_type;		/* GElf_Ehdr.e_type cache.  */
+  Dwfl_Unwind_Policy unwind_policy; /* See dwfl_module_set_unwind_policy.  */
   Dwfl_Error elferr;		/* Previous failure to open main file.  */
 
   struct dwfl_relocation *reloc_info; /* Relocatable sections.  */
@@ -190,6 +216,18 @@ struct Dwfl_Module
   Elf_Data *symxndxdata;	/* Data in the extended section index table. */
   Elf_Data *aux_symxndxdata;	/* Data in the extended auxiliary table. */
 
+  /* Hash table of the symbol table when it is a dynamic symbol table,
+     .gnu.hash when symhash_gnu is set, otherwise .hash.  */
+  Elf_Data *symhashdata;
+  bool symhash_gnu;
+
+  /* Hash table of symbol names built by dwfl_module_symbol_by_name.  */
+  struct dwfl_symnames *symnames;
+
+  /* Symbols sorted by address for dwfl_module_addrinfo [0] and
+     dwfl_module_addrsym [1], see dwfl_module_addrsym.c.  */
+  struct dwfl_symindex *symindex[2];
+
   char *elfdir;			/* The dir where we found the main Elf.  */
 
   Dwarf *dw;			/* libdw handle for its debugging info.  */
@@ -206,6 +244,7 @@ struct Dwfl_Module
   void *lazy_cu_root;		/* Table indexed by Dwarf_Off of CU.  */
 
   struct dwfl_arange *aranges;	/* Mapping of addresses in module to CUs.  */
+  Dwarf_Aranges *dwaranges;	/* libdw's ranges that ARANGES indexes.  */
 
   void *build_id_bits;		/* malloc'd copy of build ID bits.  */
   GElf_Addr build_id_vaddr;	/* Address where they reside, 0 if unknown.  */
@@ -217,6 +256,8 @@ struct Dwfl_Module
 
   Dwarf_CFI *dwarf_cfi;		/* Cached DWARF CFI for this module.  */
   Dwarf_CFI *eh_cfi;		/* Cached EH CFI for this module.  */
+  struct dwfl_frame_rules_cache dwarf_rules; /* Unwind rules from dwarf_cfi.  */
+  struct dwfl_frame_rules_cache eh_rules; /* Unwind rules from eh_cfi.  */
 
   int segment;			/* Index of first segment table entry.  */
   bool gc;			/* Mark/sweep flag.  */
@@ -234,8 +275,31 @@ struct Dwfl_Process
   void *callbacks_arg;
   struct ebl *ebl;
   bool ebl_close:1;
+  /* CALLBACKS->memory_read_bulk, or NULL when it is unset or the
+     caller's Dwfl_Thread_Callbacks predates it.  */
+  size_t (*memory_read_bulk) (Dwfl *dwfl, Dwarf_Addr addr, void *buf,
+			      size_t len, void *dwfl_arg);
+  /* Remote memory cache for memory_read_bulk, NULL if there is no
+     memory cached.  Cleared before each thread_detach (because that
+     makes the thread runnable and the cache invalid).  */
+  struct __libdwfl_remote_mem_cache *mem_cache;
+  /* Frames given back by unwinding, linked through their unwound
+     pointers, to be used again instead of allocating new ones.  Frames
+     of FRAME_ARENA always go back here, other frames only while
+     REUSE_FRAMES is set, see dwfl_frame_reuse.  */
+  Dwfl_Frame *frame_pool;
+  /* __LIBDWFL_FRAME_ARENA_FRAMES frames of FRAME_SIZE bytes allocated
+     at once, or NULL.  */
+  char *frame_arena;
+  size_t frame_size;
+  bool reuse_frames;
 };
 
+/* How many frames dwfl_frame_reuse allocates at once.  Unwinding only
+   needs the current frame and the one unwound from it, more are used
+   when dwfl_thread_getframes is called from inside its callback.  */
+#define __LIBDWFL_FRAME_ARENA_FRAMES 4
+
 /* See its typedef in libdwfl.h.  */
 
 struct Dwfl_Thread
@@ -246,6 +310,17 @@ struct Dwfl_Thread
      Later the processed frames get freed and this pointer is updated.  */
   Dwfl_Frame *unwound;
   void *callbacks_arg;
+  /* Set up by dwfl_getthreads_parallel while all threads are stopped:
+     the initial frame dwfl_thread_getframes starts from instead of
+     calling set_initial_registers, or NULL.  */
+  Dwfl_Frame *prepared;
+  /* Set instead of PREPARED if that failed, with the errno for
+     DWFL_E_ERRNO.  */
+  Dwfl_Error prepare_error;
+  int prepare_errno;
+  /* Remote memory cache of the worker unwinding this thread, or NULL
+     to use the one of PROCESS.  */
+  struct __libdwfl_remote_mem_cache *mem_cache;
 };
 
 /* See its typedef in libdwfl.h.  */
@@ -257,6 +332,8 @@ struct Dwfl_Frame
   Dwfl_Frame *unwound;
   bool signal_frame : 1;
   bool initial_frame : 1;
+  /* How this frame was found, see dwfl_frame_unwind_method.  */
+  Dwfl_Unwind_Method unwind_method;
   enum
   {
     /* This structure is still being initialized or there was an error
@@ -404,12 +481,23 @@ struct dwfl_arange
 };
 
 #define __LIBDWFL_REMOTE_MEM_CACHE_SIZE 4096
-/* Structure for caching remote memory reads as used by __libdwfl_pid_arg.  */
+#define __LIBDWFL_REMOTE_MEM_CACHE_SETS 8
+#define __LIBDWFL_REMOTE_MEM_CACHE_WAYS 4
+/* Structure for caching remote memory read with memory_read_bulk,
+   see remote-mem-cache.c.  */
 struct __libdwfl_remote_mem_cache
 {
-  Dwarf_Addr addr; /* Remote address.  */
-  Dwarf_Off len;   /* Zero if cleared, otherwise likely 4K. */
-  unsigned char buf[__LIBDWFL_REMOTE_MEM_CACHE_SIZE]; /* The actual cache.  */
+  uint64_t clock;		/* Last value of used.  */
+  struct __libdwfl_remote_mem_page
+  {
+    Dwarf_Addr addr;		/* Remote address.  */
+    Dwarf_Off len;		/* Zero if cleared, otherwise likely 4K.  */
+    uint64_t used;		/* When it was last used, for LRU.  */
+  } pages[__LIBDWFL_REMOTE_MEM_CACHE_WAYS][__LIBDWFL_REMOTE_MEM_CACHE_SETS];
+  /* The actual cache.  */
+  unsigned char buf[__LIBDWFL_REMOTE_MEM_CACHE_WAYS]
+		   [__LIBDWFL_REMOTE_MEM_CACHE_SETS]
+		   [__LIBDWFL_REMOTE_MEM_CACHE_SIZE];
 };
 
 /* Structure used for keeping track of ptrace attaching a thread.
@@ -421,10 +509,6 @@ struct __libdwfl_pid_arg
   DIR *dir;
   /* Elf for /proc/PID/exe.  Set to NULL if it couldn't be opened.  */
   Elf *elf;
-  /* Remote memory cache, NULL if there is no memory cached.
-     Should be cleared on detachment (because that makes the thread
-     runnable and the cache invalid).  */
-  struct __libdwfl_remote_mem_cache *mem_cache;
   /* fd for /proc/PID/exe.  Set to -1 if it couldn't be opened.  */
   int elf_fd;
   /* It is 0 if not used.  */
@@ -433,6 +517,9 @@ struct __libdwfl_pid_arg
   bool tid_was_stopped;
   /* True if threads are ptrace stopped by caller.  */
   bool assume_ptrace_stopped;
+  /* True while all threads are kept stopped by
+     __libdwfl_ptrace_stop_all, TID_ATTACHED is then any of them.  */
+  bool all_stopped;
 };
 
 /* If DWfl is not NULL and a Dwfl_Process has been setup that has
@@ -453,6 +540,23 @@ extern bool __libdwfl_ptrace_attach (pid_t tid, bool *tid_was_stoppedp)
 extern void __libdwfl_ptrace_detach (pid_t tid, bool tid_was_stopped)
   internal_function;
 
+/* Stops all NTIDS threads TIDS of the process of PID_ARG at once, with
+   PTRACE_SEIZE and PTRACE_INTERRUPT unless they are ptrace stopped by
+   the caller.  Sets SIGS[i] to the signal to pass on when TIDS[i] is
+   resumed, or to -1 if it is gone.  Until __libdwfl_ptrace_resume_all
+   set_initial_registers and thread_detach do not attach or detach.
+   Returns false (with all threads resumed) on error.  */
+extern bool __libdwfl_ptrace_stop_all (struct __libdwfl_pid_arg *pid_arg,
+				       const pid_t *tids, int *sigs,
+				       size_t ntids)
+  internal_function;
+
+/* Resumes the threads stopped by __libdwfl_ptrace_stop_all.  */
+extern void __libdwfl_ptrace_resume_all (struct __libdwfl_pid_arg *pid_arg,
+					 const pid_t *tids, const int *sigs,
+					 size_t ntids)
+  internal_function;
+
 
 /* Internal wrapper for old dwfl_module_getsym and new dwfl_module_getsym_info.
    adjust_st_value set to true returns adjusted SYM st_value, set to false
@@ -518,6 +622,13 @@ extern Dwfl_Error __libdwfl_nextcu (Dwfl_Module *mod, struct dwfl_cu *lastcu,
 extern Dwfl_Error __libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr,
 				    struct dwfl_cu **cu) internal_function;
 
+/* Likewise, also setting [*START, *END) to the DWARF addresses around
+   ADDR that belong to the same CU.  */
+extern Dwfl_Error __libdwfl_addrcu_range (Dwfl_Module *mod, Dwarf_Addr addr,
+					  struct dwfl_cu **cu,
+					  Dwarf_Addr *start, Dwarf_Addr *end)
+  internal_function;
+
 /* Ensure that CU->lines (and CU->cu->lines) is set up.  */
 extern Dwfl_Error __libdwfl_cu_getsrclines (struct dwfl_cu *cu)
   internal_function;
@@ -584,6 +695,36 @@ extern Dwfl_Module *__libdwfl_report_offline (Dwfl *dwfl, const char *name,
 extern void __libdwfl_process_free (Dwfl_Process *process)
   internal_function;
 
+/* Return a new frame for THREAD, taken from the frame pool of its
+   process if there is one there.  Only the registers are not
+   initialized.  Returns NULL if out of memory.  */
+extern Dwfl_Frame *__libdwfl_frame_alloc (Dwfl_Thread *thread)
+  internal_function;
+
+/* Give back STATE, to the frame pool of its process if it reuses
+   frames.  */
+extern void __libdwfl_frame_release (Dwfl_Frame *state)
+  internal_function;
+
+/* Read a word of memory at ADDR for unwinding THREAD, through its
+   memory cache or the memory_read callback.  */
+extern bool __libdwfl_memory_read (Dwfl_Thread *thread, Dwarf_Addr addr,
+				   Dwarf_Word *result)
+  internal_function;
+
+/* Forget the memory cached in CACHE.  */
+extern void __libdwfl_memory_cache_forget
+  (struct __libdwfl_remote_mem_cache *cache)
+  internal_function;
+
+/* Forget the memory cached for PROCESS.  */
+extern void __libdwfl_memory_cache_clear (Dwfl_Process *process)
+  internal_function;
+
+/* Free the unwind rules in CACHE.  */
+extern void __libdwfl_frame_rules_free (struct dwfl_frame_rules_cache *cache)
+  internal_function;
+
 /* Update STATE->unwound for the unwound frame.
    On error STATE->unwound == NULL
    or STATE->unwound->pc_state == DWFL_FRAME_STATE_ERROR;
@@ -612,6 +753,19 @@ extern Dwfl_Error __libdw_unlzma (int fd, off_t start_offset,
 				  void *mapped, size_t mapped_size,
 				  void **whole, size_t *whole_size)
   internal_function;
+extern Dwfl_Error __libdw_unzstd (int fd, off_t start_offset,
+				  void *mapped, size_t mapped_size,
+				  void **whole, size_t *whole_size)
+  internal_function;
+
+/* Open *ELF for a compressed file of SIZE bytes at START_OFFSET in FD
+   which can be decompressed piecewise, a multi-block xz file or a zstd
+   file with a seek table.  Only the parts libelf asks for are
+   decompressed.  Returns DWFL_E_BADELF if the file is not like that,
+   otherwise consumes and replaces *ELF only on success.  */
+extern Dwfl_Error __libdw_open_seekable (int fd, off_t start_offset,
+					 size_t size, Elf **elf)
+  internal_function;
 
 /* Skip the image header before a file image: updates *START_OFFSET.  */
 extern Dwfl_Error __libdw_image_header (int fd, off_t *start_offset,
@@ -767,6 +921,7 @@ INTDECL (dwfl_thread_state_register_pc)
 INTDECL (dwfl_getthread_frames)
 INTDECL (dwfl_getthreads)
 INTDECL (dwfl_thread_getframes)
+INTDECL (dwfl_frame_reuse)
 INTDECL (dwfl_frame_pc)
 
 /* Leading arguments standard to callbacks passed a Dwfl_Module.  */
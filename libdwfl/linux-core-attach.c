@@ -30,18 +30,39 @@
 # include <config.h>
 #endif
 
+#include "../libelf/libelfP.h"	/* For the core file image.  */
+#undef	_
 #include "libdwflP.h"
+#include <byteswap.h>
+#include <endian.h>
 #include <fcntl.h>
 #include "system.h"
 
 #include "../libdw/memory-access.h"
 
+#if BYTE_ORDER == LITTLE_ENDIAN
+# define MY_ELFDATA	ELFDATA2LSB
+#else
+# define MY_ELFDATA	ELFDATA2MSB
+#endif
+
+/* The file contents of a PT_LOAD segment of the core file.  */
+struct core_segment
+{
+  GElf_Addr start;
+  GElf_Addr end;		/* p_vaddr + p_filesz.  */
+  GElf_Off offset;
+};
+
 struct core_arg
 {
   Elf *core;
   Elf_Data *note_data;
   size_t thread_note_offset;
   Ebl *ebl;
+  /* Sorted by START, without the segments with no file contents.  */
+  struct core_segment *segments;
+  size_t nsegments;
 };
 
 struct thread_arg
@@ -50,51 +71,109 @@ struct thread_arg
   size_t note_offset;
 };
 
+/* Return the segment containing ADDR, or NULL.  */
+static const struct core_segment *
+find_segment (const struct core_arg *core_arg, Dwarf_Addr addr)
+{
+  size_t l = 0, u = core_arg->nsegments;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      const struct core_segment *seg = &core_arg->segments[idx];
+      if (addr < seg->start)
+	u = idx;
+      else if (addr >= seg->end)
+	l = idx + 1;
+      else
+	return seg;
+    }
+  return NULL;
+}
+
+/* Copy up to LEN bytes at ADDR out of the core file, return how many
+   could be read.  The contents are read on demand, from the mapped
+   image or with pread, nothing of the segments is kept around.  */
+static size_t
+core_read (const struct core_arg *core_arg, Dwarf_Addr addr, void *buf,
+	   size_t len)
+{
+  Elf *core = core_arg->core;
+  size_t total = 0;
+  const struct core_segment *seg = find_segment (core_arg, addr);
+  while (total < len && seg != NULL)
+    {
+      size_t n = MIN (len - total, seg->end - addr);
+      GElf_Off offset = seg->offset + (addr - seg->start);
+      if (offset >= core->maximum_size)
+	break;
+      n = MIN (n, core->maximum_size - offset);
+      if (core->map_address != NULL)
+	memcpy (buf + total, core->map_address + core->start_offset + offset,
+		n);
+      else
+	{
+	  ssize_t nread = __libelf_pread (core, buf + total, n,
+					  core->start_offset + offset);
+	  if (nread <= 0)
+	    break;
+	  n = nread;
+	}
+      total += n;
+      addr += n;
+
+      /* The read can go on in an adjacent segment.  */
+      if (addr == seg->end)
+	{
+	  seg++;
+	  if (seg == core_arg->segments + core_arg->nsegments
+	      || seg->start != addr)
+	    seg = NULL;
+	}
+    }
+  return total;
+}
+
 static bool
 core_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result,
 		  void *dwfl_arg)
 {
   Dwfl_Process *process = dwfl->process;
   struct core_arg *core_arg = dwfl_arg;
-  Elf *core = core_arg->core;
-  assert (core != NULL);
-  static size_t phnum;
-  if (elf_getphdrnum (core, &phnum) < 0)
+  assert (core_arg->core != NULL);
+  /* The words are returned in host byte order.  */
+  bool same_order = (elf_getident (core_arg->core, NULL)[EI_DATA]
+		     == MY_ELFDATA);
+  if (ebl_get_elfclass (process->ebl) == ELFCLASS64)
     {
-      __libdwfl_seterrno (DWFL_E_LIBELF);
-      return false;
+      uint64_t val;
+      if (core_read (core_arg, addr, &val, sizeof val) == sizeof val)
+	{
+	  *result = same_order ? val : bswap_64 (val);
+	  return true;
+	}
     }
-  for (size_t cnt = 0; cnt < phnum; ++cnt)
+  else
     {
-      GElf_Phdr phdr_mem, *phdr = gelf_getphdr (core, cnt, &phdr_mem);
-      if (phdr == NULL || phdr->p_type != PT_LOAD)
-	continue;
-      /* Bias is zero here, a core file itself has no bias.  */
-      GElf_Addr start = __libdwfl_segment_start (dwfl, phdr->p_vaddr);
-      GElf_Addr end = __libdwfl_segment_end (dwfl,
-					     phdr->p_vaddr + phdr->p_memsz);
-      unsigned bytes = ebl_get_elfclass (process->ebl) == ELFCLASS64 ? 8 : 4;
-      if (addr < start || addr + bytes > end)
-	continue;
-      Elf_Data *data;
-      data = elf_getdata_rawchunk (core, phdr->p_offset + addr - start,
-				   bytes, ELF_T_ADDR);
-      if (data == NULL)
+      uint32_t val;
+      if (core_read (core_arg, addr, &val, sizeof val) == sizeof val)
 	{
-	  __libdwfl_seterrno (DWFL_E_LIBELF);
-	  return false;
+	  *result = same_order ? val : bswap_32 (val);
+	  return true;
 	}
-      assert (data->d_size == bytes);
-      if (bytes == 8)
-	*result = read_8ubyte_unaligned_noncvt (data->d_buf);
-      else
-	*result = read_4ubyte_unaligned_noncvt (data->d_buf);
-      return true;
     }
   __libdwfl_seterrno (DWFL_E_ADDR_OUTOFRANGE);
   return false;
 }
 
+/* The pages read here are kept in the bounded cache of
+   remote-mem-cache.c.  */
+static size_t
+core_memory_read_bulk (Dwfl *dwfl __attribute__ ((unused)), Dwarf_Addr addr,
+		       void *buf, size_t len, void *dwfl_arg)
+{
+  return core_read (dwfl_arg, addr, buf, len);
+}
+
 static pid_t
 core_next_thread (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg,
 		  void **thread_argp)
@@ -295,9 +374,18 @@ core_detach (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg)
 {
   struct core_arg *core_arg = dwfl_arg;
   ebl_closebackend (core_arg->ebl);
+  free (core_arg->segments);
   free (core_arg);
 }
 
+static int
+compare_segments (const void *a, const void *b)
+{
+  const struct core_segment *s1 = a;
+  const struct core_segment *s2 = b;
+  return s1->start < s2->start ? -1 : s1->start > s2->start;
+}
+
 static const Dwfl_Thread_Callbacks core_thread_callbacks =
 {
   core_next_thread,
@@ -306,6 +394,7 @@ static const Dwfl_Thread_Callbacks core_thread_callbacks =
   core_set_initial_registers,
   core_detach,
   NULL, /* core_thread_detach */
+  core_memory_read_bulk,
 };
 
 int
@@ -420,9 +509,32 @@ dwfl_core_file_attach (Dwfl *dwfl, Elf *core)
   core_arg->note_data = note_data;
   core_arg->thread_note_offset = 0;
   core_arg->ebl = ebl;
+  core_arg->segments = malloc (phnum * sizeof *core_arg->segments);
+  core_arg->nsegments = 0;
+  if (core_arg->segments == NULL && phnum > 0)
+    {
+      free (core_arg);
+      err = DWFL_E_NOMEM;
+      goto fail;
+    }
+  for (size_t cnt = 0; cnt < phnum; ++cnt)
+    {
+      GElf_Phdr phdr_mem, *phdr = gelf_getphdr (core, cnt, &phdr_mem);
+      if (phdr != NULL && phdr->p_type == PT_LOAD && phdr->p_filesz > 0)
+	{
+	  struct core_segment *seg;
+	  seg = &core_arg->segments[core_arg->nsegments++];
+	  seg->start = phdr->p_vaddr;
+	  seg->end = phdr->p_vaddr + MIN (phdr->p_filesz, phdr->p_memsz);
+	  seg->offset = phdr->p_offset;
+	}
+    }
+  qsort (core_arg->segments, core_arg->nsegments,
+	 sizeof *core_arg->segments, compare_segments);
   if (! INTUSE(dwfl_attach_state) (dwfl, core, pid, &core_thread_callbacks,
 				   core_arg))
     {
+      free (core_arg->segments);
       free (core_arg);
       ebl_closebackend (ebl);
       return -1;
@@ -84,6 +84,9 @@ static const char *vmlinux_suffixes[] =
 #endif
 #ifdef USE_LZMA
     ".xz",
+#endif
+#ifdef USE_ZSTD
+    ".zst",
 #endif
   };
 
@@ -327,6 +330,9 @@ check_suffix (const FTSENT *f, size_t namelen)
 #if USE_LZMA
   TRY (".ko.xz");
 #endif
+#if USE_ZSTD
+  TRY (".ko.zst");
+#endif
 
   return 0;
 
@@ -117,75 +117,43 @@ __libdwfl_ptrace_attach (pid_t tid, bool *tid_was_stoppedp)
 }
 
 #ifdef HAVE_PROCESS_VM_READV
-/* Note that the result word size depends on the architecture word size.
-   That is sizeof long. */
-static bool
-read_cached_memory (struct __libdwfl_pid_arg *pid_arg,
-		    Dwarf_Addr addr, Dwarf_Word *result)
-{
-  /* Let the ptrace fallback deal with the corner case of the address
-     possibly crossing a page boundery.  */
-  if ((addr & ((Dwarf_Addr)__LIBDWFL_REMOTE_MEM_CACHE_SIZE - 1))
-      > (Dwarf_Addr)__LIBDWFL_REMOTE_MEM_CACHE_SIZE - sizeof (unsigned long))
-    return false;
-
-  struct __libdwfl_remote_mem_cache *mem_cache = pid_arg->mem_cache;
-  if (mem_cache == NULL)
-    {
-      size_t mem_cache_size = sizeof (struct __libdwfl_remote_mem_cache);
-      mem_cache = (struct __libdwfl_remote_mem_cache *) malloc (mem_cache_size);
-      if (mem_cache == NULL)
-	return false;
-
-      mem_cache->addr = 0;
-      mem_cache->len = 0;
-      pid_arg->mem_cache = mem_cache;
-    }
-
-  unsigned char *d;
-  if (addr >= mem_cache->addr && addr - mem_cache->addr < mem_cache->len)
-    {
-      d = &mem_cache->buf[addr - mem_cache->addr];
-      if ((((uintptr_t) d) & (sizeof (unsigned long) - 1)) == 0)
-	*result = *(unsigned long *) d;
-      else
-	memcpy (result, d, sizeof (unsigned long));
-      return true;
-    }
+/* The maximum number of pages read with one process_vm_readv call.  */
+#define BULK_READ_IOVECS	__LIBDWFL_REMOTE_MEM_CACHE_SETS
 
-  struct iovec local, remote;
-  mem_cache->addr = addr & ~((Dwarf_Addr)__LIBDWFL_REMOTE_MEM_CACHE_SIZE - 1);
-  local.iov_base = mem_cache->buf;
-  local.iov_len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
-  remote.iov_base = (void *) (uintptr_t) mem_cache->addr;
-  remote.iov_len = __LIBDWFL_REMOTE_MEM_CACHE_SIZE;
+static size_t
+pid_memory_read_bulk (Dwfl *dwfl __attribute__ ((unused)), Dwarf_Addr addr,
+		      void *buf, size_t len, void *arg)
+{
+  struct __libdwfl_pid_arg *pid_arg = arg;
+  pid_t tid = pid_arg->tid_attached;
+  assert (tid > 0);
 
-  ssize_t res = process_vm_readv (pid_arg->tid_attached,
-				  &local, 1, &remote, 1, 0);
-  if (res != __LIBDWFL_REMOTE_MEM_CACHE_SIZE)
+  /* Give every page its own remote iovec.  process_vm_readv stops at
+     the first one that cannot be read completely, so an unmapped page
+     only cuts the read short instead of failing all of it.  */
+  struct iovec local, remote[BULK_READ_IOVECS];
+  size_t niov = 0;
+  size_t total = 0;
+  while (total < len && niov < BULK_READ_IOVECS)
     {
-      mem_cache->len = 0;
-      return false;
+      Dwarf_Addr start = addr + total;
+      size_t n = (__LIBDWFL_REMOTE_MEM_CACHE_SIZE
+		  - (start & (__LIBDWFL_REMOTE_MEM_CACHE_SIZE - 1)));
+      if (n > len - total)
+	n = len - total;
+      remote[niov].iov_base = (void *) (uintptr_t) start;
+      remote[niov].iov_len = n;
+      niov++;
+      total += n;
     }
+  local.iov_base = buf;
+  local.iov_len = total;
 
-  mem_cache->len = res;
-  d = &mem_cache->buf[addr - mem_cache->addr];
-  if ((((uintptr_t) d) & (sizeof (unsigned long) - 1)) == 0)
-    *result = *(unsigned long *) d;
-  else
-    memcpy (result, d, sizeof (unsigned long));
-  return true;
+  ssize_t res = process_vm_readv (tid, &local, 1, remote, niov, 0);
+  return res > 0 ? (size_t) res : 0;
 }
 #endif /* HAVE_PROCESS_VM_READV */
 
-static void
-clear_cached_memory (struct __libdwfl_pid_arg *pid_arg)
-{
-  struct __libdwfl_remote_mem_cache *mem_cache = pid_arg->mem_cache;
-  if (mem_cache != NULL)
-    mem_cache->len = 0;
-}
-
 /* Note that the result word size depends on the architecture word size.
    That is sizeof long. */
 static bool
@@ -195,11 +163,6 @@ pid_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result, void *arg)
   pid_t tid = pid_arg->tid_attached;
   assert (tid > 0);
 
-#ifdef HAVE_PROCESS_VM_READV
-  if (read_cached_memory (pid_arg, addr, result))
-    return true;
-#endif
-
   Dwfl_Process *process = dwfl->process;
   if (ebl_get_elfclass (process->ebl) == ELFCLASS64)
     {
@@ -315,12 +278,15 @@ static bool
 pid_set_initial_registers (Dwfl_Thread *thread, void *thread_arg)
 {
   struct __libdwfl_pid_arg *pid_arg = thread_arg;
-  assert (pid_arg->tid_attached == 0);
   pid_t tid = INTUSE(dwfl_thread_tid) (thread);
-  if (! pid_arg->assume_ptrace_stopped
-      && ! __libdwfl_ptrace_attach (tid, &pid_arg->tid_was_stopped))
-    return false;
-  pid_arg->tid_attached = tid;
+  if (! pid_arg->all_stopped)
+    {
+      assert (pid_arg->tid_attached == 0);
+      if (! pid_arg->assume_ptrace_stopped
+	  && ! __libdwfl_ptrace_attach (tid, &pid_arg->tid_was_stopped))
+	return false;
+      pid_arg->tid_attached = tid;
+    }
   Dwfl_Process *process = thread->process;
   Ebl *ebl = process->ebl;
   return ebl_set_initial_registers_tid (ebl, tid,
@@ -332,7 +298,6 @@ pid_detach (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg)
 {
   struct __libdwfl_pid_arg *pid_arg = dwfl_arg;
   elf_end (pid_arg->elf);
-  free (pid_arg->mem_cache);
   close (pid_arg->elf_fd);
   closedir (pid_arg->dir);
   free (pid_arg);
@@ -351,14 +316,117 @@ __libdwfl_ptrace_detach (pid_t tid, bool tid_was_stopped)
 	  (void *) (intptr_t) (tid_was_stopped ? SIGSTOP : 0));
 }
 
+bool
+internal_function
+__libdwfl_ptrace_stop_all (struct __libdwfl_pid_arg *pid_arg,
+			   const pid_t *tids, int *sigs, size_t ntids)
+{
+  assert (pid_arg->tid_attached == 0);
+  size_t nstopped = ntids;
+  int err = 0;
+  if (pid_arg->assume_ptrace_stopped)
+    memset (sigs, 0, ntids * sizeof sigs[0]);
+  else
+    {
+#ifdef PTRACE_SEIZE
+      /* Seize all threads first and then interrupt them all, so they
+	 stop at about the same time and waiting for them is quick.  */
+      for (nstopped = 0; nstopped < ntids; nstopped++)
+	{
+	  sigs[nstopped] = 0;
+	  if (ptrace (PTRACE_SEIZE, tids[nstopped], NULL, NULL) != 0)
+	    {
+	      /* The thread may have exited meanwhile.  */
+	      if (errno != ESRCH)
+		{
+		  err = errno;
+		  break;
+		}
+	      sigs[nstopped] = -1;
+	    }
+	}
+      for (size_t i = 0; i < nstopped; i++)
+	if (sigs[i] == 0
+	    && ptrace (PTRACE_INTERRUPT, tids[i], NULL, NULL) != 0)
+	  sigs[i] = -1;
+      for (size_t i = 0; i < nstopped; i++)
+	{
+	  int status;
+	  if (sigs[i] < 0)
+	    continue;
+	  if (waitpid (tids[i], &status, __WALL) != tids[i]
+	      || ! WIFSTOPPED (status))
+	    {
+	      sigs[i] = -1;
+	      continue;
+	    }
+	  /* The thread may stop for a signal before PTRACE_INTERRUPT
+	     stops it, it is passed on when resuming it.  The pending
+	     PTRACE_INTERRUPT is discarded by PTRACE_DETACH.  Group-stops
+	     are kept by PTRACE_DETACH after PTRACE_SEIZE.  */
+	  if (status >> 16 != PTRACE_EVENT_STOP)
+	    sigs[i] = WSTOPSIG (status);
+	}
+#else
+      for (nstopped = 0; nstopped < ntids; nstopped++)
+	{
+	  bool was_stopped;
+	  if (! __libdwfl_ptrace_attach (tids[nstopped], &was_stopped))
+	    {
+	      if (errno != ESRCH)
+		{
+		  err = errno;
+		  break;
+		}
+	      sigs[nstopped] = -1;
+	    }
+	  else
+	    sigs[nstopped] = was_stopped ? SIGSTOP : 0;
+	}
+#endif
+    }
+
+  if (err != 0)
+    {
+      __libdwfl_ptrace_resume_all (pid_arg, tids, sigs, nstopped);
+      errno = err;
+      __libdwfl_seterrno (DWFL_E_ERRNO);
+      return false;
+    }
+
+  /* Any of the threads can be used to read the memory.  */
+  pid_arg->all_stopped = true;
+  for (size_t i = 0; i < ntids; i++)
+    if (sigs[i] >= 0)
+      {
+	pid_arg->tid_attached = tids[i];
+	break;
+      }
+  return true;
+}
+
+void
+internal_function
+__libdwfl_ptrace_resume_all (struct __libdwfl_pid_arg *pid_arg,
+			     const pid_t *tids, const int *sigs, size_t ntids)
+{
+  if (! pid_arg->assume_ptrace_stopped)
+    for (size_t i = 0; i < ntids; i++)
+      if (sigs[i] >= 0)
+	ptrace (PTRACE_DETACH, tids[i], NULL, (void *) (intptr_t) sigs[i]);
+  pid_arg->all_stopped = false;
+  pid_arg->tid_attached = 0;
+}
+
 static void
 pid_thread_detach (Dwfl_Thread *thread, void *thread_arg)
 {
   struct __libdwfl_pid_arg *pid_arg = thread_arg;
+  if (pid_arg->all_stopped)
+    return;
   pid_t tid = INTUSE(dwfl_thread_tid) (thread);
   assert (pid_arg->tid_attached == tid);
   pid_arg->tid_attached = 0;
-  clear_cached_memory (pid_arg);
   if (! pid_arg->assume_ptrace_stopped)
     __libdwfl_ptrace_detach (tid, pid_arg->tid_was_stopped);
 }
@@ -371,6 +439,11 @@ static const Dwfl_Thread_Callbacks pid_thread_callbacks =
   pid_set_initial_registers,
   pid_detach,
   pid_thread_detach,
+#ifdef HAVE_PROCESS_VM_READV
+  pid_memory_read_bulk,
+#else
+  NULL,
+#endif
 };
 
 int
@@ -460,9 +533,9 @@ dwfl_linux_proc_attach (Dwfl *dwfl, pid_t pid, bool assume_ptrace_stopped)
   pid_arg->dir = dir;
   pid_arg->elf = elf;
   pid_arg->elf_fd = elf_fd;
-  pid_arg->mem_cache = NULL;
   pid_arg->tid_attached = 0;
   pid_arg->assume_ptrace_stopped = assume_ptrace_stopped;
+  pid_arg->all_stopped = false;
   if (! INTUSE(dwfl_attach_state) (dwfl, elf, pid, &pid_thread_callbacks,
 				   pid_arg))
     {
@@ -506,6 +579,29 @@ __libdwfl_ptrace_detach (pid_t tid __attribute__ ((unused)),
 {
 }
 
+bool
+internal_function
+__libdwfl_ptrace_stop_all (struct __libdwfl_pid_arg *pid_arg
+			   __attribute__ ((unused)),
+			   const pid_t *tids __attribute__ ((unused)),
+			   int *sigs __attribute__ ((unused)),
+			   size_t ntids __attribute__ ((unused)))
+{
+  errno = ENOSYS;
+  __libdwfl_seterrno (DWFL_E_ERRNO);
+  return false;
+}
+
+void
+internal_function
+__libdwfl_ptrace_resume_all (struct __libdwfl_pid_arg *pid_arg
+			     __attribute__ ((unused)),
+			     const pid_t *tids __attribute__ ((unused)),
+			     const int *sigs __attribute__ ((unused)),
+			     size_t ntids __attribute__ ((unused)))
+{
+}
+
 int
 dwfl_linux_proc_attach (Dwfl *dwfl __attribute__ ((unused)),
 			pid_t pid __attribute__ ((unused)),
@@ -1,4 +1,5 @@
-/* Decompression support for libdwfl: zlib (gzip), bzlib (bzip2) or lzma (xz).
+/* Decompression support for libdwfl: zlib (gzip), bzlib (bzip2), lzma (xz)
+   or zstd.
    Copyright (C) 2009, 2016 Red Hat, Inc.
    This file is part of elfutils.
 
@@ -44,6 +45,10 @@
 # define __libdw_unlzma(...)	DWFL_E_BADELF
 #endif
 
+#if !USE_ZSTD
+# define __libdw_unzstd(...)	DWFL_E_BADELF
+#endif
+
 /* Consumes and replaces *ELF only on success.  */
 static Dwfl_Error
 decompress (int fd __attribute__ ((unused)), Elf **elf)
@@ -59,11 +64,18 @@ decompress (int fd __attribute__ ((unused)), Elf **elf)
   if (mapped_size == 0)
     return error;
 
+  /* Big files like core dumps are better not decompressed as a whole.  */
+  error = __libdw_open_seekable (fd, offset, mapped_size, elf);
+  if (error != DWFL_E_BADELF)
+    return error;
+
   error = __libdw_gunzip (fd, offset, mapped, mapped_size, &buffer, &size);
   if (error == DWFL_E_BADELF)
     error = __libdw_bunzip2 (fd, offset, mapped, mapped_size, &buffer, &size);
   if (error == DWFL_E_BADELF)
     error = __libdw_unlzma (fd, offset, mapped, mapped_size, &buffer, &size);
+  if (error == DWFL_E_BADELF)
+    error = __libdw_unzstd (fd, offset, mapped, mapped_size, &buffer, &size);
 
   if (error == DWFL_E_NOERROR)
     {
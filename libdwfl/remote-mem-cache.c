@@ -0,0 +1,236 @@
+/* Cache of process memory pages read in bulk during unwinding.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include <byteswap.h>
+#include <endian.h>
+#include <sys/param.h>
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+# define MY_ELFDATA	ELFDATA2LSB
+#else
+# define MY_ELFDATA	ELFDATA2MSB
+#endif
+
+/* The pages are kept in a set-associative cache.  Page N can only be
+   cached in set N % __LIBDWFL_REMOTE_MEM_CACHE_SETS, in any of its ways.
+   A miss reads the page plus the pages following it that are not cached
+   yet, up to the last set, into the same way with one memory_read_bulk
+   call.  That evicts the least recently used page of each set filled,
+   one in another way is replaced by the page in that way first.
+   Unwinding walks up the
+   stack starting at the stack pointer, so the first miss there reads
+   most of the stack that will be needed.  */
+
+#define PAGE_SIZE	__LIBDWFL_REMOTE_MEM_CACHE_SIZE
+#define SETS		__LIBDWFL_REMOTE_MEM_CACHE_SETS
+#define WAYS		__LIBDWFL_REMOTE_MEM_CACHE_WAYS
+
+static size_t
+page_set (Dwarf_Addr page)
+{
+  return (page / PAGE_SIZE) % SETS;
+}
+
+/* Return the way where PAGE is cached, or -1.  */
+static int
+find_page (struct __libdwfl_remote_mem_cache *cache, Dwarf_Addr page)
+{
+  size_t set = page_set (page);
+  for (int way = 0; way < WAYS; way++)
+    if (cache->pages[way][set].len != 0 && cache->pages[way][set].addr == page)
+      return way;
+  return -1;
+}
+
+/* Return the least recently used way of SET.  */
+static int
+lru_way (struct __libdwfl_remote_mem_cache *cache, size_t set)
+{
+  int way = 0;
+  for (int w = 1; w < WAYS; w++)
+    if (cache->pages[w][set].used < cache->pages[way][set].used)
+      way = w;
+  return way;
+}
+
+/* Read PAGE and the following pages, return the way it went to or -1.  */
+static int
+fill_pages (Dwfl_Process *process, struct __libdwfl_remote_mem_cache *cache,
+	    Dwarf_Addr page)
+{
+  size_t set = page_set (page);
+  int way = lru_way (cache, set);
+
+  size_t npages = 1;
+  while (set + npages < SETS
+	 && page + npages * PAGE_SIZE > page
+	 && find_page (cache, page + npages * PAGE_SIZE) < 0)
+    npages++;
+
+  /* The pages are read into WAY, so where another way of a set is the
+     least recently used one move the page in WAY there.  */
+  for (size_t i = 1; i < npages; i++)
+    {
+      int lru = lru_way (cache, set + i);
+      if (lru != way && cache->pages[way][set + i].len != 0)
+	{
+	  cache->pages[lru][set + i] = cache->pages[way][set + i];
+	  memcpy (cache->buf[lru][set + i], cache->buf[way][set + i],
+		  cache->pages[lru][set + i].len);
+	}
+    }
+
+  size_t len = process->memory_read_bulk (process->dwfl, page,
+					  cache->buf[way][set],
+					  npages * PAGE_SIZE,
+					  process->callbacks_arg);
+  if (len > npages * PAGE_SIZE)
+    len = npages * PAGE_SIZE;
+
+  for (size_t i = 0; i < npages; i++)
+    {
+      struct __libdwfl_remote_mem_page *p = &cache->pages[way][set + i];
+      p->addr = page + i * PAGE_SIZE;
+      p->len = len > i * PAGE_SIZE ? MIN (len - i * PAGE_SIZE, PAGE_SIZE) : 0;
+      p->used = p->len != 0 ? ++cache->clock : 0;
+    }
+
+  return len != 0 ? way : -1;
+}
+
+/* Copy SIZE bytes at ADDR from the cache of THREAD, reading them if
+   needed.  */
+static bool
+read_cached (Dwfl_Thread *thread, Dwarf_Addr addr, void *buf, size_t size)
+{
+  Dwfl_Process *process = thread->process;
+  struct __libdwfl_remote_mem_cache *cache = thread->mem_cache;
+  if (cache == NULL)
+    cache = process->mem_cache;
+  if (cache == NULL)
+    {
+      cache = calloc (1, sizeof *cache);
+      if (cache == NULL)
+	return false;
+      process->mem_cache = cache;
+    }
+
+  unsigned char *out = buf;
+  while (size > 0)
+    {
+      Dwarf_Addr page = addr & ~((Dwarf_Addr) PAGE_SIZE - 1);
+      size_t offset = addr - page;
+      int way = find_page (cache, page);
+      if (way < 0)
+	{
+	  way = fill_pages (process, cache, page);
+	  if (way < 0)
+	    return false;
+	}
+      else
+	cache->pages[way][page_set (page)].used = ++cache->clock;
+
+      size_t len = cache->pages[way][page_set (page)].len;
+      if (offset >= len)
+	return false;
+      size_t n = MIN (size, len - offset);
+      memcpy (out, &cache->buf[way][page_set (page)][offset], n);
+      out += n;
+      addr += n;
+      size -= n;
+    }
+  return true;
+}
+
+bool
+internal_function
+__libdwfl_memory_read (Dwfl_Thread *thread, Dwarf_Addr addr,
+		       Dwarf_Word *result)
+{
+  Dwfl_Process *process = thread->process;
+  if (process->memory_read_bulk != NULL)
+    {
+      Ebl *ebl = process->ebl;
+      if (ebl_get_elfclass (ebl) == ELFCLASS64)
+	{
+	  uint64_t val;
+	  if (read_cached (thread, addr, &val, sizeof val))
+	    {
+	      *result = (ebl_get_elfdata (ebl) == MY_ELFDATA
+			 ? val : bswap_64 (val));
+	      return true;
+	    }
+	}
+      else
+	{
+	  uint32_t val;
+	  if (read_cached (thread, addr, &val, sizeof val))
+	    {
+	      *result = (ebl_get_elfdata (ebl) == MY_ELFDATA
+			 ? val : bswap_32 (val));
+	      return true;
+	    }
+	}
+    }
+
+  if (process->callbacks->memory_read == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_INVALID_ARGUMENT);
+      return false;
+    }
+  /* The callback may be called by the workers of
+     dwfl_getthreads_parallel, one at a time.  */
+  Dwfl *dwfl = process->dwfl;
+  rwlock_wrlock (dwfl->unwind_lock);
+  bool ok = process->callbacks->memory_read (dwfl, addr, result,
+					     process->callbacks_arg);
+  rwlock_unlock (dwfl->unwind_lock);
+  return ok;
+}
+
+void
+internal_function
+__libdwfl_memory_cache_forget (struct __libdwfl_remote_mem_cache *cache)
+{
+  for (size_t way = 0; way < WAYS; way++)
+    for (size_t set = 0; set < SETS; set++)
+      cache->pages[way][set].len = 0;
+}
+
+void
+internal_function
+__libdwfl_memory_cache_clear (Dwfl_Process *process)
+{
+  if (process->mem_cache != NULL)
+    __libdwfl_memory_cache_forget (process->mem_cache);
+}
@@ -0,0 +1,700 @@
+/* Random access to compressed files made of independent blocks.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "system.h"
+
+#include <unistd.h>
+
+#if USE_LZMA
+# include <lzma.h>
+#endif
+#if USE_ZSTD
+# include <zstd.h>
+#endif
+
+/* How many decompressed blocks are kept around, and how many bytes
+   they may take together.  Blocks bigger than CACHED_BYTES are not
+   cached, each read decompresses them piecewise up to what it needs.  */
+#define CACHED_BLOCKS	8
+#define CACHED_BYTES	(64 << 20)
+
+/* The size of the pieces read and decompressed by stream_block.  */
+#define STREAM_CHUNK	(64 << 10)
+
+/* A part of the file that can be decompressed on its own.  */
+struct block
+{
+  /* Where the decompressed contents are in the whole file.  */
+  uint64_t offset;
+  uint64_t size;
+  /* Where the compressed block is in the compressed file.  */
+  uint64_t in_offset;
+  uint64_t in_size;
+  /* For xz, the size without the block padding and the check type.  */
+  uint64_t unpadded_size;
+  int check;
+};
+
+struct cached_block
+{
+  const struct block *block;
+  void *data;
+  unsigned long int used;
+};
+
+/* Copying LEFT bytes at SKIP in BLOCK to OUT without decompressing
+   all of BLOCK at once.  */
+struct block_stream
+{
+  struct seekable_image *image;
+  const struct block *block;
+  uint64_t in_pos;
+  uint64_t skip;
+  uint8_t *out;
+  size_t left;
+  uint8_t *in;
+  uint8_t *scratch;
+};
+
+struct seekable_image
+{
+  int fd;
+  off_t start_offset;
+  bool (*decompress) (const struct block *block, const void *in, void *out);
+  bool (*stream) (struct block_stream *stream);
+
+  struct block *blocks;
+  size_t nblocks;
+
+  struct cached_block cache[CACHED_BLOCKS];
+  size_t cached;
+  unsigned long int clock;
+  rwlock_define (, lock);
+};
+
+static inline bool
+read_at (struct seekable_image *image, void *buf, size_t len, uint64_t offset)
+{
+  return pread_retry (image->fd, buf, len,
+		      image->start_offset + offset) == (ssize_t) len;
+}
+
+static inline struct block *
+add_block (struct seekable_image *image, size_t *nalloc)
+{
+  if (image->nblocks == *nalloc)
+    {
+      size_t n = *nalloc == 0 ? 64 : *nalloc * 2;
+      struct block *blocks = realloc (image->blocks, n * sizeof *blocks);
+      if (blocks == NULL)
+	return NULL;
+      image->blocks = blocks;
+      *nalloc = n;
+    }
+  return &image->blocks[image->nblocks++];
+}
+
+/* Read the next piece of the compressed block into STREAM->in.
+   Returns its size, zero at the end of the block or -1 on failure.  */
+static ssize_t
+next_input (struct block_stream *stream)
+{
+  const struct block *block = stream->block;
+  size_t n = MIN (block->in_size - stream->in_pos, STREAM_CHUNK);
+  if (n > 0 && ! read_at (stream->image, stream->in, n,
+			  block->in_offset + stream->in_pos))
+    return -1;
+  stream->in_pos += n;
+  return n;
+}
+
+/* Return where the next decompressed bytes go and how many, into the
+   scratch buffer while skipping to the bytes wanted.  */
+static uint8_t *
+next_output (struct block_stream *stream, size_t *size)
+{
+  if (stream->skip > 0)
+    {
+      *size = MIN (stream->skip, STREAM_CHUNK);
+      return stream->scratch;
+    }
+  *size = stream->left;
+  return stream->out;
+}
+
+/* Account for N bytes decompressed where next_output said.  */
+static void
+output_done (struct block_stream *stream, size_t n)
+{
+  if (stream->skip > 0)
+    stream->skip -= n;
+  else
+    {
+      stream->out += n;
+      stream->left -= n;
+    }
+}
+
+#if USE_LZMA
+
+static bool
+xz_decompress (const struct block *block, const void *in, void *out)
+{
+  lzma_filter filters[LZMA_FILTERS_MAX + 1];
+  lzma_block header =
+    {
+      .version = 0,
+      .check = block->check,
+      .filters = filters,
+      .header_size = lzma_block_header_size_decode (*(const uint8_t *) in),
+    };
+  if (header.header_size > block->in_size
+      || lzma_block_header_decode (&header, NULL, in) != LZMA_OK)
+    return false;
+
+  size_t in_pos = header.header_size;
+  size_t out_pos = 0;
+  bool ok = (lzma_block_compressed_size (&header,
+					 block->unpadded_size) == LZMA_OK
+	     && lzma_block_buffer_decode (&header, NULL, in, &in_pos,
+					  block->in_size, out, &out_pos,
+					  block->size) == LZMA_OK
+	     && out_pos == block->size);
+
+  for (size_t i = 0; filters[i].id != LZMA_VLI_UNKNOWN; i++)
+    free (filters[i].options);
+  return ok;
+}
+
+static bool
+xz_stream (struct block_stream *stream)
+{
+  /* The block header is at most 1024 bytes, it fits the first piece.  */
+  ssize_t n = next_input (stream);
+  if (n <= 0)
+    return false;
+  lzma_filter filters[LZMA_FILTERS_MAX + 1];
+  lzma_block header =
+    {
+      .version = 0,
+      .check = stream->block->check,
+      .filters = filters,
+      .header_size = lzma_block_header_size_decode (stream->in[0]),
+    };
+  if (header.header_size > (size_t) n
+      || lzma_block_header_decode (&header, NULL, stream->in) != LZMA_OK)
+    return false;
+
+  lzma_stream z = LZMA_STREAM_INIT;
+  lzma_ret ret = LZMA_PROG_ERROR;
+  if (lzma_block_compressed_size (&header,
+				  stream->block->unpadded_size) == LZMA_OK
+      && lzma_block_decoder (&z, &header) == LZMA_OK)
+    {
+      z.next_in = stream->in + header.header_size;
+      z.avail_in = n - header.header_size;
+      do
+	{
+	  if (z.avail_in == 0)
+	    {
+	      n = next_input (stream);
+	      if (n < 0)
+		{
+		  ret = LZMA_PROG_ERROR;
+		  break;
+		}
+	      z.next_in = stream->in;
+	      z.avail_in = n;
+	    }
+	  z.next_out = next_output (stream, &z.avail_out);
+	  size_t avail = z.avail_out;
+	  ret = lzma_code (&z, LZMA_RUN);
+	  output_done (stream, avail - z.avail_out);
+	}
+      while (ret == LZMA_OK && stream->left > 0);
+    }
+  lzma_end (&z);
+
+  for (size_t i = 0; filters[i].id != LZMA_VLI_UNKNOWN; i++)
+    free (filters[i].options);
+  return (ret == LZMA_OK || ret == LZMA_STREAM_END) && stream->left == 0;
+}
+
+/* Read the indexes of all the streams of an xz file of SIZE bytes, from
+   the last one backwards like xz --list does.  */
+static Dwfl_Error
+xz_blocks (struct seekable_image *image, uint64_t size)
+{
+  Dwfl_Error error = DWFL_E_BADELF;
+  lzma_index *combined = NULL;
+  uint8_t buf[LZMA_STREAM_HEADER_SIZE];
+  uint64_t pos = size;
+  while (pos > 0)
+    {
+      /* Skip the stream padding after the stream.  */
+      uint64_t padding = 0;
+      do
+	{
+	  if (pos < 2 * LZMA_STREAM_HEADER_SIZE
+	      || ! read_at (image, buf, sizeof buf, pos - sizeof buf))
+	    goto out;
+	  if (memcmp (&buf[sizeof buf - 4], "\0\0\0", 4) != 0)
+	    break;
+	  pos -= 4;
+	  padding += 4;
+	}
+      while (true);
+
+      lzma_stream_flags footer;
+      if (lzma_stream_footer_decode (&footer, buf) != LZMA_OK
+	  || footer.backward_size > pos - 2 * LZMA_STREAM_HEADER_SIZE)
+	goto out;
+
+      uint8_t *index_buf = malloc (footer.backward_size);
+      if (index_buf == NULL)
+	{
+	  error = DWFL_E_NOMEM;
+	  goto out;
+	}
+      lzma_index *index = NULL;
+      uint64_t memlimit = UINT64_MAX;
+      size_t in_pos = 0;
+      bool ok = (read_at (image, index_buf, footer.backward_size,
+			  pos - LZMA_STREAM_HEADER_SIZE - footer.backward_size)
+		 && lzma_index_buffer_decode (&index, &memlimit, NULL,
+					      index_buf, &in_pos,
+					      footer.backward_size) == LZMA_OK);
+      free (index_buf);
+      if (! ok)
+	goto out;
+
+      /* Check the stream header against the footer.  */
+      lzma_stream_flags header;
+      uint64_t stream_size = lzma_index_stream_size (index);
+      if (stream_size > pos
+	  || ! read_at (image, buf, sizeof buf, pos - stream_size)
+	  || lzma_stream_header_decode (&header, buf) != LZMA_OK
+	  || lzma_stream_flags_compare (&header, &footer) != LZMA_OK
+	  || lzma_index_stream_flags (index, &footer) != LZMA_OK
+	  || lzma_index_stream_padding (index, padding) != LZMA_OK
+	  || (combined != NULL
+	      && lzma_index_cat (index, combined, NULL) != LZMA_OK))
+	{
+	  lzma_index_end (index, NULL);
+	  goto out;
+	}
+      combined = index;
+      pos -= stream_size;
+    }
+
+  size_t nalloc = 0;
+  lzma_index_iter iter;
+  lzma_index_iter_init (&iter, combined);
+  while (! lzma_index_iter_next (&iter, LZMA_INDEX_ITER_NONEMPTY_BLOCK))
+    {
+      struct block *block = add_block (image, &nalloc);
+      if (block == NULL)
+	{
+	  error = DWFL_E_NOMEM;
+	  goto out;
+	}
+      block->offset = iter.block.uncompressed_file_offset;
+      block->size = iter.block.uncompressed_size;
+      block->in_offset = iter.block.compressed_file_offset;
+      block->in_size = iter.block.total_size;
+      block->unpadded_size = iter.block.unpadded_size;
+      block->check = iter.stream.flags->check;
+    }
+  image->decompress = xz_decompress;
+  image->stream = xz_stream;
+  error = DWFL_E_NOERROR;
+
+ out:
+  lzma_index_end (combined, NULL);
+  return error;
+}
+
+#endif /* USE_LZMA */
+
+#if USE_ZSTD
+
+/* The seek table of the zstd seekable format is a skippable frame at
+   the end of the file, with a footer of the number of frames, a
+   descriptor byte and a magic number.  */
+#define ZSTD_SKIPPABLE_MAGIC	0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC	0x8F92EAB1
+#define ZSTD_SEEK_FOOTER_SIZE	9
+#define ZSTD_SEEK_CHECKSUM	0x80
+#define ZSTD_SEEK_RESERVED	0x7C
+
+static uint32_t
+get_le32 (const uint8_t *p)
+{
+  uint32_t value;
+  memcpy (&value, p, sizeof value);
+  return le32toh (value);
+}
+
+static bool
+zstd_decompress (const struct block *block, const void *in, void *out)
+{
+  size_t n = ZSTD_decompress (out, block->size, in, block->in_size);
+  return ! ZSTD_isError (n) && n == block->size;
+}
+
+static bool
+zstd_stream (struct block_stream *stream)
+{
+  ZSTD_DCtx *dctx = ZSTD_createDCtx ();
+  if (dctx == NULL)
+    return false;
+  ZSTD_inBuffer in = { .src = stream->in };
+  size_t result = 0;
+  do
+    {
+      if (in.pos == in.size)
+	{
+	  ssize_t n = next_input (stream);
+	  if (n < 0)
+	    break;
+	  in.pos = 0;
+	  in.size = n;
+	}
+      ZSTD_outBuffer out = { .pos = 0 };
+      out.dst = next_output (stream, &out.size);
+      result = ZSTD_decompressStream (dctx, &out, &in);
+      output_done (stream, out.pos);
+      /* No progress means the frame ended before the bytes wanted.  */
+      if (in.pos == 0 && out.pos == 0)
+	break;
+    }
+  while (! ZSTD_isError (result) && stream->left > 0);
+  ZSTD_freeDCtx (dctx);
+  return stream->left == 0;
+}
+
+static Dwfl_Error
+zstd_blocks (struct seekable_image *image, uint64_t size)
+{
+  uint8_t footer[ZSTD_SEEK_FOOTER_SIZE];
+  if (size < ZSTD_SEEK_FOOTER_SIZE + 8
+      || ! read_at (image, footer, sizeof footer, size - sizeof footer)
+      || get_le32 (&footer[5]) != ZSTD_SEEKABLE_MAGIC
+      || (footer[4] & ZSTD_SEEK_RESERVED) != 0)
+    return DWFL_E_BADELF;
+
+  uint32_t nframes = get_le32 (&footer[0]);
+  size_t entry_size = (footer[4] & ZSTD_SEEK_CHECKSUM) ? 12 : 8;
+  if (nframes > (size - ZSTD_SEEK_FOOTER_SIZE - 8) / entry_size)
+    return DWFL_E_BADELF;
+  size_t table_size = nframes * entry_size;
+  uint64_t frames_size = size - 8 - table_size - ZSTD_SEEK_FOOTER_SIZE;
+
+  /* The seek table frame header.  */
+  uint8_t header[8];
+  if (! read_at (image, header, sizeof header, frames_size)
+      || get_le32 (&header[0]) != ZSTD_SKIPPABLE_MAGIC
+      || get_le32 (&header[4]) != table_size + ZSTD_SEEK_FOOTER_SIZE)
+    return DWFL_E_BADELF;
+
+  uint8_t *table = malloc (table_size);
+  if (table == NULL)
+    return DWFL_E_NOMEM;
+  Dwfl_Error error = DWFL_E_BADELF;
+  if (! read_at (image, table, table_size, frames_size + sizeof header))
+    goto out;
+
+  size_t nalloc = 0;
+  uint64_t offset = 0, in_offset = 0;
+  for (uint32_t i = 0; i < nframes; i++)
+    {
+      uint32_t in_size = get_le32 (&table[i * entry_size]);
+      uint32_t frame_size = get_le32 (&table[i * entry_size + 4]);
+      if (frame_size != 0)
+	{
+	  struct block *block = add_block (image, &nalloc);
+	  if (block == NULL)
+	    {
+	      error = DWFL_E_NOMEM;
+	      goto out;
+	    }
+	  block->offset = offset;
+	  block->size = frame_size;
+	  block->in_offset = in_offset;
+	  block->in_size = in_size;
+	}
+      offset += frame_size;
+      in_offset += in_size;
+    }
+
+  /* The frames must fill the file up to the seek table.  */
+  if (in_offset == frames_size)
+    {
+      image->decompress = zstd_decompress;
+      image->stream = zstd_stream;
+      error = DWFL_E_NOERROR;
+    }
+
+ out:
+  free (table);
+  return error;
+}
+
+#endif /* USE_ZSTD */
+
+/* Return the block containing OFFSET, or NULL past the end.  */
+static const struct block *
+find_block (const struct seekable_image *image, uint64_t offset)
+{
+  size_t l = 0, u = image->nblocks;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      const struct block *block = &image->blocks[idx];
+      if (offset < block->offset)
+	u = idx;
+      else if (offset >= block->offset + block->size)
+	l = idx + 1;
+      else
+	return block;
+    }
+  return NULL;
+}
+
+/* Return the least recently used cache slot, which is an empty one if
+   there is any.  With FULL, only the slots holding a block count.  */
+static struct cached_block *
+lru_slot (struct seekable_image *image, bool full)
+{
+  struct cached_block *slot = NULL;
+  for (size_t i = 0; i < CACHED_BLOCKS; i++)
+    {
+      struct cached_block *cached = &image->cache[i];
+      if ((! full || cached->block != NULL)
+	  && (slot == NULL || cached->used < slot->used))
+	slot = cached;
+    }
+  return slot;
+}
+
+static void
+evict (struct seekable_image *image, struct cached_block *slot)
+{
+  if (slot->block != NULL)
+    image->cached -= slot->block->size;
+  free (slot->data);
+  slot->block = NULL;
+  slot->data = NULL;
+  slot->used = 0;
+}
+
+/* Return the decompressed contents of BLOCK, evicting the least
+   recently used blocks from the cache to make room.  Sets errno and
+   returns NULL on failure.  */
+static const void *
+get_block (struct seekable_image *image, const struct block *block)
+{
+  for (size_t i = 0; i < CACHED_BLOCKS; i++)
+    {
+      struct cached_block *cached = &image->cache[i];
+      if (cached->block == block)
+	{
+	  cached->used = ++image->clock;
+	  return cached->data;
+	}
+    }
+
+  while (image->cached + block->size > CACHED_BYTES)
+    evict (image, lru_slot (image, true));
+  struct cached_block *slot = lru_slot (image, false);
+  evict (image, slot);
+
+  slot->data = malloc (block->size);
+  void *in = malloc (block->in_size);
+  if (slot->data == NULL || in == NULL)
+    {
+      free (in);
+      free (slot->data);
+      slot->data = NULL;
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  bool ok = (read_at (image, in, block->in_size, block->in_offset)
+	     && image->decompress (block, in, slot->data));
+  free (in);
+  if (! ok)
+    {
+      free (slot->data);
+      slot->data = NULL;
+      errno = EIO;
+      return NULL;
+    }
+
+  slot->block = block;
+  slot->used = ++image->clock;
+  image->cached += block->size;
+  return slot->data;
+}
+
+/* Copy N bytes at SKIP in BLOCK to BUF, decompressing only the part of
+   BLOCK up to them.  Sets errno and returns false on failure.  */
+static bool
+stream_block (struct seekable_image *image, const struct block *block,
+	      uint64_t skip, void *buf, size_t n)
+{
+  struct block_stream stream =
+    {
+      .image = image,
+      .block = block,
+      .skip = skip,
+      .out = buf,
+      .left = n,
+      .in = malloc (STREAM_CHUNK),
+      .scratch = malloc (STREAM_CHUNK),
+    };
+  bool ok = stream.in != NULL && stream.scratch != NULL;
+  if (! ok)
+    errno = ENOMEM;
+  else if (! (ok = image->stream (&stream)))
+    errno = EIO;
+  free (stream.in);
+  free (stream.scratch);
+  return ok;
+}
+
+/* The Elf_Read_Function given to elf_begin_read.  */
+static ssize_t
+seekable_read (void *arg, void *buf, size_t n, off_t offset)
+{
+  struct seekable_image *image = arg;
+  const struct block *block = find_block (image, offset);
+  if (block == NULL)
+    return 0;
+
+  size_t skip = offset - block->offset;
+  ssize_t result = MIN (n, block->size - skip);
+  if (block->size > CACHED_BYTES)
+    return stream_block (image, block, skip, buf, result) ? result : -1;
+
+  rwlock_wrlock (image->lock);
+  const void *data = get_block (image, block);
+  if (data != NULL)
+    memcpy (buf, data + skip, result);
+  else
+    result = -1;
+  rwlock_unlock (image->lock);
+  return result;
+}
+
+static void
+seekable_release (void *arg)
+{
+  struct seekable_image *image = arg;
+  for (size_t i = 0; i < CACHED_BLOCKS; i++)
+    free (image->cache[i].data);
+  rwlock_fini (image->lock);
+  close (image->fd);
+  free (image->blocks);
+  free (image);
+}
+
+Dwfl_Error
+internal_function
+__libdw_open_seekable (int fd, off_t start_offset, size_t size, Elf **elf)
+{
+  unsigned char magic[6];
+  if (fd < 0
+      || size < sizeof magic
+      || pread_retry (fd, magic, sizeof magic,
+		      start_offset) != (ssize_t) sizeof magic)
+    return DWFL_E_BADELF;
+
+  struct seekable_image *image = calloc (1, sizeof *image);
+  if (image == NULL)
+    return DWFL_E_NOMEM;
+  image->fd = fd;
+  image->start_offset = start_offset;
+
+  Dwfl_Error error = DWFL_E_BADELF;
+#if USE_LZMA
+  if (memcmp (magic, "\xFD" "7zXZ\0", 6) == 0)
+    error = xz_blocks (image, size);
+#endif
+#if USE_ZSTD
+  if (memcmp (magic, "\x28\xb5\x2f\xfd", 4) == 0)
+    error = zstd_blocks (image, size);
+#endif
+
+  /* With a single block there is nothing to gain over decompressing
+     the whole file.  The blocks must be adjacent for find_block.  */
+  if (error == DWFL_E_NOERROR && image->nblocks < 2)
+    error = DWFL_E_BADELF;
+  for (size_t i = 0; error == DWFL_E_NOERROR && i < image->nblocks; i++)
+    {
+      const struct block *block = &image->blocks[i];
+      if (block->offset != (i == 0 ? 0 : block[-1].offset + block[-1].size)
+	  || block->in_offset > size || block->in_size > size - block->in_offset
+	  || block->size > SIZE_MAX - block->offset)
+	error = DWFL_E_BADELF;
+    }
+
+  if (error == DWFL_E_NOERROR)
+    {
+      image->fd = dup (fd);
+      if (image->fd < 0)
+	error = DWFL_E_ERRNO;
+    }
+
+  if (error != DWFL_E_NOERROR)
+    {
+      free (image->blocks);
+      free (image);
+      return error;
+    }
+
+  rwlock_init (image->lock);
+  const struct block *last = &image->blocks[image->nblocks - 1];
+  Elf *seekable = elf_begin_read (seekable_read, seekable_release, image,
+				  last->offset + last->size);
+  if (seekable == NULL)
+    {
+      seekable_release (image);
+      return DWFL_E_LIBELF;
+    }
+
+  elf_end (*elf);
+  *elf = seekable;
+  return DWFL_E_NOERROR;
+}
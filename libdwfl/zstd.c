@@ -0,0 +1,4 @@
+/* The zstd streaming interface is wrapped to look like zlib.  */
+
+#define ZSTD
+#include "gzip.c"
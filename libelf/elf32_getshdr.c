@@ -168,12 +168,12 @@ load_shdr_wrlock (Elf_Scn *scn)
 	    free (notcvt);
 	}
     }
-  else if (likely (elf->fildes != -1))
+  else if (likely (__libelf_can_read (elf)))
     {
       /* Read the header.  */
-      ssize_t n = pread_retry (elf->fildes,
-			       elf->state.ELFW(elf,LIBELFBITS).shdr, size,
-			       elf->start_offset + ehdr->e_shoff);
+      ssize_t n = __libelf_pread (elf,
+				  elf->state.ELFW(elf,LIBELFBITS).shdr, size,
+				  elf->start_offset + ehdr->e_shoff);
       if (unlikely ((size_t) n != size))
 	{
 	  /* Severe problems.  We cannot read the data.  */
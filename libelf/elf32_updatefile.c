@@ -34,11 +34,14 @@
 #include <assert.h>
 #include <errno.h>
 #include <libelf.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 
 #include <system.h>
 #include "libelfP.h"
@@ -468,11 +471,6 @@ __elfw2(LIBELFBITS,updatemmap) (Elf *elf, int change_bo, size_t shnum)
 /* Size of the buffer we use to generate the blocks of fill bytes.  */
 #define FILLBUFSIZE	4096
 
-/* If we have to convert the section buffer contents we have to use
-   temporary buffer.  Only buffers up to MAX_TMPBUF bytes are allocated
-   on the stack.  */
-#define MAX_TMPBUF	32768
-
 
 /* Helper function to write out fill bytes.  */
 static int
@@ -508,6 +506,309 @@ fill (int fd, off_t pos, size_t len, char *fillbuf, size_t *filledp)
 }
 
 
+/* The section data, the fill bytes between it and the section header
+   table are not written one by one.  They are collected in a batch,
+   converted to the file byte order (on several threads with
+   ELF_F_THREADS) and then written with one pwritev for each run of
+   consecutive pieces.  */
+
+/* Convert on at most this many threads.  */
+#define BATCH_THREADS_MAX	8
+
+/* Write the batch when it has this much data to convert.  */
+#define BATCH_CONVERT_SIZE	(64 * 1024 * 1024)
+
+/* Big data is converted in pieces of about this size.  */
+#define CONVERT_CHUNK_SIZE	(1024 * 1024)
+
+/* The most buffers written with one pwritev.  */
+#define BATCH_IOV_MAX		(IOV_MAX < 1024 ? IOV_MAX : 1024)
+
+struct write_piece
+{
+  off_t offset;
+  size_t size;
+  /* The data, NULL for fill bytes.  */
+  const void *buf;
+  /* If not NULL BUF is converted with this into CONVERTED, in pieces
+     of RECSIZE bytes if that isn't zero.  */
+  xfct_t convert;
+  size_t recsize;
+  void *converted;
+};
+
+struct write_batch
+{
+  int fd;
+  unsigned int threads;
+  struct write_piece *pieces;
+  size_t npieces;
+  size_t maxpieces;
+  size_t convert_size;
+  char fillbuf[FILLBUFSIZE];
+};
+
+struct convert_job
+{
+  xfct_t convert;
+  void *dest;
+  const void *src;
+  size_t size;
+};
+
+struct convert_work
+{
+  struct convert_job *jobs;
+  size_t njobs;
+  size_t next;
+};
+
+static void
+batch_init (struct write_batch *batch, Elf *elf)
+{
+  batch->fd = elf->fildes;
+  batch->threads = 1;
+  if ((elf->flags & ELF_F_THREADS) != 0)
+    {
+      if (__libelf_update_threads != 0)
+	batch->threads = __libelf_update_threads;
+      else
+	{
+	  long int ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+	  if (ncpus > 1)
+	    batch->threads = MIN (ncpus, BATCH_THREADS_MAX);
+	}
+    }
+  batch->pieces = NULL;
+  batch->npieces = 0;
+  batch->maxpieces = 0;
+  batch->convert_size = 0;
+  memset (batch->fillbuf, __libelf_fill_byte, FILLBUFSIZE);
+}
+
+static void
+batch_free (struct write_batch *batch)
+{
+  for (size_t i = 0; i < batch->npieces; i++)
+    free (batch->pieces[i].converted);
+  free (batch->pieces);
+  batch->pieces = NULL;
+  batch->npieces = 0;
+  batch->maxpieces = 0;
+}
+
+static void *
+convert_worker (void *arg)
+{
+  struct convert_work *work = arg;
+  size_t i;
+  while ((i = __atomic_fetch_add (&work->next, 1, __ATOMIC_RELAXED))
+	 < work->njobs)
+    {
+      struct convert_job *job = &work->jobs[i];
+      (*job->convert) (job->dest, job->src, job->size, 1);
+    }
+  return NULL;
+}
+
+/* Convert the data of all pieces that need it.  */
+static bool
+batch_convert (struct write_batch *batch)
+{
+  size_t njobs = 0;
+  for (size_t i = 0; i < batch->npieces; i++)
+    {
+      struct write_piece *piece = &batch->pieces[i];
+      if (piece->convert == NULL)
+	continue;
+
+      piece->converted = malloc (piece->size);
+      if (unlikely (piece->converted == NULL))
+	{
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  return false;
+	}
+      size_t chunk = piece->size;
+      if (piece->recsize != 0 && piece->size > CONVERT_CHUNK_SIZE)
+	chunk = CONVERT_CHUNK_SIZE - CONVERT_CHUNK_SIZE % piece->recsize;
+      njobs += (piece->size + chunk - 1) / chunk;
+    }
+  if (njobs == 0)
+    return true;
+
+  struct convert_job *jobs = malloc (njobs * sizeof *jobs);
+  if (unlikely (jobs == NULL))
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return false;
+    }
+  size_t n = 0;
+  for (size_t i = 0; i < batch->npieces; i++)
+    {
+      struct write_piece *piece = &batch->pieces[i];
+      if (piece->convert == NULL)
+	continue;
+
+      size_t chunk = piece->size;
+      if (piece->recsize != 0 && piece->size > CONVERT_CHUNK_SIZE)
+	chunk = CONVERT_CHUNK_SIZE - CONVERT_CHUNK_SIZE % piece->recsize;
+      for (size_t off = 0; off < piece->size; off += chunk)
+	{
+	  jobs[n].convert = piece->convert;
+	  jobs[n].dest = (char *) piece->converted + off;
+	  jobs[n].src = (const char *) piece->buf + off;
+	  jobs[n].size = MIN (chunk, piece->size - off);
+	  n++;
+	}
+    }
+
+  /* This thread works too.  If a thread cannot be created the others
+     just get more to do.  */
+  struct convert_work work = { .jobs = jobs, .njobs = njobs };
+  unsigned int threads = MIN (batch->threads, njobs);
+  pthread_t *workers = NULL;
+  if (threads > 1)
+    workers = malloc ((threads - 1) * sizeof *workers);
+  unsigned int started = 0;
+  while (workers != NULL && started < threads - 1
+	 && pthread_create (&workers[started], NULL, convert_worker,
+			    &work) == 0)
+    started++;
+  convert_worker (&work);
+  for (unsigned int i = 0; i < started; i++)
+    pthread_join (workers[i], NULL);
+  free (workers);
+  free (jobs);
+
+  return true;
+}
+
+static bool
+batch_pwritev (int fd, struct iovec *iov, int niov, off_t offset,
+	       size_t len)
+{
+  if (unlikely ((size_t) pwritev_retry (fd, iov, niov, offset) != len))
+    {
+      __libelf_seterrno (ELF_E_WRITE_ERROR);
+      return false;
+    }
+  return true;
+}
+
+/* Convert and write all pieces of BATCH and empty it.  */
+static bool
+batch_flush (struct write_batch *batch)
+{
+  if (! batch_convert (batch))
+    return false;
+
+  struct iovec iov[BATCH_IOV_MAX];
+  int niov = 0;
+  off_t start = 0;
+  size_t len = 0;
+  for (size_t i = 0; i < batch->npieces; i++)
+    {
+      struct write_piece *piece = &batch->pieces[i];
+      const char *buf = piece->converted ?: piece->buf;
+      size_t done = 0;
+      while (done < piece->size)
+	{
+	  /* A piece not following the previous one, which happens with
+	     a bogus layout with overlaps, starts a new write.  That
+	     keeps the order of the writes.  */
+	  if (niov > 0 && (niov == BATCH_IOV_MAX
+			   || start + (off_t) len != piece->offset + (off_t) done))
+	    {
+	      if (! batch_pwritev (batch->fd, iov, niov, start, len))
+		return false;
+	      niov = 0;
+	    }
+	  if (niov == 0)
+	    {
+	      start = piece->offset + (off_t) done;
+	      len = 0;
+	    }
+
+	  size_t n = piece->size - done;
+	  if (buf == NULL)
+	    {
+	      n = MIN (n, FILLBUFSIZE);
+	      iov[niov].iov_base = batch->fillbuf;
+	    }
+	  else
+	    iov[niov].iov_base = (char *) buf + done;
+	  iov[niov].iov_len = n;
+	  niov++;
+	  len += n;
+	  done += n;
+	}
+    }
+  if (niov > 0 && ! batch_pwritev (batch->fd, iov, niov, start, len))
+    return false;
+
+  batch_free (batch);
+  batch->convert_size = 0;
+  return true;
+}
+
+/* Add SIZE bytes at BUF to be written at OFFSET, converted with CONVERT
+   first unless it is NULL.  TYPE is the type of the data.  A NULL BUF
+   writes fill bytes.  */
+static bool
+batch_add (struct write_batch *batch, off_t offset, const void *buf,
+	   size_t size, xfct_t convert, Elf_Type type)
+{
+  if (size == 0)
+    return true;
+
+  if (batch->npieces == batch->maxpieces)
+    {
+      size_t newmax = batch->maxpieces * 2 ?: 64;
+      struct write_piece *newpieces = realloc (batch->pieces,
+					       newmax * sizeof *newpieces);
+      if (unlikely (newpieces == NULL))
+	{
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  return false;
+	}
+      batch->pieces = newpieces;
+      batch->maxpieces = newmax;
+    }
+
+  struct write_piece *piece = &batch->pieces[batch->npieces++];
+  piece->offset = offset;
+  piece->size = size;
+  piece->buf = buf;
+  piece->convert = convert;
+  piece->converted = NULL;
+  switch (type)
+    {
+    case ELF_T_VDEF:
+    case ELF_T_VDAUX:
+    case ELF_T_VNEED:
+    case ELF_T_VNAUX:
+    case ELF_T_NHDR:
+    case ELF_T_NHDR8:
+    case ELF_T_CHDR:
+    case ELF_T_GNUHASH:
+      /* These are not arrays of records of one size.  */
+      piece->recsize = 0;
+      break;
+    default:
+      piece->recsize = elf_typesize (LIBELFBITS, type, 1);
+      break;
+    }
+
+  if (convert != NULL)
+    {
+      batch->convert_size += size;
+      if (batch->convert_size >= BATCH_CONVERT_SIZE)
+	return batch_flush (batch);
+    }
+  return true;
+}
+
+
 int
 internal_function
 __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
@@ -689,6 +990,9 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
 	}
       sort_sections (scns, list);
 
+      struct write_batch batch;
+      batch_init (&batch, elf);
+
       for (size_t cnt = 0; cnt < shnum; ++cnt)
 	{
 	  Elf_Scn *scn = scns[cnt];
@@ -717,12 +1021,13 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
 			|| ((scn->flags | dl->flags | elf->flags)
 			    & ELF_F_DIRTY) != 0))
 		  {
-		    if (unlikely (fill (elf->fildes, last_offset,
-					(scn_start + dl->data.d.d_off)
-					- last_offset, fillbuf,
-					&filled) != 0))
+		    if (unlikely (! batch_add (&batch, last_offset, NULL,
+					       (scn_start + dl->data.d.d_off)
+					       - last_offset, NULL,
+					       ELF_T_BYTE)))
 		      {
 		      fail_free:
+			batch_free (&batch);
 			free (shdr_data_mem);
 			free (scns);
 			return 1;
@@ -733,15 +1038,16 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
 
 		if ((scn->flags | dl->flags | elf->flags) & ELF_F_DIRTY)
 		  {
-		    char tmpbuf[MAX_TMPBUF];
-		    void *buf = dl->data.d.d_buf;
+		    xfct_t convert = NULL;
 
 		    /* Let it go backward if the sections use a bogus
 		       layout with overlaps.  We'll overwrite the stupid
 		       user's section data with the latest one, rather than
 		       crashing.  */
 
-		    if (unlikely (change_bo))
+		    /* Bytes are the same in either byte order.  */
+		    if (unlikely (change_bo)
+			&& dl->data.d.d_type != ELF_T_BYTE)
 		      {
 #if EV_NUM != 2
 			xfct_t fctp;
@@ -750,36 +1056,14 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
 # undef fctp
 # define fctp __elf_xfctstom[0][EV_CURRENT - 1][ELFW(ELFCLASS, LIBELFBITS) - 1][dl->data.d.d_type]
 #endif
-
-			buf = tmpbuf;
-			if (dl->data.d.d_size > MAX_TMPBUF)
-			  {
-			    buf = malloc (dl->data.d.d_size);
-			    if (unlikely (buf == NULL))
-			      {
-				__libelf_seterrno (ELF_E_NOMEM);
-				goto fail_free;
-			      }
-			  }
-
-			/* Do the real work.  */
-			(*fctp) (buf, dl->data.d.d_buf, dl->data.d.d_size, 1);
-		      }
-
-		    ssize_t n = pwrite_retry (elf->fildes, buf,
-					      dl->data.d.d_size,
-					      last_offset);
-		    if (unlikely ((size_t) n != dl->data.d.d_size))
-		      {
-			if (buf != dl->data.d.d_buf && buf != tmpbuf)
-			  free (buf);
-
-			__libelf_seterrno (ELF_E_WRITE_ERROR);
-			goto fail_free;
+			convert = fctp;
 		      }
 
-		    if (buf != dl->data.d.d_buf && buf != tmpbuf)
-		      free (buf);
+		    if (unlikely (! batch_add (&batch, last_offset,
+					       dl->data.d.d_buf,
+					       dl->data.d.d_size, convert,
+					       dl->data.d.d_type)))
+		      goto fail_free;
 
 		    scn_changed = true;
 		  }
@@ -797,9 +1081,9 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
 		 header) changed we might have to fill the gap.  */
 	      if (scn_start > last_offset && previous_scn_changed)
 		{
-		  if (unlikely (fill (elf->fildes, last_offset,
-				      scn_start - last_offset, fillbuf,
-				      &filled) != 0))
+		  if (unlikely (! batch_add (&batch, last_offset, NULL,
+					     scn_start - last_offset, NULL,
+					     ELF_T_BYTE)))
 		    goto fail_free;
 		}
 
@@ -825,22 +1109,23 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
       /* Fill the gap between last section and section header table if
 	 necessary.  */
       if ((elf->flags & ELF_F_DIRTY) && last_offset < shdr_offset
-	  && unlikely (fill (elf->fildes, last_offset,
-			     shdr_offset - last_offset,
-			     fillbuf, &filled) != 0))
+	  && unlikely (! batch_add (&batch, last_offset, NULL,
+				    shdr_offset - last_offset, NULL,
+				    ELF_T_BYTE)))
 	goto fail_free;
 
       /* Write out the section header table.  */
       if (shdr_flags & ELF_F_DIRTY
-	  && unlikely ((size_t) pwrite_retry (elf->fildes, shdr_data,
-					      sizeof (ElfW2(LIBELFBITS,Shdr))
-					      * shnum, shdr_offset)
-		       != sizeof (ElfW2(LIBELFBITS,Shdr)) * shnum))
-	{
-	  __libelf_seterrno (ELF_E_WRITE_ERROR);
-	  goto fail_free;
-	}
+	  && unlikely (! batch_add (&batch, shdr_offset, shdr_data,
+				    sizeof (ElfW2(LIBELFBITS,Shdr)) * shnum,
+				    NULL, ELF_T_SHDR)))
+	goto fail_free;
+
+      /* Write whatever is left.  */
+      if (unlikely (! batch_flush (&batch)))
+	goto fail_free;
 
+      batch_free (&batch);
       free (shdr_data_mem);
       free (scns);
     }
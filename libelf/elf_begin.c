@@ -70,9 +70,35 @@ file_read_ar (int fildes, void *map_address, off_t offset, size_t maxsize,
 }
 
 
+/* Read LEN bytes at OFFSET through READER, or from FILDES if READER is
+   NULL.  */
+static inline ssize_t
+read_retry (int fildes, struct Elf_Reader *reader, void *buf, size_t len,
+	    off_t offset)
+{
+  if (reader != NULL)
+    return __libelf_reader_pread (reader, buf, len, offset);
+  return pread_retry (fildes, buf, len, offset);
+}
+
+
+void
+internal_function
+__libelf_reader_release (struct Elf_Reader *reader)
+{
+  if (reader == NULL
+      || __atomic_sub_fetch (&reader->ref_count, 1, __ATOMIC_ACQ_REL) != 0)
+    return;
+
+  if (reader->release != NULL)
+    reader->release (reader->arg);
+  free (reader);
+}
+
+
 static size_t
-get_shnum (void *map_address, unsigned char *e_ident, int fildes, off_t offset,
-	   size_t maxsize)
+get_shnum (void *map_address, unsigned char *e_ident, int fildes,
+	   struct Elf_Reader *reader, off_t offset, size_t maxsize)
 {
   size_t result;
   union
@@ -168,11 +194,11 @@ get_shnum (void *map_address, unsigned char *e_ident, int fildes, off_t offset,
 						 + offset))->sh_size,
 			sizeof (Elf32_Word));
 	      else
-		if (unlikely ((r = pread_retry (fildes, &size,
-						sizeof (Elf32_Word),
-						offset + ehdr.e32->e_shoff
-						+ offsetof (Elf32_Shdr,
-							    sh_size)))
+		if (unlikely ((r = read_retry (fildes, reader, &size,
+					       sizeof (Elf32_Word),
+					       offset + ehdr.e32->e_shoff
+					       + offsetof (Elf32_Shdr,
+							   sh_size)))
 			      != sizeof (Elf32_Word)))
 		  {
 		    if (r < 0)
@@ -225,11 +251,11 @@ get_shnum (void *map_address, unsigned char *e_ident, int fildes, off_t offset,
 						 + offset))->sh_size,
 			sizeof (Elf64_Xword));
 	      else
-		if (unlikely ((r = pread_retry (fildes, &size,
-						sizeof (Elf64_Xword),
-						offset + ehdr.e64->e_shoff
-						+ offsetof (Elf64_Shdr,
-							    sh_size)))
+		if (unlikely ((r = read_retry (fildes, reader, &size,
+					       sizeof (Elf64_Xword),
+					       offset + ehdr.e64->e_shoff
+					       + offsetof (Elf64_Shdr,
+							   sh_size)))
 			      != sizeof (Elf64_Xword)))
 		  {
 		    if (r < 0)
@@ -265,8 +291,9 @@ get_shnum (void *map_address, unsigned char *e_ident, int fildes, off_t offset,
 
 /* Create descriptor for ELF file in memory.  */
 static Elf *
-file_read_elf (int fildes, void *map_address, unsigned char *e_ident,
-	       off_t offset, size_t maxsize, Elf_Cmd cmd, Elf *parent)
+file_read_elf (int fildes, struct Elf_Reader *reader, void *map_address,
+	       unsigned char *e_ident, off_t offset, size_t maxsize, Elf_Cmd cmd,
+	       Elf *parent)
 {
   /* Verify the binary is of the class we can handle.  */
   if (unlikely ((e_ident[EI_CLASS] != ELFCLASS32
@@ -283,7 +310,8 @@ file_read_elf (int fildes, void *map_address, unsigned char *e_ident,
   /* Determine the number of sections.  Returns -1 and sets libelf errno
      if the file handle or elf file is invalid.  Returns zero if there
      are no section headers (or they cannot be read).  */
-  size_t scncnt = get_shnum (map_address, e_ident, fildes, offset, maxsize);
+  size_t scncnt = get_shnum (map_address, e_ident, fildes, reader, offset,
+			     maxsize);
   if (scncnt == (size_t) -1l)
     /* Could not determine the number of sections.  */
     return NULL;
@@ -546,8 +574,8 @@ __libelf_read_mmaped_file (int fildes, void *map_address,  off_t offset,
   switch (kind)
     {
     case ELF_K_ELF:
-      return file_read_elf (fildes, map_address, e_ident, offset, maxsize,
-			    cmd, parent);
+      return file_read_elf (fildes, NULL, map_address, e_ident, offset,
+			    maxsize, cmd, parent);
 
     case ELF_K_AR:
       return file_read_ar (fildes, map_address, offset, maxsize, cmd, parent);
@@ -564,8 +592,8 @@ __libelf_read_mmaped_file (int fildes, void *map_address,  off_t offset,
 
 
 static Elf *
-read_unmmaped_file (int fildes, off_t offset, size_t maxsize, Elf_Cmd cmd,
-		    Elf *parent)
+read_unmmaped_file (int fildes, struct Elf_Reader *reader, off_t offset,
+		    size_t maxsize, Elf_Cmd cmd, Elf *parent)
 {
   /* We have to find out what kind of file this is.  We handle ELF
      files and archives.  To find out what we have we must read the
@@ -585,10 +613,10 @@ read_unmmaped_file (int fildes, off_t offset, size_t maxsize, Elf_Cmd cmd,
   } mem;
 
   /* Read the head of the file.  */
-  ssize_t nread = pread_retry (fildes, mem.header,
-			       MIN (MAX (sizeof (Elf64_Ehdr), SARMAG),
-				    maxsize),
-			       offset);
+  ssize_t nread = read_retry (fildes, reader, mem.header,
+			      MIN (MAX (sizeof (Elf64_Ehdr), SARMAG),
+				   maxsize),
+			      offset);
   if (unlikely (nread == -1))
     {
       /* We cannot even read the head of the file.  Maybe FILDES is associated
@@ -603,14 +631,17 @@ read_unmmaped_file (int fildes, off_t offset, size_t maxsize, Elf_Cmd cmd,
   switch (kind)
     {
     case ELF_K_AR:
-      return file_read_ar (fildes, NULL, offset, maxsize, cmd, parent);
+      /* Archive members are always read through the file descriptor.  */
+      if (reader == NULL)
+	return file_read_ar (fildes, NULL, offset, maxsize, cmd, parent);
+      break;
 
     case ELF_K_ELF:
       /* Make sure at least the ELF header is contained in the file.  */
       if ((size_t) nread >= (mem.header[EI_CLASS] == ELFCLASS32
 			     ? sizeof (Elf32_Ehdr) : sizeof (Elf64_Ehdr)))
-	return file_read_elf (fildes, NULL, mem.header, offset, maxsize, cmd,
-			      parent);
+	return file_read_elf (fildes, reader, NULL, mem.header, offset,
+			      maxsize, cmd, parent);
       FALLTHROUGH;
 
     default:
@@ -700,7 +731,7 @@ read_file (int fildes, off_t offset, size_t maxsize,
 
   /* Otherwise we have to do it the hard way.  We read as much as necessary
      from the file whenever we need information which is not available.  */
-  return read_unmmaped_file (fildes, offset, maxsize, cmd, parent);
+  return read_unmmaped_file (fildes, NULL, offset, maxsize, cmd, parent);
 }
 
 
@@ -1178,3 +1209,42 @@ elf_begin (int fildes, Elf_Cmd cmd, Elf *ref)
   return retval;
 }
 INTDEF(elf_begin)
+
+
+Elf *
+elf_begin_read (Elf_Read_Function *read, void (*release) (void *arg),
+		void *arg, size_t size)
+{
+  if (unlikely (! __libelf_version_initialized))
+    {
+      /* Version wasn't set so far.  */
+      __libelf_seterrno (ELF_E_NO_VERSION);
+      return NULL;
+    }
+
+  if (unlikely (read == NULL))
+    {
+      __libelf_seterrno (ELF_E_INVALID_OPERAND);
+      return NULL;
+    }
+
+  struct Elf_Reader *reader = malloc (sizeof *reader);
+  if (reader == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+  reader->read = read;
+  reader->release = release;
+  reader->arg = arg;
+  reader->ref_count = 1;
+
+  /* There is no file descriptor, everything is read through READER.  */
+  Elf *result = read_unmmaped_file (-1, reader, 0, size, ELF_C_READ, NULL);
+  if (result == NULL)
+    free (reader);
+  else
+    result->reader = reader;
+
+  return result;
+}
@@ -71,6 +71,11 @@ elf_clone (Elf *elf, Elf_Cmd cmd)
       retval->state.elf32.scns.max = elf->state.elf32.scns.max;
 
       retval->class = elf->class;
+
+      /* The clone reads the file the same way.  */
+      retval->reader = elf->reader;
+      if (retval->reader != NULL)
+	__atomic_add_fetch (&retval->reader->ref_count, 1, __ATOMIC_RELAXED);
     }
 
   /* Release the lock.  */
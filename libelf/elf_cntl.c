@@ -44,7 +44,7 @@ elf_cntl (Elf *elf, Elf_Cmd cmd)
   if (elf == NULL)
     return -1;
 
-  if (elf->fildes == -1)
+  if (! __libelf_can_read (elf))
     {
       __libelf_seterrno (ELF_E_INVALID_HANDLE);
       return -1;
@@ -67,6 +67,8 @@ elf_cntl (Elf *elf, Elf_Cmd cmd)
     case ELF_C_FDDONE:
       /* Mark the file descriptor as not usable.  */
       elf->fildes = -1;
+      __libelf_reader_release (elf->reader);
+      elf->reader = NULL;
       break;
 
     default:
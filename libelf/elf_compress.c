@@ -35,11 +35,15 @@
 #include "libelfP.h"
 #include "common.h"
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <zlib.h>
+#if USE_ZSTD
+# include <zstd.h>
+#endif
 
 /* Cleanup and return result.  Don't leak memory.  */
 static void *
@@ -63,11 +67,10 @@ do_deflate_cleanup (void *result, z_stream *z, void *out_buf,
    returns the new buffer size in new_size (hsize + compressed data
    size).  Returns (void *) -1 when FORCE is false and the compressed
    data would be bigger than the original data.  */
-void *
-internal_function
-__libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
-		   size_t *orig_size, size_t *orig_addralign,
-		   size_t *new_size, bool force)
+static void *
+deflate_stream (Elf_Scn *scn, size_t hsize, int ei_data,
+		size_t *orig_size, size_t *orig_addralign,
+		size_t *new_size, bool force, int level)
 {
   /* The compressed data is the on-disk data.  We simplify the
      implementation a bit by asking for the (converted) in-memory
@@ -110,7 +113,7 @@ __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
   z.zalloc = Z_NULL;
   z.zfree = Z_NULL;
   z.opaque = Z_NULL;
-  int zrc = deflateInit (&z, Z_BEST_COMPRESSION);
+  int zrc = deflateInit (&z, level);
   if (zrc != Z_OK)
     {
       free (out_buf);
@@ -207,10 +210,436 @@ __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
   return out_buf;
 }
 
+/* Return the data of SCN converted to EI_DATA as one buffer of
+   *SIZE bytes, and the biggest alignment of its Elf_Data in
+   *ADDRALIGN.  Sets *MALLOCED when the caller has to free it.  */
+static void *
+get_raw_data (Elf_Scn *scn, int ei_data, size_t *size, size_t *addralign,
+	      bool *malloced)
+{
+  Elf_Data *data = elf_getdata (scn, NULL);
+  if (data == NULL)
+    return NULL;
+
+  Elf_Data *next_data = elf_getdata (scn, data);
+  *size = data->d_size;
+  *addralign = data->d_align;
+  if (next_data == NULL && ei_data == MY_ELFDATA)
+    {
+      /* The common case, no need to copy.  */
+      *malloced = false;
+      return data->d_buf;
+    }
+
+  for (Elf_Data *d = next_data; d != NULL; d = elf_getdata (scn, d))
+    {
+      *size += d->d_size;
+      *addralign = MAX (*addralign, d->d_align);
+    }
+
+  char *buf = malloc (*size ?: 1);
+  if (buf == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  size_t used = 0;
+  for (Elf_Data *d = data; d != NULL; d = elf_getdata (scn, d))
+    {
+      if (ei_data != MY_ELFDATA)
+	{
+	  Elf_Data cdata = *d;
+	  cdata.d_buf = buf + used;
+	  if (gelf_xlatetof (scn->elf, &cdata, d, ei_data) == NULL)
+	    {
+	      free (buf);
+	      return NULL;
+	    }
+	}
+      else if (d->d_size > 0)
+	memcpy (buf + used, d->d_buf, d->d_size);
+      used += d->d_size;
+    }
+
+  *malloced = true;
+  return buf;
+}
+
+/* Data is compressed on several threads in chunks of CHUNK_SIZE bytes,
+   each raw deflate stream primed with the WINDOW_SIZE bytes before it
+   and ended with a sync flush, like pigz does.  The chunks together
+   are one zlib stream.  */
+#define CHUNK_SIZE	(128 * 1024)
+#define WINDOW_SIZE	(32 * 1024)
+
+struct compress_chunk
+{
+  const unsigned char *in;
+  size_t in_size;
+  /* The bytes before IN used as dictionary.  */
+  size_t dict_size;
+  bool last;
+  int level;
+
+  unsigned char *out;
+  size_t out_size;
+  uLong adler;
+  bool ok;
+};
+
+struct compress_work
+{
+  struct compress_chunk *chunks;
+  size_t nchunks;
+  size_t next;
+  void (*compress) (struct compress_chunk *chunk);
+};
+
+static void
+deflate_chunk (struct compress_chunk *chunk)
+{
+  chunk->adler = adler32 (adler32 (0, Z_NULL, 0), chunk->in, chunk->in_size);
+
+  z_stream z;
+  z.zalloc = Z_NULL;
+  z.zfree = Z_NULL;
+  z.opaque = Z_NULL;
+  if (deflateInit2 (&z, chunk->level, Z_DEFLATED, -MAX_WBITS, 8,
+		    Z_DEFAULT_STRATEGY) != Z_OK)
+    return;
+
+  /* Leave room for the empty stored block of the sync flush.  */
+  size_t bound = deflateBound (&z, chunk->in_size) + 8;
+  chunk->out = malloc (bound);
+  if (chunk->out != NULL
+      && (chunk->dict_size == 0
+	  || deflateSetDictionary (&z, chunk->in - chunk->dict_size,
+				   chunk->dict_size) == Z_OK))
+    {
+      z.next_in = (Bytef *) chunk->in;
+      z.avail_in = chunk->in_size;
+      z.next_out = chunk->out;
+      z.avail_out = bound;
+      int zrc = deflate (&z, chunk->last ? Z_FINISH : Z_SYNC_FLUSH);
+      chunk->out_size = bound - z.avail_out;
+      chunk->ok = (chunk->last
+		   ? zrc == Z_STREAM_END
+		   : zrc == Z_OK && z.avail_in == 0 && z.avail_out != 0);
+    }
+  deflateEnd (&z);
+}
+
+static void *
+compress_worker (void *arg)
+{
+  struct compress_work *work = arg;
+  size_t i;
+  while ((i = __atomic_fetch_add (&work->next, 1, __ATOMIC_RELAXED))
+	 < work->nchunks)
+    work->compress (&work->chunks[i]);
+  return NULL;
+}
+
+/* Run COMPRESS_FN on all NCHUNKS CHUNKS, using up to THREADS threads.
+   Returns false if it failed for any chunk.  */
+static bool
+compress_chunks (struct compress_chunk *chunks, size_t nchunks,
+		 void (*compress_fn) (struct compress_chunk *chunk),
+		 unsigned int threads)
+{
+  /* This thread works too.  If a thread cannot be created the others
+     just get more to do.  */
+  struct compress_work work = { .chunks = chunks, .nchunks = nchunks,
+				.compress = compress_fn };
+  pthread_t *workers = NULL;
+  if (threads > 1 && nchunks > 1)
+    workers = malloc ((threads - 1) * sizeof *workers);
+  unsigned int started = 0;
+  while (workers != NULL && started < threads - 1 && started < nchunks - 1
+	 && pthread_create (&workers[started], NULL, compress_worker,
+			    &work) == 0)
+    started++;
+  compress_worker (&work);
+  for (unsigned int i = 0; i < started; i++)
+    pthread_join (workers[i], NULL);
+  free (workers);
+
+  for (size_t i = 0; i < nchunks; i++)
+    if (! chunks[i].ok)
+      {
+	__libelf_seterrno (chunks[i].out == NULL
+			   ? ELF_E_NOMEM : ELF_E_COMPRESS_ERROR);
+	return false;
+      }
+  return true;
+}
+
+/* Compress the SIZE bytes at IN into one zlib stream after HSIZE
+   bytes of header, using up to THREADS threads.  */
+static void *
+deflate_parallel (const unsigned char *in, size_t size, size_t hsize,
+		  int level, unsigned int threads, size_t *new_size)
+{
+  size_t nchunks = size / CHUNK_SIZE + (size % CHUNK_SIZE != 0 || size == 0);
+  struct compress_chunk *chunks = calloc (nchunks, sizeof *chunks);
+  void *out_buf = NULL;
+  if (chunks == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  for (size_t i = 0; i < nchunks; i++)
+    {
+      chunks[i].in = in + i * CHUNK_SIZE;
+      chunks[i].in_size = MIN (CHUNK_SIZE, size - i * CHUNK_SIZE);
+      chunks[i].dict_size = MIN (i * CHUNK_SIZE, WINDOW_SIZE);
+      chunks[i].last = i == nchunks - 1;
+      chunks[i].level = level;
+    }
+
+  if (! compress_chunks (chunks, nchunks, deflate_chunk, threads))
+    goto out;
+
+  /* The zlib header, the chunks and the Adler-32 of all the data.  */
+  size_t total = hsize + 2 + 4;
+  for (size_t i = 0; i < nchunks; i++)
+    total += chunks[i].out_size;
+
+  out_buf = malloc (total);
+  if (out_buf == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      goto out;
+    }
+
+  unsigned char *p = (unsigned char *) out_buf + hsize;
+  unsigned int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+  unsigned int header = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8
+			| flevel << 6;
+  header += 31 - header % 31;
+  *p++ = header >> 8;
+  *p++ = header & 0xff;
+
+  uLong adler = chunks[0].adler;
+  for (size_t i = 0; i < nchunks; i++)
+    {
+      memcpy (p, chunks[i].out, chunks[i].out_size);
+      p += chunks[i].out_size;
+      if (i > 0)
+	adler = adler32_combine (adler, chunks[i].adler, chunks[i].in_size);
+    }
+  *p++ = adler >> 24;
+  *p++ = adler >> 16;
+  *p++ = adler >> 8;
+  *p++ = adler;
+  *new_size = total;
+
+ out:
+  for (size_t i = 0; i < nchunks; i++)
+    free (chunks[i].out);
+  free (chunks);
+  return out_buf;
+}
+
+#if USE_ZSTD
+/* Compress the SIZE bytes at IN into a zstd frame after HSIZE bytes of
+   header.  */
+static void *
+do_zstd_compress (const void *in, size_t size, size_t hsize, int level,
+		  unsigned int threads, size_t *new_size)
+{
+  size_t bound = ZSTD_compressBound (size);
+  void *out_buf = malloc (hsize + bound);
+  ZSTD_CCtx *cctx = ZSTD_createCCtx ();
+  if (out_buf == NULL || cctx == NULL)
+    {
+      free (out_buf);
+      ZSTD_freeCCtx (cctx);
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  /* Setting the workers fails when libzstd is built without threads,
+     then it just compresses on this thread.  */
+  ZSTD_CCtx_setParameter (cctx, ZSTD_c_compressionLevel, level);
+  if (threads > 1)
+    ZSTD_CCtx_setParameter (cctx, ZSTD_c_nbWorkers, threads);
+  size_t n = ZSTD_compress2 (cctx, (char *) out_buf + hsize, bound, in, size);
+  ZSTD_freeCCtx (cctx);
+  if (ZSTD_isError (n))
+    {
+      free (out_buf);
+      __libelf_seterrno (ELF_E_COMPRESS_ERROR);
+      return NULL;
+    }
+
+  *new_size = hsize + n;
+  return out_buf;
+}
+
+/* With ELF_CHF_CHUNKED zstd data is compressed in independent frames
+   of at most ZSTD_FRAME_SIZE bytes, so elf_zdata_pread can decompress
+   just the frames it needs.  */
+#define ZSTD_FRAME_SIZE	(1024 * 1024)
+
+static void
+zstd_chunk (struct compress_chunk *chunk)
+{
+  size_t bound = ZSTD_compressBound (chunk->in_size);
+  chunk->out = malloc (bound);
+  if (chunk->out == NULL)
+    return;
+  size_t n = ZSTD_compress (chunk->out, bound, chunk->in, chunk->in_size,
+			    chunk->level);
+  chunk->out_size = n;
+  chunk->ok = ! ZSTD_isError (n);
+}
+
+static void *
+do_zstd_compress_frames (const unsigned char *in, size_t size, size_t hsize,
+			 int level, unsigned int threads, size_t *new_size)
+{
+  size_t nchunks = (size / ZSTD_FRAME_SIZE
+		    + (size % ZSTD_FRAME_SIZE != 0 || size == 0));
+  struct compress_chunk *chunks = calloc (nchunks, sizeof *chunks);
+  if (chunks == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  for (size_t i = 0; i < nchunks; i++)
+    {
+      chunks[i].in = in + i * ZSTD_FRAME_SIZE;
+      chunks[i].in_size = MIN (ZSTD_FRAME_SIZE, size - i * ZSTD_FRAME_SIZE);
+      chunks[i].level = level;
+    }
+
+  void *out_buf = NULL;
+  if (compress_chunks (chunks, nchunks, zstd_chunk, threads))
+    {
+      size_t total = hsize;
+      for (size_t i = 0; i < nchunks; i++)
+	total += chunks[i].out_size;
+      out_buf = malloc (total);
+      if (out_buf == NULL)
+	__libelf_seterrno (ELF_E_NOMEM);
+      else
+	{
+	  char *p = (char *) out_buf + hsize;
+	  for (size_t i = 0; i < nchunks; i++)
+	    p = mempcpy (p, chunks[i].out, chunks[i].out_size);
+	  *new_size = total;
+	}
+    }
+
+  for (size_t i = 0; i < nchunks; i++)
+    free (chunks[i].out);
+  free (chunks);
+  return out_buf;
+}
+#endif
+
+/* Like deflate_stream, but compresses with TYPE, at the level and on
+   the number of threads given in FLAGS.  */
+void *
+internal_function
+__libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
+		   size_t *orig_size, size_t *orig_addralign,
+		   size_t *new_size, int type, unsigned int flags)
+{
+  bool force = (flags & ELF_CHF_FORCE) != 0;
+  int level = (flags & ELF_CHF_LEVEL_MASK) / ELF_CHF_LEVEL (1);
+  unsigned int threads = (flags & ELF_CHF_THREADS_MASK) / ELF_CHF_THREADS (1);
+
+  if (type == ELFCOMPRESS_ZLIB)
+    {
+      level = level == 0 ? Z_BEST_COMPRESSION : MIN (level, 9);
+      if (threads <= 1)
+	return deflate_stream (scn, hsize, ei_data, orig_size,
+			       orig_addralign, new_size, force, level);
+    }
+
+  bool malloced;
+  void *in = get_raw_data (scn, ei_data, orig_size, orig_addralign,
+			   &malloced);
+  if (in == NULL)
+    return NULL;
+
+  void *out_buf;
+  if (!force && *orig_size <= hsize + 5 + 6)
+    out_buf = (void *) -1;
+#if USE_ZSTD
+  else if (type == ELFCOMPRESS_ZSTD && (flags & ELF_CHF_CHUNKED) != 0)
+    out_buf = do_zstd_compress_frames (in, *orig_size, hsize, level, threads,
+				       new_size);
+  else if (type == ELFCOMPRESS_ZSTD)
+    out_buf = do_zstd_compress (in, *orig_size, hsize, level, threads,
+				new_size);
+#endif
+  else
+    out_buf = deflate_parallel (in, *orig_size, hsize, level, threads,
+				new_size);
+
+  if (malloced)
+    free (in);
+
+  /* Don't bother if the compressed data is bigger.  */
+  if (!force && out_buf != NULL && out_buf != (void *) -1
+      && *new_size >= *orig_size)
+    {
+      free (out_buf);
+      out_buf = (void *) -1;
+    }
+
+  return out_buf;
+}
+
+#if USE_ZSTD
+static void *
+do_zstd_decompress (void *buf_in, size_t size_in, size_t size_out)
+{
+  /* Every zstd block of at most 128 KiB output takes at least 4 bytes,
+     refuse bigger claimed sizes before allocating them.  */
+  if (unlikely (size_out / (128 * 1024 / 4) > size_in))
+    {
+      __libelf_seterrno (ELF_E_INVALID_DATA);
+      return NULL;
+    }
+
+  void *buf_out = malloc (size_out ?: 1);
+  if (unlikely (buf_out == NULL))
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  /* Decompressed straight into the result.  */
+  size_t n = ZSTD_decompress (buf_out, size_out, buf_in, size_in);
+  if (unlikely (ZSTD_isError (n)) || unlikely (n != size_out))
+    {
+      free (buf_out);
+      __libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+      return NULL;
+    }
+
+  return buf_out;
+}
+#endif
+
 void *
 internal_function
-__libelf_decompress (void *buf_in, size_t size_in, size_t size_out)
+__libelf_decompress (int type, void *buf_in, size_t size_in, size_t size_out)
 {
+#if USE_ZSTD
+  if (type == ELFCOMPRESS_ZSTD)
+    return do_zstd_decompress (buf_in, size_in, size_out);
+#else
+  (void) type;
+#endif
+
   /* Catch highly unlikely compression ratios so we don't allocate
      some giant amount of memory for nothing. The max compression
      factor 1032:1 comes from http://www.zlib.net/zlib_tech.html  */
@@ -267,7 +696,11 @@ __libelf_decompress_elf (Elf_Scn *scn, size_t *size_out, size_t *addralign)
   if (gelf_getchdr (scn, &chdr) == NULL)
     return NULL;
 
-  if (chdr.ch_type != ELFCOMPRESS_ZLIB)
+  if (chdr.ch_type != ELFCOMPRESS_ZLIB
+#if USE_ZSTD
+      && chdr.ch_type != ELFCOMPRESS_ZSTD
+#endif
+      )
     {
       __libelf_seterrno (ELF_E_UNKNOWN_COMPRESSION_TYPE);
       return NULL;
@@ -294,7 +727,8 @@ __libelf_decompress_elf (Elf_Scn *scn, size_t *size_out, size_t *addralign)
 		  ? sizeof (Elf32_Chdr) : sizeof (Elf64_Chdr));
   size_t size_in = data->d_size - hsize;
   void *buf_in = data->d_buf + hsize;
-  void *buf_out = __libelf_decompress (buf_in, size_in, chdr.ch_size);
+  void *buf_out = __libelf_decompress (chdr.ch_type, buf_in, size_in,
+				       chdr.ch_size);
   *size_out = chdr.ch_size;
   *addralign = chdr.ch_addralign;
   return buf_out;
@@ -307,6 +741,9 @@ __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size, size_t align,
 			Elf_Type type)
 {
   /* This is the new raw data, replace and possibly free old data.  */
+  __libelf_zcache_free (scn->zcache);
+  scn->zcache = NULL;
+
   scn->rawdata.d.d_off = 0;
   scn->rawdata.d.d_version = __libelf_version;
   scn->rawdata.d.d_buf = buf;
@@ -315,6 +752,15 @@ __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size, size_t align,
   scn->rawdata.d.d_type = type;
 
   /* Existing existing data is no longer valid.  */
+  Elf_Data_List *runp = scn->data_list.next;
+  while (runp != NULL)
+    {
+      Elf_Data_List *oldp = runp;
+      runp = runp->next;
+      if ((oldp->flags & ELF_F_MALLOCED) != 0)
+	free (oldp);
+    }
+  scn->data_list.next = NULL;
   scn->data_list_rear = NULL;
   if (scn->data_base != scn->rawdata_base)
     free (scn->data_base);
@@ -340,14 +786,13 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
   if (scn == NULL)
     return -1;
 
-  if ((flags & ~ELF_CHF_FORCE) != 0)
+  if ((flags & ~(ELF_CHF_FORCE | ELF_CHF_CHUNKED | ELF_CHF_LEVEL_MASK
+		 | ELF_CHF_THREADS_MASK)) != 0)
     {
       __libelf_seterrno (ELF_E_INVALID_OPERAND);
       return -1;
     }
 
-  bool force = (flags & ELF_CHF_FORCE) != 0;
-
   Elf *elf = scn->elf;
   GElf_Ehdr ehdr;
   if (gelf_getehdr (elf, &ehdr) == NULL)
@@ -393,7 +838,11 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
     }
 
   int compressed = (sh_flags & SHF_COMPRESSED);
-  if (type == ELFCOMPRESS_ZLIB)
+  if (type == ELFCOMPRESS_ZLIB
+#if USE_ZSTD
+      || type == ELFCOMPRESS_ZSTD
+#endif
+      )
     {
       /* Compress/Deflate.  */
       if (compressed == 1)
@@ -407,7 +856,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       size_t orig_size, orig_addralign, new_size;
       void *out_buf = __libelf_compress (scn, hsize, elfdata,
 					 &orig_size, &orig_addralign,
-					 &new_size, force);
+					 &new_size, type, flags);
 
       /* Compression would make section larger, don't change anything.  */
       if (out_buf == (void *) -1)
@@ -421,7 +870,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       if (elfclass == ELFCLASS32)
 	{
 	  Elf32_Chdr chdr;
-	  chdr.ch_type = ELFCOMPRESS_ZLIB;
+	  chdr.ch_type = type;
 	  chdr.ch_size = orig_size;
 	  chdr.ch_addralign = orig_addralign;
 	  if (elfdata != MY_ELFDATA)
@@ -435,7 +884,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       else
 	{
 	  Elf64_Chdr chdr;
-	  chdr.ch_type = ELFCOMPRESS_ZLIB;
+	  chdr.ch_type = type;
 	  chdr.ch_reserved = 0;
 	  chdr.ch_size = orig_size;
 	  chdr.ch_addralign = sh_addralign;
@@ -40,14 +40,13 @@ elf_compress_gnu (Elf_Scn *scn, int inflate, unsigned int flags)
   if (scn == NULL)
     return -1;
 
-  if ((flags & ~ELF_CHF_FORCE) != 0)
+  if ((flags & ~(ELF_CHF_FORCE | ELF_CHF_CHUNKED | ELF_CHF_LEVEL_MASK
+		 | ELF_CHF_THREADS_MASK)) != 0)
     {
       __libelf_seterrno (ELF_E_INVALID_OPERAND);
       return -1;
     }
 
-  bool force = (flags & ELF_CHF_FORCE) != 0;
-
   Elf *elf = scn->elf;
   GElf_Ehdr ehdr;
   if (gelf_getehdr (elf, &ehdr) == NULL)
@@ -103,7 +102,7 @@ elf_compress_gnu (Elf_Scn *scn, int inflate, unsigned int flags)
       size_t orig_size, new_size, orig_addralign;
       void *out_buf = __libelf_compress (scn, hsize, elfdata,
 					 &orig_size, &orig_addralign,
-					 &new_size, force);
+					 &new_size, ELFCOMPRESS_ZLIB, flags);
 
       /* Compression would make section larger, don't change anything.  */
       if (out_buf == (void *) -1)
@@ -177,7 +176,8 @@ elf_compress_gnu (Elf_Scn *scn, int inflate, unsigned int flags)
       size_t size = gsize;
       size_t size_in = data->d_size - hsize;
       void *buf_in = data->d_buf + hsize;
-      void *buf_out = __libelf_decompress (buf_in, size_in, size);
+      void *buf_out = __libelf_decompress (ELFCOMPRESS_ZLIB, buf_in, size_in,
+					   size);
       if (buf_out == NULL)
 	return -1;
 
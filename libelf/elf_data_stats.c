@@ -0,0 +1,52 @@
+/* Return how much section data was used in place or copied.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libelf.h>
+
+#include "libelfP.h"
+
+
+int
+elf_data_stats (Elf *elf, size_t *mapped, size_t *copied)
+{
+  if (elf == NULL)
+    return -1;
+
+  rwlock_rdlock (elf->lock);
+  if (mapped != NULL)
+    *mapped = elf->data_mapped;
+  if (copied != NULL)
+    *copied = elf->data_copied;
+  rwlock_unlock (elf->lock);
+
+  return 0;
+}
@@ -156,6 +156,8 @@ elf_end (Elf *elf)
 		if (scn->zdata_base != scn->rawdata_base)
 		  free (scn->zdata_base);
 
+		__libelf_zcache_free (scn->zcache);
+
 		/* If the file has the same byte order and the
 		   architecture doesn't require overly stringent
 		   alignment the raw data buffer is the same as the
@@ -227,6 +229,9 @@ elf_end (Elf *elf)
 	munmap (elf->map_address, elf->maximum_size);
     }
 
+  /* Drop the reference to the reader given to elf_begin_read.  */
+  __libelf_reader_release (elf->reader);
+
   rwlock_unlock (elf->lock);
   rwlock_fini (elf->lock);
 
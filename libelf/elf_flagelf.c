@@ -53,10 +53,14 @@ elf_flagelf (Elf *elf, Elf_Cmd cmd, unsigned int flags)
 
   if (likely (cmd == ELF_C_SET))
     result = (elf->flags
-	      |= (flags & (ELF_F_DIRTY | ELF_F_LAYOUT | ELF_F_PERMISSIVE)));
+	      |= (flags & (ELF_F_DIRTY | ELF_F_LAYOUT | ELF_F_PERMISSIVE
+			   | ELF_F_FALLOCATE | ELF_F_THREADS
+			   | ELF_F_UNALIGNED)));
   else if (likely (cmd == ELF_C_CLR))
     result = (elf->flags
-	      &= ~(flags & (ELF_F_DIRTY | ELF_F_LAYOUT | ELF_F_PERMISSIVE)));
+	      &= ~(flags & (ELF_F_DIRTY | ELF_F_LAYOUT | ELF_F_PERMISSIVE
+			    | ELF_F_FALLOCATE | ELF_F_THREADS
+			    | ELF_F_UNALIGNED)));
   else
     {
       __libelf_seterrno (ELF_E_INVALID_COMMAND);
@@ -149,9 +149,15 @@ convert_data (Elf_Scn *scn, int version __attribute__ ((unused)), int eclass,
   /* Do we need to convert the data and/or adjust for alignment?  */
   if (data == MY_ELFDATA || type == ELF_T_BYTE)
     {
-      if (((((size_t) (char *) scn->rawdata_base)) & (align - 1)) == 0)
-	/* No need to copy, we can use the raw data.  */
-	scn->data_base = scn->rawdata_base;
+      /* The raw data, which usually is the mapped file, is used
+	 whatever its alignment only if the caller asked for that.  */
+      if ((ALLOW_UNALIGNED && (scn->elf->flags & ELF_F_UNALIGNED) != 0)
+	  || ((((size_t) (char *) scn->rawdata_base)) & (align - 1)) == 0)
+	{
+	  /* No need to copy, we can use the raw data.  */
+	  scn->data_base = scn->rawdata_base;
+	  scn->elf->data_mapped += size;
+	}
       else
 	{
 	  scn->data_base = (char *) malloc (size);
@@ -163,6 +169,7 @@ convert_data (Elf_Scn *scn, int version __attribute__ ((unused)), int eclass,
 
 	  /* The copy will be appropriately aligned for direct access.  */
 	  memcpy (scn->data_base, scn->rawdata_base, size);
+	  scn->elf->data_copied += size;
 	}
     }
   else
@@ -179,7 +186,8 @@ convert_data (Elf_Scn *scn, int version __attribute__ ((unused)), int eclass,
       /* Make sure the source is correctly aligned for the conversion
 	 function to directly access the data elements.  */
       char *rawdata_source;
-      if (((((size_t) (char *) scn->rawdata_base)) & (align - 1)) == 0)
+      if (ALLOW_UNALIGNED
+	  || ((((size_t) (char *) scn->rawdata_base)) & (align - 1)) == 0)
 	rawdata_source = scn->rawdata_base;
       else
 	{
@@ -205,6 +213,7 @@ convert_data (Elf_Scn *scn, int version __attribute__ ((unused)), int eclass,
 
       if (rawdata_source != scn->rawdata_base)
 	free (rawdata_source);
+      scn->elf->data_copied += size;
     }
 
   scn->data_list.data.d.d_buf = scn->data_base;
@@ -317,7 +326,7 @@ __libelf_set_rawdata_wrlock (Elf_Scn *scn)
 	  scn->rawdata_base = scn->rawdata.d.d_buf
 	    = (char *) elf->map_address + elf->start_offset + offset;
 	}
-      else if (likely (elf->fildes != -1))
+      else if (likely (__libelf_can_read (elf)))
 	{
 	  /* First see whether the information in the section header is
 	     valid and it does not ask for too much.  Check for unsigned
@@ -340,8 +349,8 @@ __libelf_set_rawdata_wrlock (Elf_Scn *scn)
 	      return 1;
 	    }
 
-	  ssize_t n = pread_retry (elf->fildes, scn->rawdata.d.d_buf, size,
-				   elf->start_offset + offset);
+	  ssize_t n = __libelf_pread (elf, scn->rawdata.d.d_buf, size,
+				      elf->start_offset + offset);
 	  if (unlikely ((size_t) n != size))
 	    {
 	      /* Cannot read the data.  */
@@ -71,6 +71,7 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
   /* Get the raw bytes from the file.  */
   void *rawchunk;
   int flags = 0;
+  bool copied = false;
   Elf_Data *result = NULL;
 
   rwlock_rdlock (elf->lock);
@@ -78,9 +79,11 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
   size_t align = __libelf_type_align (elf->class, type);
   if (elf->map_address != NULL)
     {
-    /* If the file is mmap'ed we can use it directly, if aligned for type.  */
+    /* If the file is mmap'ed we can use it directly, if aligned for type
+       or unaligned accesses are fine.  Unaligned data of the host byte
+       order is still copied below, unless ELF_F_UNALIGNED is set.  */
       char *rawdata = elf->map_address + elf->start_offset + offset;
-      if (((uintptr_t) rawdata & (align - 1)) == 0)
+      if (ALLOW_UNALIGNED || ((uintptr_t) rawdata & (align - 1)) == 0)
 	rawchunk = rawdata;
       else
 	{
@@ -90,6 +93,7 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
 	    goto nomem;
 	  memcpy (rawchunk, rawdata, size);
 	  flags = ELF_F_MALLOCED;
+	  copied = true;
 	}
     }
   else
@@ -104,8 +108,8 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
 	}
 
       /* Read the file content.  */
-      if (unlikely ((size_t) pread_retry (elf->fildes, rawchunk, size,
-					  elf->start_offset + offset)
+      if (unlikely ((size_t) __libelf_pread (elf, rawchunk, size,
+					     elf->start_offset + offset)
 		    != size))
 	{
 	  /* Something went wrong.  */
@@ -121,7 +125,8 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
   void *buffer;
   if (elf->state.elf32.ehdr->e_ident[EI_DATA] == MY_ELFDATA)
     {
-      if (((uintptr_t) rawchunk & (align - 1)) == 0)
+      if ((ALLOW_UNALIGNED && (elf->flags & ELF_F_UNALIGNED) != 0)
+	  || ((uintptr_t) rawchunk & (align - 1)) == 0)
 	/* No need to copy, we can use the raw data.  */
 	buffer = rawchunk;
       else
@@ -136,6 +141,7 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
 
 	  /* The copy will be appropriately aligned for direct access.  */
 	  memcpy (buffer, rawchunk, size);
+	  copied = true;
 	}
     }
   else
@@ -153,6 +159,7 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
       /* Call the conversion function.  */
       (*__elf_xfctstom[LIBELF_EV_IDX][LIBELF_EV_IDX][elf->class - 1][type])
 	(buffer, rawchunk, size, 0);
+      copied = true;
     }
 
   /* Allocate the dummy container to point at this buffer.  */
@@ -176,6 +183,11 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
   rwlock_unlock (elf->lock);
   rwlock_wrlock (elf->lock);
 
+  if (copied)
+    elf->data_copied += size;
+  else
+    elf->data_mapped += size;
+
   chunk->next = elf->state.elf.rawchunks;
   elf->state.elf.rawchunks = chunk;
   result = &chunk->data.d;
@@ -72,7 +72,7 @@ __libelf_readall (Elf *elf)
   /* Get the file.  */
   rwlock_wrlock (elf->lock);
 
-  if (elf->map_address == NULL && unlikely (elf->fildes == -1))
+  if (elf->map_address == NULL && unlikely (! __libelf_can_read (elf)))
     {
       __libelf_seterrno (ELF_E_INVALID_HANDLE);
       rwlock_unlock (elf->lock);
@@ -111,9 +111,9 @@ __libelf_readall (Elf *elf)
       if (mem != NULL)
 	{
 	  /* Read the file content.  */
-	  if (unlikely ((size_t) pread_retry (elf->fildes, mem,
-					      elf->maximum_size,
-					      elf->start_offset)
+	  if (unlikely ((size_t) __libelf_pread (elf, mem,
+						 elf->maximum_size,
+						 elf->start_offset)
 			!= elf->maximum_size))
 	    {
 	      /* Something went wrong.  */
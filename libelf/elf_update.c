@@ -32,6 +32,7 @@
 #endif
 
 #include <libelf.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -40,6 +41,9 @@
 #include "libelfP.h"
 
 
+unsigned int __libelf_update_threads;
+
+
 static off_t
 write_file (Elf *elf, off_t size, int change_bo, size_t shnum)
 {
@@ -126,6 +130,18 @@ write_file (Elf *elf, off_t size, int change_bo, size_t shnum)
     }
   else
     {
+      /* If asked to, allocate the space of the whole file first.  As
+	 above only running out of space is an error, a file system that
+	 cannot do it just means the writes allocate the space.  */
+      if ((elf->flags & ELF_F_FALLOCATE) != 0
+	  && elf->parent == NULL
+	  && unlikely (fallocate (elf->fildes, 0, 0, size) != 0)
+	  && errno == ENOSPC)
+	{
+	  __libelf_seterrno (ELF_E_WRITE_ERROR);
+	  return -1;
+	}
+
       /* The file is not mmaped.  */
       if ((class == ELFCLASS32
 	   ? __elf32_updatefile (elf, change_bo, shnum)
@@ -0,0 +1,484 @@
+/* Read part of the uncompressed data of a compressed section.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libelf.h>
+#include "libelfP.h"
+#include "common.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <zlib.h>
+#if USE_ZSTD
+# include <zstd.h>
+#endif
+
+/* Data that can only be decompressed from the start is decompressed
+   in chunks of ZCACHE_CHUNK_SIZE bytes.  Sections compressed with zstd
+   in several frames (see ELF_CHF_CHUNKED) are decompressed one frame
+   at a time, unless a frame is bigger than ZCACHE_FRAME_MAX.  At most
+   ZCACHE_CHUNKS chunks (or frames) of a section, of together at most
+   ZCACHE_BYTES bytes, are kept.  */
+#define ZCACHE_CHUNK_SIZE	(1024 * 1024)
+#define ZCACHE_CHUNKS		8
+#define ZCACHE_BYTES		(8 * ZCACHE_CHUNK_SIZE)
+#define ZCACHE_FRAME_MAX	(ZCACHE_BYTES / 2)
+
+/* One zstd frame of the section data.  */
+struct zframe
+{
+  size_t in_off;
+  size_t in_size;
+  uint64_t out_off;
+  size_t out_size;
+};
+
+struct zchunk
+{
+  uint64_t out_off;
+  size_t size;
+  size_t alloc;
+  char *buf;
+  /* When last used, zero if BUF holds nothing.  */
+  unsigned int used;
+};
+
+struct Elf_ZCache
+{
+  int type;
+
+  /* The compressed data, after the Chdr.  */
+  const unsigned char *in;
+  size_t in_size;
+  /* The size of the uncompressed data.  */
+  uint64_t size;
+
+  /* The zstd frames, if there is more than one.  */
+  struct zframe *frames;
+  size_t nframes;
+
+  /* Otherwise the data is decompressed as one stream, which is at
+     STREAM_OUT of the uncompressed data.  */
+  uint64_t stream_out;
+  bool z_init;
+  z_stream z;
+#if USE_ZSTD
+  ZSTD_DCtx *dctx;
+  size_t zin_pos;
+#endif
+
+  struct zchunk chunks[ZCACHE_CHUNKS];
+  /* The sum of the alloc of all chunks.  */
+  size_t cached;
+  unsigned int clock;
+};
+
+void
+internal_function
+__libelf_zcache_free (struct Elf_ZCache *zc)
+{
+  if (zc == NULL)
+    return;
+
+  for (size_t i = 0; i < ZCACHE_CHUNKS; i++)
+    free (zc->chunks[i].buf);
+  free (zc->frames);
+  if (zc->z_init)
+    inflateEnd (&zc->z);
+#if USE_ZSTD
+  ZSTD_freeDCtx (zc->dctx);
+#endif
+  free (zc);
+}
+
+#if USE_ZSTD
+/* Index the frames of the zstd data, if there is more than one and
+   they all know their size, which is at most ZCACHE_FRAME_MAX.  */
+static bool
+index_zstd_frames (struct Elf_ZCache *zc)
+{
+  size_t nframes = 0;
+  size_t alloc = 0;
+  size_t in_off = 0;
+  uint64_t out_off = 0;
+  while (in_off < zc->in_size)
+    {
+      const unsigned char *p = zc->in + in_off;
+      size_t left = zc->in_size - in_off;
+      size_t in_size = ZSTD_findFrameCompressedSize (p, left);
+      unsigned long long out_size = ZSTD_getFrameContentSize (p, left);
+      if (ZSTD_isError (in_size)
+	  || out_size == ZSTD_CONTENTSIZE_UNKNOWN
+	  || out_size == ZSTD_CONTENTSIZE_ERROR
+	  || out_size > zc->size - out_off
+	  || out_size > ZCACHE_FRAME_MAX)
+	goto no_index;
+
+      /* Skippable frames have no content.  */
+      if (out_size > 0)
+	{
+	  if (nframes == alloc)
+	    {
+	      alloc = alloc == 0 ? 16 : alloc * 2;
+	      struct zframe *frames = realloc (zc->frames,
+					       alloc * sizeof *frames);
+	      if (frames == NULL)
+		goto no_index;
+	      zc->frames = frames;
+	    }
+	  zc->frames[nframes++] = (struct zframe)
+	    {
+	      .in_off = in_off, .in_size = in_size,
+	      .out_off = out_off, .out_size = out_size
+	    };
+	}
+      in_off += in_size;
+      out_off += out_size;
+    }
+
+  if (nframes > 1 && out_off == zc->size)
+    {
+      zc->nframes = nframes;
+      return true;
+    }
+
+ no_index:
+  free (zc->frames);
+  zc->frames = NULL;
+  return false;
+}
+#endif
+
+static struct Elf_ZCache *
+zcache_new (Elf_Scn *scn)
+{
+  GElf_Chdr chdr;
+  if (gelf_getchdr (scn, &chdr) == NULL)
+    return NULL;
+
+  if (chdr.ch_type != ELFCOMPRESS_ZLIB
+#if USE_ZSTD
+      && chdr.ch_type != ELFCOMPRESS_ZSTD
+#endif
+      )
+    {
+      __libelf_seterrno (ELF_E_UNKNOWN_COMPRESSION_TYPE);
+      return NULL;
+    }
+
+  Elf_Data *data = elf_rawdata (scn, NULL);
+  if (data == NULL)
+    return NULL;
+
+  size_t hsize = (scn->elf->class == ELFCLASS32
+		  ? sizeof (Elf32_Chdr) : sizeof (Elf64_Chdr));
+  struct Elf_ZCache *zc = calloc (1, sizeof *zc);
+  if (zc == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+  zc->type = chdr.ch_type;
+  zc->in = (const unsigned char *) data->d_buf + hsize;
+  zc->in_size = data->d_size - hsize;
+  zc->size = chdr.ch_size;
+
+#if USE_ZSTD
+  if (zc->type == ELFCOMPRESS_ZSTD && ! index_zstd_frames (zc))
+    {
+      zc->dctx = ZSTD_createDCtx ();
+      if (zc->dctx == NULL)
+	{
+	  free (zc);
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  return NULL;
+	}
+    }
+#endif
+
+  return zc;
+}
+
+/* Continue the stream into the LEN bytes at BUF.  */
+static bool
+stream_read (struct Elf_ZCache *zc, char *buf, size_t len)
+{
+#if USE_ZSTD
+  if (zc->type == ELFCOMPRESS_ZSTD)
+    {
+      ZSTD_inBuffer in = { zc->in, zc->in_size, zc->zin_pos };
+      ZSTD_outBuffer out = { buf, len, 0 };
+      while (out.pos < len)
+	{
+	  size_t in_pos = in.pos;
+	  size_t out_pos = out.pos;
+	  size_t n = ZSTD_decompressStream (zc->dctx, &out, &in);
+	  if (ZSTD_isError (n) || (in.pos == in_pos && out.pos == out_pos))
+	    return false;
+	}
+      zc->zin_pos = in.pos;
+      zc->stream_out += len;
+      return true;
+    }
+#endif
+
+  if (! zc->z_init)
+    {
+      memset (&zc->z, 0, sizeof zc->z);
+      if (inflateInit (&zc->z) != Z_OK)
+	return false;
+      zc->z.next_in = (Bytef *) zc->in;
+      zc->z_init = true;
+    }
+
+  zc->z.next_out = (Bytef *) buf;
+  zc->z.avail_out = len;
+  while (zc->z.avail_out > 0)
+    {
+      /* avail_in is only 32 bits.  */
+      if (zc->z.avail_in == 0)
+	zc->z.avail_in = MIN (zc->in_size - (zc->z.next_in - zc->in),
+			      (size_t) UINT_MAX);
+      int zrc = inflate (&zc->z, Z_NO_FLUSH);
+      if (zrc != Z_OK && (zrc != Z_STREAM_END || zc->z.avail_out > 0))
+	return false;
+    }
+  zc->stream_out += len;
+  return true;
+}
+
+static bool
+frame_read (struct Elf_ZCache *zc, const struct zframe *frame, char *buf)
+{
+#if USE_ZSTD
+  return (ZSTD_decompress (buf, frame->out_size, zc->in + frame->in_off,
+			   frame->in_size) == frame->out_size);
+#else
+  (void) zc;
+  (void) frame;
+  (void) buf;
+  return false;
+#endif
+}
+
+/* Start the stream from the beginning.  */
+static bool
+stream_reset (struct Elf_ZCache *zc)
+{
+  zc->stream_out = 0;
+#if USE_ZSTD
+  if (zc->type == ELFCOMPRESS_ZSTD)
+    {
+      zc->zin_pos = 0;
+      return ! ZSTD_isError (ZSTD_DCtx_reset (zc->dctx,
+					      ZSTD_reset_session_only));
+    }
+#endif
+  if (zc->z_init)
+    {
+      inflateEnd (&zc->z);
+      zc->z_init = false;
+    }
+  return true;
+}
+
+/* Return the chunk with OFFSET, which is smaller than ZC->size.  */
+static struct zchunk *
+get_chunk (struct Elf_ZCache *zc, uint64_t offset)
+{
+  struct zchunk *victim = &zc->chunks[0];
+  for (size_t i = 0; i < ZCACHE_CHUNKS; i++)
+    {
+      struct zchunk *chunk = &zc->chunks[i];
+      if (chunk->used != 0 && offset >= chunk->out_off
+	  && offset - chunk->out_off < chunk->size)
+	{
+	  chunk->used = ++zc->clock;
+	  return chunk;
+	}
+      if (chunk->used < victim->used)
+	victim = chunk;
+    }
+
+  uint64_t out_off;
+  size_t size;
+  const struct zframe *frame = NULL;
+  if (zc->frames != NULL)
+    {
+      size_t l = 0, u = zc->nframes;
+      while (u - l > 1)
+	{
+	  size_t m = (l + u) / 2;
+	  if (zc->frames[m].out_off <= offset)
+	    l = m;
+	  else
+	    u = m;
+	}
+      frame = &zc->frames[l];
+      out_off = frame->out_off;
+      size = frame->out_size;
+    }
+  else
+    {
+      out_off = offset - offset % ZCACHE_CHUNK_SIZE;
+      size = MIN (ZCACHE_CHUNK_SIZE, zc->size - out_off);
+    }
+
+  victim->used = 0;
+
+  /* Drop the least recently used other chunks until SIZE fits.  */
+  while (zc->cached - victim->alloc + MAX (victim->alloc, size)
+	 > ZCACHE_BYTES)
+    {
+      struct zchunk *lru = NULL;
+      for (size_t i = 0; i < ZCACHE_CHUNKS; i++)
+	if (&zc->chunks[i] != victim && zc->chunks[i].alloc != 0
+	    && (lru == NULL || zc->chunks[i].used < lru->used))
+	  lru = &zc->chunks[i];
+      if (lru == NULL)
+	break;
+      free (lru->buf);
+      zc->cached -= lru->alloc;
+      lru->buf = NULL;
+      lru->alloc = 0;
+      lru->used = 0;
+    }
+
+  if (victim->alloc < size)
+    {
+      char *buf = realloc (victim->buf, size);
+      if (buf == NULL)
+	{
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  return NULL;
+	}
+      victim->buf = buf;
+      zc->cached += size - victim->alloc;
+      victim->alloc = size;
+    }
+
+  bool ok;
+  if (frame != NULL)
+    ok = frame_read (zc, frame, victim->buf);
+  else
+    {
+      /* Only the chunk we want is kept, the ones before it are
+	 decompressed into the same buffer.  */
+      ok = zc->stream_out <= out_off || stream_reset (zc);
+      while (ok && zc->stream_out <= out_off)
+	ok = stream_read (zc, victim->buf,
+			  MIN (ZCACHE_CHUNK_SIZE, zc->size - zc->stream_out));
+    }
+
+  if (! ok)
+    {
+      if (frame == NULL)
+	stream_reset (zc);
+      __libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+      return NULL;
+    }
+
+  victim->out_off = out_off;
+  victim->size = size;
+  victim->used = ++zc->clock;
+  return victim;
+}
+
+ssize_t
+elf_zdata_pread (Elf_Scn *scn, void *buf, size_t size, int64_t offset)
+{
+  if (scn == NULL)
+    return -1;
+
+  if (offset < 0)
+    {
+      __libelf_seterrno (ELF_E_INVALID_OPERAND);
+      return -1;
+    }
+
+  GElf_Shdr shdr_mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+  if (shdr == NULL)
+    return -1;
+
+  if ((shdr->sh_flags & SHF_COMPRESSED) == 0)
+    {
+      Elf_Data *data = elf_rawdata (scn, NULL);
+      if (data == NULL)
+	return -1;
+      if ((uint64_t) offset >= data->d_size)
+	return 0;
+      size = MIN (size, data->d_size - offset);
+      memcpy (buf, (char *) data->d_buf + offset, size);
+      return size;
+    }
+
+  struct Elf_ZCache *zc = __atomic_load_n (&scn->zcache, __ATOMIC_ACQUIRE);
+  if (zc == NULL)
+    {
+      zc = zcache_new (scn);
+      if (zc == NULL)
+	return -1;
+    }
+
+  rwlock_wrlock (scn->elf->lock);
+
+  /* Another thread might have been first.  */
+  if (scn->zcache == NULL)
+    __atomic_store_n (&scn->zcache, zc, __ATOMIC_RELEASE);
+  else if (scn->zcache != zc)
+    {
+      __libelf_zcache_free (zc);
+      zc = scn->zcache;
+    }
+
+  ssize_t result = 0;
+  while (size > 0 && (uint64_t) offset < zc->size)
+    {
+      struct zchunk *chunk = get_chunk (zc, offset);
+      if (chunk == NULL)
+	{
+	  result = -1;
+	  break;
+	}
+      size_t skip = offset - chunk->out_off;
+      size_t n = MIN (size, chunk->size - skip);
+      memcpy ((char *) buf + result, chunk->buf + skip, n);
+      result += n;
+      offset += n;
+      size -= n;
+    }
+
+  rwlock_unlock (scn->elf->lock);
+  return result;
+}
@@ -168,6 +168,9 @@ union unaligned
 #include "note_xlate.h"
 #include "chdr_xlate.h"
 
+/* Faster functions for the types of big sections, where possible.  */
+#include "simd_xlate.h"
+
 
 /* Now the externally visible table with the function pointers.  */
 const xfct_t __elf_xfctstom[EV_NUM - 1][EV_NUM - 1][ELFCLASSNUM - 1][ELF_T_NUM] =
@@ -177,20 +180,20 @@ const xfct_t __elf_xfctstom[EV_NUM - 1][EV_NUM - 1][ELFCLASSNUM - 1][ELF_T_NUM]
       [ELFCLASS32 - 1] = {
 #define define_xfcts(Bits) \
 	[ELF_T_BYTE]	= elf_cvt_Byte,					      \
-	[ELF_T_ADDR]	= ElfW2(Bits, cvt_Addr),			      \
-	[ELF_T_DYN]	= ElfW2(Bits, cvt_Dyn),				      \
+	[ELF_T_ADDR]	= XFCT (Bits, Addr),				      \
+	[ELF_T_DYN]	= XFCT (Bits, Dyn),				      \
 	[ELF_T_EHDR]	= ElfW2(Bits, cvt_Ehdr),			      \
-	[ELF_T_HALF]	= ElfW2(Bits, cvt_Half),			      \
-	[ELF_T_OFF]	= ElfW2(Bits, cvt_Off),				      \
+	[ELF_T_HALF]	= XFCT (Bits, Half),				      \
+	[ELF_T_OFF]	= XFCT (Bits, Off),				      \
 	[ELF_T_PHDR]	= ElfW2(Bits, cvt_Phdr),			      \
-	[ELF_T_RELA]	= ElfW2(Bits, cvt_Rela),			      \
-	[ELF_T_REL]	= ElfW2(Bits, cvt_Rel),				      \
+	[ELF_T_RELA]	= XFCT (Bits, Rela),				      \
+	[ELF_T_REL]	= XFCT (Bits, Rel),				      \
 	[ELF_T_SHDR]	= ElfW2(Bits, cvt_Shdr),			      \
-	[ELF_T_SWORD]	= ElfW2(Bits, cvt_Sword),			      \
-	[ELF_T_SYM]	= ElfW2(Bits, cvt_Sym),				      \
-	[ELF_T_WORD]	= ElfW2(Bits, cvt_Word),			      \
-	[ELF_T_XWORD]	= ElfW2(Bits, cvt_Xword),			      \
-	[ELF_T_SXWORD]	= ElfW2(Bits, cvt_Sxword),			      \
+	[ELF_T_SWORD]	= XFCT (Bits, Sword),				      \
+	[ELF_T_SYM]	= XFCT (Bits, Sym),				      \
+	[ELF_T_WORD]	= XFCT (Bits, Word),				      \
+	[ELF_T_XWORD]	= XFCT (Bits, Xword),				      \
+	[ELF_T_SXWORD]	= XFCT (Bits, Sxword),				      \
 	[ELF_T_VDEF]	= elf_cvt_Verdef,				      \
 	[ELF_T_VDAUX]	= elf_cvt_Verdef,				      \
 	[ELF_T_VNEED]	= elf_cvt_Verneed,				      \
@@ -203,7 +206,7 @@ const xfct_t __elf_xfctstom[EV_NUM - 1][EV_NUM - 1][ELFCLASSNUM - 1][ELF_T_NUM]
 	[ELF_T_AUXV]	= ElfW2(Bits, cvt_auxv_t),			      \
 	[ELF_T_CHDR]	= ElfW2(Bits, cvt_chdr)
         define_xfcts (32),
-	[ELF_T_GNUHASH] = Elf32_cvt_Word
+	[ELF_T_GNUHASH] = XFCT (32, Word)
       },
       [ELFCLASS64 - 1] = {
 	define_xfcts (64),
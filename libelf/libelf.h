@@ -64,6 +64,11 @@
  #define ELFCOMPRESS_HIPROC     0x7fffffff /* End of processor-specific.  */
 #endif
 
+#ifndef ELFCOMPRESS_ZSTD
+ /* So is the zstd compression type.  */
+ #define ELFCOMPRESS_ZSTD       2          /* Zstandard algorithm.  */
+#endif
+
 #if __GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 3)
 # define __nonnull_attribute__(...) __attribute__ ((__nonnull__ (__VA_ARGS__)))
 # define __deprecated_attribute__ __attribute__ ((__deprecated__))
@@ -167,17 +172,39 @@ enum
 #define ELF_F_DIRTY		ELF_F_DIRTY
   ELF_F_LAYOUT = 0x4,
 #define ELF_F_LAYOUT		ELF_F_LAYOUT
-  ELF_F_PERMISSIVE = 0x8
+  ELF_F_PERMISSIVE = 0x8,
 #define ELF_F_PERMISSIVE	ELF_F_PERMISSIVE
+  /* elf_update allocates the disk space of the whole file before
+     writing it.  */
+  ELF_F_FALLOCATE = 0x10,
+#define ELF_F_FALLOCATE		ELF_F_FALLOCATE
+  /* elf_update converts the section data to the file byte order on a
+     thread per CPU, up to eight.  */
+  ELF_F_THREADS = 0x20,
+#define ELF_F_THREADS		ELF_F_THREADS
+  /* elf_getdata and elf_getdata_rawchunk may return data of the host
+     byte order in place even when it isn't aligned for its type, on
+     architectures that allow unaligned accesses.  */
+  ELF_F_UNALIGNED = 0x200
+#define ELF_F_UNALIGNED		ELF_F_UNALIGNED
 };
 
 /* Flags for elf_compress[_gnu].  */
 enum
 {
-  ELF_CHF_FORCE = 0x1
+  ELF_CHF_FORCE = 0x1,
 #define ELF_CHF_FORCE ELF_CHF_FORCE
+  ELF_CHF_CHUNKED = 0x2
+#define ELF_CHF_CHUNKED ELF_CHF_CHUNKED
 };
 
+/* The compression level and the number of threads to use can be
+   added to the flags for elf_compress[_gnu] too.  */
+#define ELF_CHF_LEVEL(level)	(((level) & 0xff) << 8)
+#define ELF_CHF_LEVEL_MASK	ELF_CHF_LEVEL (0xff)
+#define ELF_CHF_THREADS(n)	(((n) & 0xff) << 16)
+#define ELF_CHF_THREADS_MASK	ELF_CHF_THREADS (0xff)
+
 /* Identification values for recognized object files.  */
 typedef enum
 {
@@ -232,6 +259,21 @@ extern Elf *elf_begin (int __fildes, Elf_Cmd __cmd, Elf *__ref);
 /* Create descriptor for memory region.  */
 extern Elf *elf_memory (char *__image, size_t __size);
 
+/* Type of the callback reading N bytes at OFFSET of a file into BUF for
+   elf_begin_read.  Returns the number of bytes read, which can be less
+   than N, zero at the end of the file, or -1 for errors.  */
+typedef ssize_t Elf_Read_Function (void *__arg, void *__buf, size_t __n,
+				   off_t __offset);
+
+/* Return descriptor to read the file of SIZE bytes with READ, like
+   elf_begin with ELF_C_READ on a file descriptor.  The contents are only
+   read when needed.  If RELEASE is not NULL it is called with ARG when
+   the last descriptor using READ is gone.  RELEASE is not called if
+   elf_begin_read fails.  */
+extern Elf *elf_begin_read (Elf_Read_Function *__read,
+			    void (*__release) (void *__arg), void *__arg,
+			    size_t __size);
+
 /* Advance archive descriptor to next element.  */
 extern Elf_Cmd elf_next (Elf *__elf);
 
@@ -348,10 +390,10 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
 
    elf_compress takes a compression type that should be either zero to
    decompress or an ELFCOMPRESS algorithm to use for compression.
-   Currently only ELFCOMPRESS_ZLIB is supported.  elf_compress_gnu
-   will compress in the traditional GNU compression format when
-   compress is one and decompress the section data when compress is
-   zero.
+   ELFCOMPRESS_ZLIB is supported, and ELFCOMPRESS_ZSTD when libelf was
+   built with zstd.  elf_compress_gnu will compress in the traditional
+   GNU compression format when compress is one and decompress the
+   section data when compress is zero.
 
    The FLAGS argument can be zero or ELF_CHF_FORCE.  If FLAGS contains
    ELF_CHF_FORCE then it will always compress the section, even if
@@ -359,6 +401,18 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
    header).  Otherwise elf_compress and elf_compress_gnu will compress
    the section only if the total data size is reduced.
 
+   ELF_CHF_LEVEL (LEVEL) in FLAGS selects the compression level, 1 to
+   9 for zlib and 1 to 22 for zstd.  Without it zlib uses its best
+   compression and zstd its default level.  ELF_CHF_THREADS (N) in
+   FLAGS compresses on N threads.  zlib data is then compressed in
+   chunks on the threads (which is slightly bigger), zstd data is
+   compressed with the zstd worker threads if libzstd supports them.
+
+   ELF_CHF_CHUNKED in FLAGS compresses zstd data in independent frames
+   of at most 1 MiB, so elf_zdata_pread can decompress just the part
+   it needs.  The frames are then compressed on the threads.  It makes
+   no difference for zlib.
+
    On successful compression or decompression the function returns
    one.  If (not forced) compression is requested and the data section
    would not actually reduce in size, the section is not actually
@@ -390,6 +444,19 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
 extern int elf_compress (Elf_Scn *scn, int type, unsigned int flags);
 extern int elf_compress_gnu (Elf_Scn *scn, int compress, unsigned int flags);
 
+/* Copy at most SIZE bytes at OFFSET of the uncompressed data of section
+   SCN into BUF, without decompressing the whole section.  Only the
+   chunks of the data that are needed are decompressed, and at most
+   8 MiB of them are kept.  Data compressed with zstd in several frames (see
+   ELF_CHF_CHUNKED) can be read at any offset for the cost of a frame.
+   Other data can only be decompressed from the start, which makes
+   reading forward cheap and reading backward expensive.  For a section
+   without SHF_COMPRESSED the raw section data is copied.  Returns the
+   number of bytes copied, which is less than SIZE at the end of the
+   data, or -1 on error.  */
+extern ssize_t elf_zdata_pread (Elf_Scn *__scn, void *__buf, size_t __size,
+				int64_t __offset);
+
 /* Set or clear flags for ELF file.  */
 extern unsigned int elf_flagelf (Elf *__elf, Elf_Cmd __cmd,
 				 unsigned int __flags);
@@ -451,6 +518,16 @@ extern Elf_Arsym *elf_getarsym (Elf *__elf, size_t *__narsyms);
 /* Control ELF descriptor.  */
 extern int elf_cntl (Elf *__elf, Elf_Cmd __cmd);
 
+/* Store in *MAPPED the number of bytes of section data returned by
+   elf_getdata and elf_getdata_rawchunk for ELF that point directly at
+   the file contents in memory (normally the mapped file), and in
+   *COPIED the number of bytes that were copied or converted into a
+   buffer of their own.  Data of the host byte order is only copied
+   where the architecture doesn't allow unaligned accesses and the data
+   is not aligned.  Either pointer can be NULL.  Returns zero on
+   success, -1 on error.  */
+extern int elf_data_stats (Elf *__elf, size_t *__mapped, size_t *__copied);
+
 /* Retrieve uninterpreted file contents.  */
 extern char *elf_rawfile (Elf *__elf, size_t *__nbytes);
 
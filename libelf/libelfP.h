@@ -245,6 +245,9 @@ struct Elf_Scn
   size_t zdata_size;		/* If zdata_base != NULL, the size of data.  */
   size_t zdata_align;		/* If zdata_base != NULL, the addralign.  */
 
+  struct Elf_ZCache *zcache;	/* Chunks of the uncompressed data read
+				   by elf_zdata_pread.  */
+
   struct Elf_ScnList *list;	/* Pointer to the section list element the
 				   data is in.  */
 };
@@ -272,6 +275,17 @@ typedef struct Elf_Data_Chunk
 } Elf_Data_Chunk;
 
 
+/* The callback given to elf_begin_read, shared by the descriptors
+   reading the same file.  */
+struct Elf_Reader
+{
+  Elf_Read_Function *read;
+  void (*release) (void *arg);
+  void *arg;
+  unsigned int ref_count;
+};
+
+
 /* The ELF descriptor.  */
 struct Elf
 {
@@ -295,6 +309,16 @@ struct Elf
   /* The used file descriptor.  -1 if not available anymore.  */
   int fildes;
 
+  /* If not NULL the file is read through this instead of FILDES,
+     see elf_begin_read.  */
+  struct Elf_Reader *reader;
+
+  /* Bytes of section data handed out pointing at the file contents in
+     memory, and bytes copied or converted into their own buffers.  See
+     elf_data_stats.  Only changed with the write lock held.  */
+  size_t data_mapped;
+  size_t data_copied;
+
   /* Offset in the archive this file starts or zero.  */
   off_t start_offset;
 
@@ -433,6 +457,10 @@ extern unsigned int __libelf_version attribute_hidden;
 /* The byte value used for filling gaps.  */
 extern int __libelf_fill_byte attribute_hidden;
 
+/* If not zero the number of threads elf_update converts the data on
+   with ELF_F_THREADS, instead of one per CPU.  Only set by tests.  */
+extern unsigned int __libelf_update_threads attribute_hidden;
+
 /* Nonzero if the version was set.  */
 extern int __libelf_version_initialized attribute_hidden;
 
@@ -472,6 +500,38 @@ extern Elf *__libelf_read_mmaped_file (int fildes, void *map_address,
 				       Elf_Cmd cmd, Elf *parent)
      internal_function;
 
+/* Read LEN bytes at OFFSET through READER.  Like pread_retry.  */
+static inline ssize_t
+__libelf_reader_pread (struct Elf_Reader *reader, void *buf, size_t len,
+		       off_t offset)
+{
+  size_t recvd = 0;
+  while (recvd < len)
+    {
+      ssize_t ret = reader->read (reader->arg, (char *) buf + recvd,
+				  len - recvd, offset + recvd);
+      if (ret <= 0)
+	return ret < 0 ? ret : (ssize_t) recvd;
+      recvd += ret;
+    }
+  return recvd;
+}
+
+/* Read LEN bytes at OFFSET of the file of ELF, through its reader or
+   its file descriptor.  Like pread_retry, which must be declared.  */
+#define __libelf_pread(elf, buf, len, offset)				     \
+  ((elf)->reader != NULL						     \
+   ? __libelf_reader_pread ((elf)->reader, buf, len, offset)		     \
+   : pread_retry ((elf)->fildes, buf, len, offset))
+
+/* Drop a reference to READER, see elf_begin_read.  */
+extern void __libelf_reader_release (struct Elf_Reader *reader)
+     internal_function;
+
+/* Whether the contents of ELF which are not in memory can be read.  */
+#define __libelf_can_read(elf) \
+  ((elf)->fildes != -1 || (elf)->reader != NULL)
+
 /* Set error value.  */
 extern void __libelf_seterrno (int value) internal_function;
 
@@ -597,11 +657,13 @@ extern uint32_t __libelf_crc32 (uint32_t crc, unsigned char *buf, size_t len)
 
 extern void * __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
 				 size_t *orig_size, size_t *orig_addralign,
-				 size_t *size, bool force)
+				 size_t *size, int type, unsigned int flags)
      internal_function;
 
-extern void * __libelf_decompress (void *buf_in, size_t size_in,
+extern void * __libelf_decompress (int type, void *buf_in, size_t size_in,
 				   size_t size_out) internal_function;
+extern void __libelf_zcache_free (struct Elf_ZCache *zc) internal_function;
+
 extern void * __libelf_decompress_elf (Elf_Scn *scn,
 				       size_t *size_out, size_t *addralign)
      internal_function;
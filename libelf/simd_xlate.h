@@ -0,0 +1,243 @@
+/* Vectorized conversion functions for the bulk types.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+/* The symbol tables, relocations, dynamic sections and word arrays
+   that make up most of a big file are converted with a byte shuffle.
+   All fields of these types are naturally aligned, so no field
+   crosses a 16 byte boundary and one 16 byte permutation (or three for
+   Elf64_Sym, which repeats every 48 bytes) swaps all of them.  On x86
+   the shuffle is pshufb (SSSE3) or vpshufb (AVX2), chosen at runtime,
+   on AArch64 it is the NEON tbl instruction.  Everything else, and the
+   records at the end that don't fill a whole block, is converted by
+   the scalar functions.  */
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+# include <immintrin.h>
+# define SIMD_XLATE 1
+# define SIMD_XLATE_X86 1
+#elif defined __aarch64__ && defined __ARM_NEON
+# include <arm_neon.h>
+# define SIMD_XLATE 1
+# define SIMD_XLATE_NEON 1
+#endif
+
+#if SIMD_XLATE
+
+struct swap_pattern
+{
+  /* The permutation for each 16 bytes, repeated after NLANES.  */
+  size_t nlanes;
+  uint8_t mask[3][16];
+};
+
+static const struct swap_pattern swap_16 =
+  { 1, { { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 } } };
+
+static const struct swap_pattern swap_32 =
+  { 1, { { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 } } };
+
+static const struct swap_pattern swap_64 =
+  { 1, { { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 } } };
+
+/* st_name, st_value, st_size, st_info, st_other, st_shndx.  */
+static const struct swap_pattern swap_sym32 =
+  { 1, { { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 12, 13, 15, 14 } } };
+
+/* st_name, st_info, st_other, st_shndx, st_value, st_size, twice.  */
+static const struct swap_pattern swap_sym64 =
+  { 3, { { 3, 2, 1, 0, 4, 5, 7, 6, 15, 14, 13, 12, 11, 10, 9, 8 },
+	 { 7, 6, 5, 4, 3, 2, 1, 0, 11, 10, 9, 8, 12, 13, 15, 14 },
+	 { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 } } };
+
+/* The kernels convert as many whole blocks as fit in LEN and return
+   the number of bytes converted.  Each block is loaded before it is
+   stored, so DEST may be SRC or before it.  */
+
+#if SIMD_XLATE_X86
+__attribute__ ((target ("ssse3")))
+static size_t
+simd_cvt_ssse3 (void *dest, const void *src, size_t len,
+		const struct swap_pattern *p)
+{
+  __m128i mask[3];
+  for (size_t i = 0; i < p->nlanes; i++)
+    mask[i] = _mm_loadu_si128 ((const __m128i *) p->mask[i]);
+
+  const size_t block = p->nlanes * 16;
+  size_t done = 0;
+  for (; len - done >= block; done += block)
+    for (size_t i = 0; i < p->nlanes; i++)
+      {
+	const __m128i *s = (const __m128i *) (src + done + i * 16);
+	__m128i *d = (__m128i *) (dest + done + i * 16);
+	_mm_storeu_si128 (d, _mm_shuffle_epi8 (_mm_loadu_si128 (s), mask[i]));
+      }
+  return done;
+}
+
+__attribute__ ((target ("avx2")))
+static size_t
+simd_cvt_avx2 (void *dest, const void *src, size_t len,
+	       const struct swap_pattern *p)
+{
+  /* vpshufb permutes each 16 byte half on its own.  A block is two
+     repeats of Elf64_Sym, so that every vector has the same masks.  */
+  const size_t nvec = p->nlanes == 1 ? 1 : 3;
+  __m256i mask[3];
+  for (size_t i = 0; i < nvec; i++)
+    {
+      __m128i lo = _mm_loadu_si128 ((const __m128i *)
+				    p->mask[(2 * i) % p->nlanes]);
+      __m128i hi = _mm_loadu_si128 ((const __m128i *)
+				    p->mask[(2 * i + 1) % p->nlanes]);
+      mask[i] = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+    }
+
+  const size_t block = nvec * 32;
+  size_t done = 0;
+  for (; len - done >= block; done += block)
+    for (size_t i = 0; i < nvec; i++)
+      {
+	const __m256i *s = (const __m256i *) (src + done + i * 32);
+	__m256i *d = (__m256i *) (dest + done + i * 32);
+	_mm256_storeu_si256 (d, _mm256_shuffle_epi8 (_mm256_loadu_si256 (s),
+						     mask[i]));
+      }
+
+  /* The remaining 16 byte blocks.  */
+  return done + simd_cvt_ssse3 (dest + done, src + done, len - done, p);
+}
+
+/* 2 for AVX2, 1 for SSSE3, 0 for neither.  */
+static int
+simd_level (void)
+{
+  static int level = -1;
+  int l = __atomic_load_n (&level, __ATOMIC_RELAXED);
+  if (l < 0)
+    {
+      __builtin_cpu_init ();
+      l = (__builtin_cpu_supports ("avx2") ? 2
+	   : __builtin_cpu_supports ("ssse3") ? 1 : 0);
+      __atomic_store_n (&level, l, __ATOMIC_RELAXED);
+    }
+  return l;
+}
+#endif
+
+#if SIMD_XLATE_NEON
+static size_t
+simd_cvt_neon (void *dest, const void *src, size_t len,
+	       const struct swap_pattern *p)
+{
+  uint8x16_t mask[3];
+  for (size_t i = 0; i < p->nlanes; i++)
+    mask[i] = vld1q_u8 (p->mask[i]);
+
+  const size_t block = p->nlanes * 16;
+  size_t done = 0;
+  for (; len - done >= block; done += block)
+    for (size_t i = 0; i < p->nlanes; i++)
+      {
+	const uint8_t *s = (const uint8_t *) src + done + i * 16;
+	uint8_t *d = (uint8_t *) dest + done + i * 16;
+	vst1q_u8 (d, vqtbl1q_u8 (vld1q_u8 (s), mask[i]));
+      }
+  return done;
+}
+#endif
+
+static size_t
+simd_cvt (void *dest, const void *src, size_t len,
+	  const struct swap_pattern *p)
+{
+  /* The scalar functions go backward when DEST overlaps the end of
+     SRC, leave that to them.  */
+  if (dest > src && dest < src + len)
+    return 0;
+
+#if SIMD_XLATE_X86
+  switch (simd_level ())
+    {
+    case 2:
+      return simd_cvt_avx2 (dest, src, len, p);
+    case 1:
+      return simd_cvt_ssse3 (dest, src, len, p);
+    default:
+      return 0;
+    }
+#else
+  return simd_cvt_neon (dest, src, len, p);
+#endif
+}
+
+/* The rest is converted by the scalar function of the type.  A block
+   need not end with a record though, Elf32_Rela is 12 bytes.  Then
+   TAIL, the type of all its fields, converts the rest.  */
+#define SIMD_CVT(Bits, Name, Pattern, Tail)				      \
+  static void								      \
+  ElfW2 (Bits, simd_cvt_##Name) (void *dest, const void *src, size_t len,     \
+				 int encode)				      \
+  {									      \
+    size_t done = simd_cvt (dest, src, len, &Pattern);			      \
+    if (done == len)							      \
+      return;								      \
+    if (done % sizeof (ElfW2 (Bits, Name)) == 0)			      \
+      ElfW2 (Bits, cvt_##Name) (dest + done, src + done, len - done, encode); \
+    else								      \
+      ElfW2 (Bits, cvt_##Tail) (dest + done, src + done, len - done, encode); \
+  }
+
+SIMD_CVT (32, Addr, swap_32, Addr)
+SIMD_CVT (32, Dyn, swap_32, Word)
+SIMD_CVT (32, Half, swap_16, Half)
+SIMD_CVT (32, Off, swap_32, Off)
+SIMD_CVT (32, Rela, swap_32, Word)
+SIMD_CVT (32, Rel, swap_32, Word)
+SIMD_CVT (32, Sword, swap_32, Sword)
+SIMD_CVT (32, Sym, swap_sym32, Sym)
+SIMD_CVT (32, Word, swap_32, Word)
+SIMD_CVT (32, Xword, swap_64, Xword)
+SIMD_CVT (32, Sxword, swap_64, Sxword)
+
+SIMD_CVT (64, Addr, swap_64, Addr)
+SIMD_CVT (64, Dyn, swap_64, Xword)
+SIMD_CVT (64, Half, swap_16, Half)
+SIMD_CVT (64, Off, swap_64, Off)
+SIMD_CVT (64, Rela, swap_64, Xword)
+SIMD_CVT (64, Rel, swap_64, Xword)
+SIMD_CVT (64, Sword, swap_32, Sword)
+SIMD_CVT (64, Sym, swap_sym64, Sym)
+SIMD_CVT (64, Word, swap_32, Word)
+SIMD_CVT (64, Xword, swap_64, Xword)
+SIMD_CVT (64, Sxword, swap_64, Sxword)
+
+# define XFCT(Bits, Name)	ElfW2 (Bits, simd_cvt_##Name)
+#else
+# define XFCT(Bits, Name)	ElfW2 (Bits, cvt_##Name)
+#endif
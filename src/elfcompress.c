@@ -43,6 +43,8 @@ ARGP_PROGRAM_VERSION_HOOK_DEF = print_version;
 /* Bug report address.  */
 ARGP_PROGRAM_BUG_ADDRESS_DEF = PACKAGE_BUGREPORT;
 
+#define OPT_CHUNKED	0x100
+
 static int verbose = 0; /* < 0, no warnings, > 0 extra verbosity.  */
 static bool force = false;
 static bool permissive = false;
@@ -50,9 +52,14 @@ static const char *foutput = NULL;
 
 #define T_UNSET 0
 #define T_DECOMPRESS 1    /* none */
-#define T_COMPRESS_ZLIB 2 /* zlib */
+#define T_COMPRESS_ZLIB 2 /* zlib or zstd, ELF gABI style */
 #define T_COMPRESS_GNU  3 /* zlib-gnu */
 static int type = T_UNSET;
+/* The ch_type used for T_COMPRESS_ZLIB.  */
+static int gabi_type = ELFCOMPRESS_ZLIB;
+static unsigned int level = 0;	 /* 0 is the best for zlib, default for zstd.  */
+static unsigned int threads = 1;
+static bool chunked = false;
 
 struct section_pattern
 {
@@ -127,10 +134,43 @@ parse_opt (int key, char *arg __attribute__ ((unused)),
 	type = T_COMPRESS_ZLIB;
       else if (strcmp ("zlib-gnu", arg) == 0 || strcmp ("gnu", arg) == 0)
 	type = T_COMPRESS_GNU;
+      else if (strcmp ("zstd", arg) == 0)
+	{
+#if USE_ZSTD
+	  type = T_COMPRESS_ZLIB;
+	  gabi_type = ELFCOMPRESS_ZSTD;
+#else
+	  argp_error (state, N_("zstd compression not supported"));
+#endif
+	}
       else
 	argp_error (state, N_("unknown compression type '%s'"), arg);
       break;
 
+    case 'l':
+      {
+	char *end;
+	unsigned long val = strtoul (arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || val == 0 || val > 255)
+	  argp_error (state, N_("invalid compression level '%s'"), arg);
+	level = val;
+      }
+      break;
+
+    case 'j':
+      {
+	char *end;
+	unsigned long val = strtoul (arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || val == 0 || val > 255)
+	  argp_error (state, N_("invalid number of threads '%s'"), arg);
+	threads = val;
+      }
+      break;
+
+    case OPT_CHUNKED:
+      chunked = true;
+      break;
+
     case ARGP_KEY_SUCCESS:
       if (type == T_UNSET)
 	type = T_COMPRESS_ZLIB;
@@ -193,6 +233,16 @@ setshdrstrndx (Elf *elf, GElf_Ehdr *ehdr, size_t ndx)
   return 0;
 }
 
+/* Whether SCN is ELF gABI compressed, but not with gabi_type.  */
+static bool
+other_gabi_type (Elf_Scn *scn, GElf_Shdr *shdr)
+{
+  GElf_Chdr chdr;
+  return ((shdr->sh_flags & SHF_COMPRESSED) != 0
+	  && gelf_getchdr (scn, &chdr) != NULL
+	  && chdr.ch_type != (Elf64_Word) gabi_type);
+}
+
 static int
 compress_section (Elf_Scn *scn, size_t orig_size, const char *name,
 		  const char *newname, size_t ndx,
@@ -200,10 +250,13 @@ compress_section (Elf_Scn *scn, size_t orig_size, const char *name,
 {
   int res;
   unsigned int flags = compress && force ? ELF_CHF_FORCE : 0;
+  if (compress)
+    flags |= (ELF_CHF_LEVEL (level) | ELF_CHF_THREADS (threads)
+	      | (chunked ? ELF_CHF_CHUNKED : 0));
   if (gnu)
     res = elf_compress_gnu (scn, compress ? 1 : 0, flags);
   else
-    res = elf_compress (scn, compress ? ELFCOMPRESS_ZLIB : 0, flags);
+    res = elf_compress (scn, compress ? gabi_type : 0, flags);
 
   if (res < 0)
     error (0, 0, "Couldn't decompress section [%zd] %s: %s",
@@ -484,7 +537,8 @@ process_file (const char *fname)
 		printf ("[%zd] %s already decompressed\n", ndx, sname);
 	    }
 	  else if (!force && type == T_COMPRESS_ZLIB
-		   && (shdr->sh_flags & SHF_COMPRESSED) != 0)
+		   && (shdr->sh_flags & SHF_COMPRESSED) != 0
+		   && !other_gabi_type (scn, shdr))
 	    {
 	      if (verbose > 0)
 		printf ("[%zd] %s already compressed\n", ndx, sname);
@@ -797,9 +851,18 @@ process_file (const char *fname)
 	      break;
 
 	    case T_COMPRESS_ZLIB:
-	      if ((shdr->sh_flags & SHF_COMPRESSED) == 0)
+	      if ((shdr->sh_flags & SHF_COMPRESSED) == 0
+		  || other_gabi_type (scn, shdr))
 		{
-		  if (strncmp (sname, ".zdebug", strlen (".zdebug")) == 0)
+		  if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
+		    {
+		      /* First decompress to recompress with gabi_type.
+			 Don't report even when verbose.  */
+		      if (compress_section (scn, size, sname, NULL, ndx,
+					    false, false, false) < 0)
+			return cleanup (-1);
+		    }
+		  else if (strncmp (sname, ".zdebug", strlen (".zdebug")) == 0)
 		    {
 		      /* First decompress to recompress zlib style.
 			 Don't report even when verbose.  */
@@ -1309,7 +1372,16 @@ main (int argc, char **argv)
 	N_("Place (de)compressed output into FILE"),
 	0 },
       { "type", 't', "TYPE", 0,
-	N_("What type of compression to apply. TYPE can be 'none' (decompress), 'zlib' (ELF ZLIB compression, the default, 'zlib-gabi' is an alias) or 'zlib-gnu' (.zdebug GNU style compression, 'gnu' is an alias)"),
+	N_("What type of compression to apply. TYPE can be 'none' (decompress), 'zlib' (ELF ZLIB compression, the default, 'zlib-gabi' is an alias), 'zlib-gnu' (.zdebug GNU style compression, 'gnu' is an alias) or 'zstd' (ELF ZSTD compression)"),
+	0 },
+      { "level", 'l', "LEVEL", 0,
+	N_("Compression LEVEL to use (defaults to the best zlib compression or the zstd default)"),
+	0 },
+      { "threads", 'j', "N", 0,
+	N_("Compress every section on N threads"),
+	0 },
+      { "chunked", OPT_CHUNKED, NULL, 0,
+	N_("Compress zstd sections in independent frames, so they can be read without decompressing them completely"),
 	0 },
       { "name", 'n', "SECTION", 0,
 	N_("SECTION name to (de)compress, SECTION is an extended wildcard pattern (defaults to '.?(z)debug*')"),
@@ -1175,6 +1175,9 @@ elf_ch_type_name (unsigned int code)
   if (code == ELFCOMPRESS_ZLIB)
     return "ZLIB";
 
+  if (code == ELFCOMPRESS_ZSTD)
+    return "ZSTD";
+
   return "UNKNOWN";
 }
 
@@ -53,6 +53,7 @@ static bool show_debugname = false;
 static bool show_inlines = false;
 
 static int maxframes = 256;
+static int jobs = 0;
 
 struct frame
 {
@@ -67,6 +68,18 @@ struct frames
   struct frame *frame;
 };
 
+/* The frames of one thread, unwound by a worker with -j.  */
+struct thread_frames
+{
+  pid_t tid;
+  int err;
+  struct frames frames;
+  struct thread_frames *next;
+};
+
+/* The threads unwound with -j, in no particular order.  */
+static struct thread_frames *thread_frames_list = NULL;
+
 static Dwfl *dwfl = NULL;
 static pid_t pid = 0;
 static int core_fd = -1;
@@ -314,45 +327,37 @@ print_frame (int nr, Dwarf_Addr pc, bool isactivation,
   printf ("\n");
 }
 
+/* SCOPES are the NSCOPES function DIEs containing PC_ADJUSTED, from
+   dwarf_getinlinechain.  */
 static void
 print_inline_frames (int *nr, Dwarf_Addr pc, bool isactivation,
 		     Dwarf_Addr pc_adjusted, Dwfl_Module *mod,
-		     const char *symname, Dwarf_Die *cudie, Dwarf_Die *die)
+		     const char *symname, Dwarf_Die *cudie,
+		     Dwarf_Die *scopes, int nscopes)
 {
-  Dwarf_Die *scopes = NULL;
-  int nscopes = dwarf_getscopes_die (die, &scopes);
-  if (nscopes > 0)
+  /* scopes[0], the lowest level, for which we already have the name.
+     This is the actual source location where it happened.  */
+  print_frame ((*nr)++, pc, isactivation, pc_adjusted, mod, symname,
+	       NULL, NULL);
+
+  /* last_scope is the source location where the next frame/function
+     call was done. */
+  Dwarf_Die *last_scope = &scopes[0];
+  for (int i = 1; i < nscopes && (maxframes == 0 || *nr < maxframes); i++)
     {
-      /* scopes[0] == die, the lowest level, for which we already have
-	 the name.  This is the actual source location where it
-	 happened.  */
+      Dwarf_Die *scope = &scopes[i];
+      int tag = dwarf_tag (scope);
+
+      symname = die_name (scope);
       print_frame ((*nr)++, pc, isactivation, pc_adjusted, mod, symname,
-		   NULL, NULL);
+		   cudie, last_scope);
 
-      /* last_scope is the source location where the next frame/function
-	 call was done. */
-      Dwarf_Die *last_scope = &scopes[0];
-      for (int i = 1; i < nscopes && (maxframes == 0 || *nr < maxframes); i++)
-	{
-	  Dwarf_Die *scope = &scopes[i];
-	  int tag = dwarf_tag (scope);
-	  if (tag != DW_TAG_inlined_subroutine
-	      && tag != DW_TAG_entry_point
-	      && tag != DW_TAG_subprogram)
-	    continue;
-
-	  symname = die_name (scope);
-	  print_frame ((*nr)++, pc, isactivation, pc_adjusted, mod, symname,
-		       cudie, last_scope);
-
-	  /* Found the "top-level" in which everything was inlined?  */
-	  if (tag == DW_TAG_subprogram)
-	    break;
+      /* Found the "top-level" in which everything was inlined?  */
+      if (tag == DW_TAG_subprogram)
+	break;
 
-	  last_scope = scope;
-	}
+      last_scope = scope;
     }
-  free (scopes);
 }
 
 static void
@@ -373,48 +378,38 @@ print_frames (struct frames *frames, pid_t tid, int dwflerr, const char *what)
       /* Get PC->SYMNAME.  */
       Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc_adjusted);
       const char *symname = NULL;
-      Dwarf_Die die_mem;
-      Dwarf_Die *die = NULL;
+      Dwarf_Die *scopes = NULL;
+      int nscopes = 0;
+      int first = 0;
       Dwarf_Die *cudie = NULL;
       if (mod && ! show_quiet)
 	{
 	  if (show_debugname)
 	    {
 	      Dwarf_Addr bias = 0;
-	      Dwarf_Die *scopes = NULL;
 	      cudie = dwfl_module_addrdie (mod, pc_adjusted, &bias);
-	      int nscopes = dwarf_getscopes (cudie, pc_adjusted - bias,
-					     &scopes);
-
-	      /* Find the first function-like DIE with a name in scope.  */
-	      for (int i = 0; symname == NULL && i < nscopes; i++)
-		{
-		  Dwarf_Die *scope = &scopes[i];
-		  int tag = dwarf_tag (scope);
-		  if (tag == DW_TAG_subprogram
-		      || tag == DW_TAG_inlined_subroutine
-		      || tag == DW_TAG_entry_point)
-		    symname = die_name (scope);
-
-		  if (symname != NULL)
-		    {
-		      die_mem = *scope;
-		      die = &die_mem;
-		    }
-		}
-	      free (scopes);
+	      if (cudie != NULL)
+		nscopes = dwarf_getinlinechain (cudie, pc_adjusted - bias,
+						&scopes);
+
+	      /* Find the first function DIE with a name.  */
+	      for (; symname == NULL && first < nscopes; first++)
+		symname = die_name (&scopes[first]);
+	      if (symname != NULL)
+		first--;
 	    }
 
 	  if (symname == NULL)
 	    symname = dwfl_module_addrname (mod, pc_adjusted);
 	}
 
-      if (show_inlines && die != NULL)
+      if (show_inlines && first < nscopes)
 	print_inline_frames (&frame_nr, pc, isactivation, pc_adjusted, mod,
-			     symname, cudie, die);
+			     symname, cudie, &scopes[first], nscopes - first);
       else
 	print_frame (frame_nr++, pc, isactivation, pc_adjusted, mod, symname,
 		     NULL, NULL);
+      free (scopes);
     }
 
   if (frames->frames > 0 && frame_nr == maxframes)
@@ -470,6 +465,77 @@ thread_callback (Dwfl_Thread *thread, void *thread_arg)
   return DWARF_CB_OK;
 }
 
+/* Called concurrently by the workers of dwfl_getthreads_parallel, so
+   only unwinds and leaves the rest to print_thread_frames.  */
+static int
+parallel_thread_callback (Dwfl_Thread *thread,
+			  void *thread_arg __attribute__ ((unused)))
+{
+  struct thread_frames *tf = malloc (sizeof *tf);
+  if (tf == NULL)
+    error (EXIT_BAD, errno, "malloc thread_frames");
+  tf->tid = dwfl_thread_tid (thread);
+  tf->err = 0;
+  tf->frames.frames = 0;
+  tf->frames.allocated = maxframes == 0 ? 2048 : maxframes;
+  tf->frames.frame = malloc (sizeof (struct frame) * tf->frames.allocated);
+  if (tf->frames.frame == NULL)
+    error (EXIT_BAD, errno, "malloc frames.frame");
+  switch (dwfl_thread_getframes (thread, frame_callback, &tf->frames))
+    {
+    case DWARF_CB_OK:
+    case DWARF_CB_ABORT:
+      break;
+    case -1:
+      tf->err = dwfl_errno ();
+      break;
+    default:
+      abort ();
+    }
+
+  tf->next = __atomic_load_n (&thread_frames_list, __ATOMIC_RELAXED);
+  while (! __atomic_compare_exchange_n (&thread_frames_list, &tf->next, tf,
+					true, __ATOMIC_RELEASE,
+					__ATOMIC_RELAXED))
+    ;
+  return DWARF_CB_OK;
+}
+
+static int
+compare_thread_frames (const void *a, const void *b)
+{
+  const struct thread_frames *tfa = *(const struct thread_frames **) a;
+  const struct thread_frames *tfb = *(const struct thread_frames **) b;
+  return (tfa->tid > tfb->tid) - (tfa->tid < tfb->tid);
+}
+
+/* Print and free the threads unwound with -j, ordered by thread id.  */
+static void
+print_thread_frames (void)
+{
+  size_t n = 0;
+  for (struct thread_frames *tf = thread_frames_list; tf != NULL;
+       tf = tf->next)
+    n++;
+  struct thread_frames **tfs = malloc ((n ?: 1) * sizeof tfs[0]);
+  if (tfs == NULL)
+    error (EXIT_BAD, errno, "malloc thread_frames");
+  n = 0;
+  for (struct thread_frames *tf = thread_frames_list; tf != NULL;
+       tf = tf->next)
+    tfs[n++] = tf;
+  qsort (tfs, n, sizeof tfs[0], compare_thread_frames);
+  for (size_t i = 0; i < n; i++)
+    {
+      print_frames (&tfs[i]->frames, tfs[i]->tid, tfs[i]->err,
+		    "dwfl_thread_getframes");
+      free (tfs[i]->frames.frame);
+      free (tfs[i]);
+    }
+  free (tfs);
+  thread_frames_list = NULL;
+}
+
 static error_t
 parse_opt (int key, char *arg __attribute__ ((unused)),
 	   struct argp_state *state)
@@ -554,6 +620,15 @@ parse_opt (int key, char *arg __attribute__ ((unused)),
       show_modules = true;
       break;
 
+    case 'j':
+      jobs = atoi (arg);
+      if (jobs <= 0)
+	{
+	  argp_error (state, N_("-j JOBS should be 1 or higher."));
+	  return EINVAL;
+	}
+      break;
+
     case ARGP_KEY_END:
       if (core == NULL && exec != NULL)
 	argp_error (state,
@@ -670,6 +745,8 @@ main (int argc, char **argv)
 	N_("Show at most MAXFRAMES per thread (default 256, use 0 for unlimited)"), 0 },
       { "list-modules", 'l', NULL, 0,
 	N_("Show module memory map with build-id, elf and debug files detected"), 0 },
+      { "jobs", 'j', "JOBS", 0,
+	N_("Stop all threads at once and unwind them with JOBS workers, show them ordered by thread id"), 0 },
       { NULL, 0, NULL, 0, NULL, 0 }
     };
 
@@ -726,17 +803,34 @@ invoked with bad or missing arguments it will exit with return code 64.")
     {
       printf ("PID %lld - %s\n", (long long) dwfl_pid (dwfl),
 	      pid != 0 ? "process" : "core");
-      switch (dwfl_getthreads (dwfl, thread_callback, &frames))
+      if (jobs > 0)
 	{
-	case DWARF_CB_OK:
-	case DWARF_CB_ABORT:
-	  break;
-	case -1:
-	  error (0, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
-	  break;
-	default:
-	  abort ();
+	  switch (dwfl_getthreads_parallel (dwfl, jobs,
+					    parallel_thread_callback, NULL))
+	    {
+	    case DWARF_CB_OK:
+	    case DWARF_CB_ABORT:
+	      break;
+	    case -1:
+	      error (0, 0, "dwfl_getthreads_parallel: %s", dwfl_errmsg (-1));
+	      break;
+	    default:
+	      abort ();
+	    }
+	  print_thread_frames ();
 	}
+      else
+	switch (dwfl_getthreads (dwfl, thread_callback, &frames))
+	  {
+	  case DWARF_CB_OK:
+	  case DWARF_CB_ABORT:
+	    break;
+	  case -1:
+	    error (0, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
+	    break;
+	  default:
+	    abort ();
+	  }
     }
   free (frames.frame);
   dwfl_end (dwfl);
@@ -0,0 +1,282 @@
+/* Test and benchmark FDE lookups with dwarf_cfi_addrframe.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dw)
+#include <dwarf.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <gelf.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Usage: dwarf-cfi-fdes FILE...
+   For each function symbol of FILE looks up the CFI of its first and
+   last address in .eh_frame and .debug_frame, and checks that the
+   frames found cover them.
+
+   Usage: dwarf-cfi-fdes --addrs FILE ADDR...
+   Prints the range of the .debug_frame FDE found for each ADDR.
+
+   Usage: dwarf-cfi-fdes --bench N FILE
+   Looks up the first address of every function N times, with a new
+   Dwarf_CFI, so the first round includes setting up the search.  */
+
+struct funcs
+{
+  GElf_Addr *addrs;
+  GElf_Addr *ends;
+  size_t n;
+};
+
+static void
+collect_funcs (Elf *elf, struct funcs *funcs)
+{
+  funcs->addrs = NULL;
+  funcs->ends = NULL;
+  funcs->n = 0;
+  size_t alloc = 0;
+
+  /* Prefer .symtab, otherwise use .dynsym.  */
+  Elf_Scn *symscn = NULL;
+  GElf_Shdr symshdr;
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr != NULL
+	  && (shdr->sh_type == SHT_SYMTAB
+	      || (shdr->sh_type == SHT_DYNSYM && symscn == NULL)))
+	{
+	  symscn = scn;
+	  symshdr = *shdr;
+	}
+    }
+  if (symscn == NULL)
+    return;
+
+  Elf_Data *data = elf_getdata (symscn, NULL);
+  if (data == NULL || symshdr.sh_entsize == 0)
+    return;
+  size_t nsyms = symshdr.sh_size / symshdr.sh_entsize;
+  for (size_t i = 0; i < nsyms; i++)
+    {
+      GElf_Sym sym;
+      if (gelf_getsym (data, i, &sym) == NULL
+	  || GELF_ST_TYPE (sym.st_info) != STT_FUNC
+	  || sym.st_shndx == SHN_UNDEF || sym.st_size == 0)
+	continue;
+
+      if (funcs->n == alloc)
+	{
+	  alloc = alloc * 2 + 64;
+	  funcs->addrs = realloc (funcs->addrs, alloc * sizeof (GElf_Addr));
+	  funcs->ends = realloc (funcs->ends, alloc * sizeof (GElf_Addr));
+	  if (funcs->addrs == NULL || funcs->ends == NULL)
+	    error (EXIT_FAILURE, errno, "realloc");
+	}
+      funcs->addrs[funcs->n] = sym.st_value;
+      funcs->ends[funcs->n] = sym.st_value + sym.st_size;
+      funcs->n++;
+    }
+}
+
+/* Returns true if ADDR is covered by CFI, and sets [*START, *END).  */
+static bool
+lookup (Dwarf_CFI *cfi, Dwarf_Addr addr, Dwarf_Addr *start, Dwarf_Addr *end)
+{
+  Dwarf_Frame *frame;
+  if (dwarf_cfi_addrframe (cfi, addr, &frame) != 0)
+    return false;
+  bool signalp;
+  dwarf_frame_info (frame, start, end, &signalp);
+  free (frame);
+  if (*start > addr || *end <= addr)
+    error (EXIT_FAILURE, 0, "frame [%#" PRIx64 ", %#" PRIx64 ")"
+	   " does not cover %#" PRIx64, *start, *end, addr);
+  return true;
+}
+
+static void
+check (const char *name, Dwarf_CFI *cfi, const struct funcs *funcs)
+{
+  size_t found = 0;
+  size_t found_last = 0;
+  for (size_t i = 0; i < funcs->n; i++)
+    {
+      Dwarf_Addr start, end;
+      found += lookup (cfi, funcs->addrs[i], &start, &end);
+      found_last += lookup (cfi, funcs->ends[i] - 1, &start, &end);
+    }
+  printf ("  %s: %zu first and %zu last addresses found\n",
+	  name, found, found_last);
+}
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return ((end.tv_sec - start->tv_sec)
+	  + (end.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static void
+bench_cfi (const char *name, Elf *elf, bool eh, const struct funcs *funcs,
+	   size_t rounds)
+{
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  Dwarf *dbg = NULL;
+  Dwarf_CFI *cfi;
+  if (eh)
+    cfi = dwarf_getcfi_elf (elf);
+  else
+    {
+      dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+      cfi = dwarf_getcfi (dbg);
+    }
+  if (cfi == NULL)
+    {
+      dwarf_end (dbg);
+      return;
+    }
+
+  size_t found = 0;
+  double first = 0;
+  for (size_t r = 0; r < rounds; r++)
+    {
+      for (size_t i = 0; i < funcs->n; i++)
+	{
+	  Dwarf_Addr fstart, fend;
+	  found += lookup (cfi, funcs->addrs[i], &fstart, &fend);
+	}
+      if (r == 0)
+	first = elapsed (&start);
+    }
+  double secs = elapsed (&start);
+
+  if (eh)
+    dwarf_cfi_end (cfi);
+  dwarf_end (dbg);
+
+  fprintf (stderr, "  %s: first round %.6fs, %.6fs (%.0f lookups/s)"
+	   ", %zu found\n", name, first, secs,
+	   rounds * funcs->n / secs, found / rounds);
+}
+
+static Elf *
+open_elf (const char *file, int *fd)
+{
+  *fd = open (file, O_RDONLY);
+  if (*fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", file);
+  Elf *elf = elf_begin (*fd, ELF_C_READ_MMAP, NULL);
+  if (elf == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin %s: %s", file, elf_errmsg (-1));
+  return elf;
+}
+
+int
+main (int argc, char *argv[])
+{
+  elf_version (EV_CURRENT);
+
+  if (argc >= 3 && strcmp (argv[1], "--addrs") == 0)
+    {
+      int fd;
+      Elf *elf = open_elf (argv[2], &fd);
+      Dwarf *dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+      Dwarf_CFI *cfi = dwarf_getcfi (dbg);
+      if (cfi == NULL)
+	error (EXIT_FAILURE, 0, "dwarf_getcfi: %s", dwarf_errmsg (-1));
+      for (int i = 3; i < argc; i++)
+	{
+	  Dwarf_Addr addr = strtoull (argv[i], NULL, 0);
+	  Dwarf_Addr start, end;
+	  if (lookup (cfi, addr, &start, &end))
+	    printf ("%#" PRIx64 ": [%#" PRIx64 ", %#" PRIx64 ")\n",
+		    addr, start, end);
+	  else
+	    printf ("%#" PRIx64 ": %s\n", addr, dwarf_errmsg (-1));
+	}
+      dwarf_end (dbg);
+      elf_end (elf);
+      close (fd);
+      return 0;
+    }
+
+  if (argc == 4 && strcmp (argv[1], "--bench") == 0)
+    {
+      size_t rounds = strtoul (argv[2], NULL, 10);
+      int fd;
+      Elf *elf = open_elf (argv[3], &fd);
+      struct funcs funcs;
+      collect_funcs (elf, &funcs);
+      fprintf (stderr, "%s: %zu functions, %zu rounds\n",
+	       argv[3], funcs.n, rounds);
+      if (funcs.n > 0 && rounds > 0)
+	{
+	  bench_cfi (".eh_frame", elf, true, &funcs, rounds);
+	  bench_cfi (".debug_frame", elf, false, &funcs, rounds);
+	}
+      free (funcs.addrs);
+      free (funcs.ends);
+      elf_end (elf);
+      close (fd);
+      return 0;
+    }
+
+  for (int i = 1; i < argc; i++)
+    {
+      int fd;
+      Elf *elf = open_elf (argv[i], &fd);
+      struct funcs funcs;
+      collect_funcs (elf, &funcs);
+      printf ("%s: %zu functions\n", argv[i], funcs.n);
+
+      Dwarf_CFI *cfi = dwarf_getcfi_elf (elf);
+      if (cfi != NULL)
+	{
+	  check (".eh_frame", cfi, &funcs);
+	  dwarf_cfi_end (cfi);
+	}
+
+      Dwarf *dbg = dwarf_begin_elf (elf, DWARF_C_READ, NULL);
+      cfi = dwarf_getcfi (dbg);
+      if (cfi != NULL)
+	check (".debug_frame", cfi, &funcs);
+      dwarf_end (dbg);
+
+      free (funcs.addrs);
+      free (funcs.ends);
+      elf_end (elf);
+      close (fd);
+    }
+
+  return 0;
+}
@@ -0,0 +1,261 @@
+/* Test concurrent readers of one Dwarf.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Walk all units of a Dwarf, resolving DIE references, line tables,
+   file tables, location expressions and aranges, and fold everything
+   into a checksum.  First once with a single thread, then with many
+   threads on one fresh Dwarf, each starting at a different unit so
+   they race to fill in the same caches.  All threads should get the
+   same answer as the single threaded run.  */
+
+#define NTHREADS 16
+
+static Dwarf *dbg;
+static size_t nunits;
+static Dwarf_Off *units;
+
+static uint64_t
+mix (uint64_t h, uint64_t v)
+{
+  h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  return h;
+}
+
+static uint64_t
+hash_string (const char *s)
+{
+  uint64_t h = 0;
+  if (s != NULL)
+    while (*s != '\0')
+      h = h * 31 + (unsigned char) *s++;
+  return h;
+}
+
+static uint64_t
+hash_die (Dwarf_Die *die)
+{
+  uint64_t h = mix (dwarf_dieoffset (die), dwarf_tag (die));
+  h = mix (h, hash_string (dwarf_diename (die)));
+
+  int line;
+  if (dwarf_decl_line (die, &line) == 0)
+    h = mix (h, line);
+  h = mix (h, hash_string (dwarf_decl_file (die)));
+
+  Dwarf_Attribute attr;
+  Dwarf_Die type;
+  if (dwarf_attr_integrate (die, DW_AT_type, &attr) != NULL
+      && dwarf_formref_die (&attr, &type) != NULL)
+    h = mix (h, dwarf_dieoffset (&type));
+
+  if (dwarf_attr (die, DW_AT_location, &attr) != NULL)
+    {
+      Dwarf_Addr base, start, end;
+      Dwarf_Op *expr;
+      size_t exprlen;
+      ptrdiff_t off = 0;
+      while ((off = dwarf_getlocations (&attr, off, &base, &start, &end,
+					&expr, &exprlen)) > 0)
+	{
+	  h = mix (h, start);
+	  h = mix (h, end);
+	  for (size_t i = 0; i < exprlen; i++)
+	    h = mix (h, mix (expr[i].atom, expr[i].number));
+	}
+    }
+
+  return h;
+}
+
+static uint64_t
+hash_dies (Dwarf_Die *die)
+{
+  uint64_t h = 0;
+  Dwarf_Die cur = *die;
+  do
+    {
+      h = mix (h, hash_die (&cur));
+
+      Dwarf_Die child;
+      if (dwarf_child (&cur, &child) == 0)
+	h = mix (h, hash_dies (&child));
+    }
+  while (dwarf_siblingof (&cur, &cur) == 0);
+
+  return h;
+}
+
+static uint64_t
+hash_unit (Dwarf_Off off)
+{
+  Dwarf_Die cudie;
+  if (dwarf_offdie (dbg, off, &cudie) == NULL)
+    return 0;
+
+  uint64_t h = hash_dies (&cudie);
+
+  Dwarf_Lines *lines;
+  size_t nlines;
+  if (dwarf_getsrclines (&cudie, &lines, &nlines) == 0)
+    for (size_t i = 0; i < nlines; i++)
+      {
+	Dwarf_Line *line = dwarf_onesrcline (lines, i);
+	Dwarf_Addr addr;
+	int lineno;
+	dwarf_lineaddr (line, &addr);
+	dwarf_lineno (line, &lineno);
+	h = mix (h, mix (addr, lineno));
+	h = mix (h, hash_string (dwarf_linesrc (line, NULL, NULL)));
+      }
+
+  Dwarf_Files *files;
+  size_t nfiles;
+  if (dwarf_getsrcfiles (&cudie, &files, &nfiles) == 0)
+    for (size_t i = 0; i < nfiles; i++)
+      h = mix (h, hash_string (dwarf_filesrc (files, i, NULL, NULL)));
+
+  /* The lookup by address goes through the aranges.  */
+  Dwarf_Addr low;
+  Dwarf_Die addrdie;
+  if (dwarf_lowpc (&cudie, &low) == 0
+      && dwarf_addrdie (dbg, low, &addrdie) != NULL)
+    h = mix (h, dwarf_dieoffset (&addrdie));
+
+  return h;
+}
+
+/* Units are hashed independently and summed, so the result doesn't
+   depend on the order in which they were visited.  */
+static uint64_t
+hash_all (size_t first)
+{
+  uint64_t h = 0;
+  for (size_t i = 0; i < nunits; i++)
+    h += hash_unit (units[(first + i) % nunits]);
+  return h;
+}
+
+static pthread_barrier_t barrier;
+static uint64_t results[NTHREADS];
+
+static void *
+thread_main (void *arg)
+{
+  size_t n = (size_t) (uintptr_t) arg;
+  pthread_barrier_wait (&barrier);
+  results[n] = hash_all (n * nunits / NTHREADS);
+  return NULL;
+}
+
+int
+main (int argc, char *argv[])
+{
+#ifndef USE_LOCKS
+  /* Without --enable-thread-safety a Dwarf can only be used by one
+     thread at a time.  */
+  (void) argc;
+  (void) argv;
+  puts ("concurrent readers not supported without thread safety");
+  return 77;
+#else
+  for (int cnt = 1; cnt < argc; cnt++)
+    {
+      int fd = open (argv[cnt], O_RDONLY);
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	{
+	  printf ("%s not usable: %s\n", argv[cnt], dwarf_errmsg (-1));
+	  return -1;
+	}
+
+      nunits = 0;
+      size_t aunits = 0;
+      Dwarf_Off off = 0;
+      Dwarf_Off next;
+      size_t hsize;
+      while (dwarf_nextcu (dbg, off, &next, &hsize, NULL, NULL, NULL) == 0)
+	{
+	  if (nunits == aunits)
+	    {
+	      aunits = aunits == 0 ? 64 : 2 * aunits;
+	      units = realloc (units, aunits * sizeof (Dwarf_Off));
+	      if (units == NULL)
+		{
+		  puts ("out of memory");
+		  return -1;
+		}
+	    }
+	  units[nunits++] = off + hsize;
+	  off = next;
+	}
+
+      uint64_t expected = hash_all (0);
+      dwarf_end (dbg);
+
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      pthread_barrier_init (&barrier, NULL, NTHREADS);
+      pthread_t threads[NTHREADS];
+      for (size_t i = 0; i < NTHREADS; i++)
+	if (pthread_create (&threads[i], NULL, thread_main,
+			    (void *) (uintptr_t) i) != 0)
+	  {
+	    puts ("pthread_create failed");
+	    return -1;
+	  }
+
+      int result = 0;
+      for (size_t i = 0; i < NTHREADS; i++)
+	{
+	  pthread_join (threads[i], NULL);
+	  if (results[i] != expected)
+	    {
+	      printf ("%s: thread %zd got %" PRIx64 ", expected %" PRIx64 "\n",
+		      argv[cnt], i, results[i], expected);
+	      result = -1;
+	    }
+	}
+      pthread_barrier_destroy (&barrier);
+
+      printf ("%s: %zd units, %d threads: %s\n", argv[cnt], nunits,
+	      NTHREADS, result == 0 ? "ok" : "FAIL");
+
+      dwarf_end (dbg);
+      close (fd);
+      if (result != 0)
+	return result;
+    }
+
+  free (units);
+  return 0;
+#endif
+}
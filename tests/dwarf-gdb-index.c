@@ -0,0 +1,130 @@
+/* Test address and name lookups through the .gdb_index.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Usage: dwarf-gdb-index FILE [ADDR|NAME...]
+   Prints the address ranges of FILE, then for each 0x prefixed ADDR
+   the unit containing it and for each NAME the DIEs found by
+   dwarf_names_lookup.  */
+
+static int
+print_entry (Dwarf *dbg, Dwarf_Name *entry, void *arg)
+{
+  int *result = arg;
+  printf (" [%" PRIx64 "] %s tag 0x%x cu [%" PRIx64 "]\n",
+	  entry->die_offset, entry->name, entry->tag, entry->cu_offset);
+
+  Dwarf_Die die;
+  Dwarf_Die cudie;
+  const char *name;
+  if (dwarf_offdie (dbg, entry->die_offset, &die) == NULL
+      || dwarf_diecu (&die, &cudie, NULL, NULL) == NULL
+      || (unsigned int) dwarf_tag (&die) != entry->tag
+      || (name = dwarf_diename (&die)) == NULL
+      || strcmp (name, entry->name) != 0
+      || dwarf_dieoffset (&cudie) != entry->cu_offset)
+    {
+      printf ("DIE %" PRIx64 " doesn't match %s\n", entry->die_offset,
+	      entry->name);
+      *result = -1;
+    }
+  return DWARF_CB_OK;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      puts ("no file given");
+      return -1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", argv[1], dwarf_errmsg (-1));
+      return -1;
+    }
+
+  int result = 0;
+  Dwarf_Aranges *aranges;
+  size_t naranges;
+  if (dwarf_getaranges (dbg, &aranges, &naranges) != 0)
+    {
+      printf ("dwarf_getaranges: %s\n", dwarf_errmsg (-1));
+      result = -1;
+    }
+  else
+    {
+      printf ("aranges: %zd\n", naranges);
+      for (size_t i = 0; i < naranges; i++)
+	{
+	  Dwarf_Addr start;
+	  Dwarf_Word length;
+	  Dwarf_Off offset;
+	  dwarf_getarangeinfo (dwarf_onearange (aranges, i), &start, &length,
+			       &offset);
+	  printf (" %#" PRIx64 " +%#" PRIx64 " die [%" PRIx64 "]\n",
+		  start, length, offset);
+	}
+    }
+
+  for (int cnt = 2; cnt < argc; cnt++)
+    {
+      if (strncmp (argv[cnt], "0x", 2) == 0)
+	{
+	  Dwarf_Addr addr = strtoull (argv[cnt], NULL, 16);
+	  Dwarf_Die cudie;
+	  if (dwarf_addrdie (dbg, addr, &cudie) == NULL)
+	    printf ("addr %#" PRIx64 ": not found\n", addr);
+	  else
+	    printf ("addr %#" PRIx64 ": cu [%" PRIx64 "] %s\n", addr,
+		    dwarf_dieoffset (&cudie), dwarf_diename (&cudie));
+	  continue;
+	}
+
+      printf ("lookup: %s\n", argv[cnt]);
+      int found = dwarf_names_lookup (dbg, argv[cnt], print_entry, &result);
+      if (found < 0)
+	{
+	  printf ("dwarf_names_lookup: %s\n", dwarf_errmsg (-1));
+	  result = -1;
+	}
+      else if (found == 0)
+	printf (" not found\n");
+    }
+
+  dwarf_end (dbg);
+  close (fd);
+  return result;
+}
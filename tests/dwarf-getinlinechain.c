@@ -0,0 +1,272 @@
+/* Test and benchmark dwarf_getinlinechain against dwarf_getscopes.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dw)
+#include <dwarf.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <gelf.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Usage: dwarf-getinlinechain FILE...
+   For the address of every line table row of every CU of FILE checks
+   that dwarf_getinlinechain returns the function DIEs that
+   dwarf_getscopes and dwarf_getscopes_die find, like eu-stack -i did.
+   Only checks MAXCHECK of the addresses of a large file, and skips
+   relocatable files.
+
+   Usage: dwarf-getinlinechain --bench N FILE
+   Looks up the inline chain of all those addresses N times both ways.  */
+
+#define MAXCHECK 2000
+
+static bool
+is_function (Dwarf_Die *die)
+{
+  int tag = dwarf_tag (die);
+  return (tag == DW_TAG_subprogram || tag == DW_TAG_inlined_subroutine
+	  || tag == DW_TAG_entry_point);
+}
+
+/* The old way: the innermost function in the scopes of PC (or
+   INNERMOST), and the functions in the scopes of that up to the first
+   subprogram.  */
+static int
+getscopes_chain (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **chain,
+		 Dwarf_Die *innermost)
+{
+  Dwarf_Die func;
+  Dwarf_Die *scopes;
+  int nscopes;
+  int i = 0;
+  if (innermost != NULL)
+    func = *innermost;
+  else
+    {
+      nscopes = dwarf_getscopes (cudie, pc, &scopes);
+      if (nscopes <= 0)
+	return nscopes;
+      while (i < nscopes && ! is_function (&scopes[i]))
+	i++;
+      if (i == nscopes)
+	{
+	  free (scopes);
+	  return 0;
+	}
+      func = scopes[i];
+      free (scopes);
+    }
+
+  nscopes = dwarf_getscopes_die (&func, &scopes);
+  if (nscopes <= 0)
+    return nscopes;
+  int n = 0;
+  for (i = 0; i < nscopes; i++)
+    if (is_function (&scopes[i]))
+      {
+	scopes[n++] = scopes[i];
+	if (dwarf_tag (&scopes[i]) == DW_TAG_subprogram)
+	  break;
+      }
+  *chain = scopes;
+  return n;
+}
+
+/* Whether the subprogram FUNC is declared in another function.  */
+static bool
+is_nested (Dwarf_Die *func)
+{
+  Dwarf_Die *scopes;
+  int nscopes = dwarf_getscopes_die (func, &scopes);
+  bool nested = false;
+  for (int i = 1; i < nscopes && ! nested; i++)
+    nested = is_function (&scopes[i]);
+  if (nscopes > 0)
+    free (scopes);
+  return nested;
+}
+
+/* Adapt to dwarf_getinlinechain for the benchmark.  */
+static int
+getscopes_bench (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **chain)
+{
+  return getscopes_chain (cudie, pc, chain, NULL);
+}
+
+struct addrs
+{
+  Dwarf_Die *cudies;
+  Dwarf_Addr *pcs;
+  size_t n;
+};
+
+static void
+collect_addrs (Dwarf *dbg, struct addrs *addrs)
+{
+  size_t alloc = 0;
+  addrs->cudies = NULL;
+  addrs->pcs = NULL;
+  addrs->n = 0;
+
+  Dwarf_Off off = 0, next;
+  size_t hsize;
+  while (dwarf_nextcu (dbg, off, &next, &hsize, NULL, NULL, NULL) == 0)
+    {
+      Dwarf_Die cudie;
+      Dwarf_Lines *lines;
+      size_t nlines;
+      if (dwarf_offdie (dbg, off + hsize, &cudie) != NULL
+	  && dwarf_getsrclines (&cudie, &lines, &nlines) == 0)
+	for (size_t i = 0; i < nlines; i++)
+	  {
+	    Dwarf_Addr pc;
+	    if (dwarf_lineaddr (dwarf_onesrcline (lines, i), &pc) != 0)
+	      continue;
+	    if (addrs->n == alloc)
+	      {
+		alloc = alloc * 2 ?: 1024;
+		addrs->cudies = realloc (addrs->cudies,
+					 alloc * sizeof addrs->cudies[0]);
+		addrs->pcs = realloc (addrs->pcs, alloc * sizeof addrs->pcs[0]);
+		if (addrs->cudies == NULL || addrs->pcs == NULL)
+		  error (EXIT_FAILURE, errno, "realloc");
+	      }
+	    addrs->cudies[addrs->n] = cudie;
+	    addrs->pcs[addrs->n++] = pc;
+	  }
+      off = next;
+    }
+}
+
+static void
+check (const char *file, const struct addrs *addrs)
+{
+  /* dwarf_getscopes is slow, check an even spread of the addresses of
+     large files.  */
+  size_t step = (addrs->n + MAXCHECK - 1) / MAXCHECK ?: 1;
+  size_t inlined = 0;
+  for (size_t i = 0; i < addrs->n; i += step)
+    {
+      Dwarf_Die *cudie = &addrs->cudies[i];
+      Dwarf_Addr pc = addrs->pcs[i];
+      Dwarf_Die *expected = NULL, *chain = NULL;
+      int nexpected = getscopes_chain (cudie, pc, &expected, NULL);
+      int n = dwarf_getinlinechain (cudie, pc, &chain);
+      /* dwarf_getscopes does not find a nested function outside of the
+	 ranges of the lexical block it is declared in, like GCC puts
+	 them.  */
+      if (nexpected == 0 && n > 0 && is_nested (&chain[n - 1]))
+	nexpected = getscopes_chain (cudie, pc, &expected, &chain[0]);
+      if (n != nexpected)
+	error (EXIT_FAILURE, 0, "%s: %#" PRIx64 ": %d functions, %d expected",
+	       file, pc, n, nexpected);
+      for (int j = 0; j < n; j++)
+	if (dwarf_dieoffset (&chain[j]) != dwarf_dieoffset (&expected[j]))
+	  error (EXIT_FAILURE, 0, "%s: %#" PRIx64 ": function %d at %#"
+		 PRIx64 ", expected at %#" PRIx64, file, pc, j,
+		 dwarf_dieoffset (&chain[j]), dwarf_dieoffset (&expected[j]));
+      if (n > 1)
+	inlined++;
+      free (chain);
+      free (expected);
+    }
+  printf ("%s: %zu addresses, %zu in inlined functions\n",
+	  file, addrs->n, inlined);
+}
+
+static double
+elapsed (const struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return ((end.tv_sec - start->tv_sec)
+	  + (end.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static void
+bench (const char *name, const struct addrs *addrs, size_t rounds,
+       int (*getchain) (Dwarf_Die *, Dwarf_Addr, Dwarf_Die **))
+{
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  size_t found = 0;
+  for (size_t r = 0; r < rounds; r++)
+    for (size_t i = 0; i < addrs->n; i++)
+      {
+	Dwarf_Die *chain = NULL;
+	if (getchain (&addrs->cudies[i], addrs->pcs[i], &chain) > 0)
+	  found++;
+	free (chain);
+      }
+  double secs = elapsed (&start);
+  fprintf (stderr, "  %s: %.6fs (%.0f lookups/s), %zu found\n",
+	   name, secs, rounds * addrs->n / secs, found / rounds);
+}
+
+int
+main (int argc, char *argv[])
+{
+  bool do_bench = argc == 4 && strcmp (argv[1], "--bench") == 0;
+  size_t rounds = do_bench ? strtoul (argv[2], NULL, 10) : 0;
+  for (int i = do_bench ? 3 : 1; i < argc; i++)
+    {
+      int fd = open (argv[i], O_RDONLY);
+      if (fd < 0)
+	error (EXIT_FAILURE, errno, "open %s", argv[i]);
+      Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	error (EXIT_FAILURE, 0, "dwarf_begin %s: %s", argv[i],
+	       dwarf_errmsg (-1));
+      /* The addresses in an unrelocated file do not identify anything.  */
+      GElf_Ehdr ehdr;
+      if (gelf_getehdr (dwarf_getelf (dbg), &ehdr) != NULL
+	  && ehdr.e_type == ET_REL)
+	{
+	  dwarf_end (dbg);
+	  close (fd);
+	  continue;
+	}
+      struct addrs addrs;
+      collect_addrs (dbg, &addrs);
+      if (do_bench)
+	{
+	  fprintf (stderr, "%s: %zu addresses, %zu rounds\n",
+		   argv[i], addrs.n, rounds);
+	  bench ("dwarf_getscopes", &addrs, rounds, getscopes_bench);
+	  bench ("dwarf_getinlinechain", &addrs, rounds,
+		 dwarf_getinlinechain);
+	}
+      else
+	check (argv[i], &addrs);
+      free (addrs.cudies);
+      free (addrs.pcs);
+      dwarf_end (dbg);
+      close (fd);
+    }
+
+  return 0;
+}
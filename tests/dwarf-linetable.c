@@ -0,0 +1,209 @@
+/* Test dwarf_getlinetable against dwarf_getsrclines.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Usage: dwarf-linetable FILE...
+   Checks for all units that the rows of the compact line table are
+   the same as the Dwarf_Lines, and that dwarf_linetable_lookup finds
+   the same rows as dwarf_getsrc_die.  Once getting the table first
+   and once getting the lines first.  */
+
+static int
+check_row (Dwarf_Line_Table *table, size_t idx, Dwarf_Line *line)
+{
+  Dwarf_Line_Row row;
+  if (dwarf_linetable_row (table, idx, &row) != 0)
+    {
+      printf ("row %zd: %s\n", idx, dwarf_errmsg (-1));
+      return -1;
+    }
+
+  Dwarf_Addr addr;
+  int lineno, col;
+  bool stmt, block, endseq, prologue, epilogue;
+  unsigned int op_index, isa, disc;
+  dwarf_lineaddr (line, &addr);
+  dwarf_lineno (line, &lineno);
+  dwarf_linecol (line, &col);
+  dwarf_linebeginstatement (line, &stmt);
+  dwarf_lineblock (line, &block);
+  dwarf_lineendsequence (line, &endseq);
+  dwarf_lineprologueend (line, &prologue);
+  dwarf_lineepiloguebegin (line, &epilogue);
+  dwarf_lineop_index (line, &op_index);
+  dwarf_lineisa (line, &isa);
+  dwarf_linediscriminator (line, &disc);
+  unsigned int flags = ((stmt ? DWARF_LINE_IS_STMT : 0)
+			| (block ? DWARF_LINE_BASIC_BLOCK : 0)
+			| (endseq ? DWARF_LINE_END_SEQUENCE : 0)
+			| (prologue ? DWARF_LINE_PROLOGUE_END : 0)
+			| (epilogue ? DWARF_LINE_EPILOGUE_BEGIN : 0));
+
+  const char *src = dwarf_linesrc (line, NULL, NULL);
+  const char *rowsrc = dwarf_filesrc (row.files, row.file, NULL, NULL);
+  if (row.addr != addr || row.line != lineno || (int) row.column != col
+      || row.flags != flags || row.op_index != op_index || row.isa != isa
+      || row.discriminator != disc || src == NULL || rowsrc == NULL
+      || strcmp (src, rowsrc) != 0
+      || dwarf_linetable_addrs (table)[idx] != addr)
+    {
+      printf ("row %zd: %#" PRIx64 " %s:%d differs from line %#" PRIx64
+	      " %s:%d\n", idx, row.addr, rowsrc, row.line, addr, src, lineno);
+      return -1;
+    }
+
+  return 0;
+}
+
+static int
+check_lookup (Dwarf_Die *cudie, Dwarf_Line_Table *table, Dwarf_Addr addr)
+{
+  Dwarf_Line *line = dwarf_getsrc_die (cudie, addr);
+  ptrdiff_t idx = dwarf_linetable_lookup (table, addr);
+  if (line == NULL && idx < 0)
+    return 0;
+
+  Dwarf_Line_Row row;
+  Dwarf_Addr lineaddr;
+  int lineno;
+  if (line == NULL || idx < 0
+      || dwarf_linetable_row (table, idx, &row) != 0
+      || dwarf_lineaddr (line, &lineaddr) != 0
+      || dwarf_lineno (line, &lineno) != 0
+      || row.addr != lineaddr || row.line != lineno)
+    {
+      printf ("lookup %#" PRIx64 ": row %td, line %p\n", addr, idx, line);
+      return -1;
+    }
+
+  return 0;
+}
+
+static int
+check_unit (Dwarf_Die *cudie, bool table_first, size_t *nrowsp)
+{
+  Dwarf_Line_Table *table;
+  size_t nrows;
+  Dwarf_Lines *lines;
+  size_t nlines;
+  int res;
+  if (table_first)
+    res = (dwarf_getlinetable (cudie, &table, &nrows)
+	   ?: dwarf_getsrclines (cudie, &lines, &nlines));
+  else
+    res = (dwarf_getsrclines (cudie, &lines, &nlines)
+	   ?: dwarf_getlinetable (cudie, &table, &nrows));
+  if (res != 0)
+    {
+      /* Units without a line table are fine, as long as both agree.  */
+      if (dwarf_getsrclines (cudie, &lines, &nlines) != 0
+	  && dwarf_getlinetable (cudie, &table, &nrows) != 0)
+	return 0;
+      printf ("unit [%" PRIx64 "]: %s\n", dwarf_dieoffset (cudie),
+	      dwarf_errmsg (-1));
+      return -1;
+    }
+
+  if (nrows != nlines)
+    {
+      printf ("unit [%" PRIx64 "]: %zd rows, %zd lines\n",
+	      dwarf_dieoffset (cudie), nrows, nlines);
+      return -1;
+    }
+
+  for (size_t i = 0; i < nrows; i++)
+    {
+      Dwarf_Line *line = dwarf_onesrcline (lines, i);
+      Dwarf_Addr addr;
+      if (check_row (table, i, line) != 0
+	  || dwarf_lineaddr (line, &addr) != 0
+	  || check_lookup (cudie, table, addr) != 0
+	  || check_lookup (cudie, table, addr - 1) != 0
+	  || check_lookup (cudie, table, addr + 1) != 0)
+	return -1;
+    }
+
+  *nrowsp += nrows;
+  return 0;
+}
+
+static int
+check_file (const char *file, bool table_first, size_t *nunits,
+	    size_t *nrows)
+{
+  int fd = open (file, O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", file, dwarf_errmsg (-1));
+      return -1;
+    }
+
+  int result = 0;
+  *nunits = 0;
+  *nrows = 0;
+  Dwarf_CU *cu = NULL;
+  Dwarf_Die cudie;
+  uint8_t unit_type;
+  while (result == 0
+	 && dwarf_get_units (dbg, cu, &cu, NULL, &unit_type,
+			     &cudie, NULL) == 0)
+    {
+      if (unit_type != DW_UT_compile && unit_type != DW_UT_skeleton
+	  && unit_type != DW_UT_partial)
+	continue;
+      (*nunits)++;
+      result = check_unit (&cudie, table_first, nrows);
+    }
+
+  dwarf_end (dbg);
+  close (fd);
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  for (int cnt = 1; cnt < argc; cnt++)
+    {
+      size_t nunits, nrows, nunits2, nrows2;
+      if (check_file (argv[cnt], true, &nunits, &nrows) != 0
+	  || check_file (argv[cnt], false, &nunits2, &nrows2) != 0)
+	{
+	  printf ("%s: failed\n", argv[cnt]);
+	  return -1;
+	}
+      printf ("%s: %zd units, %zd rows\n", argv[cnt], nunits, nrows);
+    }
+
+  return 0;
+}
@@ -0,0 +1,310 @@
+/* Test dwarf_set_memory_hint and dwarf_memory_stats.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HINT (1024 * 1024)
+
+static void
+read_dies (Dwarf_Die *die)
+{
+  Dwarf_Die cur = *die;
+  do
+    {
+      Dwarf_Attribute attr;
+      Dwarf_Op *expr;
+      size_t exprlen;
+      if (dwarf_attr (&cur, DW_AT_location, &attr) != NULL)
+	dwarf_getlocation (&attr, &expr, &exprlen);
+
+      Dwarf_Die child;
+      if (dwarf_child (&cur, &child) == 0)
+	read_dies (&child);
+    }
+  while (dwarf_siblingof (&cur, &cur) == 0);
+}
+
+/* Read the abbrevs, line table and location expressions of the unit
+   with its DIE at DIE_OFF, so libdw has to allocate some memory.  */
+static void
+read_unit (Dwarf *dbg, Dwarf_Off die_off)
+{
+  Dwarf_Die cudie;
+  if (dwarf_offdie (dbg, die_off, &cudie) != NULL)
+    {
+      Dwarf_Lines *lines;
+      size_t nlines;
+      dwarf_getsrclines (&cudie, &lines, &nlines);
+      read_dies (&cudie);
+    }
+}
+
+static void
+read_all (Dwarf *dbg)
+{
+  Dwarf_Off off = 0;
+  Dwarf_Off next;
+  size_t hsize;
+  while (dwarf_nextcu (dbg, off, &next, &hsize, NULL, NULL, NULL) == 0)
+    {
+      read_unit (dbg, off + hsize);
+      off = next;
+    }
+}
+
+struct read_arg
+{
+  Dwarf *dbg;
+  /* The unit DIE to read, or all units if ALL_UNITS.  */
+  Dwarf_Off die_off;
+};
+#define ALL_UNITS ((Dwarf_Off) -1)
+
+static void *
+read_thread (void *arg)
+{
+  struct read_arg *a = arg;
+  if (a->die_off == ALL_UNITS)
+    read_all (a->dbg);
+  else
+    read_unit (a->dbg, a->die_off);
+  return NULL;
+}
+
+static int
+run_thread (struct read_arg *arg)
+{
+  pthread_t thread;
+  if (pthread_create (&thread, NULL, read_thread, arg) != 0)
+    {
+      puts ("pthread_create failed");
+      return -1;
+    }
+  pthread_join (thread, NULL);
+  return 0;
+}
+
+/* Read all units in one thread, or each unit in a new thread that
+   exits before the next one starts, and return the memory reserved.
+   The blocks of a thread that exited are used by the next one, so
+   both should need the same.  */
+static int
+reserved_by_threads (int fd, bool thread_per_unit, size_t *reserved)
+{
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    return -1;
+
+  struct read_arg arg = { .dbg = dbg, .die_off = ALL_UNITS };
+  int res = 0;
+  if (! thread_per_unit)
+    res = run_thread (&arg);
+  else
+    {
+      Dwarf_Off off = 0;
+      Dwarf_Off next;
+      size_t hsize;
+      while (res == 0
+	     && dwarf_nextcu (dbg, off, &next, &hsize, NULL, NULL, NULL) == 0)
+	{
+	  arg.die_off = off + hsize;
+	  res = run_thread (&arg);
+	  off = next;
+	}
+    }
+
+  dwarf_memory_stats (dbg, reserved, NULL);
+  dwarf_end (dbg);
+  return res;
+}
+
+struct poll_arg
+{
+  struct read_arg read;
+  bool done;
+};
+
+static void *
+read_then_done (void *arg)
+{
+  struct poll_arg *a = arg;
+  read_thread (&a->read);
+  __atomic_store_n (&a->done, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/* Call dwarf_memory_stats over and over while another thread reads all
+   units.  Used memory must never exceed what is reserved, and neither
+   may go down.  */
+static int
+stats_while_reading (const char *file, int fd)
+{
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    return -1;
+
+  struct poll_arg arg = { .read = { .dbg = dbg, .die_off = ALL_UNITS } };
+  pthread_t thread;
+  if (pthread_create (&thread, NULL, read_then_done, &arg) != 0)
+    {
+      puts ("pthread_create failed");
+      return -1;
+    }
+
+  int res = 0;
+  size_t last_reserved = 0, last_used = 0;
+  bool done;
+  do
+    {
+      done = __atomic_load_n (&arg.done, __ATOMIC_ACQUIRE);
+      size_t reserved, used;
+      dwarf_memory_stats (dbg, &reserved, &used);
+      if (used > reserved || used < last_used || reserved < last_reserved)
+	{
+	  printf ("%s: bad stats while reading, reserved %zd -> %zd,"
+		  " used %zd -> %zd\n", file, last_reserved, reserved,
+		  last_used, used);
+	  res = -1;
+	}
+      last_reserved = reserved;
+      last_used = used;
+    }
+  while (res == 0 && ! done);
+
+  pthread_join (thread, NULL);
+  dwarf_end (dbg);
+  return res;
+}
+
+static int
+check (const char *file, int fd, size_t hint, unsigned int flags,
+       size_t *used_out)
+{
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", file, dwarf_errmsg (-1));
+      return -1;
+    }
+
+  if (hint != 0 && dwarf_set_memory_hint (dbg, hint, flags) != 0)
+    {
+      printf ("%s: dwarf_set_memory_hint failed: %s\n", file,
+	      dwarf_errmsg (-1));
+      return -1;
+    }
+
+  size_t reserved_before, used_before;
+  if (dwarf_memory_stats (dbg, &reserved_before, &used_before) != 0)
+    {
+      printf ("%s: dwarf_memory_stats failed\n", file);
+      return -1;
+    }
+
+  read_all (dbg);
+
+  size_t reserved, used;
+  dwarf_memory_stats (dbg, &reserved, &used);
+  if (used > reserved || used < used_before || reserved < reserved_before)
+    {
+      printf ("%s: bad stats, reserved %zd -> %zd, used %zd -> %zd\n",
+	      file, reserved_before, reserved, used_before, used);
+      return -1;
+    }
+
+  /* Everything fit in the first block, which was allocated before
+     the hint.  Otherwise the next block must be at least HINT.  */
+  if (hint != 0 && used > reserved_before && reserved < hint)
+    {
+      printf ("%s: hint %zd ignored, reserved %zd\n", file, hint, reserved);
+      return -1;
+    }
+
+  *used_out = used;
+  dwarf_end (dbg);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  for (int cnt = 1; cnt < argc; cnt++)
+    {
+      int fd = open (argv[cnt], O_RDONLY);
+      Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	{
+	  printf ("%s not usable: %s\n", argv[cnt], dwarf_errmsg (-1));
+	  return -1;
+	}
+      if (dwarf_set_memory_hint (dbg, HINT, ~0U) == 0)
+	{
+	  printf ("%s: unknown flags accepted\n", argv[cnt]);
+	  return -1;
+	}
+      dwarf_end (dbg);
+
+      /* The same data gets allocated no matter how the blocks are
+	 sized, only the alignment padding might differ a bit.  */
+      size_t used, used_hint, used_huge;
+      if (check (argv[cnt], fd, 0, 0, &used) != 0
+	  || check (argv[cnt], fd, HINT, 0, &used_hint) != 0
+	  || check (argv[cnt], fd, 4 * HINT, DWARF_MEM_HUGEPAGES,
+		    &used_huge) != 0)
+	return -1;
+
+      if (used_hint > used + used / 8 || used_hint + used / 8 < used
+	  || used_huge > used + used / 8 || used_huge + used / 8 < used)
+	{
+	  printf ("%s: used differs: %zd, %zd, %zd\n", argv[cnt],
+		  used, used_hint, used_huge);
+	  return -1;
+	}
+
+      size_t reserved_one, reserved_many;
+      if (reserved_by_threads (fd, false, &reserved_one) != 0
+	  || reserved_by_threads (fd, true, &reserved_many) != 0)
+	return -1;
+      if (reserved_one != reserved_many)
+	{
+	  printf ("%s: one thread reserved %zd, a thread per unit %zd\n",
+		  argv[cnt], reserved_one, reserved_many);
+	  return -1;
+	}
+
+      if (stats_while_reading (argv[cnt], fd) != 0)
+	return -1;
+
+      printf ("%s: ok\n", argv[cnt]);
+      close (fd);
+    }
+
+  return 0;
+}
@@ -0,0 +1,277 @@
+/* Test (and time) the .debug_names name index.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Usage: dwarf-names FILE [NAME...]
+   Prints all index entries of FILE, checking they describe the DIE
+   they point to, then looks up each NAME.
+
+   Usage: dwarf-names --bench N FILE
+   Looks up all function names N times, once with dwarf_names_lookup
+   and once by scanning all units with dwarf_getfuncs.  */
+
+static int
+check_entry (Dwarf *dbg, Dwarf_Name *entry)
+{
+  Dwarf_Die die;
+  Dwarf_Die cudie;
+  if (dwarf_offdie (dbg, entry->die_offset, &die) == NULL
+      || dwarf_diecu (&die, &cudie, NULL, NULL) == NULL)
+    {
+      printf ("bad DIE offset %" PRIx64 " for %s\n", entry->die_offset,
+	      entry->name);
+      return -1;
+    }
+
+  const char *name = dwarf_diename (&die);
+  if ((unsigned int) dwarf_tag (&die) != entry->tag
+      || name == NULL || strcmp (name, entry->name) != 0
+      || dwarf_dieoffset (&cudie) != entry->cu_offset)
+    {
+      printf ("DIE %" PRIx64 " doesn't match %s\n", entry->die_offset,
+	      entry->name);
+      return -1;
+    }
+
+  return 0;
+}
+
+static int
+print_entry (Dwarf *dbg, Dwarf_Name *entry, void *arg)
+{
+  int *result = arg;
+  printf (" [%" PRIx64 "] %s tag 0x%x cu [%" PRIx64 "]\n",
+	  entry->die_offset, entry->name, entry->tag, entry->cu_offset);
+  if (check_entry (dbg, entry) != 0)
+    *result = -1;
+  return DWARF_CB_OK;
+}
+
+static int
+abort_entry (Dwarf *dbg __attribute__ ((unused)), Dwarf_Name *entry,
+	     void *arg)
+{
+  const char **name = arg;
+  *name = entry->name;
+  return DWARF_CB_ABORT;
+}
+
+/* Benchmark support.  */
+
+static const char **funcs;
+static size_t nfuncs;
+static size_t afuncs;
+
+static int
+collect_func (Dwarf_Die *die, void *arg __attribute__ ((unused)))
+{
+  const char *name = dwarf_diename (die);
+  if (name == NULL)
+    return DWARF_CB_OK;
+
+  if (nfuncs == afuncs)
+    {
+      afuncs = afuncs == 0 ? 256 : 2 * afuncs;
+      funcs = realloc (funcs, afuncs * sizeof (const char *));
+      if (funcs == NULL)
+	{
+	  puts ("out of memory");
+	  exit (-1);
+	}
+    }
+  funcs[nfuncs++] = name;
+  return DWARF_CB_OK;
+}
+
+struct scan_arg
+{
+  const char *name;
+  Dwarf_Off found;
+};
+
+static int
+scan_func (Dwarf_Die *die, void *arg)
+{
+  struct scan_arg *scan = arg;
+  const char *name = dwarf_diename (die);
+  if (name != NULL && strcmp (name, scan->name) == 0)
+    {
+      scan->found = dwarf_dieoffset (die);
+      return DWARF_CB_ABORT;
+    }
+  return DWARF_CB_OK;
+}
+
+static Dwarf_Off
+scan_lookup (Dwarf *dbg, const char *name)
+{
+  struct scan_arg scan = { .name = name, .found = (Dwarf_Off) -1 };
+  Dwarf_Off off = 0;
+  Dwarf_Off next;
+  size_t hsize;
+  while (scan.found == (Dwarf_Off) -1
+	 && dwarf_nextcu (dbg, off, &next, &hsize, NULL, NULL, NULL) == 0)
+    {
+      Dwarf_Die cudie;
+      if (dwarf_offdie (dbg, off + hsize, &cudie) != NULL)
+	dwarf_getfuncs (&cudie, scan_func, &scan, 0);
+      off = next;
+    }
+  return scan.found;
+}
+
+static int
+index_func (Dwarf *dbg __attribute__ ((unused)), Dwarf_Name *entry,
+	    void *arg)
+{
+  if (entry->tag != DW_TAG_subprogram)
+    return DWARF_CB_OK;
+  *(Dwarf_Off *) arg = entry->die_offset;
+  return DWARF_CB_ABORT;
+}
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return ((end.tv_sec - start->tv_sec)
+	  + (end.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static int
+bench (Dwarf *dbg, const char *file, size_t rounds)
+{
+  Dwarf_Off off = 0;
+  Dwarf_Off next;
+  size_t hsize;
+  while (dwarf_nextcu (dbg, off, &next, &hsize, NULL, NULL, NULL) == 0)
+    {
+      Dwarf_Die cudie;
+      if (dwarf_offdie (dbg, off + hsize, &cudie) != NULL)
+	dwarf_getfuncs (&cudie, collect_func, NULL, 0);
+      off = next;
+    }
+
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (size_t r = 0; r < rounds; r++)
+    for (size_t i = 0; i < nfuncs; i++)
+      {
+	Dwarf_Off found = (Dwarf_Off) -1;
+	if (dwarf_names_lookup (dbg, funcs[i], index_func, &found) < 0)
+	  {
+	    printf ("%s: lookup failed: %s\n", funcs[i], dwarf_errmsg (-1));
+	    return -1;
+	  }
+      }
+  double index_secs = elapsed (&start);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (size_t r = 0; r < rounds; r++)
+    for (size_t i = 0; i < nfuncs; i++)
+      scan_lookup (dbg, funcs[i]);
+  double scan_secs = elapsed (&start);
+
+  fprintf (stderr, "%s: %zd functions, %zd rounds\n", file, nfuncs, rounds);
+  fprintf (stderr, "  .debug_names: %.6fs (%.0f lookups/s)\n", index_secs,
+	   rounds * nfuncs / index_secs);
+  fprintf (stderr, "  dwarf_getfuncs: %.6fs (%.0f lookups/s)\n", scan_secs,
+	   rounds * nfuncs / scan_secs);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  size_t rounds = 0;
+  int cnt = 1;
+  if (argc > 3 && strcmp (argv[1], "--bench") == 0)
+    {
+      rounds = strtoul (argv[2], NULL, 10);
+      cnt = 3;
+    }
+
+  if (cnt >= argc)
+    {
+      puts ("no file given");
+      return -1;
+    }
+
+  const char *file = argv[cnt++];
+  int fd = open (file, O_RDONLY);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", file, dwarf_errmsg (-1));
+      return -1;
+    }
+
+  int result = 0;
+  if (rounds > 0)
+    result = bench (dbg, file, rounds);
+  else
+    {
+      printf ("file: %s\n", file);
+      ptrdiff_t res = dwarf_getnames (dbg, print_entry, &result, 0);
+      if (res != 0)
+	{
+	  printf ("dwarf_getnames: %s\n", dwarf_errmsg (-1));
+	  result = -1;
+	}
+
+      /* Continue after the second name.  */
+      const char *name = NULL;
+      res = dwarf_getnames (dbg, abort_entry, &name, 0);
+      res = dwarf_getnames (dbg, abort_entry, &name, res);
+      printf ("second: %s\n", res > 0 ? name : "(none)");
+
+      for (; cnt < argc; cnt++)
+	{
+	  printf ("lookup: %s\n", argv[cnt]);
+	  int found = dwarf_names_lookup (dbg, argv[cnt], print_entry,
+					  &result);
+	  if (found < 0)
+	    {
+	      printf ("dwarf_names_lookup: %s\n", dwarf_errmsg (-1));
+	      result = -1;
+	    }
+	  else if (found == 0)
+	    printf (" not found\n");
+	}
+    }
+
+  dwarf_end (dbg);
+  close (fd);
+  free (funcs);
+  return result;
+}
@@ -0,0 +1,202 @@
+/* Test (and time) dwarf_offdie lookups of random DIE offsets.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Resolving a DW_FORM_ref_addr (or any other cross unit reference)
+   means finding the unit containing an arbitrary .debug_info offset.
+   Collect all DIE offsets, then look them up in a (deterministic)
+   random order, both on a fresh Dwarf that still has to read the
+   units and on one that already knows them all.  With --bench the
+   lookups are repeated and timed.  */
+
+struct die_ref
+{
+  Dwarf_Off die_off;
+  Dwarf_Off cu_off;	/* Offset of the CU DIE.  */
+};
+
+static struct die_ref *refs;
+static size_t nrefs;
+static size_t arefs;
+
+static void
+add_ref (Dwarf_Off die_off, Dwarf_Off cu_off)
+{
+  if (nrefs == arefs)
+    {
+      arefs = arefs == 0 ? 1024 : 2 * arefs;
+      refs = realloc (refs, arefs * sizeof (struct die_ref));
+      if (refs == NULL)
+	{
+	  puts ("out of memory");
+	  exit (-1);
+	}
+    }
+  refs[nrefs].die_off = die_off;
+  refs[nrefs].cu_off = cu_off;
+  nrefs++;
+}
+
+static void
+collect_dies (Dwarf_Die *die, Dwarf_Off cu_off)
+{
+  Dwarf_Die cur = *die;
+  do
+    {
+      add_ref (dwarf_dieoffset (&cur), cu_off);
+
+      Dwarf_Die child;
+      if (dwarf_child (&cur, &child) == 0)
+	collect_dies (&child, cu_off);
+    }
+  while (dwarf_siblingof (&cur, &cur) == 0);
+}
+
+/* Simple LCG, we want the same sequence everywhere.  */
+static uint64_t rnd_state;
+
+static size_t
+next_random (size_t n)
+{
+  rnd_state = rnd_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (size_t) ((rnd_state >> 33) % n);
+}
+
+static int
+lookup_random (Dwarf *dbg, size_t count, const char *what)
+{
+  for (size_t i = 0; i < count; i++)
+    {
+      struct die_ref *ref = &refs[next_random (nrefs)];
+      Dwarf_Die die;
+      if (dwarf_offdie (dbg, ref->die_off, &die) == NULL)
+	{
+	  printf ("%s: dwarf_offdie %" PRIx64 " failed: %s\n",
+		  what, ref->die_off, dwarf_errmsg (-1));
+	  return -1;
+	}
+
+      Dwarf_Die cudie;
+      if (dwarf_diecu (&die, &cudie, NULL, NULL) == NULL
+	  || dwarf_dieoffset (&die) != ref->die_off
+	  || dwarf_dieoffset (&cudie) != ref->cu_off)
+	{
+	  printf ("%s: bad DIE for offset %" PRIx64 "\n", what, ref->die_off);
+	  return -1;
+	}
+    }
+
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = 1;
+  size_t bench = 0;
+  if (argc > 2 && strcmp (argv[1], "--bench") == 0)
+    {
+      bench = strtoul (argv[2], NULL, 10);
+      cnt = 3;
+    }
+
+  for (; cnt < argc; cnt++)
+    {
+      int fd = open (argv[cnt], O_RDONLY);
+      Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	{
+	  printf ("%s not usable: %s\n", argv[cnt], dwarf_errmsg (-1));
+	  return -1;
+	}
+
+      /* Only real .debug_info units, dwarf_offdie doesn't find
+	 .debug_types units.  */
+      nrefs = 0;
+      size_t nunits = 0;
+      Dwarf_Off off = 0;
+      Dwarf_Off next;
+      size_t hsize;
+      while (dwarf_next_unit (dbg, off, &next, &hsize, NULL, NULL, NULL,
+			      NULL, NULL, NULL) == 0)
+	{
+	  Dwarf_Die cudie;
+	  if (dwarf_offdie (dbg, off + hsize, &cudie) != NULL)
+	    {
+	      nunits++;
+	      collect_dies (&cudie, off + hsize);
+	    }
+	  off = next;
+	}
+      dwarf_end (dbg);
+
+      if (nrefs == 0)
+	{
+	  printf ("%s: no DIEs\n", argv[cnt]);
+	  return -1;
+	}
+
+      printf ("file: %s\n", argv[cnt]);
+      printf ("units: %zd, dies: %zd\n", nunits, nrefs);
+
+      /* A fresh Dwarf has to read units on demand.  */
+      rnd_state = 42;
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (lookup_random (dbg, nrefs, "cold") != 0)
+	return -1;
+
+      /* Now all units should be known.  */
+      if (lookup_random (dbg, nrefs, "warm") != 0)
+	return -1;
+
+      if (bench > 0)
+	{
+	  struct timespec start, end;
+	  clock_gettime (CLOCK_MONOTONIC, &start);
+	  if (lookup_random (dbg, bench, "bench") != 0)
+	    return -1;
+	  clock_gettime (CLOCK_MONOTONIC, &end);
+	  double secs = ((end.tv_sec - start.tv_sec)
+			 + (end.tv_nsec - start.tv_nsec) / 1e9);
+	  fprintf (stderr, "%s: %zd lookups in %.3fs, %.0f lookups/s\n",
+		   argv[cnt], bench, secs, bench / secs);
+	}
+
+      printf ("lookups: ok\n\n");
+
+      dwarf_end (dbg);
+      close (fd);
+    }
+
+  free (refs);
+  return 0;
+}
@@ -0,0 +1,157 @@
+/* Test address lookups without (complete) .debug_aranges.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+#include ELFUTILS_HEADER(dwfl)
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Usage: dwarf-synth-aranges REF FILE
+   REF has a complete .debug_aranges, FILE has the same DWARF but no
+   or an incomplete .debug_aranges.  Looks up the first and last
+   address of each range of REF in FILE, with dwarf_addrdie and
+   dwfl_module_addrdie, before reading all ranges of FILE with
+   dwarf_getaranges.  */
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+static Dwarf *
+open_dwarf (const char *file, int *fd)
+{
+  *fd = open (file, O_RDONLY);
+  Dwarf *dbg = dwarf_begin (*fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      printf ("%s not usable: %s\n", file, dwarf_errmsg (-1));
+      exit (-1);
+    }
+  return dbg;
+}
+
+static int
+check_addr (Dwarf *dbg, Dwfl_Module *mod, Dwarf_Addr addr, Dwarf_Off off)
+{
+  Dwarf_Die die;
+  if (dwarf_addrdie (dbg, addr, &die) == NULL)
+    {
+      printf ("addr %#" PRIx64 ": %s\n", addr, dwarf_errmsg (-1));
+      return -1;
+    }
+  if (dwarf_dieoffset (&die) != off)
+    {
+      printf ("addr %#" PRIx64 ": cu [%" PRIx64 "] expected [%" PRIx64 "]\n",
+	      addr, dwarf_dieoffset (&die), off);
+      return -1;
+    }
+
+  Dwarf_Addr bias;
+  Dwarf_Die *cudie = dwfl_module_addrdie (mod, addr, &bias);
+  if (cudie == NULL || dwarf_dieoffset (cudie) != off)
+    {
+      printf ("addr %#" PRIx64 ": dwfl_module_addrdie %s\n", addr,
+	      cudie == NULL ? dwfl_errmsg (-1) : "wrong cu");
+      return -1;
+    }
+
+  printf ("addr %#" PRIx64 ": cu [%" PRIx64 "]\n", addr, off);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      puts ("usage: dwarf-synth-aranges REF FILE");
+      return -1;
+    }
+
+  int ref_fd;
+  Dwarf *ref = open_dwarf (argv[1], &ref_fd);
+  Dwarf_Aranges *ref_aranges;
+  size_t ref_naranges;
+  if (dwarf_getaranges (ref, &ref_aranges, &ref_naranges) != 0)
+    {
+      printf ("%s: dwarf_getaranges: %s\n", argv[1], dwarf_errmsg (-1));
+      return -1;
+    }
+
+  int fd;
+  Dwarf *dbg = open_dwarf (argv[2], &fd);
+
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, argv[2], argv[2], -1);
+  if (mod == NULL || dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("%s: dwfl_report_offline: %s\n", argv[2], dwfl_errmsg (-1));
+      return -1;
+    }
+
+  int result = 0;
+  for (size_t i = 0; i < ref_naranges; i++)
+    {
+      Dwarf_Addr start;
+      Dwarf_Word length;
+      Dwarf_Off off;
+      dwarf_getarangeinfo (dwarf_onearange (ref_aranges, i), &start, &length,
+			   &off);
+      if (check_addr (dbg, mod, start, off) != 0
+	  || check_addr (dbg, mod, start + length - 1, off) != 0)
+	result = -1;
+    }
+
+  Dwarf_Aranges *aranges;
+  size_t naranges;
+  if (dwarf_getaranges (dbg, &aranges, &naranges) != 0)
+    {
+      printf ("%s: dwarf_getaranges: %s\n", argv[2], dwarf_errmsg (-1));
+      return -1;
+    }
+
+  printf ("aranges: %zd\n", naranges);
+  for (size_t i = 0; i < naranges; i++)
+    {
+      Dwarf_Addr start;
+      Dwarf_Word length;
+      Dwarf_Off off;
+      dwarf_getarangeinfo (dwarf_onearange (aranges, i), &start, &length,
+			   &off);
+      printf (" %#" PRIx64 " +%#" PRIx64 " die [%" PRIx64 "]\n",
+	      start, length, off);
+    }
+
+  dwfl_end (dwfl);
+  dwarf_end (dbg);
+  dwarf_end (ref);
+  close (fd);
+  close (ref_fd);
+  return result;
+}
@@ -0,0 +1,296 @@
+/* Test dwfl_module_addrinfo_batch against dwfl_module_addrinfo.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dwfl)
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Usage: dwfl-addrsym-batch FILE...
+   Collects the start, middle and end of every symbol of each FILE,
+   plus the addresses right before them, and looks them all up with
+   dwfl_module_addrinfo_batch, in sorted and in reverse order.  Each
+   result must match what dwfl_module_addrinfo returns.
+
+   Usage: dwfl-addrsym-batch --bench N FILE
+   Looks up the same addresses N times, one by one with
+   dwfl_module_addrinfo, with dwfl_module_addrinfo_batch, and by
+   going through all symbols with dwfl_module_getsym_info for each
+   address, which is what dwfl_module_addrinfo did without an
+   index.  */
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+static GElf_Addr *addrs;
+static size_t naddrs;
+static size_t addrs_alloc;
+
+static void
+add_addr (GElf_Addr addr)
+{
+  if (naddrs == addrs_alloc)
+    {
+      addrs_alloc = addrs_alloc == 0 ? 64 : addrs_alloc * 2;
+      addrs = realloc (addrs, addrs_alloc * sizeof addrs[0]);
+      if (addrs == NULL)
+	{
+	  puts ("out of memory");
+	  exit (-1);
+	}
+    }
+  addrs[naddrs++] = addr;
+}
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  GElf_Addr x = *(const GElf_Addr *) a;
+  GElf_Addr y = *(const GElf_Addr *) b;
+  return x < y ? -1 : x > y;
+}
+
+static int
+check_batch (Dwfl_Module *mod, const char *file, const char *order,
+	     ptrdiff_t *found)
+{
+  const char **names = malloc (naddrs * sizeof names[0]);
+  GElf_Off *offsets = malloc (naddrs * sizeof offsets[0]);
+  GElf_Sym *syms = malloc (naddrs * sizeof syms[0]);
+  if (names == NULL || offsets == NULL || syms == NULL)
+    {
+      puts ("out of memory");
+      exit (-1);
+    }
+
+  int result = 0;
+  *found = dwfl_module_addrinfo_batch (mod, addrs, naddrs, names,
+				       offsets, syms);
+  if (*found < 0)
+    {
+      printf ("%s: dwfl_module_addrinfo_batch: %s\n", file,
+	      dwfl_errmsg (-1));
+      result = -1;
+    }
+
+  ptrdiff_t count = 0;
+  for (size_t i = 0; result == 0 && i < naddrs; i++)
+    {
+      GElf_Off off;
+      GElf_Sym sym;
+      const char *name = dwfl_module_addrinfo (mod, addrs[i], &off, &sym,
+					       NULL, NULL, NULL);
+      if (name != names[i]
+	  || (name != NULL
+	      && (off != offsets[i]
+		  || memcmp (&sym, &syms[i], sizeof sym) != 0)))
+	{
+	  printf ("%s: %s addr %#" PRIx64 ": batch %s+%#" PRIx64
+		  ", single %s+%#" PRIx64 "\n", file, order, addrs[i],
+		  names[i] ?: "(none)", offsets[i], name ?: "(none)", off);
+	  result = -1;
+	}
+      count += name != NULL;
+    }
+
+  if (result == 0 && count != *found)
+    {
+      printf ("%s: %s found %td, expected %td\n", file, order, *found, count);
+      result = -1;
+    }
+
+  free (names);
+  free (offsets);
+  free (syms);
+  return result;
+}
+
+static double
+elapsed (struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return ((end.tv_sec - start->tv_sec)
+	  + (end.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+/* Find the closest sized symbol containing ADDR by going through the
+   whole symbol table.  */
+static const char *
+scan_lookup (Dwfl_Module *mod, int nsyms, GElf_Addr addr)
+{
+  const char *closest = NULL;
+  GElf_Addr closest_value = 0;
+  for (int i = 1; i < nsyms; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      const char *name = dwfl_module_getsym_info (mod, i, &sym, &value,
+						  NULL, NULL, NULL);
+      if (name != NULL && value <= addr && addr - value < sym.st_size
+	  && (closest == NULL || value > closest_value))
+	{
+	  closest = name;
+	  closest_value = value;
+	}
+    }
+  return closest;
+}
+
+static int
+bench (Dwfl_Module *mod, const char *file, size_t rounds)
+{
+  const char **names = malloc (naddrs * sizeof names[0]);
+  if (names == NULL)
+    {
+      puts ("out of memory");
+      return -1;
+    }
+
+  /* The first lookup builds the index.  */
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  GElf_Off off;
+  GElf_Sym sym;
+  dwfl_module_addrinfo (mod, addrs[0], &off, &sym, NULL, NULL, NULL);
+  double build_secs = elapsed (&start);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (size_t r = 0; r < rounds; r++)
+    for (size_t i = 0; i < naddrs; i++)
+      dwfl_module_addrinfo (mod, addrs[i], &off, &sym, NULL, NULL, NULL);
+  double single_secs = elapsed (&start);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (size_t r = 0; r < rounds; r++)
+    dwfl_module_addrinfo_batch (mod, addrs, naddrs, names, NULL, NULL);
+  double batch_secs = elapsed (&start);
+
+  /* Going through all symbols is slow, one round is enough.  */
+  int nsyms = dwfl_module_getsymtab (mod);
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < naddrs; i++)
+    scan_lookup (mod, nsyms, addrs[i]);
+  double scan_secs = elapsed (&start);
+
+  fprintf (stderr, "%s: %d symbols, %zd addresses, %zd rounds\n",
+	   file, nsyms, naddrs, rounds);
+  fprintf (stderr, "  index: %.6fs\n", build_secs);
+  fprintf (stderr, "  dwfl_module_addrinfo: %.6fs (%.0f lookups/s)\n",
+	   single_secs, rounds * naddrs / single_secs);
+  fprintf (stderr, "  dwfl_module_addrinfo_batch: %.6fs (%.0f lookups/s)\n",
+	   batch_secs, rounds * naddrs / batch_secs);
+  fprintf (stderr, "  symbol table scan: %.6fs (%.0f lookups/s)\n",
+	   scan_secs, naddrs / scan_secs);
+
+  free (names);
+  return 0;
+}
+
+static int
+handle_file (const char *file, size_t rounds)
+{
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, file, file, -1);
+  if (mod == NULL || dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("%s: dwfl_report_offline: %s\n", file, dwfl_errmsg (-1));
+      dwfl_end (dwfl);
+      return -1;
+    }
+
+  int nsyms = dwfl_module_getsymtab (mod);
+  if (nsyms < 0)
+    {
+      printf ("%s: dwfl_module_getsymtab: %s\n", file, dwfl_errmsg (-1));
+      dwfl_end (dwfl);
+      return -1;
+    }
+
+  naddrs = 0;
+  add_addr (0);
+  add_addr ((GElf_Addr) -1);
+  for (int i = 1; i < nsyms; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      if (dwfl_module_getsym_info (mod, i, &sym, &value,
+				   NULL, NULL, NULL) == NULL)
+	continue;
+      add_addr (value - 1);
+      add_addr (value);
+      if (sym.st_size > 1)
+	add_addr (value + sym.st_size / 2);
+      add_addr (value + sym.st_size);
+    }
+  qsort (addrs, naddrs, sizeof addrs[0], compare_addr);
+
+  int result = 0;
+  if (rounds > 0)
+    result = bench (mod, file, rounds);
+  else
+    {
+      ptrdiff_t found;
+      result = check_batch (mod, file, "sorted", &found);
+
+      for (size_t i = 0; i < naddrs / 2; i++)
+	{
+	  GElf_Addr addr = addrs[i];
+	  addrs[i] = addrs[naddrs - 1 - i];
+	  addrs[naddrs - 1 - i] = addr;
+	}
+      ptrdiff_t rfound;
+      if (result == 0)
+	result = check_batch (mod, file, "reversed", &rfound);
+
+      if (result == 0)
+	printf ("%s: %d symbols, %zd addresses, %td found\n",
+		file, nsyms, naddrs, found);
+    }
+
+  dwfl_end (dwfl);
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  size_t rounds = 0;
+  int cnt = 1;
+  if (argc > 3 && strcmp (argv[1], "--bench") == 0)
+    {
+      rounds = strtoul (argv[2], NULL, 10);
+      cnt = 3;
+    }
+
+  int result = 0;
+  for (; cnt < argc; cnt++)
+    if (handle_file (argv[cnt], rounds) != 0)
+      result = 1;
+
+  free (addrs);
+  return result;
+}
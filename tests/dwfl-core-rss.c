@@ -0,0 +1,423 @@
+/* Test that reporting and unwinding a large core file stays small.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <argp.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <gelf.h>
+#if USE_ZSTD
+# include <zstd.h>
+#endif
+
+/* Usage: dwfl-core-rss --create CORE OUT
+   Writes OUT, a copy of the 64-bit CORE with an extra PT_LOAD segment
+   of BIG_SIZE bytes.  The segment is a hole in the file, except for
+   the headers of a module without build ID at its start.  It claims
+   to be all file contents, but its section headers are missing.
+
+   Usage: dwfl-core-rss --zstd FRAME_SIZE IN OUT
+   Compresses IN to OUT in the zstd seekable format, one frame for
+   each FRAME_SIZE bytes.
+
+   Usage: dwfl-core-rss [--mmap|--argp] EXEC CORE
+   Reports the modules of CORE, with EXEC as the executable, and
+   unwinds all its threads ROUNDS times.  Checks the peak resident set
+   size grew by less than MAX_GROWTH while doing so.  With --argp CORE
+   is opened by dwfl_standard_argp, so it can be compressed.  */
+
+#define BIG_SIZE (256 << 20)
+#define MAX_GROWTH (32 << 20)
+#define ROUNDS 100
+
+static const char soname[] = "\0libbig.so";
+
+static void
+xpwrite (int fd, const void *buf, size_t size, off_t offset)
+{
+  if (pwrite (fd, buf, size, offset) != (ssize_t) size)
+    error (EXIT_FAILURE, errno, "pwrite");
+}
+
+/* Write the SIZE bytes at HOST of TYPE at OFFSET, in ENCODING.  */
+static void
+write_xlate (int fd, void *host, size_t size, Elf_Type type,
+	     unsigned char encoding, off_t offset)
+{
+  char *file = malloc (size);
+  if (file == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  Elf_Data src = { .d_buf = host, .d_size = size, .d_type = type,
+		   .d_version = EV_CURRENT };
+  Elf_Data dst = { .d_buf = file, .d_size = size, .d_type = type,
+		   .d_version = EV_CURRENT };
+  if (elf64_xlatetof (&dst, &src, encoding) == NULL)
+    error (EXIT_FAILURE, 0, "elf64_xlatetof: %s", elf_errmsg (-1));
+  xpwrite (fd, file, size, offset);
+  free (file);
+}
+
+static void
+create (const char *core_name, const char *out_name)
+{
+  int fd = open (core_name, O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", core_name);
+  Elf *core = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (core == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  if (gelf_getclass (core) != ELFCLASS64)
+    error (EXIT_FAILURE, 0, "%s: not a 64-bit core file", core_name);
+  size_t size;
+  char *contents = elf_rawfile (core, &size);
+  if (contents == NULL)
+    error (EXIT_FAILURE, 0, "elf_rawfile: %s", elf_errmsg (-1));
+  Elf64_Ehdr *ehdr = elf64_getehdr (core);
+  if (ehdr == NULL)
+    error (EXIT_FAILURE, 0, "elf64_getehdr: %s", elf_errmsg (-1));
+  unsigned char encoding = ehdr->e_ident[EI_DATA];
+  Elf64_Phdr *old_phdrs = elf64_getphdr (core);
+  if (old_phdrs == NULL)
+    error (EXIT_FAILURE, 0, "elf64_getphdr: %s", elf_errmsg (-1));
+
+  /* The old contents stay where they are, the new program headers
+     follow them and the new segment follows those.  */
+  size_t phnum = ehdr->e_phnum + 1;
+  Elf64_Phdr *phdrs = malloc (phnum * sizeof phdrs[0]);
+  if (phdrs == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  memcpy (phdrs, old_phdrs, (phnum - 1) * sizeof phdrs[0]);
+
+  /* Put the segment in the first gap big enough after a PT_LOAD,
+     keeping the PT_LOADs sorted by address.  */
+  size_t ndx = phnum;
+  Elf64_Addr vaddr = 0;
+  for (size_t i = 0; i < phnum - 1 && ndx == phnum; i++)
+    if (phdrs[i].p_type == PT_LOAD)
+      {
+	vaddr = (phdrs[i].p_vaddr + phdrs[i].p_memsz + 0xfff) & -0x1000;
+	size_t j = i + 1;
+	while (j < phnum - 1 && phdrs[j].p_type != PT_LOAD)
+	  j++;
+	if (vaddr + BIG_SIZE > vaddr
+	    && (j == phnum - 1 || phdrs[j].p_vaddr >= vaddr + BIG_SIZE))
+	  ndx = i + 1;
+      }
+  if (ndx == phnum)
+    error (EXIT_FAILURE, 0, "%s: no room for another segment", core_name);
+  memmove (&phdrs[ndx + 1], &phdrs[ndx],
+	   (phnum - 1 - ndx) * sizeof phdrs[0]);
+
+  Elf64_Off phoff = (size + 7) & -8;
+  Elf64_Off offset = (phoff + phnum * sizeof phdrs[0] + 0xfff) & -0x1000;
+  phdrs[ndx] = (Elf64_Phdr)
+    {
+      .p_type = PT_LOAD, .p_flags = PF_R, .p_offset = offset,
+      .p_vaddr = vaddr, .p_filesz = BIG_SIZE, .p_memsz = BIG_SIZE,
+      .p_align = 0x1000
+    };
+
+  int out = open (out_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (out < 0)
+    error (EXIT_FAILURE, errno, "open %s", out_name);
+  xpwrite (out, contents, size, 0);
+  Elf64_Ehdr new_ehdr = *ehdr;
+  new_ehdr.e_phoff = phoff;
+  new_ehdr.e_phnum = phnum;
+  write_xlate (out, &new_ehdr, sizeof new_ehdr, ELF_T_EHDR, encoding, 0);
+  write_xlate (out, phdrs, phnum * sizeof phdrs[0], ELF_T_PHDR, encoding,
+	       phoff);
+  free (phdrs);
+
+  /* The module in the new segment.  */
+  Elf64_Ehdr mod_ehdr = *ehdr;
+  mod_ehdr.e_type = ET_DYN;
+  mod_ehdr.e_entry = 0;
+  mod_ehdr.e_phoff = sizeof mod_ehdr;
+  mod_ehdr.e_phnum = 2;
+  mod_ehdr.e_shoff = BIG_SIZE + 0x10000;
+  mod_ehdr.e_shentsize = sizeof (Elf64_Shdr);
+  mod_ehdr.e_shnum = 8;
+  mod_ehdr.e_shstrndx = 7;
+  Elf64_Off dyn_offset = 0x200;
+  Elf64_Off str_offset = 0x300;
+  Elf64_Phdr mod_phdrs[2] =
+    {
+      { .p_type = PT_LOAD, .p_flags = PF_R, .p_offset = 0, .p_vaddr = 0,
+	.p_filesz = BIG_SIZE, .p_memsz = BIG_SIZE, .p_align = 0x1000 },
+      { .p_type = PT_DYNAMIC, .p_flags = PF_R, .p_offset = dyn_offset,
+	.p_vaddr = dyn_offset, .p_filesz = 4 * sizeof (Elf64_Dyn),
+	.p_memsz = 4 * sizeof (Elf64_Dyn), .p_align = 8 },
+    };
+  Elf64_Dyn dyn[4] =
+    {
+      { .d_tag = DT_STRTAB, .d_un.d_ptr = vaddr + str_offset },
+      { .d_tag = DT_STRSZ, .d_un.d_val = sizeof soname },
+      { .d_tag = DT_SONAME, .d_un.d_val = 1 },
+      { .d_tag = DT_NULL },
+    };
+  write_xlate (out, &mod_ehdr, sizeof mod_ehdr, ELF_T_EHDR, encoding, offset);
+  write_xlate (out, mod_phdrs, sizeof mod_phdrs, ELF_T_PHDR, encoding,
+	       offset + sizeof mod_ehdr);
+  write_xlate (out, dyn, sizeof dyn, ELF_T_DYN, encoding,
+	       offset + dyn_offset);
+  xpwrite (out, soname, sizeof soname, offset + str_offset);
+  if (ftruncate (out, offset + BIG_SIZE) != 0)
+    error (EXIT_FAILURE, errno, "ftruncate");
+  close (out);
+
+  elf_end (core);
+  close (fd);
+}
+
+/* Return the peak resident set size in bytes.  */
+static size_t
+peak_rss (void)
+{
+  FILE *f = fopen ("/proc/self/status", "r");
+  if (f == NULL)
+    return 0;
+  char line[256];
+  size_t kb = 0;
+  while (fgets (line, sizeof line, f) != NULL)
+    if (sscanf (line, "VmHWM: %zu kB", &kb) == 1)
+      break;
+  fclose (f);
+  return kb * 1024;
+}
+
+static size_t nframes;
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg __attribute__ ((unused)))
+{
+  Dwarf_Addr pc;
+  if (! dwfl_frame_pc (state, &pc, NULL))
+    return DWARF_CB_ABORT;
+  nframes++;
+  return DWARF_CB_OK;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *arg)
+{
+  (*(size_t *) arg)++;
+  dwfl_thread_getframes (thread, frame_callback, NULL);
+  return DWARF_CB_OK;
+}
+
+static int
+module_callback (Dwfl_Module *mod, void **userdata __attribute__ ((unused)),
+		 const char *name, Dwarf_Addr start,
+		 void *arg __attribute__ ((unused)))
+{
+  if (strcmp (name, "libbig.so") == 0)
+    {
+      Dwarf_Addr end;
+      dwfl_module_info (mod, NULL, NULL, &end, NULL, NULL, NULL, NULL);
+      printf ("%s: %" PRIu64 " bytes\n", name, end - start);
+    }
+  return DWARF_CB_OK;
+}
+
+/* Report the modules of CORE and attach to its threads.  */
+static Dwfl *
+report_and_attach (Elf *core, const char *exec)
+{
+  static char *debuginfo_path;
+  static const Dwfl_Callbacks core_callbacks =
+    {
+      .find_elf = dwfl_build_id_find_elf,
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+    };
+  Dwfl *dwfl = dwfl_begin (&core_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  if (dwfl_core_file_report (dwfl, core, exec) < 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_report: %s", dwfl_errmsg (-1));
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  if (dwfl_core_file_attach (dwfl, core) < 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_attach: %s", dwfl_errmsg (-1));
+  return dwfl;
+}
+
+#if USE_ZSTD
+static void
+put_le32 (FILE *f, uint32_t value)
+{
+  uint8_t buf[4] = { value, value >> 8, value >> 16, value >> 24 };
+  if (fwrite (buf, sizeof buf, 1, f) != 1)
+    error (EXIT_FAILURE, errno, "fwrite");
+}
+
+static void
+zstd_seekable (size_t frame_size, const char *in_name, const char *out_name)
+{
+  int fd = open (in_name, O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", in_name);
+  FILE *out = fopen (out_name, "w");
+  if (out == NULL)
+    error (EXIT_FAILURE, errno, "fopen %s", out_name);
+
+  size_t bound = ZSTD_compressBound (frame_size);
+  char *buf = malloc (frame_size);
+  char *zbuf = malloc (bound);
+  uint32_t *table = NULL;
+  uint32_t nframes = 0;
+  if (buf == NULL || zbuf == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  ssize_t n;
+  while ((n = read (fd, buf, frame_size)) > 0)
+    {
+      /* Take a short read as the last frame, this is a regular file.  */
+      size_t zsize = ZSTD_compress (zbuf, bound, buf, n, 1);
+      if (ZSTD_isError (zsize))
+	error (EXIT_FAILURE, 0, "ZSTD_compress: %s",
+	       ZSTD_getErrorName (zsize));
+      if (fwrite (zbuf, zsize, 1, out) != 1)
+	error (EXIT_FAILURE, errno, "fwrite");
+      table = realloc (table, (nframes + 1) * 2 * sizeof *table);
+      if (table == NULL)
+	error (EXIT_FAILURE, errno, "realloc");
+      table[nframes * 2] = zsize;
+      table[nframes * 2 + 1] = n;
+      nframes++;
+    }
+  if (n < 0)
+    error (EXIT_FAILURE, errno, "read %s", in_name);
+
+  /* The seek table, a skippable frame without checksums.  */
+  put_le32 (out, 0x184D2A5E);
+  put_le32 (out, nframes * 8 + 9);
+  for (uint32_t i = 0; i < nframes * 2; i++)
+    put_le32 (out, table[i]);
+  put_le32 (out, nframes);
+  if (fputc (0, out) == EOF)
+    error (EXIT_FAILURE, errno, "fputc");
+  put_le32 (out, 0x8F92EAB1);
+
+  if (fclose (out) != 0)
+    error (EXIT_FAILURE, errno, "fclose %s", out_name);
+  close (fd);
+  free (table);
+  free (zbuf);
+  free (buf);
+}
+#endif
+
+int
+main (int argc, char **argv)
+{
+  elf_version (EV_CURRENT);
+
+  if (argc == 4 && strcmp (argv[1], "--create") == 0)
+    {
+      create (argv[2], argv[3]);
+      return 0;
+    }
+
+  if (argc == 5 && strcmp (argv[1], "--zstd") == 0)
+    {
+#if USE_ZSTD
+      zstd_seekable (strtoul (argv[2], NULL, 0), argv[3], argv[4]);
+      return 0;
+#else
+      return 77;
+#endif
+    }
+
+  bool use_mmap = argc > 1 && strcmp (argv[1], "--mmap") == 0;
+  bool use_argp = argc > 1 && strcmp (argv[1], "--argp") == 0;
+  if (argc != 3 + (use_mmap || use_argp))
+    error (EXIT_FAILURE, 0, "usage: %s [--mmap|--argp] EXEC CORE", argv[0]);
+  const char *exec = argv[argc - 2];
+  const char *core_name = argv[argc - 1];
+
+  size_t start_rss = peak_rss ();
+  if (start_rss == 0)
+    {
+      fprintf (stderr, "%s: no VmHWM in /proc/self/status\n", argv[0]);
+      return 77;
+    }
+
+  Dwfl *dwfl;
+  int fd = -1;
+  Elf *core = NULL;
+  if (use_argp)
+    {
+      /* This reports and attaches CORE.  */
+      char *args[] = { argv[0], (char *) "-e", (char *) exec,
+		       (char *) "--core", (char *) core_name, NULL };
+      const struct argp_child children[] =
+	{
+	  { .argp = dwfl_standard_argp () },
+	  { .argp = NULL },
+	};
+      const struct argp argp = { .children = children };
+      argp_parse (&argp, 5, args, 0, NULL, &dwfl);
+    }
+  else
+    {
+      fd = open (core_name, O_RDONLY);
+      if (fd < 0)
+	error (EXIT_FAILURE, errno, "open %s", core_name);
+      core = elf_begin (fd, use_mmap ? ELF_C_READ_MMAP : ELF_C_READ, NULL);
+      if (core == NULL)
+	error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+      dwfl = report_and_attach (core, exec);
+    }
+  dwfl_getmodules (dwfl, module_callback, NULL, 0);
+
+  size_t first = 0, nthreads = 0;
+  for (int i = 0; i < ROUNDS; i++)
+    {
+      nframes = 0;
+      nthreads = 0;
+      if (dwfl_getthreads (dwfl, thread_callback, &nthreads) != 0)
+	error (EXIT_FAILURE, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
+      if (i == 0)
+	first = nframes;
+      else if (nframes != first)
+	error (EXIT_FAILURE, 0, "%zu frames, %zu expected", nframes, first);
+    }
+  printf ("%zu threads, %zu frames\n", nthreads, first);
+
+  size_t growth = peak_rss () - start_rss;
+  if (growth >= MAX_GROWTH)
+    error (EXIT_FAILURE, 0, "peak RSS grew by %zu bytes", growth);
+  printf ("peak RSS growth below %d MiB\n", MAX_GROWTH >> 20);
+
+  dwfl_end (dwfl);
+  if (core != NULL)
+    {
+      elf_end (core);
+      close (fd);
+    }
+  return 0;
+}
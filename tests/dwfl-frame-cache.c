@@ -0,0 +1,136 @@
+/* Test the unwind rules cache with dwfl_frame_cache_stats.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dwfl)
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Usage: dwfl-frame-cache EXEC CORE
+   Unwinds all threads of CORE twice.  The second time every frame
+   must be unwound with the cached rules, to the same PCs.  */
+
+static const Dwfl_Callbacks core_callbacks =
+  {
+    .find_elf = dwfl_build_id_find_elf,
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+  };
+
+struct pcs
+{
+  Dwarf_Addr *pcs;
+  size_t n;
+  size_t alloc;
+};
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct pcs *pcs = arg;
+  Dwarf_Addr pc;
+  if (! dwfl_frame_pc (state, &pc, NULL))
+    error (EXIT_FAILURE, 0, "dwfl_frame_pc: %s", dwfl_errmsg (-1));
+
+  if (pcs->n == pcs->alloc)
+    {
+      pcs->alloc = pcs->alloc * 2 + 16;
+      pcs->pcs = realloc (pcs->pcs, pcs->alloc * sizeof pcs->pcs[0]);
+      if (pcs->pcs == NULL)
+	error (EXIT_FAILURE, errno, "realloc");
+    }
+  pcs->pcs[pcs->n++] = pc;
+  return DWARF_CB_OK;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *arg)
+{
+  /* Errors at the end of the stack are expected, the frames up to
+     there are what gets compared.  */
+  dwfl_thread_getframes (thread, frame_callback, arg);
+  return DWARF_CB_OK;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    error (EXIT_FAILURE, 0, "usage: %s EXEC CORE", argv[0]);
+
+  elf_version (EV_CURRENT);
+
+  int fd = open (argv[2], O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", argv[2]);
+  Elf *core = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (core == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+
+  Dwfl *dwfl = dwfl_begin (&core_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  if (dwfl_core_file_report (dwfl, core, argv[1]) < 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_report: %s", dwfl_errmsg (-1));
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  if (dwfl_core_file_attach (dwfl, core) < 0)
+    error (EXIT_FAILURE, 0, "dwfl_core_file_attach: %s", dwfl_errmsg (-1));
+
+  size_t hits, misses;
+  if (dwfl_frame_cache_stats (dwfl, &hits, &misses) != 0
+      || hits != 0 || misses != 0)
+    error (EXIT_FAILURE, 0, "cache not empty before unwinding");
+
+  struct pcs first = { NULL, 0, 0 };
+  if (dwfl_getthreads (dwfl, thread_callback, &first) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
+  size_t first_hits, first_misses;
+  dwfl_frame_cache_stats (dwfl, &first_hits, &first_misses);
+
+  struct pcs second = { NULL, 0, 0 };
+  if (dwfl_getthreads (dwfl, thread_callback, &second) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
+  dwfl_frame_cache_stats (dwfl, &hits, &misses);
+
+  if (first.n != second.n
+      || memcmp (first.pcs, second.pcs, first.n * sizeof first.pcs[0]) != 0)
+    error (EXIT_FAILURE, 0, "frames differ when unwound from the cache");
+  if (misses != first_misses)
+    error (EXIT_FAILURE, 0, "%zu rules compiled again", misses - first_misses);
+  if (hits - first_hits != first_hits + first_misses)
+    error (EXIT_FAILURE, 0, "%zu lookups, %zu expected",
+	   hits - first_hits, first_hits + first_misses);
+
+  printf ("%s: %zu frames, %zu rules, %zu hits\n",
+	  argv[2], first.n, first_misses, hits);
+
+  free (first.pcs);
+  free (second.pcs);
+  dwfl_end (dwfl);
+  elf_end (core);
+  close (fd);
+  return 0;
+}
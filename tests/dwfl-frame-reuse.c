@@ -0,0 +1,216 @@
+/* Test that dwfl_frame_reuse makes unwinding allocation free.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <errno.h>
+#include <error.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include ELFUTILS_HEADER(dwfl)
+
+#if !defined __linux__ || !defined __GLIBC__
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: Unwinding not supported for this architecture\n",
+	   argv[0]);
+  return 77;
+}
+
+#else /* __linux__ && __GLIBC__ */
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+/* Usage: dwfl-frame-reuse
+   Forks a child that stops with DEPTH + 1 recurse frames on its stack
+   and unwinds it ROUNDS times, with and without dwfl_frame_reuse,
+   counting the calls to the malloc family of functions (in the whole
+   process, libdw included) while doing so.  */
+
+#define DEPTH 50
+#define ROUNDS 10
+#define MAXPCS 1024
+
+/* Count the heap activity by interposing the glibc allocator.  */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void __libc_free (void *ptr);
+
+static size_t heap_calls;
+
+void *
+malloc (size_t size)
+{
+  heap_calls++;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  heap_calls++;
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  heap_calls++;
+  return __libc_realloc (ptr, size);
+}
+
+void
+free (void *ptr)
+{
+  if (ptr != NULL)
+    heap_calls++;
+  __libc_free (ptr);
+}
+
+int recurse (int depth) __attribute__ ((noinline, noclone));
+
+int
+recurse (int depth)
+{
+  volatile char buf[64];
+  buf[0] = depth;
+  if (depth == 0)
+    raise (SIGUSR2);
+  else
+    recurse (depth - 1);
+  return buf[0];
+}
+
+struct pcs
+{
+  Dwarf_Addr pcs[MAXPCS];
+  size_t n;
+};
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct pcs *pcs = arg;
+  if (! dwfl_frame_pc (state, &pcs->pcs[pcs->n], NULL))
+    error (EXIT_FAILURE, 0, "dwfl_frame_pc: %s", dwfl_errmsg (-1));
+  return ++pcs->n < MAXPCS ? DWARF_CB_OK : DWARF_CB_ABORT;
+}
+
+static struct pcs first, pcs;
+
+/* Unwind ROUNDS times, return the heap calls made.  */
+static size_t
+unwind (Dwfl *dwfl, pid_t pid)
+{
+  size_t calls = heap_calls;
+  for (int i = 0; i < ROUNDS; i++)
+    {
+      pcs.n = 0;
+      dwfl_getthread_frames (dwfl, pid, frame_callback, &pcs);
+      if (pcs.n != first.n
+	  || memcmp (pcs.pcs, first.pcs, pcs.n * sizeof pcs.pcs[0]) != 0)
+	error (EXIT_FAILURE, 0, "%zu frames, %zu expected", pcs.n, first.n);
+    }
+  return heap_calls - calls;
+}
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  elf_version (EV_CURRENT);
+
+  pid_t pid = fork ();
+  switch (pid)
+    {
+    case -1:
+      error (EXIT_FAILURE, errno, "fork");
+    case 0:
+      if (ptrace (PTRACE_TRACEME, 0, NULL, NULL) != 0)
+	error (EXIT_FAILURE, errno, "PTRACE_TRACEME");
+      exit (recurse (DEPTH));
+    default:
+      break;
+    }
+
+  int status;
+  if (waitpid (pid, &status, 0) != pid)
+    error (EXIT_FAILURE, errno, "waitpid");
+  if (! WIFSTOPPED (status) || WSTOPSIG (status) != SIGUSR2)
+    error (EXIT_FAILURE, 0, "unexpected wait status %#x", status);
+
+  static char *debuginfo_path;
+  static const Dwfl_Callbacks proc_callbacks =
+    {
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+      .find_elf = dwfl_linux_proc_find_elf,
+    };
+  Dwfl *dwfl = dwfl_begin (&proc_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  int result = dwfl_linux_proc_report (dwfl, pid);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_report: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_report");
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  result = dwfl_linux_proc_attach (dwfl, pid, true);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_attach: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_attach");
+
+  /* The first backtrace reads the modules and their unwind information.  */
+  dwfl_getthread_frames (dwfl, pid, frame_callback, &first);
+  if (first.n <= DEPTH)
+    {
+      fprintf (stderr, "%s: Unwinding not supported for this architecture"
+	       " (%zu frames)\n", argv[0], first.n);
+      kill (pid, SIGKILL);
+      return 77;
+    }
+
+  size_t calls = unwind (dwfl, pid);
+  printf ("without reuse: %s\n",
+	  calls >= ROUNDS * first.n ? "heap calls for every frame" : "???");
+
+  if (dwfl_frame_reuse (dwfl, true) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_frame_reuse: %s", dwfl_errmsg (-1));
+  calls = unwind (dwfl, pid);
+  printf ("with reuse: %zu heap calls\n", calls);
+
+  if (dwfl_frame_reuse (dwfl, false) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_frame_reuse: %s", dwfl_errmsg (-1));
+  calls = unwind (dwfl, pid);
+  printf ("reuse turned off: %s\n",
+	  calls >= ROUNDS * first.n ? "heap calls for every frame" : "???");
+
+  dwfl_end (dwfl);
+  kill (pid, SIGKILL);
+  waitpid (pid, &status, 0);
+  return 0;
+}
+
+#endif /* __linux__ && __GLIBC__ */
@@ -0,0 +1,183 @@
+/* Test dwfl_module_getsrc_batch against dwfl_module_getsrc.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dwfl)
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Usage: dwfl-getsrc-batch FILE...
+   Collects the address of every line of each FILE, plus the addresses
+   right before and after it and some outside the module, and looks
+   them all up with dwfl_module_getsrc_batch, in sorted and in reverse
+   order.  Each result must match what dwfl_module_getsrc returns.  */
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  Dwarf_Addr x = *(const Dwarf_Addr *) a;
+  Dwarf_Addr y = *(const Dwarf_Addr *) b;
+  return x < y ? -1 : x > y;
+}
+
+static int
+check_batch (Dwfl_Module *mod, const char *name, const char *order,
+	     const Dwarf_Addr *addrs, size_t n, ptrdiff_t *found)
+{
+  Dwfl_Line **lines = malloc (n * sizeof lines[0]);
+  int *errors = malloc (n * sizeof errors[0]);
+  if (lines == NULL || errors == NULL)
+    {
+      puts ("out of memory");
+      exit (-1);
+    }
+
+  int result = 0;
+  *found = dwfl_module_getsrc_batch (mod, addrs, n, lines, errors);
+  if (*found < 0)
+    {
+      printf ("%s: dwfl_module_getsrc_batch: %s\n", name, dwfl_errmsg (-1));
+      result = -1;
+    }
+
+  ptrdiff_t count = 0;
+  for (size_t i = 0; result == 0 && i < n; i++)
+    {
+      Dwfl_Line *line = dwfl_module_getsrc (mod, addrs[i]);
+      int error = line == NULL ? dwfl_errno () : 0;
+      if (line != lines[i] || (line == NULL && error != errors[i])
+	  || (line != NULL && errors[i] != 0))
+	{
+	  printf ("%s: %s addr %#" PRIx64 ": batch %p (%s), single %p (%s)\n",
+		  name, order, addrs[i], lines[i],
+		  errors[i] != 0 ? dwfl_errmsg (errors[i]) : "no error",
+		  line, line == NULL ? dwfl_errmsg (error) : "no error");
+	  result = -1;
+	}
+      count += line != NULL;
+    }
+
+  if (result == 0 && count != *found)
+    {
+      printf ("%s: %s found %td, expected %td\n", name, order, *found, count);
+      result = -1;
+    }
+
+  free (lines);
+  free (errors);
+  return result;
+}
+
+static int
+handle_file (const char *name)
+{
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, name, name, -1);
+  if (mod == NULL || dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("%s: dwfl_report_offline: %s\n", name, dwfl_errmsg (-1));
+      dwfl_end (dwfl);
+      return -1;
+    }
+
+  Dwarf_Addr low, high;
+  dwfl_module_info (mod, NULL, &low, &high, NULL, NULL, NULL, NULL);
+
+  size_t n = 0;
+  size_t alloc = 64;
+  Dwarf_Addr *addrs = malloc (alloc * sizeof addrs[0]);
+  addrs[n++] = 0;
+  addrs[n++] = low > 0 ? low - 1 : 0;
+  addrs[n++] = high;
+  addrs[n++] = (Dwarf_Addr) -1;
+
+  Dwarf_Addr bias;
+  Dwfl_Line *line;
+  size_t nlines = 0;
+  Dwarf_Die *cu = NULL;
+  while ((cu = dwfl_module_nextcu (mod, cu, &bias)) != NULL)
+    {
+      size_t cnt;
+      if (dwfl_getsrclines (cu, &cnt) != 0)
+	continue;
+      for (size_t i = 0; i < cnt; i++)
+	{
+	  line = dwfl_onesrcline (cu, i);
+	  Dwarf_Addr addr;
+	  if (line == NULL
+	      || dwfl_lineinfo (line, &addr, NULL, NULL, NULL, NULL) == NULL)
+	    {
+	      printf ("%s: line %zd: %s\n", name, i, dwfl_errmsg (-1));
+	      dwfl_end (dwfl);
+	      free (addrs);
+	      return -1;
+	    }
+	  if (n + 3 > alloc)
+	    {
+	      alloc *= 2;
+	      addrs = realloc (addrs, alloc * sizeof addrs[0]);
+	    }
+	  addrs[n++] = addr > 0 ? addr - 1 : 0;
+	  addrs[n++] = addr;
+	  addrs[n++] = addr + 1;
+	  nlines++;
+	}
+    }
+
+  qsort (addrs, n, sizeof addrs[0], compare_addr);
+  ptrdiff_t found;
+  int result = check_batch (mod, name, "sorted", addrs, n, &found);
+
+  for (size_t i = 0; i < n / 2; i++)
+    {
+      Dwarf_Addr addr = addrs[i];
+      addrs[i] = addrs[n - 1 - i];
+      addrs[n - 1 - i] = addr;
+    }
+  ptrdiff_t rfound;
+  if (result == 0)
+    result = check_batch (mod, name, "reversed", addrs, n, &rfound);
+
+  if (result == 0)
+    printf ("%s: %zd lines, %zd addresses, %td found\n",
+	    name, nlines, n, found);
+
+  free (addrs);
+  dwfl_end (dwfl);
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+  for (int i = 1; i < argc; i++)
+    if (handle_file (argv[i]) != 0)
+      result = 1;
+  return result;
+}
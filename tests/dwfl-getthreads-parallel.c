@@ -0,0 +1,324 @@
+/* Test dwfl_getthreads_parallel against dwfl_getthreads.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <errno.h>
+#include <error.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include ELFUTILS_HEADER(dwfl)
+
+#ifndef __linux__
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: Unwinding not supported for this architecture\n",
+	   argv[0]);
+  return 77;
+}
+
+#else /* __linux__ */
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+/* Usage: dwfl-getthreads-parallel
+   Forks a child with NTHREADS threads, thread K stopping with K + 1
+   recurse frames on its stack.  Checks that dwfl_getthreads_parallel
+   finds the same frames as dwfl_getthreads for every thread, and that
+   the child runs again afterwards.
+
+   Usage: dwfl-getthreads-parallel --child
+   Just forks the child and prints its pid, for eu-stack -p.  */
+
+#define NTHREADS 8
+#define MAXPCS 256
+
+int recurse (int depth) __attribute__ ((noinline, noclone));
+
+static int ready_fd;
+static int nready;
+static volatile int never;
+
+int
+recurse (int depth)
+{
+  volatile char buf[64];
+  buf[0] = depth;
+  if (depth == 0)
+    {
+      if (__atomic_add_fetch (&nready, 1, __ATOMIC_SEQ_CST) == NTHREADS)
+	{
+	  char c = 0;
+	  if (write (ready_fd, &c, 1) != 1)
+	    abort ();
+	}
+      while (! never)
+	pause ();
+    }
+  else
+    recurse (depth - 1);
+  return buf[0];
+}
+
+static void *
+thread_start (void *arg)
+{
+  recurse ((intptr_t) arg);
+  return NULL;
+}
+
+/* Return whether all threads of PID are sleeping.  */
+static bool
+all_sleeping (pid_t pid)
+{
+  char name[64 + sizeof ((struct dirent *) NULL)->d_name];
+  snprintf (name, sizeof name, "/proc/%d/task", (int) pid);
+  DIR *dir = opendir (name);
+  if (dir == NULL)
+    error (EXIT_FAILURE, errno, "opendir %s", name);
+  bool sleeping = true;
+  struct dirent *dirent;
+  while (sleeping && (dirent = readdir (dir)) != NULL)
+    {
+      if (dirent->d_name[0] == '.')
+	continue;
+      snprintf (name, sizeof name, "/proc/%d/task/%s/stat", (int) pid,
+		dirent->d_name);
+      FILE *f = fopen (name, "r");
+      if (f == NULL)
+	error (EXIT_FAILURE, errno, "fopen %s", name);
+      char stat[512];
+      size_t n = fread (stat, 1, sizeof stat - 1, f);
+      fclose (f);
+      stat[n] = '\0';
+      /* The state follows the parenthesized command name.  */
+      const char *paren = strrchr (stat, ')');
+      sleeping = paren != NULL && paren[1] == ' ' && paren[2] == 'S';
+    }
+  closedir (dir);
+  return sleeping;
+}
+
+/* Fork the child, return its pid once all its threads are stopped in
+   recurse.  The child exits with 42 when something is written to
+   *EXIT_FD.  */
+static pid_t
+start_child (int *exit_fd)
+{
+  int ready[2], quit[2];
+  if (pipe (ready) != 0 || pipe (quit) != 0)
+    error (EXIT_FAILURE, errno, "pipe");
+  pid_t pid = fork ();
+  switch (pid)
+    {
+    case -1:
+      error (EXIT_FAILURE, errno, "fork");
+    case 0:
+#ifdef PR_SET_PTRACER_ANY
+      prctl (PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+#endif
+      /* Do not keep the output of --child open.  */
+      close (0);
+      close (1);
+      ready_fd = ready[1];
+      for (intptr_t k = 0; k < NTHREADS; k++)
+	{
+	  pthread_t thread;
+	  if (pthread_create (&thread, NULL, thread_start, (void *) k) != 0)
+	    abort ();
+	}
+      char c;
+      ssize_t n;
+      while ((n = read (quit[0], &c, 1)) < 0 && errno == EINTR)
+	;
+      if (n == 1)
+	_exit (42);
+      for (;;)
+	pause ();
+    default:
+      break;
+    }
+  close (ready[1]);
+  close (quit[0]);
+  char c;
+  if (read (ready[0], &c, 1) != 1)
+    error (EXIT_FAILURE, errno, "read");
+  close (ready[0]);
+  /* The last threads to get there may not be in pause yet.  */
+  while (! all_sleeping (pid))
+    usleep (1000);
+  *exit_fd = quit[1];
+  return pid;
+}
+
+struct thread_pcs
+{
+  pid_t tid;
+  Dwarf_Addr pcs[MAXPCS];
+  size_t n;
+};
+
+static struct thread_pcs expected[NTHREADS + 1], parallel[NTHREADS + 1];
+static size_t nthreads;
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct thread_pcs *pcs = arg;
+  if (! dwfl_frame_pc (state, &pcs->pcs[pcs->n], NULL))
+    return DWARF_CB_ABORT;
+  return ++pcs->n < MAXPCS ? DWARF_CB_OK : DWARF_CB_ABORT;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *arg __attribute__ ((unused)))
+{
+  if (nthreads == NTHREADS + 1)
+    error (EXIT_FAILURE, 0, "more than %d threads", NTHREADS + 1);
+  struct thread_pcs *pcs = &expected[nthreads++];
+  pcs->tid = dwfl_thread_tid (thread);
+  dwfl_thread_getframes (thread, frame_callback, pcs);
+  return DWARF_CB_OK;
+}
+
+/* Called concurrently, every thread has its own slot.  */
+static int
+parallel_callback (Dwfl_Thread *thread, void *arg __attribute__ ((unused)))
+{
+  pid_t tid = dwfl_thread_tid (thread);
+  for (size_t i = 0; i < nthreads; i++)
+    if (expected[i].tid == tid)
+      {
+	parallel[i].tid = tid;
+	dwfl_thread_getframes (thread, frame_callback, &parallel[i]);
+	return DWARF_CB_OK;
+      }
+  return DWARF_CB_ABORT;
+}
+
+static size_t
+count_recurse (Dwfl *dwfl, const struct thread_pcs *pcs)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < pcs->n; i++)
+    {
+      Dwarf_Addr pc = pcs->pcs[i] - (i == 0 ? 0 : 1);
+      Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc);
+      const char *name = mod != NULL ? dwfl_module_addrname (mod, pc) : NULL;
+      if (name != NULL && strcmp (name, "recurse") == 0)
+	count++;
+    }
+  return count;
+}
+
+int
+main (int argc, char **argv)
+{
+  int exit_fd;
+  if (argc == 2 && strcmp (argv[1], "--child") == 0)
+    {
+      pid_t pid = start_child (&exit_fd);
+      printf ("%d\n", (int) pid);
+      return 0;
+    }
+
+  elf_version (EV_CURRENT);
+  pid_t pid = start_child (&exit_fd);
+
+  static char *debuginfo_path;
+  static const Dwfl_Callbacks proc_callbacks =
+    {
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+      .find_elf = dwfl_linux_proc_find_elf,
+    };
+  Dwfl *dwfl = dwfl_begin (&proc_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  int result = dwfl_linux_proc_report (dwfl, pid);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_report: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_report");
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  result = dwfl_linux_proc_attach (dwfl, pid, false);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_attach: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_attach");
+
+  if (dwfl_getthreads (dwfl, thread_callback, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_getthreads: %s", dwfl_errmsg (-1));
+  printf ("%zu threads\n", nthreads);
+
+  /* Every thread has another number of recurse frames, the main
+     thread none.  */
+  bool seen[NTHREADS + 2] = { false };
+  for (size_t i = 0; i < nthreads; i++)
+    {
+      size_t count = count_recurse (dwfl, &expected[i]);
+      if (count > NTHREADS || seen[count])
+	{
+	  fprintf (stderr, "%s: Unwinding not supported for this"
+		   " architecture (%zu recurse frames)\n", argv[0], count);
+	  kill (pid, SIGKILL);
+	  return 77;
+	}
+      seen[count] = true;
+    }
+
+  for (unsigned nworkers = 1; nworkers <= 4; nworkers *= 2)
+    {
+      memset (parallel, 0, sizeof parallel);
+      if (dwfl_getthreads_parallel (dwfl, nworkers, parallel_callback,
+				    NULL) != 0)
+	error (EXIT_FAILURE, 0, "dwfl_getthreads_parallel: %s",
+	       dwfl_errmsg (-1));
+      for (size_t i = 0; i < nthreads; i++)
+	if (parallel[i].n != expected[i].n
+	    || memcmp (parallel[i].pcs, expected[i].pcs,
+		       expected[i].n * sizeof expected[i].pcs[0]) != 0)
+	  error (EXIT_FAILURE, 0, "tid %d: %zu frames, %zu expected",
+		 (int) expected[i].tid, parallel[i].n, expected[i].n);
+      printf ("%u workers: same frames\n", nworkers);
+    }
+
+  dwfl_end (dwfl);
+
+  /* All threads were resumed, the child can exit.  */
+  char c = 0;
+  if (write (exit_fd, &c, 1) != 1)
+    error (EXIT_FAILURE, errno, "write");
+  int status;
+  if (waitpid (pid, &status, 0) != pid)
+    error (EXIT_FAILURE, errno, "waitpid");
+  if (! WIFEXITED (status))
+    error (EXIT_FAILURE, 0, "unexpected wait status %#x", status);
+  printf ("child exited with %d\n", WEXITSTATUS (status));
+  return 0;
+}
+
+#endif /* __linux__ */
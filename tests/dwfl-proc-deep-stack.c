@@ -0,0 +1,221 @@
+/* Test unwinding a deep stack of a live process.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <errno.h>
+#include <error.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include ELFUTILS_HEADER(dwfl)
+
+#ifndef __linux__
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: Unwinding not supported for this architecture\n",
+	   argv[0]);
+  return 77;
+}
+
+#else /* __linux__ */
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+/* Usage: dwfl-proc-deep-stack
+   Forks a child that stops with DEPTH + 1 recurse frames of more than
+   a hundred bytes each on its stack.  Unwinds the child twice through
+   dwfl_linux_proc_attach, counting the recurse frames down to main.
+   Checks that the stack is read with few process_vm_readv calls, each
+   reading up to CACHE_RUN pages.  */
+
+#define DEPTH 1000
+#define CACHE_RUN 8
+
+#ifdef HAVE_PROCESS_VM_READV
+/* Count the process_vm_readv calls of libdwfl.  */
+static size_t readv_calls;
+static bool readv_failed;
+
+ssize_t
+process_vm_readv (pid_t pid, const struct iovec *local_iov,
+		  unsigned long int liovcnt, const struct iovec *remote_iov,
+		  unsigned long int riovcnt, unsigned long int flags)
+{
+  readv_calls++;
+  ssize_t res = syscall (SYS_process_vm_readv, pid, local_iov, liovcnt,
+			 remote_iov, riovcnt, flags);
+  if (res < 0 && (errno == EPERM || errno == ENOSYS))
+    readv_failed = true;
+  return res;
+}
+#endif
+
+/* The pipe the child writes the bounds of its stack to.  */
+static int stack_pipe[2];
+static char *stack_top;
+
+int recurse (int depth) __attribute__ ((noinline, noclone));
+
+int
+recurse (int depth)
+{
+  volatile char buf[128];
+  buf[0] = depth;
+  if (depth == 0)
+    {
+      char *bounds[2] = { stack_top, (char *) buf };
+      if (write (stack_pipe[1], bounds, sizeof bounds) != sizeof bounds)
+	error (EXIT_FAILURE, errno, "write");
+      raise (SIGUSR2);
+    }
+  else
+    recurse (depth - 1);
+  return buf[0];
+}
+
+struct count
+{
+  size_t recurse;
+  bool main;
+};
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct count *count = arg;
+  Dwarf_Addr pc;
+  bool isactivation;
+  if (! dwfl_frame_pc (state, &pc, &isactivation))
+    error (EXIT_FAILURE, 0, "dwfl_frame_pc: %s", dwfl_errmsg (-1));
+  Dwarf_Addr pc_adjusted = pc - (isactivation ? 0 : 1);
+
+  Dwfl *dwfl = dwfl_thread_dwfl (dwfl_frame_thread (state));
+  Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc_adjusted);
+  const char *symname = NULL;
+  if (mod != NULL)
+    symname = dwfl_module_addrname (mod, pc_adjusted);
+
+  if (symname != NULL && strcmp (symname, "recurse") == 0)
+    count->recurse++;
+  else if (symname != NULL && strcmp (symname, "main") == 0)
+    {
+      count->main = true;
+      return DWARF_CB_ABORT;
+    }
+  return DWARF_CB_OK;
+}
+
+static void
+unwind (Dwfl *dwfl, pid_t pid, size_t stack_pages)
+{
+#ifdef HAVE_PROCESS_VM_READV
+  readv_calls = 0;
+#endif
+  struct count count = { 0, false };
+  if (dwfl_getthread_frames (dwfl, pid, frame_callback, &count) != 0
+      && ! count.main)
+    error (EXIT_FAILURE, 0, "dwfl_getthread_frames: %s", dwfl_errmsg (-1));
+  printf ("%zu recurse frames, main %s\n", count.recurse,
+	  count.main ? "found" : "not found");
+
+#ifdef HAVE_PROCESS_VM_READV
+  /* Each run of pages is read once.  Where process_vm_readv isn't
+     allowed the words are read with ptrace instead.  */
+  if (! readv_failed && readv_calls > stack_pages / CACHE_RUN + 2)
+    error (EXIT_FAILURE, 0, "%zu process_vm_readv calls for %zu pages",
+	   readv_calls, stack_pages);
+#else
+  (void) stack_pages;
+#endif
+}
+
+int
+main (int argc __attribute__ ((unused)),
+      char **argv __attribute__ ((unused)))
+{
+  elf_version (EV_CURRENT);
+
+  if (pipe (stack_pipe) != 0)
+    error (EXIT_FAILURE, errno, "pipe");
+  pid_t pid = fork ();
+  switch (pid)
+    {
+    case -1:
+      error (EXIT_FAILURE, errno, "fork");
+    case 0:
+      if (ptrace (PTRACE_TRACEME, 0, NULL, NULL) != 0)
+	error (EXIT_FAILURE, errno, "PTRACE_TRACEME");
+      char top;
+      stack_top = &top;
+      exit (recurse (DEPTH));
+    default:
+      break;
+    }
+
+  int status;
+  if (waitpid (pid, &status, 0) != pid)
+    error (EXIT_FAILURE, errno, "waitpid");
+  if (! WIFSTOPPED (status) || WSTOPSIG (status) != SIGUSR2)
+    error (EXIT_FAILURE, 0, "unexpected wait status %#x", status);
+  char *bounds[2];
+  if (read (stack_pipe[0], bounds, sizeof bounds) != sizeof bounds)
+    error (EXIT_FAILURE, errno, "read");
+  size_t stack_pages = (bounds[0] - bounds[1]) / 4096 + 1;
+
+  static char *debuginfo_path;
+  static const Dwfl_Callbacks proc_callbacks =
+    {
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+      .find_elf = dwfl_linux_proc_find_elf,
+    };
+  Dwfl *dwfl = dwfl_begin (&proc_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  int result = dwfl_linux_proc_report (dwfl, pid);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_report: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_report");
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  result = dwfl_linux_proc_attach (dwfl, pid, true);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_attach: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_attach");
+
+  /* The second time starts with an empty cache again.  */
+  unwind (dwfl, pid, stack_pages);
+  unwind (dwfl, pid, stack_pages);
+
+  dwfl_end (dwfl);
+  kill (pid, SIGKILL);
+  waitpid (pid, &status, 0);
+  return 0;
+}
+
+#endif /* ! __linux__ */
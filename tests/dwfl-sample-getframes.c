@@ -0,0 +1,244 @@
+/* Test dwfl_sample_getframes against unwinding the live process.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include ELFUTILS_HEADER(dwfl)
+
+#if !defined __linux__ || !defined __x86_64__
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: Unwinding not supported for this architecture\n",
+	   argv[0]);
+  return 77;
+}
+
+#else /* __linux__ && __x86_64__ */
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+/* Usage: dwfl-sample-getframes
+   Forks a child that stops with DEPTH + 1 recurse frames on its stack.
+   Takes its registers and a copy of its stack like a perf_event sample
+   would, and checks that dwfl_sample_getframes finds the same frames
+   as unwinding the stopped child itself, also after the child is gone
+   and for many samples with the same Dwfl.  */
+
+#define DEPTH 100
+#define MAXPCS 1024
+#define STACK_SIZE 65536
+
+int recurse (int depth) __attribute__ ((noinline, noclone));
+
+int
+recurse (int depth)
+{
+  volatile char buf[128];
+  buf[0] = depth;
+  if (depth == 0)
+    raise (SIGUSR2);
+  else
+    recurse (depth - 1);
+  return buf[0];
+}
+
+static char *debuginfo_path;
+static const Dwfl_Callbacks proc_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .debuginfo_path = &debuginfo_path,
+    .find_elf = dwfl_linux_proc_find_elf,
+  };
+
+static Dwfl *
+report_pid (pid_t pid)
+{
+  Dwfl *dwfl = dwfl_begin (&proc_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  int result = dwfl_linux_proc_report (dwfl, pid);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_report: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_report");
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  return dwfl;
+}
+
+struct pcs
+{
+  Dwarf_Addr pcs[MAXPCS];
+  size_t n;
+};
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct pcs *pcs = arg;
+  if (! dwfl_frame_pc (state, &pcs->pcs[pcs->n], NULL))
+    error (EXIT_FAILURE, 0, "dwfl_frame_pc: %s", dwfl_errmsg (-1));
+  return ++pcs->n < MAXPCS ? DWARF_CB_OK : DWARF_CB_ABORT;
+}
+
+static size_t
+count_recurse (Dwfl *dwfl, const Dwarf_Addr *pcs, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+    {
+      Dwarf_Addr pc = pcs[i] - (i == 0 ? 0 : 1);
+      Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc);
+      const char *name = mod != NULL ? dwfl_module_addrname (mod, pc) : NULL;
+      if (name != NULL && strcmp (name, "recurse") == 0)
+	count++;
+    }
+  return count;
+}
+
+int
+main (int argc __attribute__ ((unused)),
+      char **argv __attribute__ ((unused)))
+{
+  elf_version (EV_CURRENT);
+
+  pid_t pid = fork ();
+  switch (pid)
+    {
+    case -1:
+      error (EXIT_FAILURE, errno, "fork");
+    case 0:
+      if (ptrace (PTRACE_TRACEME, 0, NULL, NULL) != 0)
+	error (EXIT_FAILURE, errno, "PTRACE_TRACEME");
+      exit (recurse (DEPTH));
+    default:
+      break;
+    }
+
+  int status;
+  if (waitpid (pid, &status, 0) != pid)
+    error (EXIT_FAILURE, errno, "waitpid");
+  if (! WIFSTOPPED (status) || WSTOPSIG (status) != SIGUSR2)
+    error (EXIT_FAILURE, 0, "unexpected wait status %#x", status);
+
+  /* The frames of the stopped child.  */
+  Dwfl *live = report_pid (pid);
+  int result = dwfl_linux_proc_attach (live, pid, true);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_attach: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_attach");
+  static struct pcs expected;
+  dwfl_getthread_frames (live, pid, frame_callback, &expected);
+  printf ("live: %zu recurse frames\n",
+	  count_recurse (live, expected.pcs, expected.n));
+
+  /* A Dwfl attached otherwise cannot unwind samples.  */
+  Dwarf_Addr pcs[MAXPCS];
+  if (dwfl_sample_getframes (live, pid, NULL, 0, 0, 0, NULL, 0,
+			     pcs, MAXPCS) != -1)
+    error (EXIT_FAILURE, 0, "sample unwound with an attached Dwfl");
+
+  /* The sample, registers in DWARF order.  */
+  struct user_regs_struct user_regs;
+  if (ptrace (PTRACE_GETREGS, pid, NULL, &user_regs) != 0)
+    error (EXIT_FAILURE, errno, "PTRACE_GETREGS");
+  Dwarf_Word regs[17] =
+    {
+      user_regs.rax, user_regs.rdx, user_regs.rcx, user_regs.rbx,
+      user_regs.rsi, user_regs.rdi, user_regs.rbp, user_regs.rsp,
+      user_regs.r8, user_regs.r9, user_regs.r10, user_regs.r11,
+      user_regs.r12, user_regs.r13, user_regs.r14, user_regs.r15,
+      user_regs.rip
+    };
+  static unsigned char stack[STACK_SIZE];
+  char mem_name[64];
+  snprintf (mem_name, sizeof mem_name, "/proc/%d/mem", (int) pid);
+  int mem_fd = open (mem_name, O_RDONLY);
+  if (mem_fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", mem_name);
+  /* The stack ends somewhere in the copy, read what there is.  */
+  size_t stack_size = 0;
+  while (stack_size < STACK_SIZE)
+    {
+      ssize_t n = pread (mem_fd, stack + stack_size, 4096,
+			 user_regs.rsp + stack_size);
+      if (n <= 0)
+	break;
+      stack_size += n;
+    }
+  close (mem_fd);
+
+  Dwfl *dwfl = report_pid (pid);
+  size_t n = dwfl_sample_getframes (dwfl, pid, regs, 17, user_regs.rip,
+				    user_regs.rsp, stack, stack_size,
+				    pcs, MAXPCS);
+  if (n != expected.n
+      || memcmp (pcs, expected.pcs, n * sizeof pcs[0]) != 0)
+    error (EXIT_FAILURE, 0, "sample has %zu frames, %zu expected",
+	   n, expected.n);
+  printf ("sample: %zu recurse frames\n", count_recurse (dwfl, pcs, n));
+
+  dwfl_end (live);
+  kill (pid, SIGKILL);
+  waitpid (pid, &status, 0);
+
+  /* The modules are read by now, the process is not needed anymore.  */
+  for (int i = 0; i < 1000; i++)
+    {
+      memset (pcs, 0, sizeof pcs);
+      n = dwfl_sample_getframes (dwfl, pid, regs, 17, user_regs.rip,
+				 user_regs.rsp, stack, stack_size,
+				 pcs, MAXPCS);
+      if (n != expected.n
+	  || memcmp (pcs, expected.pcs, n * sizeof pcs[0]) != 0)
+	error (EXIT_FAILURE, 0, "sample %d has %zu frames, %zu expected",
+	       i, n, expected.n);
+    }
+  printf ("1000 samples: same frames\n");
+
+  n = dwfl_sample_getframes (dwfl, pid, regs, 17, user_regs.rip,
+			     user_regs.rsp, stack, stack_size, pcs, 3);
+  if (n != 3 || memcmp (pcs, expected.pcs, n * sizeof pcs[0]) != 0)
+    error (EXIT_FAILURE, 0, "%zu frames for maxpcs 3", n);
+  printf ("maxpcs 3: %zu frames\n", n);
+
+  /* With less of the stack, unwinding ends earlier.  */
+  n = dwfl_sample_getframes (dwfl, pid, regs, 17, user_regs.rip,
+			     user_regs.rsp, stack, 1024, pcs, MAXPCS);
+  if (n == 0 || n >= expected.n
+      || memcmp (pcs, expected.pcs, n * sizeof pcs[0]) != 0)
+    error (EXIT_FAILURE, 0, "%zu frames for 1024 bytes of stack", n);
+  printf ("1024 bytes of stack: fewer frames\n");
+
+  dwfl_end (dwfl);
+  return 0;
+}
+
+#endif /* __linux__ && __x86_64__ */
@@ -0,0 +1,165 @@
+/* Test dwfl_module_symbol_by_name.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include ELFUTILS_HEADER(dwfl)
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Usage: dwfl-symbol-by-name FILE...
+   Looks up the name of every defined symbol of each FILE and checks
+   the result against going through all symbols.  Symbols with only
+   local binding might not be found when the lookup goes through the
+   ELF hash table of a dynamic symbol table.  */
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+static int
+binding_rank (const GElf_Sym *sym)
+{
+  switch (GELF_ST_BIND (sym->st_info))
+    {
+    case STB_GLOBAL:
+      return 3;
+    case STB_WEAK:
+      return 2;
+    case STB_LOCAL:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+static bool
+usable (const char *name, const GElf_Sym *sym)
+{
+  return (name != NULL && name[0] != '\0'
+	  && sym->st_shndx != SHN_UNDEF
+	  && GELF_ST_TYPE (sym->st_info) != STT_SECTION
+	  && GELF_ST_TYPE (sym->st_info) != STT_FILE);
+}
+
+/* The symbol dwfl_module_symbol_by_name should find for NAME.  */
+static int
+expected_symbol (Dwfl_Module *mod, int nsyms, const char *name, int *rank)
+{
+  int best = -1;
+  for (int i = 1; i < nsyms; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr addr;
+      const char *symname = dwfl_module_getsym_info (mod, i, &sym, &addr,
+						     NULL, NULL, NULL);
+      if (usable (symname, &sym) && strcmp (symname, name) == 0
+	  && (best < 0 || binding_rank (&sym) > *rank))
+	{
+	  best = i;
+	  *rank = binding_rank (&sym);
+	}
+    }
+  return best;
+}
+
+static int
+handle_file (const char *file)
+{
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, file, file, -1);
+  if (mod == NULL || dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("%s: dwfl_report_offline: %s\n", file, dwfl_errmsg (-1));
+      dwfl_end (dwfl);
+      return -1;
+    }
+
+  int nsyms = dwfl_module_getsymtab (mod);
+  if (nsyms < 0)
+    {
+      printf ("%s: dwfl_module_getsymtab: %s\n", file, dwfl_errmsg (-1));
+      dwfl_end (dwfl);
+      return -1;
+    }
+
+  int result = 0;
+  size_t found = 0;
+  size_t names = 0;
+  for (int i = 1; i < nsyms; i++)
+    {
+      GElf_Sym sym;
+      GElf_Addr addr;
+      const char *name = dwfl_module_getsym_info (mod, i, &sym, &addr,
+						  NULL, NULL, NULL);
+      if (! usable (name, &sym))
+	continue;
+
+      int rank;
+      int expected = expected_symbol (mod, nsyms, name, &rank);
+      if (expected != i)
+	continue;
+      names++;
+
+      GElf_Sym fsym;
+      GElf_Addr faddr;
+      int ndx = dwfl_module_symbol_by_name (mod, name, &fsym, &faddr,
+					    NULL, NULL, NULL);
+      if (ndx < 0 && GELF_ST_BIND (sym.st_info) == STB_LOCAL)
+	continue;
+      if (ndx != expected || faddr != addr
+	  || memcmp (&fsym, &sym, sizeof sym) != 0)
+	{
+	  printf ("%s: %s: found %d at %#" PRIx64 ", expected %d at %#"
+		  PRIx64 "\n", file, name, ndx, faddr, expected, addr);
+	  result = -1;
+	}
+      else
+	found++;
+    }
+
+  GElf_Sym sym;
+  GElf_Addr addr;
+  if (dwfl_module_symbol_by_name (mod, "no such symbol", &sym, &addr,
+				  NULL, NULL, NULL) != -1)
+    {
+      printf ("%s: found a symbol that doesn't exist\n", file);
+      result = -1;
+    }
+
+  if (result == 0)
+    printf ("%s: %zd names, %zd found\n", file, names, found);
+
+  dwfl_end (dwfl);
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+  for (int i = 1; i < argc; i++)
+    if (handle_file (argv[i]) != 0)
+      result = 1;
+  return result;
+}
@@ -0,0 +1,276 @@
+/* Test dwfl_set_unwind_policy and dwfl_module_set_unwind_policy.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include ELFUTILS_HEADER(dwfl)
+
+#if !defined __linux__ || !defined __x86_64__
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: Unwinding not supported for this architecture\n",
+	   argv[0]);
+  return 77;
+}
+
+#else /* __linux__ && __x86_64__ */
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+/* Usage: dwfl-unwind-policy
+   Forks a child, built with frame pointers, that stops with DEPTH + 1
+   recurse frames on its stack.  Between main and those frames is
+   call_with_bad_fp, which has CFI but points the frame pointer at a
+   fake frame with return address BAD_PC.  Unwinds the child with CFI,
+   with the frame pointer for the main executable, and with only the
+   frame pointer for the main executable.  */
+
+#define DEPTH 50
+#define MAXPCS 1024
+#define BAD_PC 0x10
+
+int call_with_bad_fp (int (*fn) (void));
+
+asm (".pushsection .text\n"
+     ".globl call_with_bad_fp\n"
+     ".type call_with_bad_fp, @function\n"
+     "call_with_bad_fp:\n"
+     ".cfi_startproc\n"
+     "	push %rbp\n"
+     ".cfi_def_cfa_offset 16\n"
+     ".cfi_offset %rbp, -16\n"
+     "	sub $16, %rsp\n"
+     ".cfi_def_cfa_offset 32\n"
+     "	movq $0, (%rsp)\n"
+     "	movq $16, 8(%rsp)\n"
+     "	mov %rsp, %rbp\n"
+     "	call *%rdi\n"
+     "	add $16, %rsp\n"
+     ".cfi_def_cfa_offset 16\n"
+     "	pop %rbp\n"
+     ".cfi_def_cfa_offset 8\n"
+     "	ret\n"
+     ".cfi_endproc\n"
+     ".size call_with_bad_fp, .-call_with_bad_fp\n"
+     ".popsection\n");
+
+int recurse (int depth) __attribute__ ((noinline, noclone));
+
+int
+recurse (int depth)
+{
+  volatile char buf[64];
+  buf[0] = depth;
+  if (depth == 0)
+    raise (SIGUSR2);
+  else
+    recurse (depth - 1);
+  return buf[0];
+}
+
+static int __attribute__ ((noinline, noclone))
+start (void)
+{
+  int ret = recurse (DEPTH);
+  /* No tail call, keep this frame.  */
+  asm volatile ("" ::: "memory");
+  return ret;
+}
+
+struct frames
+{
+  Dwarf_Addr pcs[MAXPCS];
+  Dwfl_Unwind_Method methods[MAXPCS];
+  size_t n;
+};
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct frames *frames = arg;
+  if (! dwfl_frame_pc (state, &frames->pcs[frames->n], NULL))
+    error (EXIT_FAILURE, 0, "dwfl_frame_pc: %s", dwfl_errmsg (-1));
+  frames->methods[frames->n] = dwfl_frame_unwind_method (state);
+  return ++frames->n < MAXPCS ? DWARF_CB_OK : DWARF_CB_ABORT;
+}
+
+static size_t
+count_method (const struct frames *frames, Dwfl_Unwind_Method method)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < frames->n; i++)
+    if (frames->methods[i] == method)
+      count++;
+  return count;
+}
+
+static size_t
+count_recurse (Dwfl *dwfl, const struct frames *frames)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < frames->n; i++)
+    {
+      Dwarf_Addr pc = frames->pcs[i] - (i == 0 ? 0 : 1);
+      Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc);
+      const char *name = mod != NULL ? dwfl_module_addrname (mod, pc) : NULL;
+      if (name != NULL && strcmp (name, "recurse") == 0)
+	count++;
+    }
+  return count;
+}
+
+static struct frames expected, frames;
+static size_t cfi_frames, fp_frames, rejected;
+
+/* Unwind into FRAMES, return the frame pointer frames counted by
+   dwfl_unwind_stats meanwhile.  */
+static size_t
+unwind (Dwfl *dwfl, pid_t pid)
+{
+  size_t fp_before = fp_frames;
+  frames.n = 0;
+  dwfl_getthread_frames (dwfl, pid, frame_callback, &frames);
+  if (dwfl_unwind_stats (dwfl, &cfi_frames, &fp_frames, &rejected) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_unwind_stats failed");
+  return fp_frames - fp_before;
+}
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  elf_version (EV_CURRENT);
+
+  pid_t pid = fork ();
+  switch (pid)
+    {
+    case -1:
+      error (EXIT_FAILURE, errno, "fork");
+    case 0:
+      if (ptrace (PTRACE_TRACEME, 0, NULL, NULL) != 0)
+	error (EXIT_FAILURE, errno, "PTRACE_TRACEME");
+      exit (call_with_bad_fp (start));
+    default:
+      break;
+    }
+
+  int status;
+  if (waitpid (pid, &status, 0) != pid)
+    error (EXIT_FAILURE, errno, "waitpid");
+  if (! WIFSTOPPED (status) || WSTOPSIG (status) != SIGUSR2)
+    error (EXIT_FAILURE, 0, "unexpected wait status %#x", status);
+
+  static char *debuginfo_path;
+  static const Dwfl_Callbacks proc_callbacks =
+    {
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+      .find_elf = dwfl_linux_proc_find_elf,
+    };
+  Dwfl *dwfl = dwfl_begin (&proc_callbacks);
+  if (dwfl == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  int result = dwfl_linux_proc_report (dwfl, pid);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_report: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_report");
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  result = dwfl_linux_proc_attach (dwfl, pid, true);
+  if (result < 0)
+    error (EXIT_FAILURE, 0, "dwfl_linux_proc_attach: %s", dwfl_errmsg (-1));
+  else if (result > 0)
+    error (EXIT_FAILURE, result, "dwfl_linux_proc_attach");
+
+  /* The default policy uses the CFI everywhere.  */
+  if (unwind (dwfl, pid) != 0)
+    error (EXIT_FAILURE, 0, "frame pointer used by default");
+  expected = frames;
+  size_t nrecurse = count_recurse (dwfl, &expected);
+  if (nrecurse <= DEPTH)
+    {
+      fprintf (stderr, "%s: Unwinding not supported for this architecture"
+	       " (%zu recurse frames)\n", argv[0], nrecurse);
+      kill (pid, SIGKILL);
+      return 77;
+    }
+  if (expected.methods[0] != DWFL_UNWIND_INITIAL
+      || count_method (&expected, DWFL_UNWIND_CFI) != expected.n - 1)
+    error (EXIT_FAILURE, 0, "not all frames unwound by CFI");
+  printf ("default: %zu recurse frames, all by cfi\n", nrecurse);
+
+  if (dwfl_set_unwind_policy (dwfl, (Dwfl_Unwind_Policy) 42) != -1)
+    error (EXIT_FAILURE, 0, "invalid policy accepted");
+
+  /* The frame pointer of every frame in the main executable, only the
+     one of call_with_bad_fp is rejected.  Its caller main and the
+     callers of start and of all recurse frames are unwound with the
+     frame pointer.  */
+  Dwfl_Module *mod = dwfl_addrmodule (dwfl, (Dwarf_Addr) &recurse);
+  if (mod == NULL)
+    error (EXIT_FAILURE, 0, "dwfl_addrmodule: %s", dwfl_errmsg (-1));
+  if (dwfl_module_set_unwind_policy (mod,
+				     DWFL_UNWIND_POLICY_FRAME_POINTER) != 0)
+    error (EXIT_FAILURE, 0, "dwfl_module_set_unwind_policy: %s",
+	   dwfl_errmsg (-1));
+  size_t rejected_before = rejected;
+  size_t nfp = unwind (dwfl, pid);
+  if (frames.n != expected.n
+      || memcmp (frames.pcs, expected.pcs, frames.n * sizeof frames.pcs[0]))
+    error (EXIT_FAILURE, 0, "%zu frames, %zu expected", frames.n, expected.n);
+  if (count_method (&frames, DWFL_UNWIND_FRAME_POINTER) != nfp)
+    error (EXIT_FAILURE, 0, "%zu frame pointer frames counted", nfp);
+  printf ("frame pointer: same frames, %zu by frame pointer, %zu rejected\n",
+	  nfp, rejected - rejected_before);
+
+  /* Without the check, unwinding ends in the fake frame.  */
+  if (dwfl_module_set_unwind_policy (mod,
+				     DWFL_UNWIND_POLICY_FRAME_POINTER_ONLY)
+      != 0)
+    error (EXIT_FAILURE, 0, "dwfl_module_set_unwind_policy: %s",
+	   dwfl_errmsg (-1));
+  unwind (dwfl, pid);
+  if (frames.n == 0 || frames.pcs[frames.n - 1] != BAD_PC
+      || memcmp (frames.pcs, expected.pcs,
+		 (frames.n - 1) * sizeof frames.pcs[0]) != 0)
+    error (EXIT_FAILURE, 0, "frame pointer only: unexpected frames");
+  printf ("frame pointer only: ends at %#x\n", BAD_PC);
+
+  /* Back to the policy of DWFL.  */
+  dwfl_module_set_unwind_policy (mod, DWFL_UNWIND_POLICY_DEFAULT);
+  if (unwind (dwfl, pid) != 0 || frames.n != expected.n)
+    error (EXIT_FAILURE, 0, "default policy not restored");
+  printf ("default again: same frames\n");
+
+  dwfl_end (dwfl);
+  kill (pid, SIGKILL);
+  waitpid (pid, &status, 0);
+  return 0;
+}
+
+#endif /* __linux__ && __x86_64__ */
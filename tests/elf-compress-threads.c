@@ -0,0 +1,171 @@
+/* Test elf_compress with compression levels, threads and zstd.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+/* Usage: elf-compress-threads FILE
+   Creates FILE with a section of SIZE bytes, split over two Elf_Data,
+   and compresses it with every combination of type, level and number
+   of threads below.  Checks that a zlib compressed section inflates
+   with plain zlib and that every section decompresses to the original
+   data again.  zstd compression is skipped when libelf doesn't
+   support it.  */
+
+/* Several chunks for the threads, not a multiple of the chunk size.  */
+#define SIZE (1024 * 1024 + 12345)
+#define SPLIT (300 * 1000)
+
+static unsigned char *orig;
+
+static void
+compress_and_check (Elf_Scn *scn, int type, unsigned int level,
+		    unsigned int threads)
+{
+  char what[64];
+  snprintf (what, sizeof what, "%s level %u threads %u",
+	    type == ELFCOMPRESS_ZLIB ? "zlib" : "zstd", level, threads);
+
+  unsigned int flags = ELF_CHF_LEVEL (level) | ELF_CHF_THREADS (threads);
+  if (elf_compress (scn, type, flags) != 1)
+    error (EXIT_FAILURE, 0, "%s: elf_compress: %s", what, elf_errmsg (-1));
+
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL || (shdr->sh_flags & SHF_COMPRESSED) == 0
+      || shdr->sh_size >= SIZE)
+    error (EXIT_FAILURE, 0, "%s: not compressed", what);
+
+  GElf_Chdr chdr;
+  if (gelf_getchdr (scn, &chdr) == NULL)
+    error (EXIT_FAILURE, 0, "%s: gelf_getchdr: %s", what, elf_errmsg (-1));
+  if (chdr.ch_type != (unsigned int) type || chdr.ch_size != SIZE)
+    error (EXIT_FAILURE, 0, "%s: bad compression header", what);
+
+  if (type == ELFCOMPRESS_ZLIB)
+    {
+      /* Whatever the threads did, it has to be one zlib stream.  */
+      Elf_Data *data = elf_rawdata (scn, NULL);
+      size_t hsize = sizeof (Elf64_Chdr);
+      uLongf size = SIZE;
+      unsigned char *buf = malloc (SIZE);
+      if (buf == NULL)
+	error (EXIT_FAILURE, errno, "malloc");
+      if (uncompress (buf, &size, (Bytef *) data->d_buf + hsize,
+		      data->d_size - hsize) != Z_OK
+	  || size != SIZE || memcmp (buf, orig, SIZE) != 0)
+	error (EXIT_FAILURE, 0, "%s: zlib inflate failed", what);
+      free (buf);
+    }
+
+  if (elf_compress (scn, 0, 0) != 1)
+    error (EXIT_FAILURE, 0, "%s: decompress: %s", what, elf_errmsg (-1));
+  Elf_Data *data = elf_getdata (scn, NULL);
+  if (data == NULL || data->d_size != SIZE
+      || memcmp (data->d_buf, orig, SIZE) != 0)
+    error (EXIT_FAILURE, 0, "%s: bad decompressed data", what);
+
+  printf ("%s: OK\n", what);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    error (EXIT_FAILURE, 0, "Usage: %s FILE", argv[0]);
+
+  /* Compressible, but not trivially.  */
+  orig = malloc (SIZE);
+  if (orig == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  uint32_t seed = 42;
+  for (size_t i = 0; i < SIZE; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      orig[i] = "abcdefgh"[(seed >> 16) & 7] + (i % 4096 == 0);
+    }
+
+  elf_version (EV_CURRENT);
+  int fd = open (argv[1], O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", argv[1]);
+  Elf *elf = elf_begin (fd, ELF_C_WRITE, NULL);
+  if (elf == NULL || gelf_newehdr (elf, ELFCLASS64) == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr->e_version = EV_CURRENT;
+  if (gelf_update_ehdr (elf, ehdr) == 0)
+    error (EXIT_FAILURE, 0, "gelf_update_ehdr: %s", elf_errmsg (-1));
+
+  Elf_Scn *scn = elf_newscn (elf);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL)
+    error (EXIT_FAILURE, 0, "gelf_getshdr: %s", elf_errmsg (-1));
+  shdr->sh_type = SHT_PROGBITS;
+  shdr->sh_addralign = 1;
+  gelf_update_shdr (scn, shdr);
+
+  /* Two pieces, so the data has to be put together first.  */
+  Elf_Data *data = elf_newdata (scn);
+  data->d_buf = orig;
+  data->d_size = SPLIT;
+  data->d_align = 1;
+  data = elf_newdata (scn);
+  data->d_buf = orig + SPLIT;
+  data->d_size = SIZE - SPLIT;
+  data->d_align = 1;
+
+  static const unsigned int levels[] = { 0, 1, 6, 9 };
+  static const unsigned int nthreads[] = { 1, 2, 4 };
+  for (size_t l = 0; l < sizeof levels / sizeof levels[0]; l++)
+    for (size_t t = 0; t < sizeof nthreads / sizeof nthreads[0]; t++)
+      compress_and_check (scn, ELFCOMPRESS_ZLIB, levels[l], nthreads[t]);
+
+  if (elf_compress (scn, ELFCOMPRESS_ZSTD, 0) < 0)
+    printf ("zstd not supported\n");
+  else if (elf_compress (scn, 0, 0) != 1)
+    error (EXIT_FAILURE, 0, "zstd: decompress: %s", elf_errmsg (-1));
+  else
+    for (size_t t = 0; t < sizeof nthreads / sizeof nthreads[0]; t++)
+      compress_and_check (scn, ELFCOMPRESS_ZSTD, 3, nthreads[t]);
+
+  /* Unknown flags are still rejected.  */
+  if (elf_compress (scn, ELFCOMPRESS_ZLIB, 0x80000000) != -1)
+    error (EXIT_FAILURE, 0, "unknown flag accepted");
+
+  elf_end (elf);
+  close (fd);
+  free (orig);
+  return 0;
+}
@@ -0,0 +1,193 @@
+/* Test elf_data_stats and that data is used in place.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <endian.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <error.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+/* Usage: elf-data-stats FILE
+   Writes FILE in both byte orders with a 3 byte section followed by an
+   unaligned SHT_INIT_ARRAY section.  Reads both sections with
+   elf_getdata and the array again with elf_getdata_rawchunk, checks
+   the values and checks with elf_data_stats that the unaligned data is
+   copied, unless ELF_F_UNALIGNED is set and the architecture allows
+   unaligned accesses.  Then only the data of the other byte order is
+   copied.  */
+
+#define NADDR 100
+
+static void
+write_file (const char *fname, int encoding)
+{
+  int fd = open (fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = elf_begin (fd, ELF_C_WRITE, NULL);
+  if (elf == NULL || gelf_newehdr (elf, ELFCLASS64) == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  ehdr->e_ident[EI_DATA] = encoding;
+  ehdr->e_version = EV_CURRENT;
+  if (gelf_update_ehdr (elf, ehdr) == 0)
+    error (EXIT_FAILURE, 0, "gelf_update_ehdr: %s", elf_errmsg (-1));
+
+  static char bytes[3] = "abc";
+  static uint64_t addrs[NADDR];
+  for (size_t i = 0; i < NADDR; i++)
+    addrs[i] = 0x0102030405060708ULL * (i + 1);
+
+  for (int i = 0; i < 2; i++)
+    {
+      Elf_Scn *scn = elf_newscn (elf);
+      GElf_Shdr mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+      if (shdr == NULL)
+	error (EXIT_FAILURE, 0, "gelf_getshdr: %s", elf_errmsg (-1));
+      shdr->sh_type = i == 0 ? SHT_PROGBITS : SHT_INIT_ARRAY;
+      shdr->sh_addralign = 1;
+      gelf_update_shdr (scn, shdr);
+      Elf_Data *data = elf_newdata (scn);
+      data->d_buf = i == 0 ? (void *) bytes : (void *) addrs;
+      data->d_size = i == 0 ? sizeof bytes : sizeof addrs;
+      data->d_type = i == 0 ? ELF_T_BYTE : ELF_T_ADDR;
+      data->d_align = 1;
+    }
+
+  if (elf_update (elf, ELF_C_WRITE) < 0)
+    error (EXIT_FAILURE, 0, "elf_update: %s", elf_errmsg (-1));
+  elf_end (elf);
+  close (fd);
+}
+
+static void
+check_addrs (const void *buf, const char *what)
+{
+  for (size_t i = 0; i < NADDR; i++)
+    {
+      uint64_t addr;
+      memcpy (&addr, (const char *) buf + i * sizeof addr, sizeof addr);
+      if (addr != 0x0102030405060708ULL * (i + 1))
+	error (EXIT_FAILURE, 0, "%s: bad address %zu", what, i);
+    }
+}
+
+static void
+check_stats (Elf *elf, const char *what, size_t mapped, size_t copied)
+{
+  size_t m, c;
+  if (elf_data_stats (elf, &m, &c) != 0)
+    error (EXIT_FAILURE, 0, "elf_data_stats: %s", elf_errmsg (-1));
+  if (m != mapped || c != copied)
+    error (EXIT_FAILURE, 0, "%s: %zu bytes mapped, %zu copied,"
+	   " expected %zu and %zu", what, m, c, mapped, copied);
+}
+
+static void
+read_file (const char *fname, int encoding, bool unaligned, const char *what)
+{
+  int fd = open (fname, O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (elf == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  if (unaligned)
+    elf_flagelf (elf, ELF_C_SET, ELF_F_UNALIGNED);
+  check_stats (elf, what, 0, 0);
+
+  char *file = elf_rawfile (elf, NULL);
+  Elf_Data *bytes = elf_getdata (elf_getscn (elf, 1), NULL);
+  Elf_Scn *scn = elf_getscn (elf, 2);
+  Elf_Data *addrs = elf_getdata (scn, NULL);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (bytes == NULL || addrs == NULL || shdr == NULL)
+    error (EXIT_FAILURE, 0, "%s: elf_getdata: %s", what, elf_errmsg (-1));
+  if (addrs->d_type != ELF_T_ADDR || addrs->d_size != NADDR * 8)
+    error (EXIT_FAILURE, 0, "%s: bad data", what);
+  if (shdr->sh_offset % 8 == 0)
+    error (EXIT_FAILURE, 0, "%s: section is aligned", what);
+  check_addrs (addrs->d_buf, what);
+
+  /* Data that needs converting is always copied, unaligned data
+     unless the caller said it can use it.  */
+  size_t size = addrs->d_size;
+  int in_place = (encoding == (BYTE_ORDER == LITTLE_ENDIAN
+			       ? ELFDATA2LSB : ELFDATA2MSB)
+		  && unaligned && ALLOW_UNALIGNED);
+  if (((uintptr_t) addrs->d_buf & 7) != 0 && !in_place)
+    error (EXIT_FAILURE, 0, "%s: addresses not aligned", what);
+  GElf_Shdr bytes_mem;
+  GElf_Shdr *bytes_shdr = gelf_getshdr (elf_getscn (elf, 1), &bytes_mem);
+  if (bytes_shdr == NULL || bytes->d_buf != file + bytes_shdr->sh_offset)
+    error (EXIT_FAILURE, 0, "%s: bytes not used in place", what);
+  if (in_place && addrs->d_buf != file + shdr->sh_offset)
+    error (EXIT_FAILURE, 0, "%s: addresses not used in place", what);
+  check_stats (elf, what, 3 + (in_place ? size : 0), in_place ? 0 : size);
+
+  Elf_Data *chunk = elf_getdata_rawchunk (elf, shdr->sh_offset, size,
+					  ELF_T_ADDR);
+  if (chunk == NULL)
+    error (EXIT_FAILURE, 0, "%s: elf_getdata_rawchunk: %s",
+	   what, elf_errmsg (-1));
+  check_addrs (chunk->d_buf, what);
+  if (((uintptr_t) chunk->d_buf & 7) != 0 && !in_place)
+    error (EXIT_FAILURE, 0, "%s: chunk not aligned", what);
+  if (in_place && chunk->d_buf != file + shdr->sh_offset)
+    error (EXIT_FAILURE, 0, "%s: chunk not used in place", what);
+  check_stats (elf, what, 3 + (in_place ? 2 * size : 0),
+	       in_place ? 0 : 2 * size);
+
+  elf_end (elf);
+  close (fd);
+  printf ("%s: OK\n", what);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    error (EXIT_FAILURE, 0, "Usage: %s FILE", argv[0]);
+
+  elf_version (EV_CURRENT);
+
+  write_file (argv[1], ELFDATA2LSB);
+  read_file (argv[1], ELFDATA2LSB, false, "LSB");
+  read_file (argv[1], ELFDATA2LSB, true, "LSB unaligned");
+  write_file (argv[1], ELFDATA2MSB);
+  read_file (argv[1], ELFDATA2MSB, false, "MSB");
+  read_file (argv[1], ELFDATA2MSB, true, "MSB unaligned");
+
+  if (elf_data_stats (NULL, NULL, NULL) != -1)
+    error (EXIT_FAILURE, 0, "elf_data_stats (NULL) succeeded");
+
+  return 0;
+}
@@ -0,0 +1,217 @@
+/* Test elf_update with ELF_F_THREADS and ELF_F_FALLOCATE.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <endian.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+/* Usage: elf-update-batch FILE1 FILE2
+   Writes FILE1 in the other byte order with a symbol table big enough
+   to be converted in pieces, relocations, and many small sections with
+   fill bytes between them.  Writes FILE2 the same with ELF_F_THREADS
+   and ELF_F_FALLOCATE, on one thread per CPU and then on four threads
+   whatever the number of CPUs.  Checks that the files are the same and
+   reads the sections and fill bytes back.  */
+
+/* Linked statically to libelf to set this.  */
+extern unsigned int __libelf_update_threads;
+
+#define NSYMS (200 * 1000)
+#define NRELAS 1000
+#define NSMALL 700
+#define FILL 0xaa
+
+static void
+add_section (Elf *elf, Elf64_Word type, Elf64_Xword align, void *buf,
+	     size_t size, Elf_Type dtype)
+{
+  Elf_Scn *scn = elf_newscn (elf);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL)
+    error (EXIT_FAILURE, 0, "gelf_getshdr: %s", elf_errmsg (-1));
+  shdr->sh_type = type;
+  shdr->sh_addralign = align;
+  shdr->sh_entsize = gelf_fsize (elf, dtype, 1, EV_CURRENT);
+  gelf_update_shdr (scn, shdr);
+  Elf_Data *data = elf_newdata (scn);
+  data->d_buf = buf;
+  data->d_size = size;
+  data->d_type = dtype;
+  data->d_align = align;
+}
+
+static Elf64_Sym *syms;
+static Elf64_Rela *relas;
+static char small[3] = "xyz";
+
+static void
+write_file (const char *fname, unsigned int flags)
+{
+  int fd = open (fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = elf_begin (fd, ELF_C_WRITE, NULL);
+  if (elf == NULL || gelf_newehdr (elf, ELFCLASS64) == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  ehdr->e_ident[EI_DATA] = (BYTE_ORDER == LITTLE_ENDIAN
+			    ? ELFDATA2MSB : ELFDATA2LSB);
+  ehdr->e_version = EV_CURRENT;
+  if (gelf_update_ehdr (elf, ehdr) == 0)
+    error (EXIT_FAILURE, 0, "gelf_update_ehdr: %s", elf_errmsg (-1));
+
+  add_section (elf, SHT_SYMTAB, 8, syms, NSYMS * sizeof *syms, ELF_T_SYM);
+  add_section (elf, SHT_RELA, 8, relas, NRELAS * sizeof *relas, ELF_T_RELA);
+  for (int i = 0; i < NSMALL; i++)
+    add_section (elf, SHT_PROGBITS, 16, small, sizeof small, ELF_T_BYTE);
+
+  elf_flagelf (elf, ELF_C_SET, flags);
+  if (elf_update (elf, ELF_C_WRITE) < 0)
+    error (EXIT_FAILURE, 0, "elf_update: %s", elf_errmsg (-1));
+  elf_end (elf);
+  close (fd);
+}
+
+static char *
+read_whole (const char *fname, size_t *size)
+{
+  int fd = open (fname, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  char *buf = malloc (st.st_size);
+  if (buf == NULL || read (fd, buf, st.st_size) != st.st_size)
+    error (EXIT_FAILURE, errno, "read %s", fname);
+  close (fd);
+  *size = st.st_size;
+  return buf;
+}
+
+static void
+check_file (const char *fname)
+{
+  size_t size;
+  char *contents = read_whole (fname, &size);
+
+  int fd = open (fname, O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+
+  Elf_Data *data = elf_getdata (elf_getscn (elf, 1), NULL);
+  if (data == NULL || data->d_size != NSYMS * sizeof *syms)
+    error (EXIT_FAILURE, 0, "bad symbol table");
+  for (int i = 0; i < NSYMS; i++)
+    {
+      GElf_Sym sym;
+      if (gelf_getsym (data, i, &sym) == NULL
+	  || memcmp (&sym, &syms[i], sizeof sym) != 0)
+	error (EXIT_FAILURE, 0, "bad symbol %d", i);
+    }
+
+  data = elf_getdata (elf_getscn (elf, 2), NULL);
+  if (data == NULL || data->d_size != NRELAS * sizeof *relas
+      || memcmp (data->d_buf, relas, data->d_size) != 0)
+    error (EXIT_FAILURE, 0, "bad relocations");
+
+  /* Everything between the small sections is fill.  */
+  size_t end = 0;
+  for (int i = 0; i < NSMALL; i++)
+    {
+      GElf_Shdr mem;
+      GElf_Shdr *shdr = gelf_getshdr (elf_getscn (elf, 3 + i), &mem);
+      if (shdr == NULL || shdr->sh_offset % 16 != 0
+	  || memcmp (contents + shdr->sh_offset, small, sizeof small) != 0)
+	error (EXIT_FAILURE, 0, "bad section %d", 3 + i);
+      for (size_t j = end; i > 0 && j < shdr->sh_offset; j++)
+	if ((unsigned char) contents[j] != FILL)
+	  error (EXIT_FAILURE, 0, "no fill byte at %zu", j);
+      end = shdr->sh_offset + sizeof small;
+    }
+
+  elf_end (elf);
+  close (fd);
+  free (contents);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    error (EXIT_FAILURE, 0, "Usage: %s FILE1 FILE2", argv[0]);
+
+  syms = malloc (NSYMS * sizeof *syms);
+  relas = malloc (NRELAS * sizeof *relas);
+  if (syms == NULL || relas == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  for (int i = 0; i < NSYMS; i++)
+    {
+      syms[i].st_name = i;
+      syms[i].st_info = GELF_ST_INFO (STB_GLOBAL, STT_FUNC);
+      syms[i].st_other = i % 4;
+      syms[i].st_shndx = i % 7;
+      syms[i].st_value = 0x400000 + i * 16;
+      syms[i].st_size = i;
+    }
+  for (int i = 0; i < NRELAS; i++)
+    {
+      relas[i].r_offset = i * 8;
+      relas[i].r_info = GELF_R_INFO (i, 1);
+      relas[i].r_addend = -i;
+    }
+
+  elf_version (EV_CURRENT);
+  elf_fill (FILL);
+
+  write_file (argv[1], 0);
+  check_file (argv[1]);
+  size_t size1, size2;
+  char *contents1 = read_whole (argv[1], &size1);
+  for (unsigned int threads = 0; threads <= 4; threads += 4)
+    {
+      __libelf_update_threads = threads;
+      write_file (argv[2], ELF_F_THREADS | ELF_F_FALLOCATE);
+      check_file (argv[2]);
+
+      char *contents2 = read_whole (argv[2], &size2);
+      if (size1 != size2 || memcmp (contents1, contents2, size1) != 0)
+	error (EXIT_FAILURE, 0, "files differ with %u threads", threads);
+      free (contents2);
+    }
+
+  free (contents1);
+  free (syms);
+  free (relas);
+  return 0;
+}
@@ -0,0 +1,327 @@
+/* Test elf_zdata_pread.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <endian.h>
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+#ifndef __GLIBC__
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  fprintf (stderr, "%s: Needs the glibc allocator\n", argv[0]);
+  return 77;
+}
+
+#else /* __GLIBC__ */
+
+/* Usage: elf-zdata-pread FILE
+   Writes FILE with a compressed section of SIZE bytes, compressed with
+   zlib, zstd, zstd in frames and zstd in two frames the first of which
+   is too big to be cached whole (when libelf supports zstd), and reads
+   it back in pieces with elf_zdata_pread, sequentially and at random
+   offsets.  Checks the data read and that no allocation as big as half
+   the section was made while reading it.  */
+
+#define SIZE (6 * 1024 * 1024 + 4321)
+#define PIECE (64 * 1024 + 7)
+#define NRANDOM 200
+
+/* Track the biggest allocation by interposing the glibc allocator.  */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static size_t max_alloc;
+
+void *
+malloc (size_t size)
+{
+  if (size > max_alloc)
+    max_alloc = size;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  if (nmemb * size > max_alloc)
+    max_alloc = nmemb * size;
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  if (size > max_alloc)
+    max_alloc = size;
+  return __libc_realloc (ptr, size);
+}
+
+static unsigned char *orig;
+static unsigned char *buf;
+
+/* Return a new ELF file for writing to FD, with an ELF header.  */
+static Elf *
+new_elf (int fd, int encoding)
+{
+  Elf *elf = elf_begin (fd, ELF_C_WRITE, NULL);
+  if (elf == NULL || gelf_newehdr (elf, ELFCLASS64) == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  ehdr->e_ident[EI_DATA] = encoding;
+  ehdr->e_version = EV_CURRENT;
+  if (gelf_update_ehdr (elf, ehdr) == 0)
+    error (EXIT_FAILURE, 0, "gelf_update_ehdr: %s", elf_errmsg (-1));
+  return elf;
+}
+
+/* Write FNAME with section 1 compressed with TYPE and FLAGS.  Returns
+   false if TYPE isn't supported.  */
+static bool
+write_file (const char *fname, int type, unsigned int flags)
+{
+  int fd = open (fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = new_elf (fd, ELFDATA2LSB);
+
+  Elf_Scn *scn = elf_newscn (elf);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL)
+    error (EXIT_FAILURE, 0, "gelf_getshdr: %s", elf_errmsg (-1));
+  shdr->sh_type = SHT_PROGBITS;
+  shdr->sh_addralign = 1;
+  gelf_update_shdr (scn, shdr);
+  Elf_Data *data = elf_newdata (scn);
+  data->d_buf = orig;
+  data->d_size = SIZE;
+  data->d_align = 1;
+
+  bool supported = elf_compress (scn, type, flags) == 1;
+  if (supported && elf_update (elf, ELF_C_WRITE) < 0)
+    error (EXIT_FAILURE, 0, "elf_update: %s", elf_errmsg (-1));
+
+  elf_end (elf);
+  close (fd);
+  return supported;
+}
+
+/* Return the zstd frame libelf compresses the N bytes at P to, and
+   its size in *FSIZE.  FNAME is opened, but not written.  */
+static unsigned char *
+zstd_frame (const char *fname, const unsigned char *p, size_t n,
+	    size_t *fsize)
+{
+  int fd = open (fname, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = new_elf (fd, ELFDATA2LSB);
+  Elf_Scn *scn = elf_newscn (elf);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL)
+    error (EXIT_FAILURE, 0, "gelf_getshdr: %s", elf_errmsg (-1));
+  shdr->sh_type = SHT_PROGBITS;
+  gelf_update_shdr (scn, shdr);
+  Elf_Data *data = elf_newdata (scn);
+  data->d_buf = (void *) p;
+  data->d_size = n;
+  data->d_align = 1;
+  if (elf_compress (scn, ELFCOMPRESS_ZSTD, 0) != 1)
+    error (EXIT_FAILURE, 0, "elf_compress: %s", elf_errmsg (-1));
+  data = elf_getdata (scn, NULL);
+  if (data == NULL)
+    error (EXIT_FAILURE, 0, "elf_getdata: %s", elf_errmsg (-1));
+  *fsize = data->d_size - sizeof (Elf64_Chdr);
+  unsigned char *frame = malloc (*fsize);
+  if (frame == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  memcpy (frame, (char *) data->d_buf + sizeof (Elf64_Chdr), *fsize);
+  elf_end (elf);
+  close (fd);
+  return frame;
+}
+
+/* Write FNAME with section 1 compressed with zstd in two frames, the
+   first one holding FIRST bytes.  */
+static void
+write_frames_file (const char *fname, size_t first)
+{
+  size_t size1, size2;
+  unsigned char *frame1 = zstd_frame (fname, orig, first, &size1);
+  unsigned char *frame2 = zstd_frame (fname, orig + first, SIZE - first,
+				      &size2);
+  size_t size = sizeof (Elf64_Chdr) + size1 + size2;
+  unsigned char *zdata = malloc (size);
+  if (zdata == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  Elf64_Chdr chdr = { .ch_type = htole32 (ELFCOMPRESS_ZSTD),
+		      .ch_size = htole64 (SIZE),
+		      .ch_addralign = htole64 (1) };
+  memcpy (zdata, &chdr, sizeof chdr);
+  memcpy (zdata + sizeof chdr, frame1, size1);
+  memcpy (zdata + sizeof chdr + size1, frame2, size2);
+
+  int fd = open (fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = new_elf (fd, ELFDATA2LSB);
+
+  Elf_Scn *scn = elf_newscn (elf);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL)
+    error (EXIT_FAILURE, 0, "gelf_getshdr: %s", elf_errmsg (-1));
+  shdr->sh_type = SHT_PROGBITS;
+  shdr->sh_flags = SHF_COMPRESSED;
+  shdr->sh_addralign = 8;
+  gelf_update_shdr (scn, shdr);
+  Elf_Data *data = elf_newdata (scn);
+  data->d_buf = zdata;
+  data->d_size = size;
+  data->d_align = 8;
+
+  if (elf_update (elf, ELF_C_WRITE) < 0)
+    error (EXIT_FAILURE, 0, "elf_update: %s", elf_errmsg (-1));
+  elf_end (elf);
+  close (fd);
+  free (zdata);
+  free (frame1);
+  free (frame2);
+}
+
+static void
+check_read (Elf_Scn *scn, const char *what, size_t size, int64_t offset)
+{
+  size_t expect = (offset >= SIZE ? 0
+		   : size < SIZE - offset ? size : SIZE - offset);
+  ssize_t n = elf_zdata_pread (scn, buf, size, offset);
+  if (n < 0)
+    error (EXIT_FAILURE, 0, "%s: elf_zdata_pread (%zu, %" PRId64 "): %s",
+	   what, size, offset, elf_errmsg (-1));
+  if ((size_t) n != expect || memcmp (buf, orig + offset, expect) != 0)
+    error (EXIT_FAILURE, 0, "%s: bad data for %zu bytes at %" PRId64,
+	   what, size, offset);
+}
+
+static void
+read_file (const char *fname, const char *what)
+{
+  int fd = open (fname, O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "open %s", fname);
+  Elf *elf = elf_begin (fd, ELF_C_READ_MMAP, NULL);
+  if (elf == NULL)
+    error (EXIT_FAILURE, 0, "elf_begin: %s", elf_errmsg (-1));
+  Elf_Scn *scn = elf_getscn (elf, 1);
+  GElf_Shdr mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+  if (shdr == NULL || (shdr->sh_flags & SHF_COMPRESSED) == 0)
+    error (EXIT_FAILURE, 0, "%s: section not compressed", what);
+
+  max_alloc = 0;
+  for (int64_t offset = 0; offset < SIZE + PIECE; offset += PIECE)
+    check_read (scn, what, PIECE, offset);
+
+  /* Random offsets and sizes, crossing chunks.  */
+  uint32_t seed = 17;
+  for (int i = 0; i < NRANDOM; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      int64_t offset = seed % (SIZE + 1000);
+      seed = seed * 1103515245 + 12345;
+      size_t size = seed % (3 * PIECE);
+      check_read (scn, what, size, offset);
+    }
+
+  if (max_alloc >= SIZE / 2)
+    error (EXIT_FAILURE, 0, "%s: allocated %zu bytes", what, max_alloc);
+
+  /* Still decompresses completely.  */
+  if (elf_compress (scn, 0, 0) != 1)
+    error (EXIT_FAILURE, 0, "%s: elf_compress: %s", what, elf_errmsg (-1));
+  Elf_Data *data = elf_getdata (scn, NULL);
+  if (data == NULL || data->d_size != SIZE
+      || memcmp (data->d_buf, orig, SIZE) != 0)
+    error (EXIT_FAILURE, 0, "%s: bad decompressed data", what);
+
+  /* And reads uncompressed.  */
+  check_read (scn, what, PIECE, SIZE - 100);
+
+  elf_end (elf);
+  close (fd);
+  printf ("%s: OK\n", what);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    error (EXIT_FAILURE, 0, "Usage: %s FILE", argv[0]);
+
+  /* Compressible, but not trivially.  */
+  orig = malloc (SIZE);
+  buf = malloc (3 * PIECE);
+  if (orig == NULL || buf == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  uint32_t seed = 42;
+  for (size_t i = 0; i < SIZE; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      orig[i] = "abcdefgh"[(seed >> 16) & 7] + (i % 4096 == 0);
+    }
+
+  elf_version (EV_CURRENT);
+
+  write_file (argv[1], ELFCOMPRESS_ZLIB, 0);
+  read_file (argv[1], "zlib");
+
+  if (! write_file (argv[1], ELFCOMPRESS_ZSTD, 0))
+    printf ("zstd not supported\n");
+  else
+    {
+      read_file (argv[1], "zstd");
+      write_file (argv[1], ELFCOMPRESS_ZSTD,
+		  ELF_CHF_CHUNKED | ELF_CHF_THREADS (2));
+      read_file (argv[1], "zstd chunked");
+      write_frames_file (argv[1], SIZE - 1024 * 1024);
+      read_file (argv[1], "zstd big frame");
+    }
+
+  free (orig);
+  free (buf);
+  return 0;
+}
+
+#endif /* __GLIBC__ */
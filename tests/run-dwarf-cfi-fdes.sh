@@ -0,0 +1,95 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Files with an .eh_frame_hdr and a .debug_frame, as used by
+# run-addrcfi.sh, plus an ET_REL file with only a .debug_frame.
+testfiles testfile11 testfile12 testfileppc32 testfileaarch64 testfilearm
+testfiles testfile-debug-rel-ppc64.o
+
+testrun_compare ${abs_builddir}/dwarf-cfi-fdes \
+	testfile11 testfile12 testfileppc32 testfileaarch64 testfilearm \
+	testfile-debug-rel-ppc64.o << \EOF
+testfile11: 8 functions
+  .eh_frame: 4 first and 4 last addresses found
+  .debug_frame: 8 first and 8 last addresses found
+testfile12: 1 functions
+  .eh_frame: 1 first and 1 last addresses found
+  .debug_frame: 1 first and 1 last addresses found
+testfileppc32: 5 functions
+  .eh_frame: 2 first and 2 last addresses found
+  .debug_frame: 2 first and 2 last addresses found
+testfileaarch64: 5 functions
+  .eh_frame: 2 first and 2 last addresses found
+  .debug_frame: 2 first and 2 last addresses found
+testfilearm: 4 functions
+  .eh_frame: 0 first and 0 last addresses found
+  .debug_frame: 2 first and 2 last addresses found
+testfile-debug-rel-ppc64.o: 1 functions
+  .debug_frame: 1 first and 1 last addresses found
+EOF
+
+testrun_on_self_quiet ${abs_builddir}/dwarf-cfi-fdes
+
+# Overlapping FDEs, from this .debug_frame assembled with as --64.
+#	.section .debug_frame,"",@progbits
+# cie:	.long	cie_end - cie_start
+# cie_start:
+#	.long	0xffffffff
+#	.byte	1
+#	.string	""
+#	.uleb128 1
+#	.sleb128 -8
+#	.byte	16
+#	.byte	0xc, 7, 8
+#	.balign	4
+# cie_end:
+#	.macro fde start, len
+#	.long	1f - 0f
+# 0:	.long	0
+#	.quad	\start
+#	.quad	\len
+#	.balign	4
+# 1:
+#	.endm
+#	fde 0x1000, 0x100
+#	fde 0x1080, 0x180
+#	fde 0x1010, 0x10
+#	fde 0x1400, 0x100
+#	fde 0x1300, 0x200
+testfiles testfile-cfi-overlap.o
+testrun_compare ${abs_builddir}/dwarf-cfi-fdes --addrs \
+	testfile-cfi-overlap.o 0xfff 0x1000 0x1010 0x10ff 0x1100 0x11ff \
+	0x1200 0x1300 0x1400 0x14ff 0x1500 << \EOF
+0xfff: no matching address range
+0x1000: [0x1000, 0x1100)
+0x1010: [0x1000, 0x1100)
+0x10ff: [0x1000, 0x1100)
+0x1100: [0x1080, 0x1200)
+0x11ff: [0x1080, 0x1200)
+0x1200: no matching address range
+0x1300: [0x1300, 0x1500)
+0x1400: [0x1300, 0x1500)
+0x14ff: [0x1300, 0x1500)
+0x1500: no matching address range
+EOF
+
+# The benchmark should at least run.
+testrun ${abs_builddir}/dwarf-cfi-fdes --bench 10 testfile11 2>/dev/null
+
+exit 0
@@ -0,0 +1,46 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Without arguments it only checks whether libdw was built with
+# --enable-thread-safety, skip the test if not.
+testrun ${abs_builddir}/dwarf-concurrent || exit $?
+
+# see tests/testfile-dwarf-45.source
+testfiles testfile-dwarf-4 testfile-dwarf-5
+testfiles testfile-splitdwarf-4 testfile-hello4.dwo testfile-world4.dwo
+testfiles testfile-splitdwarf-5 testfile-hello5.dwo testfile-world5.dwo
+
+# see run-readelf-dwz-multi.sh
+testfiles testfile_multi_main testfile_multi.dwz
+
+testrun_compare ${abs_builddir}/dwarf-concurrent testfile-dwarf-4 \
+	testfile-dwarf-5 testfile-splitdwarf-4 testfile-splitdwarf-5 \
+	testfile_multi_main << \EOF
+testfile-dwarf-4: 2 units, 16 threads: ok
+testfile-dwarf-5: 2 units, 16 threads: ok
+testfile-splitdwarf-4: 2 units, 16 threads: ok
+testfile-splitdwarf-5: 2 units, 16 threads: ok
+testfile_multi_main: 1 units, 16 threads: ok
+EOF
+
+# Self test (not on obj files, since those need relocation first).
+testrun_on_self_exe ${abs_builddir}/dwarf-concurrent
+testrun_on_self_lib ${abs_builddir}/dwarf-concurrent
+
+exit 0
@@ -0,0 +1,51 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-readelf-gdb_index.sh for the sources of testfilegdbindex7.
+# objcopy -R .debug_aranges testfilegdbindex7 testfilegdbindex7-noaranges
+# So the address ranges have to come from the .gdb_index.
+
+testfiles testfilegdbindex7 testfilegdbindex7-noaranges
+
+for file in testfilegdbindex7 testfilegdbindex7-noaranges; do
+testrun_compare ${abs_builddir}/dwarf-gdb-index $file \
+  0x40049c 0x4004f0 0x400600 main hello say global int foo <<\EOF
+aranges: 2
+ 0x40049c +0x36 die [b]
+ 0x4004d4 +0x38 die [c3]
+addr 0x40049c: cu [b] hello.c
+addr 0x4004f0: cu [c3] world.c
+addr 0x400600: not found
+lookup: main
+ [34] main tag 0x2e cu [b]
+lookup: hello
+ [97] hello tag 0x34 cu [b]
+ [f7] hello tag 0x2e cu [c3]
+lookup: say
+ [12e] say tag 0x2e cu [c3]
+lookup: global
+ [168] global tag 0x34 cu [c3]
+lookup: int
+ [84] int tag 0x24 cu [b]
+lookup: foo
+ not found
+EOF
+done
+
+exit 0
@@ -0,0 +1,37 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Files with inlined functions, as used by run-addr2line-i-test.sh,
+# run-addr2line-i-lex-test.sh and run-stack-i-test.sh.
+testfiles testfile-inlines testfile-lex-inlines testfiledwarfinlines
+
+testrun_compare ${abs_builddir}/dwarf-getinlinechain \
+	testfile-inlines testfile-lex-inlines testfiledwarfinlines << \EOF
+testfile-inlines: 22 addresses, 9 in inlined functions
+testfile-lex-inlines: 5 addresses, 2 in inlined functions
+testfiledwarfinlines: 57 addresses, 34 in inlined functions
+EOF
+
+testrun_on_self_quiet ${abs_builddir}/dwarf-getinlinechain
+
+# The benchmark should at least run.
+testrun ${abs_builddir}/dwarf-getinlinechain --bench 10 testfile-inlines \
+	2>/dev/null
+
+exit 0
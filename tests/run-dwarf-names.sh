@@ -0,0 +1,67 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Two DWARF5 compile units, each with its own name index.  Compiled
+# from LLVM IR equivalent to:
+#
+# a.c:
+# struct point { int x, y; };
+# struct point origin;
+# int add (int a, int b) { return a + b; }
+# int main () { return add (1, 2); }
+#
+# b.c:
+# struct point { int x, y; };
+# int counter;
+# void Scale_Point (struct point *p, int f) { }
+#
+# llc -filetype=obj -O0 a.ll; llc -filetype=obj -O0 b.ll
+# gcc -nostdlib -Wl,-e,main -o testfile-debug-names a.o b.o
+testfiles testfile-debug-names
+
+testrun_compare ${abs_builddir}/dwarf-names testfile-debug-names \
+	add Scale_Point scale_point point nothere << \EOF
+file: testfile-debug-names
+ [4e] add tag 0x2e cu [c]
+ [71] main tag 0x2e cu [c]
+ [4a] int tag 0x24 cu [c]
+ [32] point tag 0x13 cu [c]
+ [27] origin tag 0x34 cu [c]
+ [af] int tag 0x24 cu [8d]
+ [a4] counter tag 0x34 cu [8d]
+ [b3] Scale_Point tag 0x2e cu [8d]
+ [d8] point tag 0x13 cu [8d]
+second: main
+lookup: add
+ [4e] add tag 0x2e cu [c]
+lookup: Scale_Point
+ [b3] Scale_Point tag 0x2e cu [8d]
+lookup: scale_point
+ not found
+lookup: point
+ [32] point tag 0x13 cu [c]
+ [d8] point tag 0x13 cu [8d]
+lookup: nothere
+ not found
+EOF
+
+# The benchmark should at least run.
+testrun ${abs_builddir}/dwarf-names --bench 10 testfile-debug-names 2>/dev/null
+
+exit 0
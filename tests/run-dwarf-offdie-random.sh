@@ -0,0 +1,53 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-typeiter.sh
+testfiles testfile-debug-types
+
+# see run-readelf-dwz-multi.sh
+testfiles testfile_multi_main testfile_multi.dwz
+
+# see tests/testfile-dwarf-45.source
+testfiles testfile-dwarf-4 testfile-dwarf-5
+
+testrun_compare ${abs_builddir}/dwarf-offdie-random testfile-debug-types \
+	testfile_multi_main testfile-dwarf-4 testfile-dwarf-5 << \EOF
+file: testfile-debug-types
+units: 1, dies: 5
+lookups: ok
+
+file: testfile_multi_main
+units: 1, dies: 8
+lookups: ok
+
+file: testfile-dwarf-4
+units: 2, dies: 74
+lookups: ok
+
+file: testfile-dwarf-5
+units: 2, dies: 74
+lookups: ok
+
+EOF
+
+# Self test (not on obj files, since those need relocation first).
+testrun_on_self_exe ${abs_builddir}/dwarf-offdie-random
+testrun_on_self_lib ${abs_builddir}/dwarf-offdie-random
+
+exit 0
@@ -0,0 +1,83 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-dwarf-ranges.sh and run-all-dwarf-ranges.sh for the sources.
+# The first unit of testfileranges5.debug uses DW_AT_ranges (rnglists).
+#
+# objcopy -R .debug_aranges testfileranges5.debug \
+#   testfileranges5-noaranges.debug
+# dd if=testfileranges5.debug bs=1 skip=$((0x2d0)) count=64 of=first
+# objcopy --update-section .debug_aranges=first testfileranges5.debug \
+#   testfileranges5-partaranges.debug
+# objcopy -R .debug_aranges testfile-splitdwarf-5 \
+#   testfile-splitdwarf-5-noaranges
+
+testfiles testfileranges5.debug testfileranges5-noaranges.debug
+testfiles testfileranges5-partaranges.debug
+
+lookups='addr 0x401050: cu [c]
+addr 0x401066: cu [c]
+addr 0x401150: cu [c]
+addr 0x401179: cu [c]
+addr 0x401180: cu [1ab]
+addr 0x4011e6: cu [1ab]'
+
+# A complete .debug_aranges is returned as is.
+for file in testfileranges5.debug testfileranges5-noaranges.debug; do
+testrun_compare ${abs_builddir}/dwarf-synth-aranges \
+  testfileranges5.debug $file <<EOF
+$lookups
+aranges: 3
+ 0x401050 +0x17 die [c]
+ 0x401150 +0x2a die [c]
+ 0x401180 +0x67 die [1ab]
+EOF
+done
+
+# The unit missing from .debug_aranges is still found by address, but
+# dwarf_getaranges only returns what .debug_aranges has.
+testrun_compare ${abs_builddir}/dwarf-synth-aranges \
+  testfileranges5.debug testfileranges5-partaranges.debug <<EOF
+$lookups
+aranges: 2
+ 0x401050 +0x17 die [c]
+ 0x401150 +0x2a die [c]
+EOF
+
+# Skeleton units, one with DW_AT_ranges.
+testfiles testfile-splitdwarf-5 testfile-splitdwarf-5-noaranges
+testfiles testfile-hello5.dwo testfile-world5.dwo
+
+for file in testfile-splitdwarf-5 testfile-splitdwarf-5-noaranges; do
+testrun_compare ${abs_builddir}/dwarf-synth-aranges \
+  testfile-splitdwarf-5 $file <<\EOF
+addr 0x401060: cu [49]
+addr 0x40107f: cu [49]
+addr 0x401160: cu [14]
+addr 0x4011b0: cu [14]
+addr 0x4011c0: cu [49]
+addr 0x4011ea: cu [49]
+aranges: 3
+ 0x401060 +0x20 die [49]
+ 0x401160 +0x51 die [14]
+ 0x4011c0 +0x2b die [49]
+EOF
+done
+
+exit 0
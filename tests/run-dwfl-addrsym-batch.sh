@@ -0,0 +1,113 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# see tests/testfile-dwarf-45.source
+testfiles testfile-dwarf-4
+# ppc64 with function descriptors, see run-addrname-test.sh
+testfiles testfile66
+
+testrun_compare ${abs_builddir}/dwfl-addrsym-batch \
+	testfile-dwarf-4 testfile66 << \EOF
+testfile-dwarf-4: 72 symbols, 223 addresses, 107 found
+testfile66: 17 symbols, 51 addresses, 14 found
+EOF
+
+# Symbols sharing an address must resolve like a search through the
+# whole symbol table would.  Of equally good sized symbols the first in
+# the table wins, of sizeless ones at the same address the last does.
+# Locals are only tried when no global matches the address exactly.
+# testfile-addrsym-ties.so is ties.s built with
+# gcc -shared -nostdlib -Wl,--build-id=none -o testfile-addrsym-ties.so ties.s
+#	.text
+#	.globl	g1
+#	.globl	g2
+#	.weak	w1
+# l1:
+# g1:
+# w1:
+# g2:
+# l2:
+#	nop
+#	nop
+#	.globl	f
+#	.type	f,@function
+# f:
+#	nop
+#	nop
+#	.size	f, 2
+# lab_after:
+#	nop
+#	.globl	ga
+# ga:
+# lb:
+#	nop
+#	.type	s1,@function
+#	.globl	s1
+#	.globl	s2
+#	.type	s2,@function
+# s1:
+# s2:
+#	nop
+#	nop
+#	.size	s1, 2
+#	.size	s2, 2
+#	.local	s3
+#	.type	s3,@function
+# s3:
+#	nop
+#	.size	s3, 1
+#	.data
+# d0:
+#	.long 0
+testfiles testfile-addrsym-ties.so
+
+testrun_compare ${abs_top_builddir}/src/addr2line -S \
+	-e testfile-addrsym-ties.so \
+	0x1000 0x1001 0x1004 0x1005 0x1006 0x1007 0x1008 0x1009 << \EOF
+g2
+??:0
+l2+0x1
+??:0
+lab_after
+??:0
+ga
+??:0
+s1
+??:0
+s1+0x1
+??:0
+s3
+??:0
+()+0x1009
+??:0
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-addrsym-batch \
+	testfile-addrsym-ties.so << \EOF
+testfile-addrsym-ties.so: 17 symbols, 53 addresses, 38 found
+EOF
+
+# Self test, including obj files, whose symbols need relocation.
+testrun_on_self ${abs_builddir}/dwfl-addrsym-batch
+
+# The benchmark should at least run.
+testrun ${abs_builddir}/dwfl-addrsym-batch --bench 10 testfile-dwarf-4 \
+	2>/dev/null
+
+exit 0
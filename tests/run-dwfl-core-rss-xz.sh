@@ -0,0 +1,42 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# This test cannot be run under valgrind, it measures its own memory use.
+unset VALGRIND_CMD
+
+type xz > /dev/null 2>&1 || { echo "no xz"; exit 77; }
+
+# The core of run-dwfl-core-rss.sh compressed in blocks.  In 1 MiB
+# blocks libdwfl must only decompress and cache the blocks it needs, in
+# 128 MiB blocks it must not keep any block whole.
+testfiles backtrace.x86_64.exec backtrace.x86_64.core
+tempfiles big.core big.core.xz
+for block_size in 1MiB 128MiB; do
+  testrun ${abs_builddir}/dwfl-core-rss --create backtrace.x86_64.core big.core
+  xz -f -0 -T1 --block-size=$block_size big.core
+
+  testrun_compare ${abs_builddir}/dwfl-core-rss --argp \
+    backtrace.x86_64.exec big.core.xz << \EOF
+libbig.so: 268435456 bytes
+2 threads, 11 frames
+peak RSS growth below 32 MiB
+EOF
+done
+
+exit 0
@@ -0,0 +1,56 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Unwind the cores of run-backtrace-core-*.sh and run-backtrace-fp-core-*.sh
+# twice, the second time only with the cached rules.
+for arch in x86_64 i386 aarch64 ppc s390x x86_64.fp; do
+  testfiles backtrace.$arch.exec backtrace.$arch.core
+done
+
+testrun_compare ${abs_builddir}/dwfl-frame-cache \
+	backtrace.x86_64.exec backtrace.x86_64.core << \EOF
+backtrace.x86_64.core: 11 frames, 11 rules, 11 hits
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-frame-cache \
+	backtrace.i386.exec backtrace.i386.core << \EOF
+backtrace.i386.core: 13 frames, 11 rules, 13 hits
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-frame-cache \
+	backtrace.aarch64.exec backtrace.aarch64.core << \EOF
+backtrace.aarch64.core: 12 frames, 10 rules, 10 hits
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-frame-cache \
+	backtrace.ppc.exec backtrace.ppc.core << \EOF
+backtrace.ppc.core: 11 frames, 10 rules, 10 hits
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-frame-cache \
+	backtrace.s390x.exec backtrace.s390x.core << \EOF
+backtrace.s390x.core: 11 frames, 9 rules, 9 hits
+EOF
+
+testrun_compare ${abs_builddir}/dwfl-frame-cache \
+	backtrace.x86_64.fp.exec backtrace.x86_64.fp.core << \EOF
+backtrace.x86_64.fp.core: 11 frames, 6 rules, 6 hits
+EOF
+
+exit 0
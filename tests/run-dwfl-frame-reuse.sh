@@ -0,0 +1,36 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+. $srcdir/backtrace-subr.sh
+
+# This test cannot be run under valgrind, it unwinds its own child
+# through ptrace and counts its own heap allocations.
+unset VALGRIND_CMD
+
+tempfiles reuse.{out,err}
+(set +ex; testrun ${abs_builddir}/dwfl-frame-reuse 1>reuse.out 2>reuse.err; true)
+cat reuse.{out,err}
+check_native_unsupported reuse.err reuse
+
+testrun_compare cat reuse.out << \EOF
+without reuse: heap calls for every frame
+with reuse: 0 heap calls
+reuse turned off: heap calls for every frame
+EOF
+
+exit 0
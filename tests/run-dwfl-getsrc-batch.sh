@@ -0,0 +1,38 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# see tests/testfile-dwarf-45.source
+testfiles testfile-dwarf-4 testfile-dwarf-5
+
+# No .debug_aranges, so the units are found one by one.
+testfiles testfileranges5-noaranges.debug
+
+testrun_compare ${abs_builddir}/dwfl-getsrc-batch \
+	testfile-dwarf-4 testfile-dwarf-5 << \EOF
+testfile-dwarf-4: 57 lines, 175 addresses, 155 found
+testfile-dwarf-5: 57 lines, 175 addresses, 155 found
+EOF
+
+testrun ${abs_builddir}/dwfl-getsrc-batch testfileranges5-noaranges.debug
+
+# Self test (not on obj files, since those need relocation first).
+testrun_on_self_exe ${abs_builddir}/dwfl-getsrc-batch
+testrun_on_self_lib ${abs_builddir}/dwfl-getsrc-batch
+
+exit 0
@@ -0,0 +1,49 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/backtrace-subr.sh
+
+# This test cannot be run under valgrind, it unwinds its own children
+# through ptrace.
+unset VALGRIND_CMD
+
+tempfiles parallel.{out,err}
+(set +ex; testrun ${abs_builddir}/dwfl-getthreads-parallel \
+   1>parallel.out 2>parallel.err; true)
+cat parallel.{out,err}
+check_native_unsupported parallel.err parallel
+
+testrun_compare cat parallel.out << \EOF
+9 threads
+1 workers: same frames
+2 workers: same frames
+4 workers: same frames
+child exited with 42
+EOF
+
+# eu-stack -j shows the same backtraces, the threads are found in the
+# order they were started, which is also the order of their ids.
+tempfiles bt bt.err btj btj.err
+pid=$(testrun ${abs_builddir}/dwfl-getthreads-parallel --child)
+testrun ${abs_top_builddir}/src/stack -p $pid 1>bt 2>bt.err || true
+testrun ${abs_top_builddir}/src/stack -j 4 -p $pid 1>btj 2>btj.err || true
+kill -9 $pid
+cat bt.err btj.err
+check_native_unsupported btj.err parallel
+testrun_compare cat btj < bt
+
+exit 0
@@ -0,0 +1,37 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+. $srcdir/backtrace-subr.sh
+
+# This test cannot be run under valgrind, it unwinds its own child
+# through ptrace.
+unset VALGRIND_CMD
+
+# The stack of the child is much larger than the remote memory cache,
+# so unwinding it refills and evicts cached pages many times.
+tempfiles deep.{out,err}
+(set +ex; testrun ${abs_builddir}/dwfl-proc-deep-stack 1>deep.out 2>deep.err; true)
+cat deep.{out,err}
+check_native_unsupported deep.err deep
+
+testrun_compare cat deep.out << \EOF
+1001 recurse frames, main found
+1001 recurse frames, main found
+EOF
+
+exit 0
@@ -0,0 +1,38 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+. $srcdir/backtrace-subr.sh
+
+# This test cannot be run under valgrind, it unwinds its own child
+# through ptrace.
+unset VALGRIND_CMD
+
+tempfiles sample.{out,err}
+(set +ex; testrun ${abs_builddir}/dwfl-sample-getframes 1>sample.out 2>sample.err; true)
+cat sample.{out,err}
+check_native_unsupported sample.err sample
+
+testrun_compare cat sample.out << \EOF
+live: 101 recurse frames
+sample: 101 recurse frames
+1000 samples: same frames
+maxpcs 3: 3 frames
+1024 bytes of stack: fewer frames
+EOF
+
+exit 0
@@ -0,0 +1,40 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Only .dynsym, with .hash (testfile13), with .gnu.hash (testfile32)
+# and without section headers (testfile52-32.noshdrs.so).
+testfiles testfile13 testfile32 testfile52-32.noshdrs.so
+
+# .dynsym plus minidebuginfo (see run-dwflsyms.sh) and a full .symtab.
+testfiles testfilebazmin testfile-dwarf-4
+
+testrun_compare ${abs_builddir}/dwfl-symbol-by-name \
+	testfile13 testfile32 testfile52-32.noshdrs.so \
+	testfilebazmin testfile-dwarf-4 << \EOF
+testfile13: 8 names, 8 found
+testfile32: 2 names, 2 found
+testfile52-32.noshdrs.so: 6 names, 6 found
+testfilebazmin: 19 names, 19 found
+testfile-dwarf-4: 31 names, 31 found
+EOF
+
+# Self test, including obj files, whose symbols need relocation.
+testrun_on_self ${abs_builddir}/dwfl-symbol-by-name
+
+exit 0
@@ -0,0 +1,36 @@
+#! /bin/bash
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/backtrace-subr.sh
+
+# This test cannot be run under valgrind, it unwinds its own child
+# through ptrace.
+unset VALGRIND_CMD
+
+tempfiles policy.{out,err}
+(set +ex; testrun ${abs_builddir}/dwfl-unwind-policy 1>policy.out 2>policy.err; true)
+cat policy.{out,err}
+check_native_unsupported policy.err policy
+
+testrun_compare cat policy.out << \EOF
+default: 51 recurse frames, all by cfi
+frame pointer: same frames, 53 by frame pointer, 1 rejected
+frame pointer only: ends at 0x10
+default again: same frames
+EOF
+
+exit 0
@@ -0,0 +1,63 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+tempfiles testfile.compress-threads
+
+testrun ${abs_top_builddir}/tests/elf-compress-threads testfile.compress-threads
+
+# The same file compressed with more threads or with zstd is as good.
+testfiles testfile-zgabi64
+tempfiles uncompressed threads threads.uncompressed
+testrun ${abs_top_builddir}/src/elfcompress -q -t none -o uncompressed \
+  testfile-zgabi64
+testrun ${abs_top_builddir}/src/elfcompress -t zlib --level=6 --threads=4 \
+  -o threads uncompressed
+testrun ${abs_top_builddir}/src/elflint --gnu-ld threads
+testrun ${abs_top_builddir}/src/elfcompress -t none -o threads.uncompressed \
+  threads
+testrun ${abs_top_builddir}/src/elfcmp uncompressed threads.uncompressed
+
+# Only when libelf supports zstd.
+tempfiles zstd zstd.uncompressed
+if testrun ${abs_top_builddir}/src/elfcompress -t zstd -j 2 -o zstd \
+     uncompressed 2> /dev/null; then
+  testrun ${abs_top_builddir}/src/readelf -z -S zstd | grep -q ZSTD
+  testrun ${abs_top_builddir}/src/elflint --gnu-ld zstd
+  testrun ${abs_top_builddir}/src/elfcompress -t none -o zstd.uncompressed \
+    zstd
+  testrun ${abs_top_builddir}/src/elfcmp uncompressed zstd.uncompressed
+
+  # Sections compressed with the other type are recompressed, not kept.
+  tempfiles zlib.zstd zstd.zlib recompressed.uncompressed readelf.out
+  testrun ${abs_top_builddir}/src/elfcompress -t zstd -o zlib.zstd threads
+  testrun ${abs_top_builddir}/src/readelf -z -S zlib.zstd > readelf.out
+  grep -q ZSTD readelf.out && ! grep -q ZLIB readelf.out || exit 1
+  testrun ${abs_top_builddir}/src/elfcompress -t none \
+    -o recompressed.uncompressed zlib.zstd
+  testrun ${abs_top_builddir}/src/elfcmp uncompressed recompressed.uncompressed
+
+  testrun ${abs_top_builddir}/src/elfcompress -t zlib -o zstd.zlib zstd
+  testrun ${abs_top_builddir}/src/readelf -z -S zstd.zlib > readelf.out
+  grep -q ZLIB readelf.out && ! grep -q ZSTD readelf.out || exit 1
+  testrun ${abs_top_builddir}/src/elfcompress -t none \
+    -o recompressed.uncompressed zstd.zlib
+  testrun ${abs_top_builddir}/src/elfcmp uncompressed recompressed.uncompressed
+fi
+
+exit 0
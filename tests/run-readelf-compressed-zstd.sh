@@ -0,0 +1,47 @@
+#! /bin/sh
+# Copyright (C) 2026 agent <agent@local>
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+type zstd > /dev/null 2>&1 || { echo "no zstd"; exit 77; }
+
+# See run-readelf-compressed.sh
+testfiles hello_i386.ko
+
+tempfiles hello_i386.ko.zst truncated.ko.zst readelf.out.1 readelf.out.2
+
+testrun ${abs_top_builddir}/src/readelf -a hello_i386.ko > readelf.out.1
+zstd -q hello_i386.ko
+testrun ${abs_top_builddir}/src/readelf -a hello_i386.ko.zst > readelf.out.2 \
+  || { echo "no zstd support in libdwfl"; exit 77; }
+
+diff -u readelf.out.1 readelf.out.2
+if [ $? != 0 ]; then
+  exit 1;
+fi
+
+# A stream cut in the middle of the frame is an error, it must not make
+# the decompressor wait for more input forever.
+head -c $(($(stat -c %s hello_i386.ko.zst) / 2)) hello_i386.ko.zst \
+  > truncated.ko.zst
+if testrun ${abs_top_builddir}/src/readelf -h truncated.ko.zst \
+     > /dev/null 2>&1; then
+  echo "truncated zstd stream read as a whole file"
+  exit 1
+fi
+
+exit 0
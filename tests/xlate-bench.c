@@ -0,0 +1,244 @@
+/* Check and benchmark byte order conversion of the bulk types.
+   Copyright (C) 2026 agent <agent@local>
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <endian.h>
+#include <errno.h>
+#include <error.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+
+/* Usage: xlate-bench
+   Converts random data of every type below with elf32_xlatetom and
+   elf64_xlatetom to the other byte order, with all sizes up to a few
+   blocks, unaligned, in place and overlapping, and checks the result
+   against swapping every field by hand.
+
+   Usage: xlate-bench --bench [MB]
+   Prints the throughput in GB/s of xlatetom and of the field by field
+   swap for MB (default 64) megabytes of each type.  */
+
+struct type
+{
+  const char *name;
+  Elf_Type type;
+  /* The sizes of the fields of the 32 and 64 bit record.  */
+  int fields[2][7];
+};
+
+static const struct type types[] =
+  {
+    { "Addr", ELF_T_ADDR, { { 4 }, { 8 } } },
+    { "Dyn", ELF_T_DYN, { { 4, 4 }, { 8, 8 } } },
+    { "Half", ELF_T_HALF, { { 2 }, { 2 } } },
+    { "Off", ELF_T_OFF, { { 4 }, { 8 } } },
+    { "Rela", ELF_T_RELA, { { 4, 4, 4 }, { 8, 8, 8 } } },
+    { "Rel", ELF_T_REL, { { 4, 4 }, { 8, 8 } } },
+    { "Sword", ELF_T_SWORD, { { 4 }, { 4 } } },
+    { "Sym", ELF_T_SYM, { { 4, 4, 4, 1, 1, 2 }, { 4, 1, 1, 2, 8, 8 } } },
+    { "Word", ELF_T_WORD, { { 4 }, { 4 } } },
+    { "Xword", ELF_T_XWORD, { { 8 }, { 8 } } },
+    { "Sxword", ELF_T_SXWORD, { { 8 }, { 8 } } },
+  };
+#define NTYPES (sizeof types / sizeof types[0])
+
+static int
+other_encoding (void)
+{
+  return BYTE_ORDER == LITTLE_ENDIAN ? ELFDATA2MSB : ELFDATA2LSB;
+}
+
+static size_t
+recsize (const struct type *t, int is64)
+{
+  size_t size = 0;
+  for (int i = 0; t->fields[is64][i] != 0; i++)
+    size += t->fields[is64][i];
+  return size;
+}
+
+/* Reverse every field of the LEN bytes at SRC into DEST.  */
+static void
+swap_fields (unsigned char *dest, const unsigned char *src, size_t len,
+	     const struct type *t, int is64)
+{
+  size_t pos = 0;
+  while (pos < len)
+    for (int i = 0; t->fields[is64][i] != 0; i++)
+      {
+	int size = t->fields[is64][i];
+	for (int j = 0; j < size; j++)
+	  dest[pos + j] = src[pos + size - 1 - j];
+	pos += size;
+      }
+}
+
+static void
+xlate (void *dest, const void *src, size_t len, const struct type *t,
+       int is64)
+{
+  Elf_Data dst_data =
+    {
+      .d_buf = dest, .d_size = len, .d_type = t->type,
+      .d_version = EV_CURRENT
+    };
+  Elf_Data src_data = dst_data;
+  src_data.d_buf = (void *) src;
+  if ((is64
+       ? elf64_xlatetom (&dst_data, &src_data, other_encoding ())
+       : elf32_xlatetom (&dst_data, &src_data, other_encoding ())) == NULL)
+    error (EXIT_FAILURE, 0, "xlatetom: %s", elf_errmsg (-1));
+}
+
+static unsigned char *
+random_buf (size_t size)
+{
+  unsigned char *buf = malloc (size);
+  if (buf == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+  for (size_t i = 0; i < size; i++)
+    buf[i] = random ();
+  return buf;
+}
+
+static void
+check (void)
+{
+  /* Enough for several blocks of the biggest record and vector.  */
+  const size_t maxrecs = 40;
+  const size_t bufsize = 4 * maxrecs * 24 + 64;
+
+  for (size_t ti = 0; ti < NTYPES; ti++)
+    for (int is64 = 0; is64 < 2; is64++)
+      {
+	const struct type *t = &types[ti];
+	size_t rec = recsize (t, is64);
+	for (size_t n = 0; n <= maxrecs; n++)
+	  for (size_t misalign = 0; misalign < 3; misalign++)
+	    {
+	      size_t len = n * rec;
+	      unsigned char *orig = random_buf (bufsize);
+	      unsigned char *expect = malloc (len + 1);
+	      unsigned char *buf = malloc (bufsize);
+	      if (expect == NULL || buf == NULL)
+		error (EXIT_FAILURE, errno, "malloc");
+	      swap_fields (expect, orig + misalign, len, t, is64);
+
+	      /* Separate buffers, unaligned.  */
+	      xlate (buf + 2 * misalign, orig + misalign, len, t, is64);
+	      if (memcmp (buf + 2 * misalign, expect, len) != 0)
+		error (EXIT_FAILURE, 0, "Elf%d_%s: %zu records wrong",
+		       is64 ? 64 : 32, t->name, n);
+
+	      /* In place.  */
+	      memcpy (buf, orig + misalign, len);
+	      xlate (buf, buf, len, t, is64);
+	      if (memcmp (buf, expect, len) != 0)
+		error (EXIT_FAILURE, 0, "Elf%d_%s: %zu records in place wrong",
+		       is64 ? 64 : 32, t->name, n);
+
+	      /* Overlapping, the destination before the source.  */
+	      size_t shift = rec * (misalign + 1) / 2 + misalign;
+	      memcpy (buf + shift, orig + misalign, len);
+	      xlate (buf, buf + shift, len, t, is64);
+	      if (memcmp (buf, expect, len) != 0)
+		error (EXIT_FAILURE, 0, "Elf%d_%s: %zu records backward wrong",
+		       is64 ? 64 : 32, t->name, n);
+
+	      /* And after it, which only the types with a single field
+		 support.  */
+	      if (t->fields[is64][1] == 0)
+		{
+		  memcpy (buf, orig + misalign, len);
+		  xlate (buf + shift, buf, len, t, is64);
+		  if (memcmp (buf + shift, expect, len) != 0)
+		    error (EXIT_FAILURE, 0,
+			   "Elf%d_%s: %zu records forward wrong",
+			   is64 ? 64 : 32, t->name, n);
+		}
+
+	      free (orig);
+	      free (expect);
+	      free (buf);
+	    }
+	printf ("Elf%d_%s: OK\n", is64 ? 64 : 32, t->name);
+      }
+}
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench (size_t mb)
+{
+  size_t size = mb * 1024 * 1024;
+  unsigned char *src = random_buf (size);
+  unsigned char *dest = malloc (size);
+  if (dest == NULL)
+    error (EXIT_FAILURE, errno, "malloc");
+
+  printf ("%-14s %10s %10s\n", "type", "xlatetom", "by field");
+  for (size_t ti = 0; ti < NTYPES; ti++)
+    for (int is64 = 0; is64 < 2; is64++)
+      {
+	const struct type *t = &types[ti];
+	size_t len = size - size % recsize (t, is64);
+
+	/* Touch the pages first.  */
+	xlate (dest, src, len, t, is64);
+	double start = now ();
+	xlate (dest, src, len, t, is64);
+	double xlate_time = now () - start;
+
+	start = now ();
+	swap_fields (dest, src, len, t, is64);
+	double field_time = now () - start;
+
+	char name[32];
+	snprintf (name, sizeof name, "Elf%d_%s", is64 ? 64 : 32, t->name);
+	printf ("%-14s %7.2f GB/s %5.2f GB/s\n", name,
+		len / xlate_time / 1e9, len / field_time / 1e9);
+      }
+
+  free (src);
+  free (dest);
+}
+
+int
+main (int argc, char *argv[])
+{
+  elf_version (EV_CURRENT);
+
+  if (argc >= 2 && strcmp (argv[1], "--bench") == 0)
+    bench (argc >= 3 ? strtoul (argv[2], NULL, 10) : 64);
+  else
+    check ();
+
+  return 0;
+}